@@ -25,7 +25,10 @@
 #include "names.h"
 #include "pointer.h"
 #include "log.h"
+#include "trace-source-accessor.h"
 
+#include <limits>
+#include <map>
 #include <sstream>
 
 /**
@@ -149,7 +152,12 @@ MatchContainer::DisconnectWithoutContext (std::string name, const CallbackBase &
 } // namespace Config
 
 
-/** Helper to test if an array entry matches a config path specification. */
+/**
+ * Helper to test if an array entry matches a config path specification.
+ *
+ * The specification is parsed once, when the matcher is constructed,
+ * into the list of index ranges it accepts.
+ */
 class ArrayMatcher
 {
 public:
@@ -166,6 +174,13 @@ public:
    * \returns \c true if the index matches the Config Path.
    */
   bool Matches (uint32_t i) const;
+  /**
+   * Test if a single index matches the Config Path.
+   *
+   * \param [out] i The index.
+   * \returns \c true if the Config Path matches a single index.
+   */
+  bool IsSingleIndex (uint32_t *i) const;
 private:
   /**
    * Convert a string to an \c uint32_t.
@@ -175,79 +190,94 @@ private:
    * \returns \c true if the string could be converted.
    */
   bool StringToUint32 (std::string str, uint32_t *value) const;
+  /**
+   * Add the index ranges matched by a Config path specification.
+   *
+   * \param [in] element The Config path specification.
+   */
+  void Parse (std::string element);
   /** The Config path element. */
   std::string m_element;
+  /** The inclusive index ranges matching the Config path element. */
+  std::vector<std::pair<uint32_t, uint32_t> > m_ranges;
 };
 
-
 ArrayMatcher::ArrayMatcher (std::string element)
   : m_element (element)
 {
   NS_LOG_FUNCTION (this << element);
+  Parse (element);
 }
-bool
-ArrayMatcher::Matches (uint32_t i) const
+void
+ArrayMatcher::Parse (std::string element)
 {
-  NS_LOG_FUNCTION (this << i);
-  if (m_element == "*")
+  NS_LOG_FUNCTION (this << element);
+  if (element == "*")
     {
-      NS_LOG_DEBUG ("Array "<<i<<" matches *");
-      return true;
+      m_ranges.push_back (std::make_pair (0U, std::numeric_limits<uint32_t>::max ()));
+      return;
     }
   std::string::size_type tmp;
-  tmp = m_element.find ("|");
+  tmp = element.find ("|");
   if (tmp != std::string::npos)
     {
-      std::string left = m_element.substr (0, tmp-0);
-      std::string right = m_element.substr (tmp+1, m_element.size () - (tmp + 1));
-      ArrayMatcher matcher = ArrayMatcher (left);
-      if (matcher.Matches (i))
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<left);
-          return true;
-        }
-      matcher = ArrayMatcher (right);
-      if (matcher.Matches (i))
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<right);
-          return true;
-        }
-      NS_LOG_DEBUG ("Array "<<i<<" does not match "<<m_element);
-      return false;
+      std::string left = element.substr (0, tmp-0);
+      std::string right = element.substr (tmp+1, element.size () - (tmp + 1));
+      Parse (left);
+      Parse (right);
+      return;
     }
-  std::string::size_type leftBracket = m_element.find ("[");
-  std::string::size_type rightBracket = m_element.find ("]");
-  std::string::size_type dash = m_element.find ("-");
-  if (leftBracket == 0 && rightBracket == m_element.size () - 1 &&
+  std::string::size_type leftBracket = element.find ("[");
+  std::string::size_type rightBracket = element.find ("]");
+  std::string::size_type dash = element.find ("-");
+  if (leftBracket == 0 && rightBracket == element.size () - 1 &&
       dash > leftBracket && dash < rightBracket)
     {
-      std::string lowerBound = m_element.substr (leftBracket + 1, dash - (leftBracket + 1));
-      std::string upperBound = m_element.substr (dash + 1, rightBracket - (dash + 1));
+      std::string lowerBound = element.substr (leftBracket + 1, dash - (leftBracket + 1));
+      std::string upperBound = element.substr (dash + 1, rightBracket - (dash + 1));
       uint32_t min;
       uint32_t max;
       if (StringToUint32 (lowerBound, &min) && 
           StringToUint32 (upperBound, &max) &&
-          i >= min && i <= max)
+          min <= max)
         {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
-          return true;
-        }
-      else
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" does not "<<m_element);
-          return false;
+          m_ranges.push_back (std::make_pair (min, max));
         }
+      return;
     }
   uint32_t value;
-  if (StringToUint32 (m_element, &value) &&
-      i == value)
+  if (StringToUint32 (element, &value))
     {
-      NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
-      return true;
+      m_ranges.push_back (std::make_pair (value, value));
+    }
+}
+bool
+ArrayMatcher::Matches (uint32_t i) const
+{
+  NS_LOG_FUNCTION (this << i);
+  for (std::vector<std::pair<uint32_t, uint32_t> >::const_iterator j = m_ranges.begin ();
+       j != m_ranges.end (); ++j)
+    {
+      if (i >= j->first && i <= j->second)
+        {
+          NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
+          return true;
+        }
     }
   NS_LOG_DEBUG ("Array "<<i<<" does not match "<<m_element);
   return false;
 }
+bool
+ArrayMatcher::IsSingleIndex (uint32_t *i) const
+{
+  NS_LOG_FUNCTION (this << i);
+  if (m_ranges.size () != 1 || m_ranges[0].first != m_ranges[0].second)
+    {
+      return false;
+    }
+  *i = m_ranges[0].first;
+  return true;
+}
 
 bool
 ArrayMatcher::StringToUint32 (std::string str, uint32_t *value) const
@@ -259,114 +289,182 @@ ArrayMatcher::StringToUint32 (std::string str, uint32_t *value) const
   return !iss.bad () && !iss.fail ();
 }
 
+namespace Config {
+
 /**
- * Abstract class to parse Config paths into object references.
+ * \ingroup config
+ * The compiled form of a Config::Path.
+ *
+ * The path is split into its items once.  The attributes an item refers
+ * to are looked up once for each TypeId met while resolving the item,
+ * and the trace source named by the leaf once for each TypeId it is
+ * connected on.
  */
-class Resolver
+class Path::Impl : public SimpleRefCount<Path::Impl>
 {
 public:
   /**
-   * Construct from a base Config path.
+   * Construct from a path split by Config::Path.
    *
-   * \param [in] path The Config path.
+   * \param [in] root The path of the objects.
+   * \param [in] leaf The name of the attribute or trace source.
    */
-  Resolver (std::string path);
-  /** Destructor. */
-  virtual ~Resolver ();
+  Impl (std::string root, std::string leaf);
 
   /**
-   * Parse the stored Config path into an object reference,
-   * beginning at the indicated root object.
+   * Find the objects matching the path of the objects, under all the
+   * root namespace objects and in the name service.
+   *
+   * \param [out] objects The objects matching the path.
+   * \param [out] contexts The matched path of each object.
+   */
+  void Resolve (std::vector<Ptr<Object> > &objects, std::vector<std::string> &contexts);
+  /**
+   * Look up the trace source named by the leaf.
    *
-   * \param [in] root The object corresponding to the current position in
-   *                  in the Config path.
+   * \param [in] object The object.
+   * \returns The trace source of the object, or zero.
    */
-  void Resolve (Ptr<Object> root);
-  
+  Ptr<const TraceSourceAccessor> GetTraceSource (Ptr<Object> object);
+
+  /** The canonical path of the objects, starting and ending with a '/'. */
+  std::string m_root;
+  /** The name of the attribute or trace source. */
+  std::string m_leaf;
+
 private:
-  /** Ensure the Config path starts and ends with a '/'. */
-  void Canonicalize (void);
+  /** An attribute holding the objects an item refers to. */
+  struct Step
+  {
+    std::string name;                           //!< The attribute name
+    Ptr<const AttributeAccessor> accessor;      //!< The attribute accessor
+    bool isPointer;                             //!< Whether the attribute is a pointer or a container
+  };
+  /** The attributes an item refers to. */
+  typedef std::vector<Step> Steps;
+
   /**
-   * Parse the next element in the Config path.
+   * Resolve a path, recursively.
    *
-   * \param [in] path The remaining portion of the Config path.
-   * \param [in] root The object corresponding to the current positon
-   *                  in the Config path.
+   * \param [in] item The index of the item to resolve.
+   * \param [in] root The object to resolve the item on.
    */
-  void DoResolve (std::string path, Ptr<Object> root);
+  void DoResolve (uint32_t item, Ptr<Object> root);
   /**
-   * Parse an index on the Config path.
+   * Resolve the item naming the elements of a container.
    *
-   * \param [in] path The remaining Config path.
-   * \param [in,out] vector The resulting list of matching objects.
+   * \param [in] item The index of the item.
+   * \param [in] container The container.
    */
-  void DoArrayResolve (std::string path, const ObjectPtrContainerValue &vector);
+  void DoArrayResolve (uint32_t item, const ObjectPtrContainerValue &container);
   /**
-   * Handle one object found on the path.
+   * Record an object matching the path.
    *
-   * \param [in] object The current object on the Config path.
+   * \param [in] object The object.
    */
   void DoResolveOne (Ptr<Object> object);
   /**
-   * Get the current Config path.
-   *
-   * \returns The current Config path.
+   * \returns The path matched so far.
    */
   std::string GetResolvedPath (void) const;
   /**
-   * Handle one found object.
+   * Look up, once, the attributes matching an item in a TypeId and its
+   * parents.
    *
-   * \param [in] object The found object.
-   * \param [in] path The matching Config path context.
+   * \param [in] item The index of the item.
+   * \param [in] tid The TypeId.
+   * \returns The attributes matching the item.
    */
-  virtual void DoOne (Ptr<Object> object, std::string path) = 0;
+  const Steps & GetSteps (uint32_t item, TypeId tid);
 
+  /** The items of the path. */
+  std::vector<std::string> m_items;
+  /** The array matcher of each item. */
+  std::vector<ArrayMatcher> m_matchers;
+  /** The TypeId of each $TypeId item, once looked up. */
+  std::map<uint32_t, TypeId> m_tids;
+  /** The attributes matching each item, by TypeId uid. */
+  std::map<std::pair<uint32_t, uint16_t>, Steps> m_steps;
+  /** The trace source named by the leaf, by TypeId uid. */
+  std::map<uint16_t, Ptr<const TraceSourceAccessor> > m_traceSources;
   /** Current list of path tokens. */
   std::vector<std::string> m_workStack;
-  /** The Config path. */
-  std::string m_path;
+  /** The objects matching the path during Resolve. */
+  std::vector<Ptr<Object> > *m_objects;
+  /** The contexts of m_objects. */
+  std::vector<std::string> *m_contexts;
 };
 
-Resolver::Resolver (std::string path)
-  : m_path (path)
-{
-  NS_LOG_FUNCTION (this << path);
-  Canonicalize ();
-}
-Resolver::~Resolver ()
+Path::Impl::Impl (std::string root, std::string leaf)
+  : m_root (root),
+    m_leaf (leaf),
+    m_objects (0),
+    m_contexts (0)
 {
-  NS_LOG_FUNCTION (this);
-}
-void
-Resolver::Canonicalize (void)
-{
-  NS_LOG_FUNCTION (this);
+  NS_LOG_FUNCTION (this << root << leaf);
 
   // ensure that we start and end with a '/'
-  std::string::size_type tmp = m_path.find ("/");
+  std::string::size_type tmp = m_root.find ("/");
   if (tmp != 0)
     {
       // no slash at start
-      m_path = "/" + m_path;
+      m_root = "/" + m_root;
     }
-  tmp = m_path.find_last_of ("/");
-  if (tmp != (m_path.size () - 1))
+  tmp = m_root.find_last_of ("/");
+  if (tmp != (m_root.size () - 1))
     {
       // no slash at end
-      m_path = m_path + "/";
+      m_root = m_root + "/";
+    }
+
+  std::string::size_type cur = 0;
+  std::string::size_type next;
+  while ((next = m_root.find ("/", cur + 1)) != std::string::npos)
+    {
+      m_items.push_back (m_root.substr (cur + 1, next - (cur + 1)));
+      m_matchers.push_back (ArrayMatcher (m_items.back ()));
+      cur = next;
     }
 }
 
-void 
-Resolver::Resolve (Ptr<Object> root)
+void
+Path::Impl::Resolve (std::vector<Ptr<Object> > &objects, std::vector<std::string> &contexts)
 {
-  NS_LOG_FUNCTION (this << root);
+  NS_LOG_FUNCTION (this);
+  m_objects = &objects;
+  m_contexts = &contexts;
+  for (uint32_t i = 0; i < GetRootNamespaceObjectN (); i++)
+    {
+      DoResolve (0, GetRootNamespaceObject (i));
+    }
 
-  DoResolve (m_path, root);
+  //
+  // See if we can do something with the object name service.  Starting with
+  // the root pointer zeroed indicates to the resolver that it should start
+  // looking at the root of the "/Names" namespace during this go.
+  //
+  DoResolve (0, 0);
+  m_objects = 0;
+  m_contexts = 0;
+}
+
+Ptr<const TraceSourceAccessor>
+Path::Impl::GetTraceSource (Ptr<Object> object)
+{
+  NS_LOG_FUNCTION (this << object);
+  TypeId tid = object->GetInstanceTypeId ();
+  std::map<uint16_t, Ptr<const TraceSourceAccessor> >::const_iterator i = m_traceSources.find (tid.GetUid ());
+  if (i != m_traceSources.end ())
+    {
+      return i->second;
+    }
+  Ptr<const TraceSourceAccessor> accessor = tid.LookupTraceSourceByName (m_leaf);
+  m_traceSources[tid.GetUid ()] = accessor;
+  return accessor;
 }
 
 std::string
-Resolver::GetResolvedPath (void) const
+Path::Impl::GetResolvedPath (void) const
 {
   NS_LOG_FUNCTION (this);
 
@@ -379,22 +477,70 @@ Resolver::GetResolvedPath (void) const
 }
 
 void 
-Resolver::DoResolveOne (Ptr<Object> object)
+Path::Impl::DoResolveOne (Ptr<Object> object)
 {
   NS_LOG_FUNCTION (this << object);
 
   NS_LOG_DEBUG ("resolved="<<GetResolvedPath ());
-  DoOne (object, GetResolvedPath ());
+  m_objects->push_back (object);
+  m_contexts->push_back (GetResolvedPath ());
+}
+
+const Path::Impl::Steps &
+Path::Impl::GetSteps (uint32_t item, TypeId tid)
+{
+  NS_LOG_FUNCTION (this << item << tid);
+  std::pair<uint32_t, uint16_t> key (item, tid.GetUid ());
+  std::map<std::pair<uint32_t, uint16_t>, Steps>::iterator found = m_steps.find (key);
+  if (found != m_steps.end ())
+    {
+      return found->second;
+    }
+  Steps &steps = m_steps[key];
+  std::string const &name = m_items[item];
+  TypeId nextTid = tid;
+  do
+    {
+      tid = nextTid;
+
+      for (uint32_t i = 0; i < tid.GetAttributeN (); i++)
+        {
+          struct TypeId::AttributeInformation info;
+          info = tid.GetAttribute (i);
+          if (info.name != name && name != "*")
+            {
+              continue;
+            }
+          Step step;
+          step.name = info.name;
+          step.accessor = info.accessor;
+          // attempt to cast to a pointer checker.
+          if (dynamic_cast<const PointerChecker *> (PeekPointer (info.checker)) != 0)
+            {
+              step.isPointer = true;
+              steps.push_back (step);
+            }
+          // attempt to cast to an object vector.
+          if (dynamic_cast<const ObjectPtrContainerChecker *> (PeekPointer (info.checker)) != 0)
+            {
+              step.isPointer = false;
+              steps.push_back (step);
+            }
+          // this could be anything else and we don't know what to do with it.
+          // So, we just ignore it.
+        }
+
+      nextTid = tid.GetParent ();
+    } while (nextTid != tid);
+  return steps;
 }
 
 void
-Resolver::DoResolve (std::string path, Ptr<Object> root)
+Path::Impl::DoResolve (uint32_t index, Ptr<Object> root)
 {
-  NS_LOG_FUNCTION (this << path << root);
-  NS_ASSERT ((path.find ("/")) == 0);
-  std::string::size_type next = path.find ("/", 1);
+  NS_LOG_FUNCTION (this << index << root);
 
-  if (next == std::string::npos)
+  if (index == m_items.size ())
     {
       //
       // If root is zero, we're beginning to see if we can use the object name 
@@ -410,8 +556,7 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
         }
       return;
     }
-  std::string item = path.substr (1, next-1);
-  std::string pathLeft = path.substr (next, path.size ()-next);
+  std::string const &item = m_items[index];
 
   //
   // If root is zero, we're beginning to see if we can use the object name 
@@ -422,11 +567,10 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
   //
   if (root == 0)
     {
-      std::string::size_type offset = path.find ("/Names");
-      if (offset == 0)
+      if (item.compare (0, 5, "Names") == 0)
         {
           m_workStack.push_back (item);
-          DoResolve (pathLeft, root);
+          DoResolve (index + 1, root);
           m_workStack.pop_back ();
           return;
         }
@@ -443,7 +587,7 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
     {
       NS_LOG_DEBUG ("Name system resolved item = " << item << " to " << namedObject);
       m_workStack.push_back (item);
-      DoResolve (pathLeft, namedObject);
+      DoResolve (index + 1, namedObject);
       m_workStack.pop_back ();
       return;
     }
@@ -463,79 +607,58 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
   if (dollarPos == 0)
     {
       // This is a call to GetObject
-      std::string tidString = item.substr (1, item.size () - 1);
-      NS_LOG_DEBUG ("GetObject="<<tidString<<" on path="<<GetResolvedPath ());
-      TypeId tid = TypeId::LookupByName (tidString);
-      Ptr<Object> object = root->GetObject<Object> (tid);
+      std::map<uint32_t, TypeId>::const_iterator found = m_tids.find (index);
+      if (found == m_tids.end ())
+        {
+          std::string tidString = item.substr (1, item.size () - 1);
+          found = m_tids.insert (std::make_pair (index, TypeId::LookupByName (tidString))).first;
+        }
+      NS_LOG_DEBUG ("GetObject="<<item<<" on path="<<GetResolvedPath ());
+      Ptr<Object> object = root->GetObject<Object> (found->second);
       if (object == 0)
         {
-          NS_LOG_DEBUG ("GetObject ("<<tidString<<") failed on path="<<GetResolvedPath ());
+          NS_LOG_DEBUG ("GetObject ("<<item<<") failed on path="<<GetResolvedPath ());
           return;
         }
       m_workStack.push_back (item);
-      DoResolve (pathLeft, object);
+      DoResolve (index + 1, object);
       m_workStack.pop_back ();
     }
   else 
     {
       // this is a normal attribute.
-      TypeId tid;
-      TypeId nextTid = root->GetInstanceTypeId ();
-      bool foundMatch = false;
-      
-      do
+      const Steps &steps = GetSteps (index, root->GetInstanceTypeId ());
+      for (Steps::const_iterator i = steps.begin (); i != steps.end (); ++i)
         {
-          tid = nextTid;
-          
-          for (uint32_t i = 0; i < tid.GetAttributeN(); i++)
+          if (i->isPointer)
             {
-              struct TypeId::AttributeInformation info;
-              info = tid.GetAttribute(i);
-              if (info.name != item && item != "*")
+              NS_LOG_DEBUG ("GetAttribute(ptr)="<<i->name<<" on path="<<GetResolvedPath ());
+              PointerValue ptr;
+              i->accessor->Get (PeekPointer (root), ptr);
+              Ptr<Object> object = ptr.Get<Object> ();
+              if (object == 0)
                 {
+                  NS_LOG_ERROR ("Requested object name=\""<<item<<
+                                "\" exists on path=\""<<GetResolvedPath ()<<"\""
+                                " but is null.");
                   continue;
                 }
-              // attempt to cast to a pointer checker.
-              const PointerChecker *ptr = dynamic_cast<const PointerChecker *> (PeekPointer (info.checker));
-              if (ptr != 0)
-                {
-                  NS_LOG_DEBUG ("GetAttribute(ptr)="<<info.name<<" on path="<<GetResolvedPath ());
-                  PointerValue ptr;
-                  root->GetAttribute (info.name, ptr);
-                  Ptr<Object> object = ptr.Get<Object> ();
-                  if (object == 0)
-                    {
-                      NS_LOG_ERROR ("Requested object name=\""<<item<<
-                                    "\" exists on path=\""<<GetResolvedPath ()<<"\""
-                                    " but is null.");
-                      continue;
-                    }
-                  foundMatch = true;
-                  m_workStack.push_back (info.name);
-                  DoResolve (pathLeft, object);
-                  m_workStack.pop_back ();
-                }
-              // attempt to cast to an object vector.
-              const ObjectPtrContainerChecker *vectorChecker = 
-                dynamic_cast<const ObjectPtrContainerChecker *> (PeekPointer (info.checker));
-              if (vectorChecker != 0)
-                {
-                  NS_LOG_DEBUG ("GetAttribute(vector)="<<info.name<<" on path="<<GetResolvedPath () << pathLeft);
-                  foundMatch = true;
-                  ObjectPtrContainerValue vector;
-                  root->GetAttribute (info.name, vector);
-                  m_workStack.push_back (info.name);
-                  DoArrayResolve (pathLeft, vector);
-                  m_workStack.pop_back ();
-                }
-              // this could be anything else and we don't know what to do with it.
-              // So, we just ignore it.
+              m_workStack.push_back (i->name);
+              DoResolve (index + 1, object);
+              m_workStack.pop_back ();
             }
-
-          nextTid = tid.GetParent ();
-        } while (nextTid != tid);
+          else
+            {
+              NS_LOG_DEBUG ("GetAttribute(vector)="<<i->name<<" on path="<<GetResolvedPath ());
+              ObjectPtrContainerValue vector;
+              i->accessor->Get (PeekPointer (root), vector);
+              m_workStack.push_back (i->name);
+              DoArrayResolve (index + 1, vector);
+              m_workStack.pop_back ();
+            }
+        }
       
-      if (!foundMatch)
+      if (steps.empty ())
         {
           NS_LOG_DEBUG ("Requested item="<<item<<" does not exist on path="<<GetResolvedPath ());
           return;
@@ -544,20 +667,29 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
 }
 
 void 
-Resolver::DoArrayResolve (std::string path, const ObjectPtrContainerValue &container)
+Path::Impl::DoArrayResolve (uint32_t index, const ObjectPtrContainerValue &container)
 {
-  NS_LOG_FUNCTION(this << path << &container);
-  NS_ASSERT (path != "");
-  NS_ASSERT ((path.find ("/")) == 0);
-  std::string::size_type next = path.find ("/", 1);
-  if (next == std::string::npos)
+  NS_LOG_FUNCTION(this << index << &container);
+  if (index == m_items.size ())
     {
       return;
     }
-  std::string item = path.substr (1, next-1);
-  std::string pathLeft = path.substr (next, path.size ()-next);
 
-  ArrayMatcher matcher = ArrayMatcher (item);
+  const ArrayMatcher &matcher = m_matchers[index];
+  uint32_t single;
+  if (matcher.IsSingleIndex (&single))
+    {
+      Ptr<Object> object = container.Get (single);
+      if (object != 0)
+        {
+          std::ostringstream oss;
+          oss << single;
+          m_workStack.push_back (oss.str ());
+          DoResolve (index + 1, object);
+          m_workStack.pop_back ();
+        }
+      return;
+    }
   ObjectPtrContainerValue::Iterator it;
   for (it = container.Begin (); it != container.End (); ++it)
     {
@@ -566,12 +698,126 @@ Resolver::DoArrayResolve (std::string path, const ObjectPtrContainerValue &conta
           std::ostringstream oss;
           oss << (*it).first;
           m_workStack.push_back (oss.str ());
-          DoResolve (pathLeft, (*it).second);
+          DoResolve (index + 1, (*it).second);
           m_workStack.pop_back ();
         }
     }
 }
 
+Path::Path (std::string path)
+  : m_path (path)
+{
+  NS_LOG_FUNCTION (this << path);
+  std::string::size_type slash = path.find_last_of ("/");
+  NS_ASSERT (slash != std::string::npos);
+  m_impl = Create<Impl> (path.substr (0, slash), path.substr (slash + 1, path.size () - (slash + 1)));
+}
+Path::Path (const Path &o)
+  : m_path (o.m_path),
+    m_impl (o.m_impl)
+{
+  NS_LOG_FUNCTION (this << &o);
+}
+Path &
+Path::operator = (const Path &o)
+{
+  NS_LOG_FUNCTION (this << &o);
+  m_path = o.m_path;
+  m_impl = o.m_impl;
+  return *this;
+}
+Path::~Path ()
+{
+  NS_LOG_FUNCTION (this);
+}
+std::string
+Path::GetPath (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_path;
+}
+MatchContainer
+Path::LookupMatches (void) const
+{
+  NS_LOG_FUNCTION (this);
+  std::vector<Ptr<Object> > objects;
+  std::vector<std::string> contexts;
+  m_impl->Resolve (objects, contexts);
+  return MatchContainer (objects, contexts, m_path.substr (0, m_path.find_last_of ("/")));
+}
+void
+Path::Set (const AttributeValue &value) const
+{
+  NS_LOG_FUNCTION (this << &value);
+  LookupMatches ().Set (m_impl->m_leaf, value);
+}
+void
+Path::Connect (const CallbackBase &cb) const
+{
+  NS_LOG_FUNCTION (this << &cb);
+  std::vector<Ptr<Object> > objects;
+  std::vector<std::string> contexts;
+  m_impl->Resolve (objects, contexts);
+  for (uint32_t i = 0; i < objects.size (); ++i)
+    {
+      Ptr<const TraceSourceAccessor> accessor = m_impl->GetTraceSource (objects[i]);
+      if (accessor != 0)
+        {
+          accessor->Connect (PeekPointer (objects[i]), contexts[i] + m_impl->m_leaf, cb);
+        }
+    }
+}
+void
+Path::ConnectWithoutContext (const CallbackBase &cb) const
+{
+  NS_LOG_FUNCTION (this << &cb);
+  std::vector<Ptr<Object> > objects;
+  std::vector<std::string> contexts;
+  m_impl->Resolve (objects, contexts);
+  for (uint32_t i = 0; i < objects.size (); ++i)
+    {
+      Ptr<const TraceSourceAccessor> accessor = m_impl->GetTraceSource (objects[i]);
+      if (accessor != 0)
+        {
+          accessor->ConnectWithoutContext (PeekPointer (objects[i]), cb);
+        }
+    }
+}
+void
+Path::Disconnect (const CallbackBase &cb) const
+{
+  NS_LOG_FUNCTION (this << &cb);
+  std::vector<Ptr<Object> > objects;
+  std::vector<std::string> contexts;
+  m_impl->Resolve (objects, contexts);
+  for (uint32_t i = 0; i < objects.size (); ++i)
+    {
+      Ptr<const TraceSourceAccessor> accessor = m_impl->GetTraceSource (objects[i]);
+      if (accessor != 0)
+        {
+          accessor->Disconnect (PeekPointer (objects[i]), contexts[i] + m_impl->m_leaf, cb);
+        }
+    }
+}
+void
+Path::DisconnectWithoutContext (const CallbackBase &cb) const
+{
+  NS_LOG_FUNCTION (this << &cb);
+  std::vector<Ptr<Object> > objects;
+  std::vector<std::string> contexts;
+  m_impl->Resolve (objects, contexts);
+  for (uint32_t i = 0; i < objects.size (); ++i)
+    {
+      Ptr<const TraceSourceAccessor> accessor = m_impl->GetTraceSource (objects[i]);
+      if (accessor != 0)
+        {
+          accessor->DisconnectWithoutContext (PeekPointer (objects[i]), cb);
+        }
+    }
+}
+
+} // namespace Config
+
 /** Config system implementation class. */
 class ConfigImpl : public Singleton<ConfigImpl>
 {
@@ -600,15 +846,6 @@ public:
   Ptr<Object> GetRootNamespaceObject (uint32_t i) const;
 
 private:
-  /**
-   * Break a Config path into the leading path and the last leaf token.
-   * \param [in] path The Config path.
-   * \param [in,out] root The leading part of the \p path,
-   *   up to the final slash.
-   * \param [in,out] leaf The trailing part of the \p path.
-   */
-  void ParsePath (std::string path, std::string *root, std::string *leaf) const;
-
   /** Container type to hold the root Config path tokens. */
   typedef std::vector<Ptr<Object> > Roots;
 
@@ -616,97 +853,43 @@ private:
   Roots m_roots;
 };
 
-void 
-ConfigImpl::ParsePath (std::string path, std::string *root, std::string *leaf) const
-{
-  NS_LOG_FUNCTION (this << path << root << leaf);
-
-  std::string::size_type slash = path.find_last_of ("/");
-  NS_ASSERT (slash != std::string::npos);
-  *root = path.substr (0, slash);
-  *leaf = path.substr (slash+1, path.size ()-(slash+1));
-  NS_LOG_FUNCTION (path << *root << *leaf);
-}
-
 void 
 ConfigImpl::Set (std::string path, const AttributeValue &value)
 {
   NS_LOG_FUNCTION (this << path << &value);
-
-  std::string root, leaf;
-  ParsePath (path, &root, &leaf);
-  Config::MatchContainer container = LookupMatches (root);
-  container.Set (leaf, value);
+  Config::Path (path).Set (value);
 }
 void 
 ConfigImpl::ConnectWithoutContext (std::string path, const CallbackBase &cb)
 {
   NS_LOG_FUNCTION (this << path << &cb);
-  std::string root, leaf;
-  ParsePath (path, &root, &leaf);
-  Config::MatchContainer container = LookupMatches (root);
-  container.ConnectWithoutContext (leaf, cb);
+  Config::Path (path).ConnectWithoutContext (cb);
 }
 void 
 ConfigImpl::DisconnectWithoutContext (std::string path, const CallbackBase &cb)
 {
   NS_LOG_FUNCTION (this << path << &cb);
-  std::string root, leaf;
-  ParsePath (path, &root, &leaf);
-  Config::MatchContainer container = LookupMatches (root);
-  container.DisconnectWithoutContext (leaf, cb);
+  Config::Path (path).DisconnectWithoutContext (cb);
 }
 void 
 ConfigImpl::Connect (std::string path, const CallbackBase &cb)
 {
   NS_LOG_FUNCTION (this << path << &cb);
-
-  std::string root, leaf;
-  ParsePath (path, &root, &leaf);
-  Config::MatchContainer container = LookupMatches (root);
-  container.Connect (leaf, cb);
+  Config::Path (path).Connect (cb);
 }
 void 
 ConfigImpl::Disconnect (std::string path, const CallbackBase &cb)
 {
   NS_LOG_FUNCTION (this << path << &cb);
-
-  std::string root, leaf;
-  ParsePath (path, &root, &leaf);
-  Config::MatchContainer container = LookupMatches (root);
-  container.Disconnect (leaf, cb);
+  Config::Path (path).Disconnect (cb);
 }
 
 Config::MatchContainer 
 ConfigImpl::LookupMatches (std::string path)
 {
   NS_LOG_FUNCTION (this << path);
-  class LookupMatchesResolver : public Resolver 
-  {
-  public:
-    LookupMatchesResolver (std::string path)
-      : Resolver (path)
-    {}
-    virtual void DoOne (Ptr<Object> object, std::string path) {
-      m_objects.push_back (object);
-      m_contexts.push_back (path);
-    }
-    std::vector<Ptr<Object> > m_objects;
-    std::vector<std::string> m_contexts;
-  } resolver = LookupMatchesResolver (path);
-  for (Roots::const_iterator i = m_roots.begin (); i != m_roots.end (); i++)
-    {
-      resolver.Resolve (*i);
-    }
-
-  //
-  // See if we can do something with the object name service.  Starting with
-  // the root pointer zeroed indicates to the resolver that it should start
-  // looking at the root of the "/Names" namespace during this go.
-  //
-  resolver.Resolve (0);
-
-  return Config::MatchContainer (resolver.m_objects, resolver.m_contexts, path);
+  // with an empty leaf, the objects of the whole path are matched
+  return Config::Path (path + "/").LookupMatches ();
 }
 
 void 
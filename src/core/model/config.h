@@ -250,6 +250,89 @@ private:
   std::string m_path;
 };
 
+/**
+ * \ingroup config
+ * \brief A Config path, compiled once to be resolved many times.
+ *
+ * Config::Set and Config::Connect parse their path and look up the
+ * attributes it names on every call.  A Path is parsed when it is
+ * constructed, and remembers the attributes and trace sources it finds
+ * for each TypeId it meets, so resolving it again, or resolving it
+ * over many objects of the same types, is much cheaper.
+ *
+ * Wiring a trace sink to many objects is fastest with a single path
+ * matching all of them, using wildcards or index ranges for the node and
+ * device indexes, rather than one path per object: the node and device
+ * lists are then walked once, and the context passed to the sink tells
+ * the objects apart.
+ */
+class Path
+{
+public:
+  /**
+   * \param [in] path A path to match attributes or trace sources, the
+   *        last item of the path being the name of the attribute or
+   *        of the trace source.
+   */
+  Path (std::string path);
+  /**
+   * Copy constructor.
+   *
+   * \param [in] o The path to copy, which shares its caches with the copy.
+   */
+  Path (const Path &o);
+  /**
+   * Assignment operator.
+   *
+   * \param [in] o The path to copy, which shares its caches with the copy.
+   * \returns This path.
+   */
+  Path & operator = (const Path &o);
+  ~Path ();
+
+  /**
+   * \returns The path.
+   */
+  std::string GetPath (void) const;
+  /**
+   * \returns A container of the objects which match the path, up to
+   *          the name of the attribute or trace source.
+   */
+  MatchContainer LookupMatches (void) const;
+  /**
+   * \param [in] value The value to set in all matching attributes.
+   * \sa ns3::Config::Set
+   */
+  void Set (const AttributeValue &value) const;
+  /**
+   * \param [in] cb The callback to connect to the matching trace sources.
+   * \sa ns3::Config::Connect
+   */
+  void Connect (const CallbackBase &cb) const;
+  /**
+   * \param [in] cb The callback to connect to the matching trace sources.
+   * \sa ns3::Config::ConnectWithoutContext
+   */
+  void ConnectWithoutContext (const CallbackBase &cb) const;
+  /**
+   * \param [in] cb The callback to disconnect from the matching trace sources.
+   * \sa ns3::Config::Disconnect
+   */
+  void Disconnect (const CallbackBase &cb) const;
+  /**
+   * \param [in] cb The callback to disconnect from the matching trace sources.
+   * \sa ns3::Config::DisconnectWithoutContext
+   */
+  void DisconnectWithoutContext (const CallbackBase &cb) const;
+
+private:
+  class Impl;
+  /** The path. */
+  std::string m_path;
+  /** The compiled path and its caches. */
+  Ptr<Impl> m_impl;
+};
+
 /**
  * \ingroup config
  * \param [in] path The path to perform a match against
@@ -0,0 +1,272 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "dary-heap-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+#include <algorithm>
+#include <cstring>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Implementation of ns3::DaryHeapScheduler class.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("DaryHeapScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (DaryHeapScheduler);
+
+TypeId
+DaryHeapScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DaryHeapScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<DaryHeapScheduler> ()
+  ;
+  return tid;
+}
+
+DaryHeapScheduler::DaryHeapScheduler ()
+  : m_keys (0),
+    m_capacity (0),
+    m_size (0)
+{
+  NS_LOG_FUNCTION (this);
+  Grow ();
+}
+
+DaryHeapScheduler::~DaryHeapScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+/*
+ * The root is stored at index 3, so that the children of index i,
+ * 4i-8 to 4i-5, always start on a multiple of four keys, that is
+ * on a 64-byte boundary of the aligned key array.
+ */
+uint32_t
+DaryHeapScheduler::FirstChild (uint32_t id)
+{
+  return 4 * id - 8;
+}
+
+uint32_t
+DaryHeapScheduler::Parent (uint32_t id)
+{
+  return id / 4 + 2;
+}
+
+uint32_t
+DaryHeapScheduler::End (void) const
+{
+  return kRoot + m_size;
+}
+
+bool
+DaryHeapScheduler::IsLess (const Key &a, const Key &b)
+{
+  return a.m_ts < b.m_ts || (a.m_ts == b.m_ts && a.m_uid < b.m_uid);
+}
+
+Scheduler::Event
+DaryHeapScheduler::GetEvent (uint32_t id) const
+{
+  const Key &key = m_keys[id];
+  const Payload &payload = m_payloads[key.m_slot];
+  Scheduler::Event ev;
+  ev.impl = payload.m_impl;
+  ev.key.m_ts = key.m_ts;
+  ev.key.m_uid = key.m_uid;
+  ev.key.m_context = payload.m_context;
+  return ev;
+}
+
+void
+DaryHeapScheduler::Grow (void)
+{
+  NS_LOG_FUNCTION (this << m_capacity);
+  uint32_t capacity = (m_capacity == 0) ? 64 : m_capacity * 2;
+  // std::vector only guarantees the alignment of Key, that is 8
+  // bytes, so allocate one extra cache line to align the array.
+  // The allocators we know of return 16-byte aligned blocks; if not,
+  // the heap still works, only with a less friendly layout.
+  std::vector<Key> storage (capacity + 4);
+  uintptr_t addr = reinterpret_cast<uintptr_t> (&storage[0]);
+  uintptr_t offset = 0;
+  if (addr % sizeof (Key) == 0)
+    {
+      offset = ((64 - addr % 64) % 64) / sizeof (Key);
+    }
+  Key *keys = &storage[offset];
+  if (m_size > 0)
+    {
+      std::memcpy (keys + kRoot, m_keys + kRoot, m_size * sizeof (Key));
+    }
+  m_storage.swap (storage);
+  m_keys = keys;
+  m_capacity = capacity;
+}
+
+void
+DaryHeapScheduler::SiftUp (uint32_t id, const Key &key)
+{
+  while (id > kRoot)
+    {
+      uint32_t parent = Parent (id);
+      if (!IsLess (key, m_keys[parent]))
+        {
+          break;
+        }
+      m_keys[id] = m_keys[parent];
+      id = parent;
+    }
+  m_keys[id] = key;
+}
+
+void
+DaryHeapScheduler::SiftDown (uint32_t id, const Key &key)
+{
+  uint32_t end = End ();
+  while (true)
+    {
+      uint32_t child = FirstChild (id);
+      if (child >= end)
+        {
+          break;
+        }
+      uint32_t last = std::min (child + 4, end);
+      uint32_t smallest = child;
+      for (uint32_t i = child + 1; i < last; i++)
+        {
+          if (IsLess (m_keys[i], m_keys[smallest]))
+            {
+              smallest = i;
+            }
+        }
+      if (!IsLess (m_keys[smallest], key))
+        {
+          break;
+        }
+      m_keys[id] = m_keys[smallest];
+      id = smallest;
+    }
+  m_keys[id] = key;
+}
+
+void
+DaryHeapScheduler::RemoveAt (uint32_t id)
+{
+  NS_LOG_FUNCTION (this << id);
+  NS_ASSERT (id >= kRoot && id < End ());
+  m_freeSlots.push_back (m_keys[id].m_slot);
+  m_size--;
+  uint32_t last = End ();
+  if (id == last)
+    {
+      return;
+    }
+  Key moved = m_keys[last];
+  if (id > kRoot && IsLess (moved, m_keys[Parent (id)]))
+    {
+      SiftUp (id, moved);
+    }
+  else
+    {
+      SiftDown (id, moved);
+    }
+}
+
+void
+DaryHeapScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.key.m_ts << ev.key.m_uid);
+  uint32_t slot;
+  if (m_freeSlots.empty ())
+    {
+      slot = m_payloads.size ();
+      m_payloads.push_back (Payload ());
+    }
+  else
+    {
+      slot = m_freeSlots.back ();
+      m_freeSlots.pop_back ();
+    }
+  m_payloads[slot].m_impl = ev.impl;
+  m_payloads[slot].m_context = ev.key.m_context;
+
+  if (End () == m_capacity)
+    {
+      Grow ();
+    }
+  Key key;
+  key.m_ts = ev.key.m_ts;
+  key.m_uid = ev.key.m_uid;
+  key.m_slot = slot;
+  m_size++;
+  SiftUp (End () - 1, key);
+}
+
+bool
+DaryHeapScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_size == 0;
+}
+
+Scheduler::Event
+DaryHeapScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  return GetEvent (kRoot);
+}
+
+Scheduler::Event
+DaryHeapScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  Event next = GetEvent (kRoot);
+  RemoveAt (kRoot);
+  return next;
+}
+
+void
+DaryHeapScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << &ev);
+  uint32_t uid = ev.key.m_uid;
+  uint32_t end = End ();
+  for (uint32_t i = kRoot; i < end; i++)
+    {
+      if (uid == m_keys[i].m_uid)
+        {
+          NS_ASSERT (m_payloads[m_keys[i].m_slot].m_impl == ev.impl);
+          RemoveAt (i);
+          return;
+        }
+    }
+  NS_ASSERT (false);
+}
+
+} // namespace ns3
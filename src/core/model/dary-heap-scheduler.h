@@ -0,0 +1,164 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef DARY_HEAP_SCHEDULER_H
+#define DARY_HEAP_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Declaration of ns3::DaryHeapScheduler class.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a cache-friendly 4-ary implicit heap event scheduler
+ *
+ * Compared to the HeapScheduler, this heap differs in three ways:
+ *  - each node has four children instead of two, which halves the
+ *    depth of the heap;
+ *  - the heap only holds 16-byte keys (timestamp, uid and the index of
+ *    the event in a separate payload array), so sifting never touches
+ *    the EventImpl pointer nor the context of the events moved;
+ *  - the key array is aligned on a 64-byte boundary and offset so that
+ *    the four children of any node share a single cache line.
+ *
+ * As a result, a sift-down touches one cache line per level, and the
+ * payloads stay in place from Insert until the event is removed.
+ */
+class DaryHeapScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  DaryHeapScheduler ();
+  /** Destructor. */
+  virtual ~DaryHeapScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+private:
+  /** Sort key stored in the heap. */
+  struct Key
+  {
+    uint64_t m_ts;    //!< Event time stamp.
+    uint32_t m_uid;   //!< Event unique id.
+    uint32_t m_slot;  //!< Index of the event in m_payloads.
+  };
+  /** Event data which does not take part in the ordering. */
+  struct Payload
+  {
+    EventImpl *m_impl;   //!< Pointer to the event implementation.
+    uint32_t m_context;  //!< Event context.
+  };
+
+  /**
+   * Compare (less than) two keys.
+   *
+   * \param [in] a The first key.
+   * \param [in] b The second key.
+   * \returns \c true if \c a < \c b
+   */
+  static inline bool IsLess (const Key &a, const Key &b);
+  /**
+   * Get the index of the first child of a node.
+   *
+   * \param [in] id The parent index.
+   * \returns The index of the first of the four children.
+   */
+  static inline uint32_t FirstChild (uint32_t id);
+  /**
+   * Get the parent index of a node.
+   *
+   * \param [in] id The child index.
+   * \returns The index of the parent of \p id.
+   */
+  static inline uint32_t Parent (uint32_t id);
+  /**
+   * Get the index one past the last element.
+   *
+   * \returns The end index.
+   */
+  inline uint32_t End (void) const;
+  /**
+   * Build the Event stored at some index.
+   *
+   * \param [in] id The index.
+   * \returns The event.
+   */
+  inline Scheduler::Event GetEvent (uint32_t id) const;
+  /**
+   * Move a key up from a hole until the heap order is restored.
+   *
+   * \param [in] id The index of the hole.
+   * \param [in] key The key to store.
+   */
+  void SiftUp (uint32_t id, const Key &key);
+  /**
+   * Move a key down from a hole until the heap order is restored.
+   *
+   * \param [in] id The index of the hole.
+   * \param [in] key The key to store.
+   */
+  void SiftDown (uint32_t id, const Key &key);
+  /**
+   * Remove the key at some index from the heap and release its payload.
+   *
+   * \param [in] id The index of the key to remove.
+   */
+  void RemoveAt (uint32_t id);
+  /**
+   * Grow the key array to hold at least one more key.
+   */
+  void Grow (void);
+
+  /** Index of the root in the key array. */
+  static const uint32_t kRoot = 3;
+
+  /** Raw key storage, with room for the alignment adjustment. */
+  std::vector<Key> m_storage;
+  /** The 64-byte aligned key array, of which the first kRoot entries are unused. */
+  Key *m_keys;
+  /** Number of keys m_keys can hold, including the unused ones. */
+  uint32_t m_capacity;
+  /** Number of events in the heap. */
+  uint32_t m_size;
+  /** Payloads of the events, indexed by Key::m_slot. */
+  std::vector<Payload> m_payloads;
+  /** Unused entries of m_payloads. */
+  std::vector<uint32_t> m_freeSlots;
+};
+
+} // namespace ns3
+
+#endif /* DARY_HEAP_SCHEDULER_H */
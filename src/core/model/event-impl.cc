@@ -20,6 +20,7 @@
 
 #include "event-impl.h"
 #include "log.h"
+#include <new>
 
 /**
  * \file
@@ -31,6 +32,157 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("EventImpl");
 
+namespace {
+
+/** Size classes are multiples of this many bytes. */
+const std::size_t kPoolGranularity = 16;
+/** Number of size classes: events up to 256 bytes are pooled. */
+const std::size_t kPoolClasses = 16;
+/** Maximum number of free blocks kept per size class. */
+const uint32_t kPoolMaxCached = 65536;
+
+/**
+ * \ingroup events
+ * Per-thread free lists of EventImpl memory blocks.
+ *
+ * Each block is individually obtained from the global heap, so a
+ * block can be released to the pool of any thread, and a pool can
+ * give all its blocks back when its thread exits.
+ */
+class EventImplPool
+{
+public:
+  EventImplPool ();
+  ~EventImplPool ();
+  /**
+   * \param [in] size The requested size.
+   * \returns A block of at least \p size bytes.
+   */
+  void * Allocate (std::size_t size);
+  /**
+   * \param [in] p The block to release.
+   * \param [in] size The size which was requested for \p p.
+   */
+  void Release (void *p, std::size_t size);
+
+  /** The allocation counters. */
+  EventImpl::PoolStats m_stats;
+
+private:
+  /** A free block, linked through its first bytes. */
+  struct FreeBlock
+  {
+    FreeBlock *m_next;  /**< The next free block of the same class. */
+  };
+  FreeBlock *m_free[kPoolClasses];   /**< Free list heads. */
+  uint32_t m_nFree[kPoolClasses];    /**< Free list lengths. */
+  bool m_alive;                      /**< False once destroyed. */
+};
+
+EventImplPool::EventImplPool ()
+  : m_alive (true)
+{
+  m_stats.m_hits = 0;
+  m_stats.m_misses = 0;
+  m_stats.m_releases = 0;
+  m_stats.m_cached = 0;
+  for (std::size_t i = 0; i < kPoolClasses; i++)
+    {
+      m_free[i] = 0;
+      m_nFree[i] = 0;
+    }
+}
+
+EventImplPool::~EventImplPool ()
+{
+  for (std::size_t i = 0; i < kPoolClasses; i++)
+    {
+      while (m_free[i] != 0)
+        {
+          FreeBlock *block = m_free[i];
+          m_free[i] = block->m_next;
+          ::operator delete (block);
+        }
+      m_nFree[i] = 0;
+    }
+  m_stats.m_cached = 0;
+  // events released during the destruction of static objects
+  // go straight back to the global heap.
+  m_alive = false;
+}
+
+void *
+EventImplPool::Allocate (std::size_t size)
+{
+  std::size_t cls = (size + kPoolGranularity - 1) / kPoolGranularity - 1;
+  if (cls < kPoolClasses && m_free[cls] != 0)
+    {
+      FreeBlock *block = m_free[cls];
+      m_free[cls] = block->m_next;
+      m_nFree[cls]--;
+      m_stats.m_cached--;
+      m_stats.m_hits++;
+      return block;
+    }
+  m_stats.m_misses++;
+  if (cls < kPoolClasses)
+    {
+      // allocate the full class size so the block can be reused
+      // by any event of the same class.
+      return ::operator new ((cls + 1) * kPoolGranularity);
+    }
+  return ::operator new (size);
+}
+
+void
+EventImplPool::Release (void *p, std::size_t size)
+{
+  std::size_t cls = (size + kPoolGranularity - 1) / kPoolGranularity - 1;
+  if (!m_alive || cls >= kPoolClasses || m_nFree[cls] >= kPoolMaxCached)
+    {
+      ::operator delete (p);
+      return;
+    }
+  FreeBlock *block = static_cast<FreeBlock *> (p);
+  block->m_next = m_free[cls];
+  m_free[cls] = block;
+  m_nFree[cls]++;
+  m_stats.m_cached++;
+  m_stats.m_releases++;
+}
+
+/**
+ * The pool of the calling thread.  It is thread_local in every build:
+ * RealtimeSimulatorImpl::ScheduleWithContext creates events in the
+ * threads of the callers.
+ */
+thread_local EventImplPool g_eventImplPool;
+
+} // unnamed namespace
+
+EventImpl::PoolStats
+EventImpl::GetPoolStats (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return g_eventImplPool.m_stats;
+}
+
+void *
+EventImpl::operator new (std::size_t size)
+{
+  return g_eventImplPool.Allocate (size);
+}
+
+void
+EventImpl::operator delete (void *p, std::size_t size)
+{
+  if (p == 0)
+    {
+      return;
+    }
+  g_eventImplPool.Release (p, size);
+}
+
 EventImpl::~EventImpl ()
 {
   NS_LOG_FUNCTION (this);
@@ -21,6 +21,7 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <cstddef>
 #include "simple-ref-count.h"
 
 /**
@@ -66,6 +67,46 @@ public:
    */
   bool IsCancelled (void);
 
+  /**
+   * \brief Allocation counters of the EventImpl pool of a thread.
+   *
+   * Events are small and short-lived, so their memory is recycled
+   * through per-thread free lists, one per 16-byte size class, instead
+   * of going back to the global heap each time.  Events larger than
+   * the biggest size class always use the global heap.
+   */
+  struct PoolStats
+  {
+    uint64_t m_hits;      /**< Allocations served from a free list. */
+    uint64_t m_misses;    /**< Allocations served by the global heap. */
+    uint64_t m_releases;  /**< Events returned to a free list. */
+    uint64_t m_cached;    /**< Blocks currently held in the free lists. */
+  };
+  /**
+   * Get the allocation counters of the pool of the calling thread.
+   *
+   * \returns The counters.
+   */
+  static PoolStats GetPoolStats (void);
+  /**
+   * Allocate the memory of an event from the pool of the calling thread.
+   *
+   * \param [in] size The size of the event object.
+   * \returns The allocated memory.
+   */
+  static void * operator new (std::size_t size);
+  /**
+   * Return the memory of an event to the pool of the calling thread.
+   *
+   * The memory may have been allocated by another thread, e.g. for
+   * events scheduled from outside the simulation thread of the
+   * RealtimeSimulatorImpl: blocks simply migrate between pools.
+   *
+   * \param [in] p The memory to release.
+   * \param [in] size The size of the most derived event object.
+   */
+  static void operator delete (void *p, std::size_t size);
+
 protected:
   /**
    * Implementation for Invoke().
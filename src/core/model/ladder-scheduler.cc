@@ -0,0 +1,391 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ladder-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+#include "unused.h"
+#include <algorithm>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Implementation of ns3::LadderScheduler class.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LadderScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (LadderScheduler);
+
+namespace {
+
+/**
+ * \ingroup scheduler
+ * Order events by decreasing EventKey, so that the earliest
+ * event of a heap built with it sits at its front.
+ */
+struct LaterEvent
+{
+  /**
+   * \param [in] a The first event.
+   * \param [in] b The second event.
+   * \returns \c true if \c a is after \c b
+   */
+  bool operator () (const Scheduler::Event &a, const Scheduler::Event &b) const
+  {
+    return b.key < a.key;
+  }
+};
+
+/**
+ * \ingroup scheduler
+ * Remove an event from an unsorted bucket.
+ *
+ * \param [in,out] bucket The bucket.
+ * \param [in] ev The event to remove.
+ * \returns \c true if the event was found.
+ */
+bool
+RemoveFromBucket (std::vector<Scheduler::Event> &bucket, const Scheduler::Event &ev)
+{
+  for (std::vector<Scheduler::Event>::iterator i = bucket.begin (); i != bucket.end (); ++i)
+    {
+      if (i->key.m_uid == ev.key.m_uid)
+        {
+          NS_ASSERT (i->impl == ev.impl);
+          *i = bucket.back ();
+          bucket.pop_back ();
+          return true;
+        }
+    }
+  return false;
+}
+
+} // unnamed namespace
+
+TypeId
+LadderScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<LadderScheduler> ()
+  ;
+  return tid;
+}
+
+LadderScheduler::LadderScheduler ()
+  : m_topMin (~0ULL),
+    m_topMax (0),
+    m_topStart (0),
+    m_nRungs (0),
+    m_bottomLimit (kThreshold),
+    m_size (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LadderScheduler::~LadderScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint64_t
+LadderScheduler::CurrentStart (uint32_t rung) const
+{
+  const Rung &r = m_rungs[rung];
+  return r.m_start + r.m_current * r.m_width;
+}
+
+uint32_t
+LadderScheduler::Hash (uint32_t rung, uint64_t ts) const
+{
+  const Rung &r = m_rungs[rung];
+  NS_ASSERT (ts >= r.m_start);
+  uint64_t bucket = (ts - r.m_start) / r.m_width;
+  NS_ASSERT (bucket < r.m_nBuckets);
+  return static_cast<uint32_t> (bucket);
+}
+
+uint32_t
+LadderScheduler::FindRung (uint64_t ts) const
+{
+  uint32_t rung = 0;
+  while (rung < m_nRungs && ts < CurrentStart (rung))
+    {
+      rung++;
+    }
+  return rung;
+}
+
+uint32_t
+LadderScheduler::AddRung (uint64_t start, uint64_t limit, uint32_t nEvents)
+{
+  NS_LOG_FUNCTION (this << start << limit << nEvents);
+  NS_ASSERT (limit > start && nEvents > 0);
+  if (m_nRungs == m_rungs.size ())
+    {
+      m_rungs.push_back (Rung ());
+    }
+  Rung &r = m_rungs[m_nRungs];
+  r.m_start = start;
+  // round up, so that the buckets cover all of [start, limit)
+  r.m_width = (limit - start - 1) / nEvents + 1;
+  r.m_nBuckets = static_cast<uint32_t> ((limit - start - 1) / r.m_width + 1);
+  r.m_current = 0;
+  r.m_nEvents = 0;
+  if (r.m_buckets.size () < r.m_nBuckets)
+    {
+      r.m_buckets.resize (r.m_nBuckets);
+    }
+  NS_LOG_LOGIC ("rung " << m_nRungs << ": start=" << r.m_start <<
+                ", width=" << r.m_width << ", buckets=" << r.m_nBuckets);
+  return m_nRungs++;
+}
+
+void
+LadderScheduler::InsertBottom (const Event &ev)
+{
+  m_bottom.push_back (ev);
+  std::push_heap (m_bottom.begin (), m_bottom.end (), LaterEvent ());
+}
+
+void
+LadderScheduler::FillBottom (Bucket &events)
+{
+  NS_ASSERT (m_bottom.empty ());
+  m_bottom.swap (events);
+  std::make_heap (m_bottom.begin (), m_bottom.end (), LaterEvent ());
+  m_bottomLimit = kThreshold;
+}
+
+void
+LadderScheduler::SpillBottom (void)
+{
+  NS_LOG_FUNCTION (this);
+  // All of Bottom lies before the current bucket of the lowest rung
+  // (or before Top when the ladder is empty), so a new rung covering
+  // up to that point keeps the tiers ordered.
+  uint64_t start = m_bottom.front ().key.m_ts;
+  uint64_t end = start;
+  for (Bucket::const_iterator i = m_bottom.begin (); i != m_bottom.end (); ++i)
+    {
+      end = std::max (end, i->key.m_ts);
+    }
+  uint64_t limit = (m_nRungs == 0) ? m_topStart : CurrentStart (m_nRungs - 1);
+  if (m_nRungs == kMaxRungs || end == start)
+    {
+      // cannot spread those events any further: let Bottom grow, and
+      // only try again once it has doubled, so that a burst of events
+      // at a single timestamp costs O(log n) per event.
+      m_bottomLimit = 2 * m_bottom.size ();
+      return;
+    }
+  uint32_t rung = AddRung (start, limit, m_bottom.size ());
+  Rung &r = m_rungs[rung];
+  for (Bucket::const_iterator i = m_bottom.begin (); i != m_bottom.end (); ++i)
+    {
+      r.m_buckets[Hash (rung, i->key.m_ts)].push_back (*i);
+    }
+  r.m_nEvents = m_bottom.size ();
+  m_bottom.clear ();
+  m_bottomLimit = kThreshold;
+}
+
+void
+LadderScheduler::TransferTop (void)
+{
+  NS_LOG_FUNCTION (this << m_top.size () << m_topMin << m_topMax);
+  NS_ASSERT (!m_top.empty () && m_nRungs == 0 && m_bottom.empty ());
+  uint64_t limit = m_topMax + 1;
+  if (m_top.size () <= kThreshold || m_topMin == m_topMax)
+    {
+      FillBottom (m_top);
+    }
+  else
+    {
+      uint32_t rung = AddRung (m_topMin, limit, m_top.size ());
+      Rung &r = m_rungs[rung];
+      for (Bucket::const_iterator i = m_top.begin (); i != m_top.end (); ++i)
+        {
+          r.m_buckets[Hash (rung, i->key.m_ts)].push_back (*i);
+        }
+      r.m_nEvents = m_top.size ();
+      m_top.clear ();
+    }
+  m_topStart = limit;
+  m_topMin = ~0ULL;
+  m_topMax = 0;
+}
+
+void
+LadderScheduler::Refill (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_bottom.empty () && m_size > 0);
+  while (true)
+    {
+      if (m_nRungs == 0)
+        {
+          TransferTop ();
+          if (!m_bottom.empty ())
+            {
+              return;
+            }
+        }
+      uint32_t rung = m_nRungs - 1;
+      Rung &r = m_rungs[rung];
+      if (r.m_nEvents == 0)
+        {
+          m_nRungs--;
+          continue;
+        }
+      while (r.m_buckets[r.m_current].empty ())
+        {
+          r.m_current++;
+        }
+      NS_ASSERT (r.m_current < r.m_nBuckets);
+      Bucket &bucket = r.m_buckets[r.m_current];
+      uint64_t bucketStart = CurrentStart (rung);
+      r.m_current++;
+      r.m_nEvents -= bucket.size ();
+      if (bucket.size () > kThreshold && r.m_width > 1 && m_nRungs < kMaxRungs)
+        {
+          // too many events to sort: spread them on a finer rung.
+          // Note that AddRung may reallocate m_rungs.
+          Bucket events;
+          events.swap (bucket);
+          uint32_t child = AddRung (bucketStart, bucketStart + m_rungs[rung].m_width,
+                                   events.size ());
+          Rung &c = m_rungs[child];
+          for (Bucket::const_iterator i = events.begin (); i != events.end (); ++i)
+            {
+              c.m_buckets[Hash (child, i->key.m_ts)].push_back (*i);
+            }
+          c.m_nEvents = events.size ();
+          // give the storage back to the parent bucket for later reuse.
+          events.clear ();
+          m_rungs[rung].m_buckets[m_rungs[rung].m_current - 1].swap (events);
+          continue;
+        }
+      FillBottom (bucket);
+      return;
+    }
+}
+
+void
+LadderScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.key.m_ts << ev.key.m_uid);
+  uint64_t ts = ev.key.m_ts;
+  m_size++;
+  if (ts >= m_topStart)
+    {
+      m_top.push_back (ev);
+      m_topMin = std::min (m_topMin, ts);
+      m_topMax = std::max (m_topMax, ts);
+      return;
+    }
+  uint32_t rung = FindRung (ts);
+  if (rung < m_nRungs)
+    {
+      Rung &r = m_rungs[rung];
+      r.m_buckets[Hash (rung, ts)].push_back (ev);
+      r.m_nEvents++;
+      return;
+    }
+  InsertBottom (ev);
+  if (m_bottom.size () > m_bottomLimit)
+    {
+      SpillBottom ();
+    }
+}
+
+bool
+LadderScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_size == 0;
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  if (m_bottom.empty ())
+    {
+      // Refilling Bottom does not change the set of events held, only
+      // the tier they are stored in.
+      const_cast<LadderScheduler *> (this)->Refill ();
+    }
+  return m_bottom.front ();
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  if (m_bottom.empty ())
+    {
+      Refill ();
+    }
+  std::pop_heap (m_bottom.begin (), m_bottom.end (), LaterEvent ());
+  Event next = m_bottom.back ();
+  m_bottom.pop_back ();
+  m_size--;
+  NS_LOG_LOGIC ("remove ts=" << next.key.m_ts << ", uid=" << next.key.m_uid);
+  return next;
+}
+
+void
+LadderScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << &ev);
+  NS_ASSERT (!IsEmpty ());
+  uint64_t ts = ev.key.m_ts;
+  if (ts >= m_topStart)
+    {
+      bool found = RemoveFromBucket (m_top, ev);
+      NS_ASSERT (found);
+      NS_UNUSED (found);
+      m_size--;
+      return;
+    }
+  uint32_t rung = FindRung (ts);
+  if (rung < m_nRungs)
+    {
+      Rung &r = m_rungs[rung];
+      bool found = RemoveFromBucket (r.m_buckets[Hash (rung, ts)], ev);
+      NS_ASSERT (found);
+      NS_UNUSED (found);
+      r.m_nEvents--;
+      m_size--;
+      return;
+    }
+  bool found = RemoveFromBucket (m_bottom, ev);
+  NS_ASSERT (found);
+  NS_UNUSED (found);
+  std::make_heap (m_bottom.begin (), m_bottom.end (), LaterEvent ());
+  m_size--;
+}
+
+} // namespace ns3
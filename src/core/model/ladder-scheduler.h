@@ -0,0 +1,178 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Declaration of ns3::LadderScheduler class.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler implements the Ladder Queue described in
+ * "Ladder Queue: An O(1) Priority Queue Structure for Large-Scale
+ * Discrete Event Simulation" by W. T. Tang, R. S. M. Goh and
+ * I. L.-J. Thng (ACM TOMACS, 2005).
+ *
+ * The event list is split in three tiers:
+ *  - Top: an unsorted vector which receives all the events scheduled
+ *    at or after m_topStart.  Only the minimum and maximum timestamps
+ *    are tracked.
+ *  - Ladder: up to kMaxRungs rungs of buckets.  The first rung is
+ *    created from the whole Top when the lower tiers run dry; a bucket
+ *    holding more than kThreshold events is spawned into a finer rung
+ *    instead of being sorted.
+ *  - Bottom: a small binary heap from which events are dequeued.  When
+ *    its events cannot be spread on a new rung (they share a single
+ *    timestamp, or kMaxRungs is reached) it keeps growing as a heap, so
+ *    that a burst of simultaneous events costs O(log n) per event.
+ *
+ * Unlike the CalendarScheduler, the bucket width is derived from the
+ * actual spread of the events being transferred every time a rung is
+ * created, so no global resize is ever needed and skewed timestamp
+ * distributions are handled by adding rungs locally.  Insert and
+ * RemoveNext run in O(1) amortized time; Remove is linear in the size
+ * of the bucket holding the event.
+ */
+class LadderScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  LadderScheduler ();
+  /** Destructor. */
+  virtual ~LadderScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+private:
+  /** Unsorted list of events. */
+  typedef std::vector<Scheduler::Event> Bucket;
+
+  /** One rung of the ladder. */
+  struct Rung
+  {
+    uint64_t m_start;              //!< Timestamp of the start of the first bucket.
+    uint64_t m_width;              //!< Duration of a bucket, in dimensionless time units.
+    uint32_t m_nBuckets;           //!< Number of buckets in use.
+    uint32_t m_current;            //!< Index of the next bucket to be dequeued.
+    uint32_t m_nEvents;            //!< Number of events held in this rung.
+    std::vector<Bucket> m_buckets; //!< Bucket storage, reused across rungs.
+  };
+
+  /** Maximum number of events moved to Bottom without spawning a new rung. */
+  static const uint32_t kThreshold = 50;
+  /** Maximum number of rungs in the ladder. */
+  static const uint32_t kMaxRungs = 8;
+
+  /**
+   * Get the timestamp at which the next bucket of a rung starts.
+   *
+   * Events strictly before this timestamp belong to a lower rung
+   * or to Bottom.
+   *
+   * \param [in] rung The rung index.
+   * \returns The start of the current bucket of \p rung.
+   */
+  inline uint64_t CurrentStart (uint32_t rung) const;
+  /**
+   * Find the rung an event with a given timestamp belongs to.
+   *
+   * \param [in] ts The dimensionless timestamp.
+   * \returns The rung index, or m_nRungs if the event belongs to Bottom.
+   */
+  uint32_t FindRung (uint64_t ts) const;
+  /**
+   * Compute the bucket index of a timestamp in a rung.
+   *
+   * \param [in] rung The rung index.
+   * \param [in] ts The dimensionless timestamp.
+   * \returns The bucket index.
+   */
+  inline uint32_t Hash (uint32_t rung, uint64_t ts) const;
+  /**
+   * Append a new rung covering [start, limit).
+   *
+   * \param [in] start The first timestamp covered.
+   * \param [in] limit The first timestamp not covered.
+   * \param [in] nEvents The number of events which will be inserted.
+   * \returns The index of the new rung.
+   */
+  uint32_t AddRung (uint64_t start, uint64_t limit, uint32_t nEvents);
+  /**
+   * Insert an event in the Bottom heap.
+   *
+   * \param [in] ev The event.
+   */
+  void InsertBottom (const Scheduler::Event &ev);
+  /**
+   * Replace the empty Bottom with a set of events.
+   *
+   * \param [in,out] events The events, swapped with the storage of Bottom.
+   */
+  void FillBottom (Bucket &events);
+  /** Move the content of Bottom to a new rung, if it grew too large. */
+  void SpillBottom (void);
+  /** Move the events of Top to the ladder. */
+  void TransferTop (void);
+  /** Refill Bottom from the ladder and Top, which must not be empty. */
+  void Refill (void);
+
+  /** Events scheduled at or after m_topStart. */
+  Bucket m_top;
+  /** Smallest timestamp in Top. */
+  uint64_t m_topMin;
+  /** Largest timestamp in Top. */
+  uint64_t m_topMax;
+  /** Events with a timestamp at or after this value are stored in Top. */
+  uint64_t m_topStart;
+  /** The rungs, of which only the first m_nRungs are in use. */
+  std::vector<Rung> m_rungs;
+  /** Number of rungs in use. */
+  uint32_t m_nRungs;
+  /** Heap of events ordered by LaterEvent: the next event is at the front. */
+  Bucket m_bottom;
+  /** Size of Bottom above which it is spilled to a new rung. */
+  uint32_t m_bottomLimit;
+  /** Total number of events in the scheduler. */
+  uint32_t m_size;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
@@ -82,19 +82,35 @@ ObjectBase::ConstructSelf (const AttributeConstructionList &attributes)
   // loop over the inheritance tree back to the Object base class.
   NS_LOG_FUNCTION (this << &attributes);
   TypeId tid = GetInstanceTypeId ();
+  // the env var is the same for every attribute: read it once.
+  std::string env;
+#ifdef HAVE_GETENV
+  char *envVar = getenv ("NS_ATTRIBUTE_DEFAULT");
+  if (envVar != 0)
+    {
+      env = std::string (envVar);
+    }
+#endif /* HAVE_GETENV */
   do {
       // loop over all attributes in object type
       NS_LOG_DEBUG ("construct tid="<<tid.GetName ()<<", params="<<tid.GetAttributeN ());
       for (uint32_t i = 0; i < tid.GetAttributeN (); i++)
         {
-          struct TypeId::AttributeInformation info = tid.GetAttribute(i);
+          // the setters can register a TypeId, which moves the attribute
+          // information: copy what is needed first.
+          const struct TypeId::AttributeInformation &peeked = tid.PeekAttribute (i);
+          const std::string attrName = peeked.name;
+          const uint32_t flags = peeked.flags;
+          const Ptr<const AttributeAccessor> accessor = peeked.accessor;
+          const Ptr<const AttributeChecker> checker = peeked.checker;
+          const Ptr<const AttributeValue> initialValue = peeked.initialValue;
           NS_LOG_DEBUG ("try to construct \""<< tid.GetName ()<<"::"<<
-                        info.name <<"\"");
+                        attrName <<"\"");
           // is this attribute stored in this AttributeConstructionList instance ?
-          Ptr<AttributeValue> value = attributes.Find(info.checker);
+          Ptr<AttributeValue> value = attributes.Find(checker);
           // See if this attribute should not be set here in the
           // constructor.
-          if (!(info.flags & TypeId::ATTR_CONSTRUCT))
+          if (!(flags & TypeId::ATTR_CONSTRUCT))
             {
               // Handle this attribute if it should not be 
               // set here.
@@ -109,62 +125,66 @@ ObjectBase::ConstructSelf (const AttributeConstructionList &attributes)
                   // This is an error because this attribute is not
                   // settable in its constructor but is present in
                   // the AttributeConstructionList.
-                  NS_FATAL_ERROR ("Attribute name="<<info.name<<" tid="<<tid.GetName () << ": initial value cannot be set using attributes");
+                  NS_FATAL_ERROR ("Attribute name="<<attrName<<" tid="<<tid.GetName () << ": initial value cannot be set using attributes");
                 }
             }
           bool found = false;
           if (value != 0)
             {
               // We have a matching attribute value.
-              if (DoSet (info.accessor, info.checker, *value))
+              if (DoSet (accessor, checker, *value))
                 {
                   NS_LOG_DEBUG ("construct \""<< tid.GetName ()<<"::"<<
-                                info.name<<"\"");
+                                attrName<<"\"");
                   found = true;
                   continue;
                 }
             }              
-          if (!found)
+          if (!found && !env.empty ())
             {
               // No matching attribute value so we try to look at the env var.
-#ifdef HAVE_GETENV
-              char *envVar = getenv ("NS_ATTRIBUTE_DEFAULT");
-              if (envVar != 0)
+              std::string fullName = tid.GetAttributeFullName (i);
+              std::string::size_type cur = 0;
+              std::string::size_type next = 0;
+              while (next != std::string::npos)
                 {
-                  std::string env = std::string (envVar);
-                  std::string::size_type cur = 0;
-                  std::string::size_type next = 0;
-                  while (next != std::string::npos)
+                  next = env.find (";", cur);
+                  std::string tmp = std::string (env, cur, next-cur);
+                  std::string::size_type equal = tmp.find ("=");
+                  if (equal != std::string::npos)
                     {
-                      next = env.find (";", cur);
-                      std::string tmp = std::string (env, cur, next-cur);
-                      std::string::size_type equal = tmp.find ("=");
-                      if (equal != std::string::npos)
+                      std::string name = tmp.substr (0, equal);
+                      std::string value = tmp.substr (equal+1, tmp.size () - equal - 1);
+                      if (name == fullName)
                         {
-                          std::string name = tmp.substr (0, equal);
-                          std::string value = tmp.substr (equal+1, tmp.size () - equal - 1);
-                          if (name == tid.GetAttributeFullName (i))
+                          if (DoSet (accessor, checker, StringValue (value)))
                             {
-                              if (DoSet (info.accessor, info.checker, StringValue (value)))
-                                {
-                                  NS_LOG_DEBUG ("construct \""<< tid.GetName ()<<"::"<<
-                                                info.name <<"\" from env var");
-                                  found = true;
-                                  break;
-                                }
+                              NS_LOG_DEBUG ("construct \""<< tid.GetName ()<<"::"<<
+                                            attrName <<"\" from env var");
+                              found = true;
+                              break;
                             }
                         }
-                      cur = next + 1;
                     }
+                  cur = next + 1;
                 }
-#endif /* HAVE_GETENV */
             }
           if (!found)
             {
               // No matching attribute value so we try to set the default value.
-              DoSet (info.accessor, info.checker, *info.initialValue);
+              // A default value already of the type of the attribute is set
+              // as is, without the copy made by DoSet: only string defaults
+              // need to be converted for each new object.
+              if (checker->Check (*initialValue))
+                {
+                  accessor->Set (this, *initialValue);
+                }
+              else
+                {
+                  DoSet (accessor, checker, *initialValue);
+                }
               NS_LOG_DEBUG ("construct \""<< tid.GetName ()<<"::"<<
-                            info.name <<"\" from initial value.");
+                            attrName <<"\" from initial value.");
             }
         }
       tid = tid.GetParent ();
@@ -0,0 +1,45 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_THREAD_LOCAL_H
+#define NS3_THREAD_LOCAL_H
+
+#include "ns3/core-config.h"
+
+/**
+ * \file
+ * \ingroup core
+ * Definition of the NS_THREAD_LOCAL macro.
+ */
+
+/**
+ * \ingroup core
+ * \def NS_THREAD_LOCAL
+ * Storage class of the static pools and caches which each thread of
+ * the MultithreadedSimulatorImpl must own.
+ *
+ * It is \c thread_local when ns-3 is configured with
+ * --enable-multithreaded-simulator, and empty otherwise, so that
+ * single-threaded builds do not pay for thread-local accesses on the
+ * hot paths of the packets and events.
+ */
+#ifdef NS3_MULTITHREADED
+# define NS_THREAD_LOCAL thread_local
+#else
+# define NS_THREAD_LOCAL
+#endif
+
+#endif /* NS3_THREAD_LOCAL_H */
@@ -229,6 +229,21 @@ public:
    * \returns The information associated to attribute whose index is \p i.
    */
   struct TypeId::AttributeInformation GetAttribute(uint16_t uid, uint32_t i) const;
+  /**
+   * Get Attribute information by index, without copying it.
+   * \param [in] uid The id.
+   * \param [in] i Index into attribute array
+   * \returns The information associated to attribute whose index is \p i.
+   */
+  const struct TypeId::AttributeInformation & PeekAttribute (uint16_t uid, uint32_t i) const;
+  /**
+   * Find an Attribute of a type id, not of its parents, by name.
+   * \param [in] uid The id.
+   * \param [in] name The Attribute name.
+   * \param [out] i The index of the Attribute.
+   * \returns \c true if \p uid has the Attribute \p name.
+   */
+  bool FindAttribute (uint16_t uid, const std::string &name, uint32_t *i) const;
   /**
    * Record a new TraceSource.
    * \param [in] uid The id.
@@ -264,6 +279,14 @@ public:
    * \returns Detailed information about the requested trace source.
    */
   struct TypeId::TraceSourceInformation GetTraceSource(uint16_t uid, uint32_t i) const;
+  /**
+   * Find a TraceSource of a type id, not of its parents, by name.
+   * \param [in] uid The id.
+   * \param [in] name The TraceSource name.
+   * \param [out] i The index of the TraceSource.
+   * \returns \c true if \p uid has the TraceSource \p name.
+   */
+  bool FindTraceSource (uint16_t uid, const std::string &name, uint32_t *i) const;
   /**
    * Check if this TypeId should not be listed in documentation.
    * \param [in] uid The id.
@@ -293,6 +316,9 @@ private:
    */
   static TypeId::hash_t Hasher (const std::string name);
 
+  /** Type of the by-name index of Attributes and TraceSources. */
+  typedef std::map<std::string, uint32_t> indexmap_t;
+
   /** The information record about a single type id. */
   struct IidInformation {
     /** The type id name. */
@@ -315,6 +341,10 @@ private:
     std::vector<struct TypeId::AttributeInformation> attributes;
     /** The container of TraceSources. */
     std::vector<struct TypeId::TraceSourceInformation> traceSources;
+    /** The by-name index of attributes. */
+    indexmap_t attributeIndex;
+    /** The by-name index of traceSources. */
+    indexmap_t traceSourceIndex;
     /** Support level/deprecation. */
     TypeId::SupportLevel supportLevel;
     /** Support message. */
@@ -605,14 +635,10 @@ IidManager::HasAttribute (uint16_t uid,
   struct IidInformation *information  = LookupInformation (uid);
   while (true)
     {
-      for (std::vector<struct TypeId::AttributeInformation>::const_iterator i = information->attributes.begin ();
-           i != information->attributes.end (); ++i)
+      if (information->attributeIndex.count (name) != 0)
         {
-          if (i->name == name)
-            {
-              NS_LOG_LOGIC (IIDL << true);
-              return true;
-            }
+          NS_LOG_LOGIC (IIDL << true);
+          return true;
         }
       struct IidInformation *parent = LookupInformation (information->parent);
       if (parent == information)
@@ -665,6 +691,7 @@ IidManager::AddAttribute (uint16_t uid,
   info.supportLevel = supportLevel;
   info.supportMsg = supportMsg;
   information->attributes.push_back (info);
+  information->attributeIndex[name] = information->attributes.size () - 1;
   NS_LOG_LOGIC (IIDL << information->attributes.size () - 1);
 }
 void 
@@ -698,6 +725,27 @@ IidManager::GetAttribute(uint16_t uid, uint32_t i) const
   NS_LOG_LOGIC (IIDL << information->name);
   return information->attributes[i];
 }
+const struct TypeId::AttributeInformation &
+IidManager::PeekAttribute (uint16_t uid, uint32_t i) const
+{
+  NS_LOG_FUNCTION (IID << uid << i);
+  struct IidInformation *information = LookupInformation (uid);
+  NS_ASSERT (i < information->attributes.size ());
+  return information->attributes[i];
+}
+bool
+IidManager::FindAttribute (uint16_t uid, const std::string &name, uint32_t *i) const
+{
+  NS_LOG_FUNCTION (IID << uid << name << i);
+  struct IidInformation *information = LookupInformation (uid);
+  indexmap_t::const_iterator found = information->attributeIndex.find (name);
+  if (found == information->attributeIndex.end ())
+    {
+      return false;
+    }
+  *i = found->second;
+  return true;
+}
 
 bool
 IidManager::HasTraceSource (uint16_t uid,
@@ -707,14 +755,10 @@ IidManager::HasTraceSource (uint16_t uid,
   struct IidInformation *information  = LookupInformation (uid);
   while (true)
     {
-      for (std::vector<struct TypeId::TraceSourceInformation>::const_iterator i = information->traceSources.begin ();
-           i != information->traceSources.end (); ++i)
+      if (information->traceSourceIndex.count (name) != 0)
         {
-          if (i->name == name)
-            {
-              NS_LOG_LOGIC (IIDL << true);
-              return true ;
-            }
+          NS_LOG_LOGIC (IIDL << true);
+          return true;
         }
       struct IidInformation *parent = LookupInformation (information->parent);
       if (parent == information)
@@ -756,6 +800,7 @@ IidManager::AddTraceSource (uint16_t uid,
   source.supportLevel = supportLevel;
   source.supportMsg = supportMsg;
   information->traceSources.push_back (source);
+  information->traceSourceIndex[name] = information->traceSources.size () - 1;
   NS_LOG_LOGIC (IIDL << information->traceSources.size () - 1);
 }
 uint32_t 
@@ -776,6 +821,19 @@ IidManager::GetTraceSource(uint16_t uid, uint32_t i) const
   NS_LOG_LOGIC (IIDL << information->name);
   return information->traceSources[i];
 }
+bool
+IidManager::FindTraceSource (uint16_t uid, const std::string &name, uint32_t *i) const
+{
+  NS_LOG_FUNCTION (IID << uid << name << i);
+  struct IidInformation *information = LookupInformation (uid);
+  indexmap_t::const_iterator found = information->traceSourceIndex.find (name);
+  if (found == information->traceSourceIndex.end ())
+    {
+      return false;
+    }
+  *i = found->second;
+  return true;
+}
 bool 
 IidManager::MustHideFromDocumentation (uint16_t uid) const
 {
@@ -870,29 +928,27 @@ TypeId::LookupAttributeByName (std::string name, struct TypeId::AttributeInforma
   TypeId nextTid = *this;
   do {
       tid = nextTid;
-      for (uint32_t i = 0; i < tid.GetAttributeN (); i++)
+      uint32_t i;
+      if (IidManager::Get ()->FindAttribute (tid.m_tid, name, &i))
         {
-          struct TypeId::AttributeInformation tmp = tid.GetAttribute(i);
-          if (tmp.name == name)
+          const struct TypeId::AttributeInformation &tmp = tid.PeekAttribute (i);
+          if (tmp.supportLevel == TypeId::SUPPORTED)
+            {
+              *info = tmp;
+              return true;
+            }
+          else if (tmp.supportLevel == TypeId::DEPRECATED)
+            {
+              std::cerr << "Attribute '" << name << "' is deprecated: "
+                             << tmp.supportMsg << std::endl;
+              *info = tmp;
+              return true;
+            }
+          else if (tmp.supportLevel == TypeId::OBSOLETE)
             {
-              if (tmp.supportLevel == TypeId::SUPPORTED)
-                {
-                  *info = tmp;
-                  return true;
-                }
-              else if (tmp.supportLevel == TypeId::DEPRECATED)
-                {
-                  std::cerr << "Attribute '" << name << "' is deprecated: "
-                                 << tmp.supportMsg << std::endl;
-                  *info = tmp;
-                  return true;
-                }
-              else if (tmp.supportLevel == TypeId::OBSOLETE)
-                {
-                  NS_FATAL_ERROR ("Attribute '" << name
-                                  << "' is obsolete, with no fallback: "
-                                  << tmp.supportMsg);
-                }
+              NS_FATAL_ERROR ("Attribute '" << name
+                              << "' is obsolete, with no fallback: "
+                              << tmp.supportMsg);
             }
         }
       nextTid = tid.GetParent ();
@@ -1067,6 +1123,12 @@ TypeId::GetAttribute(uint32_t i) const
   NS_LOG_FUNCTION (this << i);
   return IidManager::Get ()->GetAttribute(m_tid, i);
 }
+const struct TypeId::AttributeInformation &
+TypeId::PeekAttribute (uint32_t i) const
+{
+  NS_LOG_FUNCTION (this << i);
+  return IidManager::Get ()->PeekAttribute (m_tid, i);
+}
 std::string 
 TypeId::GetAttributeFullName (uint32_t i) const
 {
@@ -1131,29 +1193,27 @@ TypeId::LookupTraceSourceByName (std::string name,
   struct TypeId::TraceSourceInformation tmp;
   do {
       tid = nextTid;
-      for (uint32_t i = 0; i < tid.GetTraceSourceN (); i++)
+      uint32_t i;
+      if (IidManager::Get ()->FindTraceSource (tid.m_tid, name, &i))
         {
           tmp = tid.GetTraceSource (i);
-          if (tmp.name == name)
+          if (tmp.supportLevel == TypeId::SUPPORTED)
+            {
+              *info = tmp;
+               return tmp.accessor;
+            }
+          else if (tmp.supportLevel == TypeId::DEPRECATED)
+            {
+              std::cerr << "TraceSource '" << name << "' is deprecated: "
+                             << tmp.supportMsg << std::endl;
+              *info = tmp;
+              return tmp.accessor;
+            }
+          else  if (tmp.supportLevel == TypeId::OBSOLETE)
             {
-              if (tmp.supportLevel == TypeId::SUPPORTED)
-                {
-                  *info = tmp;
-                   return tmp.accessor;
-                }
-              else if (tmp.supportLevel == TypeId::DEPRECATED)
-                {
-                  std::cerr << "TraceSource '" << name << "' is deprecated: "
-                                 << tmp.supportMsg << std::endl;
-                  *info = tmp;
-                  return tmp.accessor;
-                }
-              else  if (tmp.supportLevel == TypeId::OBSOLETE)
-                {
-                  NS_FATAL_ERROR ("TraceSource '" << name
-                                  << "' is obsolete, with no fallback: "
-                                  << tmp.supportMsg);
-                }
+              NS_FATAL_ERROR ("TraceSource '" << name
+                              << "' is obsolete, with no fallback: "
+                              << tmp.supportMsg);
             }
         }
       nextTid = tid.GetParent ();
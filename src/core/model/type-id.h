@@ -255,6 +255,18 @@ public:
    * \returns The information associated to attribute whose index is \p i.
    */
   struct TypeId::AttributeInformation GetAttribute(uint32_t i) const;
+  /**
+   * Get Attribute information by index, without copying it.
+   *
+   * The reference stays valid until a TypeId is registered, or an
+   * Attribute is added to this TypeId.  In particular, it must not be
+   * used after calling code, such as an Attribute setter, which can
+   * register a TypeId.
+   *
+   * \param [in] i Index into attribute array
+   * \returns The information associated to attribute whose index is \p i.
+   */
+  const struct TypeId::AttributeInformation & PeekAttribute (uint32_t i) const;
   /**
    * Get the Attribute name by index.
    *
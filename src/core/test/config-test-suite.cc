@@ -721,6 +721,79 @@ SearchAttributesOfParentObjectsTestCase::DoRun (void)
 
 }
 
+// ===========================================================================
+// Test for the ability to reuse a compiled path.
+// ===========================================================================
+class CompiledPathConfigTestCase : public TestCase
+{
+public:
+  CompiledPathConfigTestCase ();
+  virtual ~CompiledPathConfigTestCase () {}
+
+  void TraceWithPath (std::string path, int16_t old, int16_t newValue) { m_paths.push_back (path); }
+
+private:
+  virtual void DoRun (void);
+
+  std::vector<std::string> m_paths;
+};
+
+CompiledPathConfigTestCase::CompiledPathConfigTestCase ()
+  : TestCase ("Check ability to set attributes and connect trace sources with a compiled path")
+{
+}
+
+void
+CompiledPathConfigTestCase::DoRun (void)
+{
+  IntegerValue iv;
+  Ptr<ConfigTestObject> root = CreateObject<ConfigTestObject> ();
+  Config::RegisterRootNamespaceObject (root);
+  std::vector<Ptr<ConfigTestObject> > objects;
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      objects.push_back (CreateObject<ConfigTestObject> ());
+      root->AddNodeA (objects.back ());
+    }
+
+  Config::Path set ("/NodesA/0|[2-5]/A");
+  NS_TEST_ASSERT_MSG_EQ (set.GetPath (), "/NodesA/0|[2-5]/A", "Unexpected path");
+  set.Set (IntegerValue (-3));
+  for (uint32_t i = 0; i < objects.size (); ++i)
+    {
+      objects[i]->GetAttribute ("A", iv);
+      NS_TEST_ASSERT_MSG_EQ (iv.Get (), (i == 1 ? 10 : -3), "Object Attribute \"A\" not set as expected");
+    }
+  Config::MatchContainer matches = set.LookupMatches ();
+  NS_TEST_ASSERT_MSG_EQ (matches.GetN (), 2, "Unexpected number of matches");
+  NS_TEST_ASSERT_MSG_EQ (matches.GetMatchedPath (1), "/NodesA/2/", "Unexpected matched path");
+
+  //
+  // The path is resolved again at each use, so it matches objects added
+  // after it was first used.
+  //
+  Config::Path trace ("/NodesA/1|3/Source");
+  trace.Connect (MakeCallback (&CompiledPathConfigTestCase::TraceWithPath, this));
+  objects.push_back (CreateObject<ConfigTestObject> ());
+  root->AddNodeA (objects.back ());
+  trace.Connect (MakeCallback (&CompiledPathConfigTestCase::TraceWithPath, this));
+  for (uint32_t i = 0; i < objects.size (); ++i)
+    {
+      objects[i]->SetAttribute ("Source", IntegerValue (i));
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_paths.size (), 3, "Unexpected number of trace events");
+  NS_TEST_EXPECT_MSG_EQ (m_paths[0], "/NodesA/1/Source", "Unexpected context");
+  NS_TEST_EXPECT_MSG_EQ (m_paths[1], "/NodesA/1/Source", "Unexpected context");
+  NS_TEST_EXPECT_MSG_EQ (m_paths[2], "/NodesA/3/Source", "Unexpected context");
+
+  m_paths.clear ();
+  trace.Disconnect (MakeCallback (&CompiledPathConfigTestCase::TraceWithPath, this));
+  objects[3]->SetAttribute ("Source", IntegerValue (-1));
+  NS_TEST_EXPECT_MSG_EQ (m_paths.size (), 0, "Trace fired after being disconnected");
+
+  Config::UnregisterRootNamespaceObject (root);
+}
+
 // ===========================================================================
 // The Test Suite that glues all of the Test Cases together.
 // ===========================================================================
@@ -737,6 +810,7 @@ ConfigTestSuite::ConfigTestSuite ()
   AddTestCase (new UnderRootNamespaceConfigTestCase, TestCase::QUICK);
   AddTestCase (new ObjectVectorConfigTestCase, TestCase::QUICK);
   AddTestCase (new SearchAttributesOfParentObjectsTestCase, TestCase::QUICK);
+  AddTestCase (new CompiledPathConfigTestCase, TestCase::QUICK);
 }
 
 static ConfigTestSuite configTestSuite;
@@ -23,6 +23,11 @@
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
+#include "ns3/dary-heap-scheduler.h"
+#include "ns3/event-impl.h"
+#include <set>
+#include <vector>
 
 using namespace ns3;
 
@@ -168,6 +173,141 @@ SimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_destroy, true, "Event should have run");
 }
 
+/**
+ * \ingroup tests
+ *
+ * Check that a scheduler dequeues a large, skewed population of events
+ * in (timestamp, uid) order, while events are removed and inserted in
+ * the future of the current one, and through a burst of events which
+ * all share a single timestamp.
+ */
+class SchedulerOrderTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   *
+   * \param [in] schedulerFactory Factory of the scheduler under test.
+   */
+  SchedulerOrderTestCase (ObjectFactory schedulerFactory);
+private:
+  virtual void DoRun (void);
+  /**
+   * Draw the next pseudo-random number.
+   * \returns A pseudo-random number.
+   */
+  uint32_t Next (void);
+  /**
+   * Insert an event in the scheduler under test.
+   * \param [in] ts The event timestamp.
+   */
+  void Insert (uint64_t ts);
+
+  ObjectFactory m_schedulerFactory;        //!< Factory of the scheduler under test.
+  Ptr<Scheduler> m_scheduler;              //!< The scheduler under test.
+  std::vector<Scheduler::Event> m_pending; //!< All the events inserted.
+  uint32_t m_uid;                          //!< Uid of the next event inserted.
+  uint32_t m_state;                        //!< State of the pseudo-random generator.
+};
+
+SchedulerOrderTestCase::SchedulerOrderTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check that many events are dequeued in order with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory),
+    m_uid (0),
+    m_state (1)
+{
+}
+
+uint32_t
+SchedulerOrderTestCase::Next (void)
+{
+  // xorshift32: keeps the test deterministic and independent of the RNG
+  m_state ^= m_state << 13;
+  m_state ^= m_state >> 17;
+  m_state ^= m_state << 5;
+  return m_state;
+}
+
+void
+SchedulerOrderTestCase::Insert (uint64_t ts)
+{
+  Scheduler::Event ev;
+  ev.impl = 0;
+  ev.key.m_ts = ts;
+  ev.key.m_uid = m_uid++;
+  ev.key.m_context = 0;
+  m_scheduler->Insert (ev);
+  m_pending.push_back (ev);
+}
+
+void
+SchedulerOrderTestCase::DoRun (void)
+{
+  m_scheduler = m_schedulerFactory.Create<Scheduler> ();
+  std::set<uint32_t> removed;
+
+  // a skewed population: a dense cluster, a sparse tail and duplicates
+  for (uint32_t i = 0; i < 5000; i++)
+    {
+      uint32_t r = Next ();
+      switch (r % 4)
+        {
+        case 0:
+          Insert (1000 + r % 64);
+          break;
+        case 1:
+          Insert (r % 1000000);
+          break;
+        case 2:
+          Insert (500000);
+          break;
+        default:
+          Insert (r % 5000);
+          break;
+        }
+    }
+  for (uint32_t i = 0; i < m_pending.size (); i += 7)
+    {
+      m_scheduler->Remove (m_pending[i]);
+      removed.insert (m_pending[i].key.m_uid);
+    }
+
+  Scheduler::EventKey last = { 0, 0, 0 };
+  uint32_t count = 0;
+  while (!m_scheduler->IsEmpty ())
+    {
+      Scheduler::Event peek = m_scheduler->PeekNext ();
+      Scheduler::Event next = m_scheduler->RemoveNext ();
+      NS_TEST_ASSERT_MSG_EQ (peek.key.m_uid, next.key.m_uid, "PeekNext and RemoveNext disagree");
+      NS_TEST_ASSERT_MSG_EQ ((next.key < last), false, "Events dequeued out of order");
+      NS_TEST_ASSERT_MSG_EQ (removed.count (next.key.m_uid), 0, "Removed event was dequeued");
+      last = next.key;
+      count++;
+      if (count == 100)
+        {
+          // a burst of simultaneous events, which cannot be spread on rungs
+          for (uint32_t i = 0; i < 20000; i++)
+            {
+              Insert (last.m_ts);
+            }
+        }
+      // keep scheduling in the future of the current event, as the simulator does
+      uint32_t r = Next ();
+      if (count < 20000 && r % 2 == 0)
+        {
+          Insert (last.m_ts + r % 3000);
+          if (r % 11 == 0)
+            {
+              m_scheduler->Remove (m_pending.back ());
+              removed.insert (m_pending.back ().key.m_uid);
+            }
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (count + removed.size (), m_pending.size (), "Some events were lost");
+  m_scheduler = 0;
+}
+
 class SimulatorTemplateTestCase : public TestCase
 {
 public:
@@ -459,6 +599,45 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+class EventImplPoolTestCase : public TestCase
+{
+public:
+  EventImplPoolTestCase ();
+private:
+  virtual void DoRun (void);
+  void Reschedule (uint32_t left);
+};
+
+EventImplPoolTestCase::EventImplPoolTestCase ()
+  : TestCase ("Check that event memory is recycled through the EventImpl pool")
+{
+}
+
+void
+EventImplPoolTestCase::Reschedule (uint32_t left)
+{
+  if (left > 0)
+    {
+      Simulator::Schedule (NanoSeconds (1), &EventImplPoolTestCase::Reschedule, this, left - 1);
+    }
+}
+
+void
+EventImplPoolTestCase::DoRun (void)
+{
+  EventImpl::PoolStats before = EventImpl::GetPoolStats ();
+  Simulator::Schedule (NanoSeconds (1), &EventImplPoolTestCase::Reschedule, this, 1000);
+  Simulator::Run ();
+  Simulator::Destroy ();
+  EventImpl::PoolStats after = EventImpl::GetPoolStats ();
+
+  uint64_t allocs = (after.m_hits + after.m_misses) - (before.m_hits + before.m_misses);
+  NS_TEST_ASSERT_MSG_GT_OR_EQ (allocs, 1001, "Every event should go through the pool");
+  // a single event is pending at any time, so its memory is reused
+  NS_TEST_ASSERT_MSG_GT_OR_EQ (after.m_hits - before.m_hits, 999, "Event memory was not recycled");
+  NS_TEST_ASSERT_MSG_GT_OR_EQ (after.m_releases - before.m_releases, 1001, "Events were not released to the pool");
+}
+
 class SimulatorTestSuite : public TestSuite
 {
 public:
@@ -475,5 +654,12 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (DaryHeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    AddTestCase (new EventImplPoolTestCase (), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
@@ -325,6 +325,96 @@ DeprecatedAttributeTestCase::DoRun (void)
        << endl;
 }
 
+
+//----------------------------
+//
+// Test lookups by name through the parents of a TypeId
+
+class DerivedAttribute : public DeprecatedAttribute
+{
+private:
+  double m_derived;
+  TracedValue<double> m_derivedTrace;
+
+public:
+  DerivedAttribute () : m_derived (0) { };
+  virtual ~DerivedAttribute () { };
+
+  // Register a type with an Attribute of its own
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("DerivedAttribute")
+      .SetParent<DeprecatedAttribute> ()
+      .AddConstructor<DerivedAttribute> ()
+      .AddAttribute ("derived",
+                     "the derived Attribute",
+                     DoubleValue (2.5),
+                     MakeDoubleAccessor (&DerivedAttribute::m_derived),
+                     MakeDoubleChecker<double> ())
+      .AddTraceSource ("derivedTrace",
+                       "the derived TraceSource",
+                       MakeTraceSourceAccessor (&DerivedAttribute::m_derivedTrace),
+                       "ns3::TracedValueCallback::Double");
+    return tid;
+  }
+
+};
+
+class LookupByNameTestCase : public TestCase
+{
+public:
+  LookupByNameTestCase ();
+  virtual ~LookupByNameTestCase ();
+private:
+  virtual void DoRun (void);
+
+};
+
+LookupByNameTestCase::LookupByNameTestCase ()
+  : TestCase ("Check lookups by name of inherited Attributes and TraceSources")
+{
+}
+
+LookupByNameTestCase::~LookupByNameTestCase ()
+{
+}
+
+void
+LookupByNameTestCase::DoRun (void)
+{
+  TypeId tid = DerivedAttribute::GetTypeId ();
+
+  struct TypeId::AttributeInformation ainfo;
+  NS_TEST_ASSERT_MSG_EQ (tid.LookupAttributeByName ("derived", &ainfo), true,
+                         "lookup own attribute");
+  NS_TEST_EXPECT_MSG_EQ (ainfo.name, "derived", "wrong attribute found");
+  NS_TEST_ASSERT_MSG_EQ (tid.LookupAttributeByName ("attribute", &ainfo), true,
+                         "lookup parent attribute");
+  NS_TEST_EXPECT_MSG_EQ (ainfo.name, "attribute", "wrong attribute found");
+  NS_TEST_EXPECT_MSG_EQ (tid.LookupAttributeByName ("missing", &ainfo), false,
+                         "lookup missing attribute");
+  NS_TEST_EXPECT_MSG_EQ (DeprecatedAttribute::GetTypeId ().LookupAttributeByName ("derived", &ainfo), false,
+                         "child attribute found in parent");
+
+  struct TypeId::TraceSourceInformation tinfo;
+  NS_TEST_EXPECT_MSG_NE (tid.LookupTraceSourceByName ("derivedTrace", &tinfo), 0,
+                         "lookup own trace source");
+  NS_TEST_EXPECT_MSG_NE (tid.LookupTraceSourceByName ("trace", &tinfo), 0,
+                         "lookup parent trace source");
+  NS_TEST_EXPECT_MSG_EQ (tinfo.name, "trace", "wrong trace source found");
+  NS_TEST_EXPECT_MSG_EQ (tid.LookupTraceSourceByName ("missing"), 0,
+                         "lookup missing trace source");
+
+  // Objects are constructed with the initial values of their Attributes
+  Ptr<DerivedAttribute> object = CreateObject<DerivedAttribute> ();
+  DoubleValue derived;
+  object->GetAttribute ("derived", derived);
+  NS_TEST_EXPECT_MSG_EQ (derived.Get (), 2.5, "wrong derived initial value");
+  IntegerValue attribute;
+  object->GetAttribute ("attribute", attribute);
+  NS_TEST_EXPECT_MSG_EQ (attribute.Get (), 1, "wrong parent initial value");
+}
+
   
 //----------------------------
 //
@@ -437,6 +527,7 @@ TypeIdTestSuite::TypeIdTestSuite ()
   AddTestCase (new UniqueTypeIdTestCase, QUICK);
   AddTestCase (new CollisionTestCase, QUICK);
   AddTestCase (new DeprecatedAttributeTestCase, QUICK);
+  AddTestCase (new LookupByNameTestCase, QUICK);
 }
 
 static TypeIdTestSuite g_TypeIdTestSuite;  
@@ -65,6 +65,18 @@ void Ipv4QueueDiscItem::AddHeader(void)
   m_headerAdded = true;
 }
 
+bool
+Ipv4QueueDiscItem::Mark (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_headerAdded && m_header.GetEcn () != Ipv4Header::ECN_NotECT)
+    {
+      m_header.SetEcn (Ipv4Header::ECN_CE);
+      return true;
+    }
+  return false;
+}
+
 void
 Ipv4QueueDiscItem::Print (std::ostream& os) const
 {
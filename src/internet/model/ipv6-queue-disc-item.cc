@@ -65,6 +65,20 @@ void Ipv6QueueDiscItem::AddHeader(void)
   m_headerAdded = true;
 }
 
+bool
+Ipv6QueueDiscItem::Mark (void)
+{
+  NS_LOG_FUNCTION (this);
+  // the ECN field is made of the two least significant bits of the traffic class
+  uint8_t tc = m_header.GetTrafficClass ();
+  if (!m_headerAdded && (tc & 0x03) != 0)
+    {
+      m_header.SetTrafficClass (tc | 0x03);
+      return true;
+    }
+  return false;
+}
+
 void
 Ipv6QueueDiscItem::Print (std::ostream& os) const
 {
@@ -64,6 +64,12 @@ public:
    */
   virtual void AddHeader (void);
 
+  /**
+   * \brief Set the ECN field of the header to CE, if the packet is ECN capable
+   * \return true if the packet was marked
+   */
+  virtual bool Mark (void);
+
   /**
    * \brief Print the item contents.
    * \param os output stream in which the data should be printed.
@@ -269,9 +269,9 @@ int Ipv6RawSocketImpl::SendTo (Ptr<Packet> p, uint32_t flags, const Address& toA
               if (type == Icmpv6Header::ICMPV6_ECHO_REQUEST)
                 {
                   Icmpv6Echo hdr (1);
-                  p->RemoveHeader (hdr);
-                  hdr.CalculatePseudoHeaderChecksum (route->GetSource (), dst, p->GetSize () + hdr.GetSerializedSize (), Icmpv6L4Protocol::GetStaticProtocolNumber ());
-                  p->AddHeader (hdr);
+                  p->PeekHeader (hdr);
+                  hdr.CalculatePseudoHeaderChecksum (route->GetSource (), dst, p->GetSize (), Icmpv6L4Protocol::GetStaticProtocolNumber ());
+                  p->ModifyHeader (hdr);
                 }
             }
 
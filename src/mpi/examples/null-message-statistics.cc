@@ -0,0 +1,206 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ * NullMessageStatistics checks the Null Message counters of the
+ * NullMessageSimulatorImpl, with and without its AdaptiveNullMessages
+ * attribute.
+ *
+ *                 -------   -------
+ *                  RANK 0    RANK 1
+ *                 ------- | -------
+ *                         |
+ *                n0 ------|------ n1
+ *
+ * Each node sends a packet to the other one every 10 ms, through a
+ * point-to-point link between the ranks.  At the end of the run, each
+ * rank checks that:
+ *   - its bundle counted the packets sent and received by its node;
+ *   - the other rank received the packets it sent, and no more Null
+ *     Messages than it sent;
+ *   - Null Messages were suppressed if and only if AdaptiveNullMessages
+ *     is true.
+ *
+ * The program exits with a non-zero status if a check fails.  Run it
+ * with both values of --adaptive:
+ *
+ *   mpirun -np 2 ./waf --run "null-message-statistics --adaptive=0"
+ *   mpirun -np 2 ./waf --run "null-message-statistics --adaptive=1"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mpi-interface.h"
+#include "ns3/point-to-point-helper.h"
+
+// the counters of the bundles are not part of the public API
+#include "../model/remote-channel-bundle.h"
+#include "../model/remote-channel-bundle-manager.h"
+
+#ifdef NS3_MPI
+#include <mpi.h>
+#endif
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("NullMessageStatistics");
+
+#ifdef NS3_MPI
+
+namespace {
+
+uint32_t g_packetsSent = 0;       //!< Packets sent by the local node
+uint32_t g_packetsReceived = 0;   //!< Packets received by the local node
+
+/**
+ * Send a packet to the other node.
+ *
+ * \param device the device of the local node
+ */
+void
+SendPacket (Ptr<NetDevice> device)
+{
+  device->Send (Create<Packet> (500), device->GetBroadcast (), 0x0800);
+  g_packetsSent++;
+}
+
+/**
+ * Count the packets received by the local node.
+ *
+ * \param device the receiving device
+ * \param packet the packet
+ * \param protocol the protocol number
+ * \param from the sender address
+ * \returns true
+ */
+bool
+ReceivePacket (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from)
+{
+  g_packetsReceived++;
+  return true;
+}
+
+/**
+ * Check a condition, and report it if it does not hold.
+ *
+ * \param ok [in,out] false once a check failed
+ * \param condition the condition checked
+ * \param systemId the rank of this task
+ * \param message what failed
+ */
+void
+Check (bool &ok, bool condition, uint32_t systemId, std::string const &message)
+{
+  if (!condition)
+    {
+      std::cout << "Rank " << systemId << ": FAIL: " << message << std::endl;
+      ok = false;
+    }
+}
+
+} // unnamed namespace
+
+#endif
+
+int
+main (int argc, char *argv[])
+{
+#ifdef NS3_MPI
+
+  bool adaptive = true;
+  uint32_t packets = 100;
+
+  CommandLine cmd;
+  cmd.AddValue ("adaptive", "Enable the adaptive Null Message schedule", adaptive);
+  cmd.AddValue ("packets", "Number of packets sent by each node", packets);
+  cmd.Parse (argc, argv);
+
+  GlobalValue::Bind ("SimulatorImplementationType",
+                     StringValue ("ns3::NullMessageSimulatorImpl"));
+  Config::SetDefault ("ns3::NullMessageSimulatorImpl::AdaptiveNullMessages", BooleanValue (adaptive));
+
+  MpiInterface::Enable (&argc, &argv);
+
+  uint32_t systemId = MpiInterface::GetSystemId ();
+  uint32_t systemCount = MpiInterface::GetSize ();
+
+  // Must have 2 and only 2 Logical Processors (LPs)
+  if (systemCount != 2)
+    {
+      std::cout << "This simulation requires 2 and only 2 logical processors." << std::endl;
+      return 1;
+    }
+
+  NodeContainer nodes;
+  nodes.Add (CreateObject<Node> (0));
+  nodes.Add (CreateObject<Node> (1));
+
+  PointToPointHelper link;
+  link.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+  link.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  NetDeviceContainer devices = link.Install (nodes);
+
+  Ptr<NetDevice> device = devices.Get (systemId);
+  device->SetReceiveCallback (MakeCallback (&ReceivePacket));
+  for (uint32_t i = 0; i < packets; i++)
+    {
+      Simulator::ScheduleWithContext (device->GetNode ()->GetId (),
+                                      MilliSeconds (100 + 10 * i + 5 * systemId),
+                                      &SendPacket, device);
+    }
+
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+
+  // packets sent, packets received, Null Messages sent, suppressed and received
+  Ptr<RemoteChannelBundle> bundle = RemoteChannelBundleManager::Find (1 - systemId);
+  NS_ABORT_MSG_IF (bundle == 0, "No bundle to the other rank");
+  const RemoteChannelBundle::Statistics &stats = bundle->GetStatistics ();
+  uint32_t local[5] = { stats.packetsSent, stats.packetsReceived,
+                        stats.nullMessagesSent, stats.nullMessagesSuppressed,
+                        stats.nullMessagesReceived };
+  uint32_t all[10];
+  MPI_Allgather (local, 5, MPI_UNSIGNED, all, 5, MPI_UNSIGNED, MPI_COMM_WORLD);
+  const uint32_t *remote = all + 5 * (1 - systemId);
+
+  std::cout << "Rank " << systemId << ": adaptive = " << adaptive
+            << ", packets sent = " << local[0] << ", received = " << local[1]
+            << ", Null Messages sent = " << local[2] << ", suppressed = " << local[3]
+            << ", received = " << local[4] << std::endl;
+
+  bool ok = true;
+  Check (ok, g_packetsSent == packets, systemId, "the node did not send all its packets");
+  Check (ok, local[0] == g_packetsSent, systemId, "the bundle did not count the packets sent");
+  Check (ok, local[1] == g_packetsReceived, systemId, "the bundle did not count the packets received");
+  Check (ok, remote[1] == local[0], systemId, "the other rank did not receive the packets sent");
+  Check (ok, local[2] > 0, systemId, "no Null Message was sent");
+  Check (ok, remote[4] <= local[2], systemId, "the other rank received more Null Messages than sent");
+  if (adaptive)
+    {
+      Check (ok, local[3] > 0, systemId, "no Null Message was suppressed");
+    }
+  else
+    {
+      Check (ok, local[3] == 0, systemId, "Null Messages were suppressed");
+    }
+
+  Simulator::Destroy ();
+  // Exit the MPI execution environment
+  MpiInterface::Disable ();
+  return ok ? 0 : 1;
+#else
+  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#endif
+}
@@ -23,6 +23,9 @@
 #include <iostream>
 #include <iomanip>
 #include <list>
+#include <sstream>
+#include <cstring>
+#include <unistd.h>
 
 #include "granted-time-window-mpi-interface.h"
 #include "mpi-receiver.h"
@@ -35,6 +38,8 @@
 #include "ns3/simulator-impl.h"
 #include "ns3/nstime.h"
 #include "ns3/log.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
 
 #ifdef NS3_MPI
 #include <mpi.h>
@@ -44,6 +49,17 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("GrantedTimeWindowMpiInterface");
 
+/**
+ * \ingroup mpi
+ * The size of the shared memory rings between the ranks of a host.
+ */
+static GlobalValue g_sharedMemoryRingSize = GlobalValue
+  ("MpiSharedMemoryRingSize",
+   "The size in bytes of the shared memory ring used to send packets to "
+   "each rank running on the same host, 0 to always use MPI messages",
+   UintegerValue (256 * 1024),
+   MakeUintegerChecker<uint32_t> ());
+
 SentBuffer::SentBuffer ()
 {
   m_buffer = 0;
@@ -82,6 +98,9 @@ bool                  GrantedTimeWindowMpiInterface::m_enabled = false;
 uint32_t              GrantedTimeWindowMpiInterface::m_rxCount = 0;
 uint32_t              GrantedTimeWindowMpiInterface::m_txCount = 0;
 std::list<SentBuffer> GrantedTimeWindowMpiInterface::m_pendingTx;
+std::vector<SharedMemorySegment *> GrantedTimeWindowMpiInterface::m_segments;
+std::vector<SharedMemoryRing> GrantedTimeWindowMpiInterface::m_txRings;
+std::vector<SharedMemoryRing> GrantedTimeWindowMpiInterface::m_rxRings;
 
 #ifdef NS3_MPI
 MPI_Request* GrantedTimeWindowMpiInterface::m_requests;
@@ -112,6 +131,14 @@ GrantedTimeWindowMpiInterface::Destroy ()
   delete [] m_requests;
 
   m_pendingTx.clear ();
+
+  m_txRings.clear ();
+  m_rxRings.clear ();
+  for (std::vector<SharedMemorySegment *>::iterator i = m_segments.begin (); i != m_segments.end (); ++i)
+    {
+      delete *i;
+    }
+  m_segments.clear ();
 #endif
 }
 
@@ -182,17 +209,118 @@ GrantedTimeWindowMpiInterface::Enable (int* pargc, char*** pargv)
       MPI_Irecv (m_pRxBuffers[i], MAX_MPI_MSG_SIZE, MPI_CHAR, MPI_ANY_SOURCE, 0,
                  MPI_COMM_WORLD, &m_requests[i]);
     }
+  EnableSharedMemory ();
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
 #endif
 }
 
+void
+GrantedTimeWindowMpiInterface::EnableSharedMemory (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+#if defined (NS3_MPI) && MPI_VERSION >= 3
+  UintegerValue ringSize;
+  g_sharedMemoryRingSize.GetValue (ringSize);
+  // Keep each ring on its own cache lines
+  uint32_t capacity = static_cast<uint32_t> ((ringSize.Get () + 63) & ~static_cast<uint64_t> (63));
+  if (capacity == 0)
+    {
+      return;
+    }
+
+  MPI_Comm local;
+  MPI_Comm_split_type (MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &local);
+  int localRank;
+  int localSize;
+  MPI_Comm_rank (local, &localRank);
+  MPI_Comm_size (local, &localSize);
+  if (localSize == 1)
+    {
+      MPI_Comm_free (&local);
+      return;
+    }
+
+  // Get the system id of each local rank, and a name prefix unique to this run
+  std::vector<int> sysIds (localSize);
+  int sid = m_sid;
+  MPI_Allgather (&sid, 1, MPI_INT, &sysIds[0], 1, MPI_INT, local);
+  int pid = getpid ();
+  MPI_Bcast (&pid, 1, MPI_INT, 0, local);
+  std::ostringstream prefix;
+  prefix << "/ns3-mpi-" << pid << "-";
+
+  size_t ringStorage = SharedMemoryRing::GetStorageSize (capacity);
+  size_t segmentSize = ringStorage * localSize;
+  std::ostringstream name;
+  name << prefix.str () << localRank;
+  SharedMemorySegment *segment = new SharedMemorySegment;
+  int ok = segment->Create (name.str (), segmentSize);
+  if (ok)
+    {
+      for (int i = 0; i < localSize; ++i)
+        {
+          SharedMemoryRing::Format (segment->GetAddress () + i * ringStorage, capacity);
+        }
+    }
+  int allOk;
+  MPI_Allreduce (&ok, &allOk, 1, MPI_INT, MPI_MIN, local);
+  if (!allOk)
+    {
+      NS_LOG_WARN ("Cannot create the shared memory rings, using MPI messages only");
+      delete segment;
+      MPI_Comm_free (&local);
+      return;
+    }
+  m_segments.push_back (segment);
+
+  m_txRings.resize (m_size);
+  m_rxRings.resize (localSize);
+  for (int i = 0; i < localSize; ++i)
+    {
+      if (i == localRank)
+        {
+          continue;
+        }
+      m_rxRings[i].Attach (segment->GetAddress () + i * ringStorage, capacity);
+      std::ostringstream peerName;
+      peerName << prefix.str () << i;
+      SharedMemorySegment *peer = new SharedMemorySegment;
+      if (!peer->Open (peerName.str (), segmentSize))
+        {
+          // Messages to this rank will use MPI
+          NS_LOG_WARN ("Cannot map the shared memory ring of rank " << sysIds[i]);
+          delete peer;
+          continue;
+        }
+      m_segments.push_back (peer);
+      m_txRings[sysIds[i]].Attach (peer->GetAddress () + localRank * ringStorage, capacity);
+    }
+
+  // The segments can be removed once all the ranks mapped them
+  MPI_Barrier (local);
+  segment->Unlink ();
+  MPI_Comm_free (&local);
+#endif
+}
+
 void
 GrantedTimeWindowMpiInterface::SendPacket (Ptr<Packet> p, const Time& rxTime, uint32_t node, uint32_t dev)
 {
   NS_LOG_FUNCTION (this << p << rxTime.GetTimeStep () << node << dev);
 
 #ifdef NS3_MPI
+  // Find the system id for the destination node
+  Ptr<Node> destNode = NodeList::GetNode (node);
+  uint32_t nodeSysId = destNode->GetSystemId ();
+
+  if (SendSharedMemory (p, rxTime, node, dev, nodeSysId))
+    {
+      m_txCount++;
+      return;
+    }
+
   SentBuffer sendBuf;
   m_pendingTx.push_back (sendBuf);
   std::list<SentBuffer>::reverse_iterator i = m_pendingTx.rbegin (); // Points to the last element
@@ -210,10 +338,6 @@ GrantedTimeWindowMpiInterface::SendPacket (Ptr<Packet> p, const Time& rxTime, ui
   // Serialize the packet
   p->Serialize (reinterpret_cast<uint8_t *> (pData), serializedSize);
 
-  // Find the system id for the destination node
-  Ptr<Node> destNode = NodeList::GetNode (node);
-  uint32_t nodeSysId = destNode->GetSystemId ();
-
   MPI_Isend (reinterpret_cast<void *> (i->GetBuffer ()), serializedSize + 16, MPI_CHAR, nodeSysId,
              0, MPI_COMM_WORLD, (i->GetRequest ()));
   m_txCount++;
@@ -222,12 +346,110 @@ GrantedTimeWindowMpiInterface::SendPacket (Ptr<Packet> p, const Time& rxTime, ui
 #endif
 }
 
+bool
+GrantedTimeWindowMpiInterface::SendSharedMemory (Ptr<Packet> p, const Time &rxTime, uint32_t node, uint32_t dev,
+                                                 uint32_t sysId)
+{
+  if (sysId >= m_txRings.size () || !m_txRings[sysId].IsAttached ())
+    {
+      return false;
+    }
+  // Serialize the message in place; the reader sees it once the ring
+  // is flushed, before the next LBTS computation.
+  uint32_t serializedSize = p->GetSerializedSize ();
+  uint8_t *buffer = m_txRings[sysId].Reserve (serializedSize + 16);
+  if (buffer == 0)
+    {
+      // The ring is full until the peer reads it: use MPI
+      return false;
+    }
+  uint64_t t = rxTime.GetInteger ();
+  std::memcpy (buffer, &t, sizeof (t));
+  std::memcpy (buffer + 8, &node, sizeof (node));
+  std::memcpy (buffer + 12, &dev, sizeof (dev));
+  p->Serialize (buffer + 16, serializedSize);
+  return true;
+}
+
+void
+GrantedTimeWindowMpiInterface::FlushSharedMemory (void)
+{
+  for (std::vector<SharedMemoryRing>::iterator i = m_txRings.begin (); i != m_txRings.end (); ++i)
+    {
+      if (i->HasReserved ())
+        {
+          i->Commit ();
+        }
+    }
+}
+
+void
+GrantedTimeWindowMpiInterface::ReceiveSharedMemory (void)
+{
+  for (std::vector<SharedMemoryRing>::iterator i = m_rxRings.begin (); i != m_rxRings.end (); ++i)
+    {
+      if (!i->IsAttached ())
+        {
+          continue;
+        }
+      uint32_t count;
+      const uint8_t *record;
+      while ((record = i->Peek (&count)) != 0)
+        {
+          m_rxCount++; // Count this receive
+          HandleMessage (record, count);
+          i->Release ();
+        }
+    }
+}
+
+void
+GrantedTimeWindowMpiInterface::HandleMessage (const uint8_t *buffer, uint32_t count)
+{
+  // Get the meta data first
+  uint64_t time;
+  uint32_t node;
+  uint32_t dev;
+  std::memcpy (&time, buffer, sizeof (time));
+  std::memcpy (&node, buffer + 8, sizeof (node));
+  std::memcpy (&dev, buffer + 12, sizeof (dev));
+
+  Time rxTime (time);
+
+  count -= sizeof (time) + sizeof (node) + sizeof (dev);
+
+  Ptr<Packet> p = Create<Packet> (buffer + 16, count, true);
+
+  // Find the correct node/device to schedule receive event
+  Ptr<Node> pNode = NodeList::GetNode (node);
+  Ptr<MpiReceiver> pMpiRec = 0;
+  uint32_t nDevices = pNode->GetNDevices ();
+  for (uint32_t i = 0; i < nDevices; ++i)
+    {
+      Ptr<NetDevice> pThisDev = pNode->GetDevice (i);
+      if (pThisDev->GetIfIndex () == dev)
+        {
+          pMpiRec = pThisDev->GetObject<MpiReceiver> ();
+          break;
+        }
+    }
+
+  NS_ASSERT (pNode && pMpiRec);
+
+  // Schedule the rx event
+  Simulator::ScheduleWithContext (pNode->GetId (), rxTime - Simulator::Now (),
+                                  &MpiReceiver::Receive, pMpiRec, p);
+}
+
 void
 GrantedTimeWindowMpiInterface::ReceiveMessages ()
 { 
   NS_LOG_FUNCTION_NOARGS ();
 
 #ifdef NS3_MPI
+  // Drain the shared memory rings first
+  ReceiveSharedMemory ();
+
   // Poll the non-block reads to see if data arrived
   while (true)
     {
@@ -244,38 +466,7 @@ GrantedTimeWindowMpiInterface::ReceiveMessages ()
       MPI_Get_count (&status, MPI_CHAR, &count);
       m_rxCount++; // Count this receive
 
-      // Get the meta data first
-      uint64_t* pTime = reinterpret_cast<uint64_t *> (m_pRxBuffers[index]);
-      uint64_t time = *pTime++;
-      uint32_t* pData = reinterpret_cast<uint32_t *> (pTime);
-      uint32_t node = *pData++;
-      uint32_t dev  = *pData++;
-
-      Time rxTime (time);
-
-      count -= sizeof (time) + sizeof (node) + sizeof (dev);
-
-      Ptr<Packet> p = Create<Packet> (reinterpret_cast<uint8_t *> (pData), count, true);
-
-      // Find the correct node/device to schedule receive event
-      Ptr<Node> pNode = NodeList::GetNode (node);
-      Ptr<MpiReceiver> pMpiRec = 0;
-      uint32_t nDevices = pNode->GetNDevices ();
-      for (uint32_t i = 0; i < nDevices; ++i)
-        {
-          Ptr<NetDevice> pThisDev = pNode->GetDevice (i);
-          if (pThisDev->GetIfIndex () == dev)
-            {
-              pMpiRec = pThisDev->GetObject<MpiReceiver> ();
-              break;
-            }
-        }
-
-      NS_ASSERT (pNode && pMpiRec);
-
-      // Schedule the rx event
-      Simulator::ScheduleWithContext (pNode->GetId (), rxTime - Simulator::Now (),
-                                      &MpiReceiver::Receive, pMpiRec, p);
+      HandleMessage (reinterpret_cast<uint8_t *> (m_pRxBuffers[index]), count);
 
       // Re-queue the next read
       MPI_Irecv (m_pRxBuffers[index], MAX_MPI_MSG_SIZE, MPI_CHAR, MPI_ANY_SOURCE, 0,
@@ -292,6 +483,9 @@ GrantedTimeWindowMpiInterface::TestSendComplete ()
   NS_LOG_FUNCTION_NOARGS ();
 
 #ifdef NS3_MPI
+  // Publish the messages written in the rings during this window
+  FlushSharedMemory ();
+
   std::list<SentBuffer>::iterator i = m_pendingTx.begin ();
   while (i != m_pendingTx.end ())
     {
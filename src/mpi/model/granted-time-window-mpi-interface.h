@@ -25,11 +25,13 @@
 
 #include <stdint.h>
 #include <list>
+#include <vector>
 
 #include "ns3/nstime.h"
 #include "ns3/buffer.h"
 
 #include "parallel-communication-interface.h"
+#include "shared-memory-ring.h"
 
 #ifdef NS3_MPI
 #include "mpi.h"
@@ -149,6 +151,42 @@ public:
   static uint32_t GetTxCount ();
 
 private:
+  /**
+   * Set up the shared memory rings between the ranks running on the
+   * same host.
+   *
+   * Each rank creates a segment holding one ring per rank of its host,
+   * ring \c i receiving the messages sent by the local rank \c i, and
+   * maps the segments of the other local ranks.  Nothing is set up if
+   * the ring size is 0 or if the MPI library does not support shared
+   * memory communicators.
+   */
+  static void EnableSharedMemory (void);
+  /**
+   * Try to send a message through the shared memory ring of a rank.
+   *
+   * \param p packet to send
+   * \param rxTime received time at destination node
+   * \param node destination node
+   * \param dev destination device
+   * \param sysId system id of the destination node
+   * \return true if the message was written in the ring
+   */
+  static bool SendSharedMemory (Ptr<Packet> p, const Time &rxTime, uint32_t node, uint32_t dev,
+                                uint32_t sysId);
+  /** Publish the messages written in the shared memory rings since the last call. */
+  static void FlushSharedMemory (void);
+  /** Read the messages written in the shared memory rings. */
+  static void ReceiveSharedMemory (void);
+  /**
+   * Schedule the reception of a message.
+   *
+   * \param buffer the message: receive time, destination node and
+   *        device, and serialized packet
+   * \param count the size of the message
+   */
+  static void HandleMessage (const uint8_t *buffer, uint32_t count);
+
   static uint32_t m_sid;
   static uint32_t m_size;
 
@@ -168,6 +206,15 @@ private:
 
   // List of pending non-blocking sends
   static std::list<SentBuffer> m_pendingTx;
+
+  // Shared memory segments of this rank and of the other local ranks
+  static std::vector<SharedMemorySegment *> m_segments;
+
+  // Rings to the local ranks, indexed by system id
+  static std::vector<SharedMemoryRing> m_txRings;
+
+  // Rings from the local ranks
+  static std::vector<SharedMemoryRing> m_rxRings;
 };
 
 } // namespace ns3
@@ -0,0 +1,708 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "multithreaded-simulator-impl.h"
+
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/net-device.h"
+#include "ns3/channel.h"
+#include "ns3/nstime.h"
+#include "ns3/uinteger.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <thread>
+
+/**
+ * \file
+ * \ingroup mpi
+ * Implementation of class ns3::MultithreadedSimulatorImpl.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+thread_local MultithreadedSimulatorImpl::Partition *MultithreadedSimulatorImpl::m_current = 0;
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .SetGroupName ("Mpi")
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+    .AddAttribute ("ThreadCount",
+                   "The number of threads used to run the partitions, "
+                   "0 for one thread per processor.  No more threads "
+                   "than partitions are ever used.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MultithreadedSimulatorImpl::m_threadCount),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+  : m_partitioned (false),
+    m_lookAhead (GetMaximumSimulationTime ().GetTimeStep ()),
+    m_windowEnd (0),
+    m_threadCount (0),
+    m_nThreads (1),
+    m_stop (false),
+    m_finished (false),
+    m_barrierCount (0),
+    m_barrierGeneration (0),
+    m_nextThread (0)
+{
+  NS_LOG_FUNCTION (this);
+  m_global.m_id = 0;
+  // uids are allocated from 4.
+  // uid 0 is "invalid" events
+  // uid 1 is "now" events
+  // uid 2 is "destroy" events
+  m_global.m_uid = 4;
+  // before ::Run is entered, the m_currentUid will be zero
+  m_global.m_currentUid = 0;
+  m_global.m_currentTs = 0;
+  m_global.m_currentContext = Simulator::NO_CONTEXT;
+  m_global.m_unscheduledEvents = 0;
+  m_global.m_events = 0;
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t i = 0; i <= m_partitions.size (); i++)
+    {
+      Partition *partition = GetPartition (i);
+      while (partition->m_events != 0 && !partition->m_events->IsEmpty ())
+        {
+          Scheduler::Event next = partition->m_events->RemoveNext ();
+          next.impl->Unref ();
+        }
+      partition->m_events = 0;
+    }
+  m_partitions.clear ();
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetCurrent (void) const
+{
+  if (m_current != 0)
+    {
+      return m_current;
+    }
+  return const_cast<Partition *> (&m_global);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartitionId (uint32_t context) const
+{
+  if (context < m_nodePartition.size ())
+    {
+      return m_nodePartition[context];
+    }
+  return m_partitions.size ();
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetPartition (uint32_t id) const
+{
+  NS_ASSERT (id <= m_partitions.size ());
+  if (id == m_partitions.size ())
+    {
+      return const_cast<Partition *> (&m_global);
+    }
+  return const_cast<Partition *> (&m_partitions[id]);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::Insert (Partition *partition, uint64_t ts, uint32_t context, EventImpl *event)
+{
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = ts;
+  ev.key.m_context = context;
+  ev.key.m_uid = partition->m_uid;
+  partition->m_uid++;
+  partition->m_unscheduledEvents++;
+  partition->m_events->Insert (ev);
+  return ev.key.m_uid;
+}
+
+uint64_t
+MultithreadedSimulatorImpl::NextTs (const Partition &partition) const
+{
+  if (partition.m_events->IsEmpty ())
+    {
+      return GetMaximumSimulationTime ().GetTimeStep ();
+    }
+  return partition.m_events->PeekNext ().key.m_ts;
+}
+
+uint64_t
+MultithreadedSimulatorImpl::MinNextTs (void) const
+{
+  uint64_t next = GetMaximumSimulationTime ().GetTimeStep ();
+  for (std::vector<Partition>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      next = std::min (next, NextTs (*i));
+    }
+  return next;
+}
+
+void
+MultithreadedSimulatorImpl::ProcessOneEvent (Partition *partition)
+{
+  Scheduler::Event next = partition->m_events->RemoveNext ();
+
+  NS_ASSERT (next.key.m_ts >= partition->m_currentTs);
+  partition->m_unscheduledEvents--;
+
+  NS_LOG_LOGIC ("handle " << next.key.m_ts << " in partition " << partition->m_id);
+  partition->m_currentTs = next.key.m_ts;
+  partition->m_currentContext = next.key.m_context;
+  partition->m_currentUid = next.key.m_uid;
+  next.impl->Invoke ();
+  next.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::CalculatePartitions (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  uint32_t nPartitions = 0;
+  m_nodePartition.resize (NodeList::GetNNodes ());
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); ++i)
+    {
+      uint32_t systemId = (*i)->GetSystemId ();
+      m_nodePartition[(*i)->GetId ()] = systemId;
+      nPartitions = std::max (nPartitions, systemId + 1);
+    }
+
+  m_partitions.resize (nPartitions);
+  for (uint32_t i = 0; i < nPartitions; i++)
+    {
+      Partition &partition = m_partitions[i];
+      partition.m_id = i;
+      partition.m_events = m_schedulerFactory.Create<Scheduler> ();
+      // start above the uids of the events moved from the global
+      // partition below.
+      partition.m_uid = m_global.m_uid;
+      partition.m_currentUid = 0;
+      partition.m_currentTs = m_global.m_currentTs;
+      partition.m_currentContext = Simulator::NO_CONTEXT;
+      partition.m_unscheduledEvents = 0;
+      partition.m_outbox.resize (nPartitions + 1);
+    }
+  m_global.m_id = nPartitions;
+  m_global.m_outbox.resize (nPartitions + 1);
+
+  // Move the events of the nodes to their partition, keeping their
+  // key so that the EventIds already returned stay valid.
+  std::vector<Scheduler::Event> global;
+  while (!m_global.m_events->IsEmpty ())
+    {
+      Scheduler::Event ev = m_global.m_events->RemoveNext ();
+      uint32_t id = GetPartitionId (ev.key.m_context);
+      if (id == nPartitions)
+        {
+          global.push_back (ev);
+          continue;
+        }
+      m_partitions[id].m_events->Insert (ev);
+      m_partitions[id].m_unscheduledEvents++;
+      m_global.m_unscheduledEvents--;
+    }
+  for (std::vector<Scheduler::Event>::const_iterator i = global.begin (); i != global.end (); ++i)
+    {
+      m_global.m_events->Insert (*i);
+    }
+
+  // The lookahead is the smallest delay of the channels between
+  // partitions: only point-to-point channels are supported.
+  m_lookAhead = GetMaximumSimulationTime ().GetTimeStep ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); ++i)
+    {
+      Ptr<Node> node = *i;
+      for (uint32_t j = 0; j < node->GetNDevices (); ++j)
+        {
+          Ptr<NetDevice> device = node->GetDevice (j);
+          Ptr<Channel> channel = device->GetChannel ();
+          if (channel == 0)
+            {
+              continue;
+            }
+          for (uint32_t k = 0; k < channel->GetNDevices (); ++k)
+            {
+              Ptr<Node> remoteNode = channel->GetDevice (k)->GetNode ();
+              if (remoteNode == 0 || remoteNode->GetSystemId () == node->GetSystemId ())
+                {
+                  continue;
+                }
+              if (!device->IsPointToPoint ())
+                {
+                  NS_FATAL_ERROR ("Node " << node->GetId () << " and node " << remoteNode->GetId () <<
+                                  " belong to different partitions but are connected by a " <<
+                                  channel->GetInstanceTypeId ().GetName () <<
+                                  ": only point-to-point channels may connect partitions");
+                }
+              TimeValue delay;
+              channel->GetAttribute ("Delay", delay);
+              if (!delay.Get ().IsStrictlyPositive ())
+                {
+                  NS_FATAL_ERROR ("The channel between node " << node->GetId () << " and node " <<
+                                  remoteNode->GetId () << " connects different partitions "
+                                  "with a zero delay");
+                }
+              m_lookAhead = std::min<uint64_t> (m_lookAhead, delay.Get ().GetTimeStep ());
+            }
+        }
+    }
+  NS_LOG_LOGIC (nPartitions << " partitions, lookahead=" << m_lookAhead);
+  m_partitioned = true;
+}
+
+void
+MultithreadedSimulatorImpl::MergeOutboxes (void)
+{
+  NS_LOG_FUNCTION (this);
+  // Deliver the messages in the order of their source, then in the
+  // order they were sent, so that the uids assigned do not depend on
+  // the order in which the threads ran.
+  for (uint32_t dst = 0; dst <= m_partitions.size (); dst++)
+    {
+      Partition *destination = GetPartition (dst);
+      for (std::vector<Partition>::iterator src = m_partitions.begin (); src != m_partitions.end (); ++src)
+        {
+          std::vector<Message> &outbox = src->m_outbox[dst];
+          for (std::vector<Message>::const_iterator i = outbox.begin (); i != outbox.end (); ++i)
+            {
+              Insert (destination, i->m_ts, i->m_context, i->m_impl);
+            }
+          outbox.clear ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Barrier (void)
+{
+  std::unique_lock<std::mutex> lock (m_mutex);
+  uint64_t generation = m_barrierGeneration;
+  m_barrierCount++;
+  if (m_barrierCount == m_nThreads)
+    {
+      m_barrierCount = 0;
+      m_barrierGeneration++;
+      m_barrierDone.notify_all ();
+      return;
+    }
+  while (generation == m_barrierGeneration)
+    {
+      m_barrierDone.wait (lock);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::RunWindow (uint32_t thread)
+{
+  for (uint32_t i = thread; i < m_partitions.size (); i += m_nThreads)
+    {
+      Partition *partition = &m_partitions[i];
+      m_current = partition;
+      while (!m_stop && !partition->m_events->IsEmpty ()
+             && partition->m_events->PeekNext ().key.m_ts < m_windowEnd)
+        {
+          ProcessOneEvent (partition);
+        }
+    }
+  m_current = 0;
+}
+
+void
+MultithreadedSimulatorImpl::DoWorker (void)
+{
+  uint32_t thread;
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    m_nextThread++;
+    thread = m_nextThread;
+  }
+  NS_LOG_FUNCTION (this << thread);
+  while (true)
+    {
+      Barrier ();
+      if (m_finished)
+        {
+          return;
+        }
+      RunWindow (thread);
+      Barrier ();
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (m_current == 0, "Run called from within a simulation window");
+
+  if (!m_partitioned)
+    {
+      CalculatePartitions ();
+    }
+  m_stop = false;
+  m_finished = false;
+
+  uint32_t nThreads = m_threadCount;
+  if (nThreads == 0)
+    {
+      nThreads = std::thread::hardware_concurrency ();
+    }
+  m_nThreads = std::max<uint32_t> (1, std::min<uint32_t> (nThreads, m_partitions.size ()));
+  m_nextThread = 0;
+  m_barrierCount = 0;
+  for (uint32_t i = 1; i < m_nThreads; i++)
+    {
+      Ptr<SystemThread> thread =
+        Create<SystemThread> (MakeCallback (&MultithreadedSimulatorImpl::DoWorker, this));
+      thread->Start ();
+      m_threads.push_back (thread);
+    }
+
+  uint64_t maxTs = GetMaximumSimulationTime ().GetTimeStep ();
+  while (true)
+    {
+      // Serial phase: the helper threads wait on the barrier, so
+      // m_stop can be read and all the partitions modified safely.
+      MergeOutboxes ();
+      uint64_t next = MinNextTs ();
+      while (!m_stop && !m_global.m_events->IsEmpty () && NextTs (m_global) <= next)
+        {
+          ProcessOneEvent (&m_global);
+          next = MinNextTs ();
+        }
+      if (m_stop || next == maxTs)
+        {
+          break;
+        }
+      uint64_t windowEnd = (next > maxTs - m_lookAhead) ? maxTs : next + m_lookAhead;
+      m_windowEnd = std::min (windowEnd, NextTs (m_global));
+      NS_LOG_LOGIC ("window [" << next << ", " << m_windowEnd << ")");
+
+      // Parallel phase.
+      Barrier ();
+      RunWindow (0);
+      Barrier ();
+    }
+
+  m_finished = true;
+  Barrier ();
+  for (std::vector<Ptr<SystemThread> >::iterator i = m_threads.begin (); i != m_threads.end (); ++i)
+    {
+      (*i)->Join ();
+    }
+  m_threads.clear ();
+
+  // Now () returns the time of the last event run, as with the
+  // other simulator implementations.
+  for (std::vector<Partition>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      m_global.m_currentTs = std::max (m_global.m_currentTs, i->m_currentTs);
+      // If the simulator stopped naturally by lack of events, make a
+      // consistency test to check that we didn't lose any events along the way.
+      NS_ASSERT (!i->m_events->IsEmpty () || i->m_unscheduledEvents == 0);
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  if (m_stop)
+    {
+      return true;
+    }
+  return m_global.m_events->IsEmpty ()
+         && MinNextTs () == static_cast<uint64_t> (GetMaximumSimulationTime ().GetTimeStep ());
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  if (m_current == 0)
+    {
+      return 0;
+    }
+  return m_current->m_id;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_stop = true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &delay)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep ());
+  uint64_t ts = GetCurrent ()->m_currentTs + delay.GetTimeStep ();
+  if (m_current != 0 && ts < m_windowEnd)
+    {
+      // too close to be handed over to the global partition.
+      Simulator::Schedule (delay, &Simulator::Stop);
+    }
+  else
+    {
+      Simulator::ScheduleWithContext (Simulator::NO_CONTEXT, delay, &Simulator::Stop);
+    }
+}
+
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep () << event);
+  Partition *current = GetCurrent ();
+
+  Time tAbsolute = delay + TimeStep (current->m_currentTs);
+
+  NS_ASSERT (tAbsolute.IsPositive ());
+  NS_ASSERT (tAbsolute >= TimeStep (current->m_currentTs));
+  uint64_t ts = static_cast<uint64_t> (tAbsolute.GetTimeStep ());
+  uint32_t context = current->m_currentContext;
+  uint32_t uid = Insert (current, ts, context, event);
+  return EventId (event, ts, context, uid);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << context << delay.GetTimeStep () << event);
+  Partition *current = GetCurrent ();
+  uint64_t ts = current->m_currentTs + delay.GetTimeStep ();
+  uint32_t id = GetPartitionId (context);
+
+  if (m_current == 0 || id == current->m_id)
+    {
+      Insert (GetPartition (id), ts, context, event);
+      return;
+    }
+  if (ts < m_windowEnd)
+    {
+      NS_FATAL_ERROR ("Event scheduled at " << TimeStep (ts) << " from partition " << current->m_id <<
+                      " for partition " << id << " within the current window, which ends at " <<
+                      TimeStep (m_windowEnd) << ": the partitions must only interact through " <<
+                      "point-to-point channels");
+    }
+  Message message;
+  message.m_ts = ts;
+  message.m_context = context;
+  message.m_impl = event;
+  current->m_outbox[id].push_back (message);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << event);
+  Partition *current = GetCurrent ();
+  uint32_t uid = Insert (current, current->m_currentTs, current->m_currentContext, event);
+  return EventId (event, current->m_currentTs, current->m_currentContext, uid);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << event);
+  EventId id (Ptr<EventImpl> (event, false), GetCurrent ()->m_currentTs, 0xffffffff, 2);
+  std::lock_guard<std::mutex> lock (m_mutex);
+  m_destroyEvents.push_back (id);
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  return TimeStep (GetCurrent ()->m_currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs () - GetCurrent ()->m_currentTs);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+      std::lock_guard<std::mutex> lock (m_mutex);
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  Partition *partition = GetPartition (GetPartitionId (id.GetContext ()));
+  NS_ASSERT_MSG (m_current == 0 || m_current == partition,
+                 "Cannot remove an event of another partition");
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  partition->m_events->Remove (event);
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+
+  partition->m_unscheduledEvents--;
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &id) const
+{
+  if (id.GetUid () == 2)
+    {
+      if (id.PeekEventImpl () == 0
+          || id.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      std::lock_guard<std::mutex> lock (m_mutex);
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  const Partition *partition = GetPartition (GetPartitionId (id.GetContext ()));
+  // the time of the other partitions changes while they run: within a
+  // window, only the events of the current and global partitions can
+  // be checked.
+  NS_ASSERT_MSG (m_current == 0 || m_current == partition || partition == &m_global,
+                 "Cannot check an event of another partition");
+  if (id.PeekEventImpl () == 0
+      || id.GetTs () < partition->m_currentTs
+      || (id.GetTs () == partition->m_currentTs
+          && id.GetUid () <= partition->m_currentUid)
+      || id.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return TimeStep (0x7fffffffffffffffLL);
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  m_schedulerFactory = schedulerFactory;
+  for (uint32_t i = 0; i <= m_partitions.size (); i++)
+    {
+      Partition *partition = GetPartition (i);
+      Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+      if (partition->m_events != 0)
+        {
+          while (!partition->m_events->IsEmpty ())
+            {
+              Scheduler::Event next = partition->m_events->RemoveNext ();
+              scheduler->Insert (next);
+            }
+        }
+      partition->m_events = scheduler;
+    }
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  return GetCurrent ()->m_currentContext;
+}
+
+} // namespace ns3
@@ -0,0 +1,253 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef NS3_MULTITHREADED_SIMULATOR_IMPL_H
+#define NS3_MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "ns3/simulator-impl.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/object-factory.h"
+#include "ns3/system-thread.h"
+#include "ns3/ptr.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup mpi
+ * Declaration of class ns3::MultithreadedSimulatorImpl.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup mpi
+ *
+ * \brief Parallel simulator implementation running the partitions of a
+ * single process in several threads.
+ *
+ * Nodes are partitioned by system id, as for the
+ * DistributedSimulatorImpl, but all the partitions live in the same
+ * address space and are run by a pool of threads: partition \c p is
+ * run by thread <tt>p % ThreadCount</tt>, the calling thread being
+ * thread 0.  Events are assigned to the partition of the node their
+ * context refers to; events without a node context belong to a global
+ * partition which is only run while all the other partitions are
+ * stopped.
+ *
+ * The partitions are synchronized conservatively in time windows: the
+ * lookahead is the smallest delay of the point-to-point channels which
+ * connect nodes of different partitions, and each window covers
+ * <tt>[t, min (t + lookahead, next global event))</tt>, \c t being the
+ * earliest pending event of all the partitions.  Within a window each
+ * thread runs its partitions without any locking; events scheduled for
+ * another partition are buffered and handed over at the end of the
+ * window, in a deterministic order, so that the results do not depend
+ * on the number of threads.  Packets sent over a point-to-point channel
+ * which crosses partitions are passed by pointer, as a private
+ * Packet::DeepCopy, without being serialized.
+ *
+ * This implementation is only built when ns-3 is configured with
+ * --enable-multithreaded-simulator, which also makes the packet and
+ * event pools thread-local (see NS_THREAD_LOCAL).
+ *
+ * Restrictions:
+ *  - only point-to-point channels may connect nodes of different
+ *    partitions, and they must have a non-zero delay;
+ *  - the partition of the nodes is computed on the first call to Run:
+ *    the events of nodes created later belong to the global partition;
+ *  - trace sinks and other objects shared between partitions must be
+ *    thread-safe;
+ *  - within a window, Remove, Cancel, IsExpired and GetDelayLeft only
+ *    accept the events of the calling partition and of the global
+ *    partition;
+ *  - Stop () stops each partition before its next event: the point the
+ *    other partitions reached in the current window depends on the
+ *    scheduling of the threads.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  MultithreadedSimulatorImpl ();
+  /** Destructor. */
+  ~MultithreadedSimulatorImpl ();
+
+  // Inherited
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (Time const &delay);
+  virtual EventId Schedule (Time const &delay, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &id);
+  virtual void Cancel (const EventId &id);
+  virtual bool IsExpired (const EventId &id) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+private:
+  virtual void DoDispose (void);
+
+  /** An event sent to another partition during a window. */
+  struct Message
+  {
+    uint64_t m_ts;       //!< Event timestamp.
+    uint32_t m_context;  //!< Event context.
+    EventImpl *m_impl;   //!< Event implementation.
+  };
+
+  /** The events and the clock of one partition. */
+  struct Partition
+  {
+    uint32_t m_id;                  //!< Partition index.
+    Ptr<Scheduler> m_events;        //!< Pending events.
+    uint32_t m_uid;                 //!< Next event uid.
+    uint32_t m_currentUid;          //!< Uid of the current event.
+    uint64_t m_currentTs;           //!< Timestamp of the current event.
+    uint32_t m_currentContext;      //!< Context of the current event.
+    /**
+     * Number of events that have been inserted but not yet executed,
+     * used for validation.
+     */
+    int m_unscheduledEvents;
+    /** Events sent to other partitions, indexed by destination. */
+    std::vector<std::vector<Message> > m_outbox;
+  };
+
+  /**
+   * Get the partition of the calling thread.
+   * \returns The partition being run by the calling thread, or the
+   *          global partition outside of the parallel windows.
+   */
+  Partition * GetCurrent (void) const;
+  /**
+   * Get the index of the partition an event context belongs to.
+   * \param [in] context The context.
+   * \returns The partition index.
+   */
+  uint32_t GetPartitionId (uint32_t context) const;
+  /**
+   * Get a partition from its index.
+   * \param [in] id The partition index.
+   * \returns The partition.
+   */
+  Partition * GetPartition (uint32_t id) const;
+  /**
+   * Insert an event in a partition.
+   * \param [in] partition The partition.
+   * \param [in] ts The event timestamp.
+   * \param [in] context The event context.
+   * \param [in] event The event implementation.
+   * \returns The uid of the event.
+   */
+  uint32_t Insert (Partition *partition, uint64_t ts, uint32_t context, EventImpl *event);
+  /**
+   * Get the timestamp of the next event of a partition.
+   * \param [in] partition The partition.
+   * \returns The timestamp, or the maximum simulation time if empty.
+   */
+  uint64_t NextTs (const Partition &partition) const;
+  /**
+   * Get the earliest timestamp of all the node partitions.
+   * \returns The timestamp, or the maximum simulation time if they are empty.
+   */
+  uint64_t MinNextTs (void) const;
+  /**
+   * Run the next event of a partition.
+   * \param [in] partition The partition.
+   */
+  void ProcessOneEvent (Partition *partition);
+  /** Assign the nodes to partitions and compute the lookahead. */
+  void CalculatePartitions (void);
+  /** Hand the messages buffered during the last window to their partition. */
+  void MergeOutboxes (void);
+  /**
+   * Run the events of the current window of all the partitions of a thread.
+   * \param [in] thread The thread index.
+   */
+  void RunWindow (uint32_t thread);
+  /** Body of the helper threads. */
+  void DoWorker (void);
+  /** Wait until all the threads have reached the barrier. */
+  void Barrier (void);
+
+  /** Destroy events. */
+  typedef std::list<EventId> DestroyEvents;
+  /** The destroy events, protected by m_mutex. */
+  DestroyEvents m_destroyEvents;
+  /** The node partitions. */
+  std::vector<Partition> m_partitions;
+  /** The global partition, holding all the events before the first Run. */
+  Partition m_global;
+  /** Partition of each node, indexed by node id. */
+  std::vector<uint32_t> m_nodePartition;
+  /** Whether the nodes were assigned to partitions. */
+  bool m_partitioned;
+  /** Factory used to create the schedulers of the partitions. */
+  ObjectFactory m_schedulerFactory;
+  /** The smallest delay between partitions, in time steps. */
+  uint64_t m_lookAhead;
+  /** The end (excluded) of the current window. */
+  uint64_t m_windowEnd;
+  /** The requested number of threads, 0 for one per processor. */
+  uint32_t m_threadCount;
+  /** The number of threads used by the current Run. */
+  uint32_t m_nThreads;
+  /** The helper threads. */
+  std::vector<Ptr<SystemThread> > m_threads;
+  /** Set by Stop, and checked before each event by all the threads. */
+  std::atomic<bool> m_stop;
+  /** Tells the helper threads to exit. */
+  bool m_finished;
+
+  /** Protects the barrier and the destroy events. */
+  mutable std::mutex m_mutex;
+  /** Signals the completion of a barrier. */
+  std::condition_variable m_barrierDone;
+  /** Number of threads which reached the barrier. */
+  uint32_t m_barrierCount;
+  /** Number of barriers completed. */
+  uint64_t m_barrierGeneration;
+  /** Number of helper threads which picked their index. */
+  uint32_t m_nextThread;
+
+  /** The partition run by the calling thread, if any. */
+  static thread_local Partition *m_current;
+};
+
+} // namespace ns3
+
+#endif /* NS3_MULTITHREADED_SIMULATOR_IMPL_H */
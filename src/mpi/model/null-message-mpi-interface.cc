@@ -222,6 +222,12 @@ NullMessageMpiInterface::SendPacket (Ptr<Packet> p, const Time& rxTime, uint32_t
   Time guarantee_update = NullMessageSimulatorImpl::GetInstance ()->CalculateGuaranteeTime (nodeSysId);
   *pTime++ = guarantee_update.GetTimeStep ();
 
+  // The guarantee time is piggybacked on the packet.
+  Ptr<RemoteChannelBundle> bundle = RemoteChannelBundleManager::Find (nodeSysId);
+  NS_ASSERT (bundle);
+  bundle->SetSentGuaranteeTime (guarantee_update);
+  bundle->GetStatistics ().packetsSent++;
+
   uint32_t* pData = reinterpret_cast<uint32_t *> (pTime);
   *pData++ = node;
   *pData++ = dev;
@@ -231,7 +237,7 @@ NullMessageMpiInterface::SendPacket (Ptr<Packet> p, const Time& rxTime, uint32_t
   MPI_Isend (reinterpret_cast<void *> (iter->GetBuffer ()), bufferSize, MPI_CHAR, nodeSysId,
              0, MPI_COMM_WORLD, (iter->GetRequest ()));
 
-  NullMessageSimulatorImpl::GetInstance ()->RescheduleNullMessageEvent (nodeSysId);
+  NullMessageSimulatorImpl::GetInstance ()->RescheduleNullMessageEvent (bundle);
 
 #endif
 }
@@ -263,6 +269,9 @@ NullMessageMpiInterface::SendNullMessage (const Time& guarantee_update, Ptr<Remo
   // Find the system id for the destination MPI rank
   uint32_t nodeSysId = bundle->GetSystemId ();
 
+  bundle->SetSentGuaranteeTime (guarantee_update);
+  bundle->GetStatistics ().nullMessagesSent++;
+
   MPI_Isend (reinterpret_cast<void *> (iter->GetBuffer ()), bufferSize, MPI_CHAR, nodeSysId,
              0, MPI_COMM_WORLD, (iter->GetRequest ()));
 #endif
@@ -370,6 +379,15 @@ NullMessageMpiInterface::ReceiveMessages (bool blocking)
           Ptr<RemoteChannelBundle> bundle = RemoteChannelBundleManager::Find (status.MPI_SOURCE);
           NS_ASSERT (bundle);
 
+          if (rxTime > Time (0))
+            {
+              bundle->GetStatistics ().packetsReceived++;
+            }
+          else
+            {
+              bundle->GetStatistics ().nullMessagesReceived++;
+            }
+
           bundle->SetGuaranteeTime (Time (guaranteeUpdate));
 
           // Re-queue the next read
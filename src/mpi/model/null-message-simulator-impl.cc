@@ -32,11 +32,13 @@
 #include <ns3/channel.h>
 #include <ns3/node-container.h>
 #include <ns3/double.h>
+#include <ns3/boolean.h>
 #include <ns3/ptr.h>
 #include <ns3/pointer.h>
 #include <ns3/assert.h>
 #include <ns3/log.h>
 
+#include <chrono>
 #include <cmath>
 #include <iostream>
 #include <fstream>
@@ -61,6 +63,18 @@ NullMessageSimulatorImpl::GetTypeId (void)
                    DoubleValue (1.0),
                    MakeDoubleAccessor (&NullMessageSimulatorImpl::m_schedulerTune),
                    MakeDoubleChecker<double> (0.01,1.0))
+    .AddAttribute ("AdaptiveNullMessages",
+                   "Only send Null Messages when the guarantee time known by the remote task "
+                   "is about to be reached and can be advanced, and send pending guarantee "
+                   "updates before blocking",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&NullMessageSimulatorImpl::m_adaptiveNullMessages),
+                   MakeBooleanChecker ())
+    .AddAttribute ("PrintStatistics",
+                   "Print the message and stall statistics of each remote task on Destroy",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&NullMessageSimulatorImpl::m_printStatistics),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
@@ -131,6 +145,12 @@ NullMessageSimulatorImpl::Destroy ()
         }
     }
 
+  if (m_printStatistics)
+    {
+      std::cout << "NullMessageSimulatorImpl statistics of rank " << m_myId << std::endl;
+      RemoteChannelBundleManager::PrintStatistics (std::cout);
+    }
+
   RemoteChannelBundleManager::Destroy();
   MpiInterface::Destroy ();
 }
@@ -267,6 +287,13 @@ NullMessageSimulatorImpl::ScheduleNullMessageEvent (Ptr<RemoteChannelBundle> bun
   NS_LOG_FUNCTION (this << bundle);
 
   Time delay (m_schedulerTune * bundle->GetDelay ().GetTimeStep ());
+  if (m_adaptiveNullMessages)
+    {
+      // The remote task may advance up to the guarantee time already
+      // sent; a new one is only needed when local time gets within a
+      // link delay of it.
+      delay = Max (delay, bundle->GetSentGuaranteeTime () - bundle->GetDelay () - Now ());
+    }
 
   bundle->SetEventId (Simulator::Schedule (delay, &NullMessageSimulatorImpl::NullMessageEventHandler, 
                                            this, PeekPointer(bundle)));
@@ -277,6 +304,13 @@ NullMessageSimulatorImpl::RescheduleNullMessageEvent (Ptr<RemoteChannelBundle> b
 {
   NS_LOG_FUNCTION (this << bundle);
 
+  if (m_adaptiveNullMessages)
+    {
+      // The packet carried the guarantee time; the pending Null Message
+      // will be suppressed unless the guarantee advances by then.
+      return;
+    }
+
   Simulator::Cancel (bundle->GetEventId ());
 
   Time delay (m_schedulerTune * bundle->GetDelay ().GetTimeStep ());
@@ -342,8 +376,25 @@ NullMessageSimulatorImpl::HandleArrivingMessagesBlocking (void)
 {
   NS_LOG_FUNCTION (this);
 
+  if (m_adaptiveNullMessages)
+    {
+      // Let the neighbors advance as far as possible while this task waits.
+      RemoteChannelBundleManager::SendPendingNullMessages ();
+    }
+
+  Ptr<RemoteChannelBundle> limiting = RemoteChannelBundleManager::GetLimitingBundle ();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+
   NullMessageMpiInterface::ReceiveMessagesBlocking ();
 
+  if (limiting)
+    {
+      std::chrono::nanoseconds stall = std::chrono::steady_clock::now () - start;
+      RemoteChannelBundle::Statistics &stats = limiting->GetStatistics ();
+      stats.stalls++;
+      stats.stallTime += NanoSeconds (stall.count ());
+    }
+
   CalculateSafeTime ();
 
   // Check for send completes
@@ -588,7 +639,15 @@ void NullMessageSimulatorImpl::NullMessageEventHandler(RemoteChannelBundle* bund
   NS_LOG_FUNCTION (this << bundle);
 
   Time time = Min (Next (), GetSafeTime ()) + bundle->GetDelay ();
-  NullMessageMpiInterface::SendNullMessage (time, bundle);
+  if (m_adaptiveNullMessages && time <= bundle->GetSentGuaranteeTime ())
+    {
+      // The remote task already knows this guarantee time.
+      bundle->GetStatistics ().nullMessagesSuppressed++;
+    }
+  else
+    {
+      NullMessageMpiInterface::SendNullMessage (time, bundle);
+    }
 
   ScheduleNullMessageEvent (bundle);
 }
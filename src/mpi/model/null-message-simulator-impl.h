@@ -201,6 +201,21 @@ private:
    */
   double m_schedulerTune;
 
+  /*
+   * When true, the Null Message event of a bundle is delayed until the
+   * guarantee time already sent to the remote task is about to be
+   * reached, Null Messages which would not advance that guarantee are
+   * suppressed, the event is not rescheduled when a packet carrying a
+   * guarantee time is sent, and pending guarantee updates are sent to
+   * every neighbor before blocking.
+   */
+  bool m_adaptiveNullMessages;
+
+  /*
+   * Print the statistics of each remote channel bundle on Destroy.
+   */
+  bool m_printStatistics;
+
   /*
    * Singleton instance.
    */
@@ -23,6 +23,7 @@
 
 #include "remote-channel-bundle.h"
 #include "null-message-simulator-impl.h"
+#include "null-message-mpi-interface.h"
 
 #include "ns3/simulator.h"
 
@@ -100,6 +101,55 @@ RemoteChannelBundleManager::GetSafeTime (void)
   return safeTime;
 }
 
+Ptr<RemoteChannelBundle>
+RemoteChannelBundleManager::GetLimitingBundle (void)
+{
+  Ptr<RemoteChannelBundle> limiting = 0;
+
+  for (RemoteChannelMap::const_iterator kv = g_remoteChannelBundles.begin ();
+       kv != g_remoteChannelBundles.end ();
+       ++kv)
+    {
+      if (limiting == 0 || kv->second->GetGuaranteeTime () < limiting->GetGuaranteeTime ())
+        {
+          limiting = kv->second;
+        }
+    }
+
+  return limiting;
+}
+
+void
+RemoteChannelBundleManager::SendPendingNullMessages (void)
+{
+  NS_ASSERT (g_initialized);
+
+  NullMessageSimulatorImpl *simulator = NullMessageSimulatorImpl::GetInstance ();
+  for (RemoteChannelMap::const_iterator kv = g_remoteChannelBundles.begin ();
+       kv != g_remoteChannelBundles.end ();
+       ++kv)
+    {
+      Ptr<RemoteChannelBundle> bundle = kv->second;
+      Time guarantee = simulator->CalculateGuaranteeTime (bundle->GetSystemId ());
+      if (guarantee > bundle->GetSentGuaranteeTime ())
+        {
+          NullMessageMpiInterface::SendNullMessage (guarantee, bundle);
+        }
+    }
+}
+
+void
+RemoteChannelBundleManager::PrintStatistics (std::ostream &os)
+{
+  for (RemoteChannelMap::const_iterator kv = g_remoteChannelBundles.begin ();
+       kv != g_remoteChannelBundles.end ();
+       ++kv)
+    {
+      Ptr<RemoteChannelBundle> bundle = kv->second;
+      os << *bundle;
+    }
+}
+
 void
 RemoteChannelBundleManager::Destroy (void)
 {
@@ -25,6 +25,7 @@
 #include <ns3/nstime.h>
 #include <ns3/ptr.h>
 #include <map>
+#include <ostream>
 
 namespace ns3 {
 
@@ -69,6 +70,26 @@ public:
    */
   static Time GetSafeTime (void);
 
+  /**
+   * \return the bundle with the smallest guarantee time, the one
+   * limiting the safe time, or 0 if there is no bundle.
+   */
+  static Ptr<RemoteChannelBundle> GetLimitingBundle (void);
+
+  /**
+   * Send a Null Message to every remote task whose guarantee time
+   * advanced past the last one sent to it, with a packet or a Null
+   * Message.
+   */
+  static void SendPendingNullMessages (void);
+
+  /**
+   * \param os output stream
+   *
+   * Print the statistics of every RemoteChannelBundle.
+   */
+  static void PrintStatistics (std::ostream &os);
+
   /**
    * Destroy the singleton.
    */
@@ -30,6 +30,17 @@ namespace ns3 {
 
 #define NS_TIME_INFINITY ns3::Time (0x7fffffffffffffffLL)
 
+RemoteChannelBundle::Statistics::Statistics ()
+  : packetsSent (0),
+    packetsReceived (0),
+    nullMessagesSent (0),
+    nullMessagesSuppressed (0),
+    nullMessagesReceived (0),
+    stalls (0),
+    stallTime (0)
+{
+}
+
 TypeId RemoteChannelBundle::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::RemoteChannelBundle")
@@ -42,14 +53,16 @@ TypeId RemoteChannelBundle::GetTypeId (void)
 RemoteChannelBundle::RemoteChannelBundle ()
   : m_remoteSystemId (-1),
     m_guaranteeTime (0),
-    m_delay (NS_TIME_INFINITY)
+    m_delay (NS_TIME_INFINITY),
+    m_sentGuaranteeTime (0)
 {
 }
 
 RemoteChannelBundle::RemoteChannelBundle (const uint32_t remoteSystemId)
   : m_remoteSystemId (remoteSystemId),
     m_guaranteeTime (0),
-    m_delay (NS_TIME_INFINITY)
+    m_delay (NS_TIME_INFINITY),
+    m_sentGuaranteeTime (0)
 {
 }
 
@@ -80,12 +93,30 @@ RemoteChannelBundle::SetGuaranteeTime (Time time)
   m_guaranteeTime = time;
 }
 
+Time
+RemoteChannelBundle::GetSentGuaranteeTime (void) const
+{
+  return m_sentGuaranteeTime;
+}
+
+void
+RemoteChannelBundle::SetSentGuaranteeTime (Time time)
+{
+  m_sentGuaranteeTime = time;
+}
+
 Time
 RemoteChannelBundle::GetDelay (void) const
 {
   return m_delay;
 }
 
+RemoteChannelBundle::Statistics &
+RemoteChannelBundle::GetStatistics (void)
+{
+  return m_statistics;
+}
+
 void
 RemoteChannelBundle::SetEventId (EventId id)
 {
@@ -115,6 +146,15 @@ std::ostream& operator<< (std::ostream& out, ns3::RemoteChannelBundle& bundle )
   out << "RemoteChannelBundle Rank = " << bundle.m_remoteSystemId
       << ", GuaranteeTime = "  << bundle.m_guaranteeTime
       << ", Delay = " << bundle.m_delay << std::endl;
+
+  const RemoteChannelBundle::Statistics &stats = bundle.m_statistics;
+  out << "\tPackets sent = " << stats.packetsSent
+      << ", received = " << stats.packetsReceived << std::endl
+      << "\tNull Messages sent = " << stats.nullMessagesSent
+      << ", suppressed = " << stats.nullMessagesSuppressed
+      << ", received = " << stats.nullMessagesReceived << std::endl
+      << "\tStalls = " << stats.stalls
+      << ", stall time = " << stats.stallTime.GetSeconds () << "s" << std::endl;
   
   for (std::map < uint32_t, Ptr < Channel > > ::const_iterator pair = bundle.m_channels.begin ();
        pair != bundle.m_channels.end ();
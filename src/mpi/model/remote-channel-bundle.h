@@ -47,6 +47,27 @@ class RemoteChannelBundle : public Object
 public:
   static TypeId GetTypeId (void);
 
+  /**
+   * Message and synchronization counters of a bundle.
+   */
+  struct Statistics
+  {
+    Statistics ();
+
+    uint32_t packetsSent;             //!< Packets sent to the remote task
+    uint32_t packetsReceived;         //!< Packets received from the remote task
+    uint32_t nullMessagesSent;        //!< Null Messages sent to the remote task
+    uint32_t nullMessagesSuppressed;  //!< Null Messages not sent because the guarantee did not advance
+    uint32_t nullMessagesReceived;    //!< Null Messages received from the remote task
+    /**
+     * Number of times the local task blocked while this bundle had the
+     * smallest guarantee time.
+     */
+    uint32_t stalls;
+    /** Wall clock time spent blocked while this bundle had the smallest guarantee time. */
+    Time stallTime;
+  };
+
   RemoteChannelBundle ();
 
   RemoteChannelBundle (const uint32_t remoteSystemId);
@@ -79,11 +100,29 @@ public:
    */
   void SetGuaranteeTime (Time time);
 
+  /**
+   * \return the last guarantee time sent to the remote task, with a
+   * packet or a Null Message
+   */
+  Time GetSentGuaranteeTime (void) const;
+
+  /**
+   * \param time guarantee time
+   *
+   * Record the guarantee time sent to the remote task.
+   */
+  void SetSentGuaranteeTime (Time time);
+
   /**
    * \return the minimum delay along any channel in this bundle
    */
   Time GetDelay (void) const;
 
+  /**
+   * \return the counters of this bundle
+   */
+  Statistics & GetStatistics (void);
+
   /**
    * Set the event ID of the Null Message send event current scheduled
    * for this channel.
@@ -139,11 +178,21 @@ private:
    */
   Time m_delay;
 
+  /*
+   * Last guarantee time sent to remote_rank.
+   */
+  Time m_sentGuaranteeTime;
+
   /*
    * Event scheduled to send Null Message for this bundle.
    */
   EventId m_nullEventId;
 
+  /*
+   * Message and synchronization counters.
+   */
+  Statistics m_statistics;
+
 };
 
 }
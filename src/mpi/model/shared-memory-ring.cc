@@ -0,0 +1,288 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "shared-memory-ring.h"
+
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ns3/unused.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * \file
+ * \ingroup mpi
+ * Implementation of classes ns3::SharedMemoryRing and ns3::SharedMemorySegment.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SharedMemoryRing");
+
+/**
+ * The positions of a ring, each on its own cache line so that the
+ * reader and the writer do not contend for it.
+ */
+struct SharedMemoryRing::Header
+{
+  std::atomic<uint64_t> m_head;  //!< Position following the last published record.
+  char m_pad1[64 - sizeof (std::atomic<uint64_t>)];  //!< Padding.
+  std::atomic<uint64_t> m_tail;  //!< Position of the oldest record not yet released.
+  char m_pad2[64 - sizeof (std::atomic<uint64_t>)];  //!< Padding.
+};
+
+namespace {
+
+/** Size of the header of each record. */
+const uint32_t RECORD_HEADER = 8;
+/** Size of a padding record, marking the end of the storage. */
+const uint32_t RECORD_PADDING = 0xffffffff;
+
+} // unnamed namespace
+
+SharedMemoryRing::SharedMemoryRing ()
+  : m_header (0),
+    m_storage (0),
+    m_capacity (0),
+    m_head (0),
+    m_cachedTail (0),
+    m_next (0)
+{
+}
+
+size_t
+SharedMemoryRing::GetStorageSize (uint32_t capacity)
+{
+  NS_ASSERT (capacity % RECORD_HEADER == 0);
+  return sizeof (Header) + capacity;
+}
+
+void
+SharedMemoryRing::Format (void *memory, uint32_t capacity)
+{
+  NS_LOG_FUNCTION (memory << capacity);
+  NS_ASSERT (std::atomic<uint64_t> ().is_lock_free ());
+  Header *header = new (memory) Header;
+  header->m_head.store (0, std::memory_order_relaxed);
+  header->m_tail.store (0, std::memory_order_relaxed);
+  std::atomic_thread_fence (std::memory_order_release);
+  NS_UNUSED (capacity);
+}
+
+void
+SharedMemoryRing::Attach (void *memory, uint32_t capacity)
+{
+  NS_LOG_FUNCTION (this << memory << capacity);
+  m_header = static_cast<Header *> (memory);
+  m_storage = static_cast<uint8_t *> (memory) + sizeof (Header);
+  m_capacity = capacity;
+  m_head = m_header->m_head.load (std::memory_order_acquire);
+  m_cachedTail = m_header->m_tail.load (std::memory_order_acquire);
+  m_next = m_cachedTail;
+}
+
+bool
+SharedMemoryRing::IsAttached (void) const
+{
+  return m_header != 0;
+}
+
+uint64_t
+SharedMemoryRing::GetRecordSize (uint32_t size)
+{
+  return (static_cast<uint64_t> (size) + RECORD_HEADER + 7) & ~static_cast<uint64_t> (7);
+}
+
+uint8_t *
+SharedMemoryRing::Reserve (uint32_t size)
+{
+  NS_ASSERT (IsAttached ());
+  uint64_t recordSize = GetRecordSize (size);
+  uint64_t offset = m_head % m_capacity;
+  uint64_t padding = 0;
+  if (offset + recordSize > m_capacity)
+    {
+      // start again at the beginning of the storage.
+      padding = m_capacity - offset;
+    }
+  uint64_t end = m_head + padding + recordSize;
+  if (end - m_cachedTail > m_capacity)
+    {
+      // only read the tail, written by the other process, when the
+      // last value read does not leave enough room.
+      m_cachedTail = m_header->m_tail.load (std::memory_order_acquire);
+      if (end - m_cachedTail > m_capacity)
+        {
+          return 0;
+        }
+    }
+  if (padding != 0)
+    {
+      uint32_t marker = RECORD_PADDING;
+      std::memcpy (m_storage + offset, &marker, sizeof (marker));
+      offset = 0;
+    }
+  std::memcpy (m_storage + offset, &size, sizeof (size));
+  m_head = end;
+  return m_storage + offset + RECORD_HEADER;
+}
+
+void
+SharedMemoryRing::Commit (void)
+{
+  NS_ASSERT (IsAttached ());
+  m_header->m_head.store (m_head, std::memory_order_release);
+}
+
+bool
+SharedMemoryRing::HasReserved (void) const
+{
+  return IsAttached () && m_header->m_head.load (std::memory_order_relaxed) != m_head;
+}
+
+const uint8_t *
+SharedMemoryRing::Peek (uint32_t *size)
+{
+  NS_ASSERT (IsAttached ());
+  uint64_t tail = m_header->m_tail.load (std::memory_order_relaxed);
+  uint64_t head = m_header->m_head.load (std::memory_order_acquire);
+  if (tail == head)
+    {
+      return 0;
+    }
+  uint64_t offset = tail % m_capacity;
+  uint32_t recordSize;
+  std::memcpy (&recordSize, m_storage + offset, sizeof (recordSize));
+  if (recordSize == RECORD_PADDING)
+    {
+      tail += m_capacity - offset;
+      offset = 0;
+      std::memcpy (&recordSize, m_storage, sizeof (recordSize));
+    }
+  NS_ASSERT (tail < head);
+  *size = recordSize;
+  m_next = tail + GetRecordSize (recordSize);
+  return m_storage + offset + RECORD_HEADER;
+}
+
+void
+SharedMemoryRing::Release (void)
+{
+  NS_ASSERT (IsAttached ());
+  m_header->m_tail.store (m_next, std::memory_order_release);
+}
+
+SharedMemorySegment::SharedMemorySegment ()
+  : m_address (0),
+    m_size (0),
+    m_owner (false)
+{
+}
+
+SharedMemorySegment::~SharedMemorySegment ()
+{
+  Close ();
+}
+
+bool
+SharedMemorySegment::Map (const std::string &name, size_t size, bool create)
+{
+  NS_LOG_FUNCTION (this << name << size << create);
+  NS_ASSERT (m_address == 0);
+  int flags = create ? (O_RDWR | O_CREAT | O_EXCL) : O_RDWR;
+  int fd = shm_open (name.c_str (), flags, S_IRUSR | S_IWUSR);
+  if (fd < 0)
+    {
+      NS_LOG_WARN ("cannot open shared memory segment " << name << ": " << std::strerror (errno));
+      return false;
+    }
+  if (create && ftruncate (fd, size) != 0)
+    {
+      NS_LOG_WARN ("cannot size shared memory segment " << name << ": " << std::strerror (errno));
+      close (fd);
+      shm_unlink (name.c_str ());
+      return false;
+    }
+  void *address = mmap (0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close (fd);
+  if (address == MAP_FAILED)
+    {
+      NS_LOG_WARN ("cannot map shared memory segment " << name << ": " << std::strerror (errno));
+      if (create)
+        {
+          shm_unlink (name.c_str ());
+        }
+      return false;
+    }
+  m_name = name;
+  m_address = static_cast<uint8_t *> (address);
+  m_size = size;
+  m_owner = create;
+  return true;
+}
+
+bool
+SharedMemorySegment::Create (const std::string &name, size_t size)
+{
+  return Map (name, size, true);
+}
+
+bool
+SharedMemorySegment::Open (const std::string &name, size_t size)
+{
+  return Map (name, size, false);
+}
+
+void
+SharedMemorySegment::Unlink (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_owner)
+    {
+      shm_unlink (m_name.c_str ());
+      m_owner = false;
+    }
+}
+
+void
+SharedMemorySegment::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  Unlink ();
+  if (m_address != 0)
+    {
+      munmap (m_address, m_size);
+      m_address = 0;
+      m_size = 0;
+    }
+}
+
+uint8_t *
+SharedMemorySegment::GetAddress (void) const
+{
+  return m_address;
+}
+
+} // namespace ns3
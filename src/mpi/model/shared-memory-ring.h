@@ -0,0 +1,184 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef NS3_SHARED_MEMORY_RING_H
+#define NS3_SHARED_MEMORY_RING_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+
+/**
+ * \file
+ * \ingroup mpi
+ * Declaration of classes ns3::SharedMemoryRing and ns3::SharedMemorySegment.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup mpi
+ *
+ * \brief A single-producer, single-consumer ring of variable-sized
+ * records, stored in memory shared by two processes.
+ *
+ * The ring is made of a header holding the write (head) and read
+ * (tail) positions, each on its own cache line, followed by the record
+ * storage.  Positions only grow: the offset of a position in the
+ * storage is the position modulo the capacity.  The writer publishes
+ * the records it reserved by storing the new head with release
+ * semantics, and the reader frees a record by storing the new tail once
+ * it is done with it, so no lock is ever taken.  Several records may be
+ * reserved before they are published together, so that the shared
+ * head is only written once per batch.
+ *
+ * Records are contiguous: when a record does not fit before the end of
+ * the storage, a padding record fills the end and the record starts
+ * again at offset 0.
+ *
+ * This object only holds pointers into the shared memory: copies
+ * refer to the same ring.
+ */
+class SharedMemoryRing
+{
+public:
+  SharedMemoryRing ();
+
+  /**
+   * \param [in] capacity The size of the record storage, in bytes.
+   * \returns The number of bytes needed to store a ring, header included.
+   */
+  static size_t GetStorageSize (uint32_t capacity);
+  /**
+   * Initialize an empty ring in some memory.
+   *
+   * \param [in] memory The memory, at least GetStorageSize (capacity)
+   *             bytes long and 64-byte aligned.
+   * \param [in] capacity The size of the record storage, in bytes.
+   */
+  static void Format (void *memory, uint32_t capacity);
+
+  /**
+   * Attach this object to a ring initialized by Format.
+   *
+   * \param [in] memory The memory given to Format, possibly mapped at
+   *             another address.
+   * \param [in] capacity The capacity given to Format.
+   */
+  void Attach (void *memory, uint32_t capacity);
+  /** \returns true if this object is attached to a ring. */
+  bool IsAttached (void) const;
+
+  /**
+   * Reserve room for a record.
+   *
+   * The record is only visible to the reader once Commit is called.
+   *
+   * \param [in] size The size of the record.
+   * \returns A pointer to \p size writable bytes, or 0 if the ring is full.
+   */
+  uint8_t * Reserve (uint32_t size);
+  /** Publish all the records reserved since the last call to Commit. */
+  void Commit (void);
+  /** \returns true if some records are reserved but not yet published. */
+  bool HasReserved (void) const;
+
+  /**
+   * Get the oldest record of the ring.
+   *
+   * \param [out] size The size of the record.
+   * \returns A pointer to the record, or 0 if the ring is empty.
+   */
+  const uint8_t * Peek (uint32_t *size);
+  /** Free the record returned by the last call to Peek. */
+  void Release (void);
+
+private:
+  struct Header;
+
+  /**
+   * \param [in] size A record size.
+   * \returns The room taken by the record, including its own header.
+   */
+  static uint64_t GetRecordSize (uint32_t size);
+
+  Header *m_header;       //!< The shared positions.
+  uint8_t *m_storage;     //!< The shared record storage.
+  uint64_t m_capacity;    //!< The size of m_storage.
+  uint64_t m_head;        //!< Writer: the position following the last reserved record.
+  uint64_t m_cachedTail;  //!< Writer: the last tail read from the shared header.
+  uint64_t m_next;        //!< Reader: the position following the peeked record.
+};
+
+/**
+ * \ingroup mpi
+ *
+ * \brief A named POSIX shared memory segment, mapped in the address
+ * space of the process.
+ */
+class SharedMemorySegment
+{
+public:
+  SharedMemorySegment ();
+  ~SharedMemorySegment ();
+
+  /**
+   * Create, size and map a new segment.
+   *
+   * \param [in] name The name of the segment, starting with a '/'.
+   * \param [in] size The size of the segment.
+   * \returns true on success.
+   */
+  bool Create (const std::string &name, size_t size);
+  /**
+   * Map an existing segment.
+   *
+   * \param [in] name The name of the segment.
+   * \param [in] size The size of the segment.
+   * \returns true on success.
+   */
+  bool Open (const std::string &name, size_t size);
+  /**
+   * Remove the name of the segment created by this object, so that
+   * the memory is released when the last process unmaps it.
+   */
+  void Unlink (void);
+  /** Unmap the segment. */
+  void Close (void);
+  /** \returns The address the segment is mapped at, or 0. */
+  uint8_t * GetAddress (void) const;
+
+private:
+  /**
+   * Map a segment.
+   *
+   * \param [in] name The name of the segment.
+   * \param [in] size The size of the segment.
+   * \param [in] create Whether the segment must be created.
+   * \returns true on success.
+   */
+  bool Map (const std::string &name, size_t size, bool create);
+
+  std::string m_name;  //!< The name of the segment.
+  uint8_t *m_address;  //!< The mapping address.
+  size_t m_size;       //!< The size of the mapping.
+  bool m_owner;        //!< Whether this object created the segment.
+};
+
+} // namespace ns3
+
+#endif /* NS3_SHARED_MEMORY_RING_H */
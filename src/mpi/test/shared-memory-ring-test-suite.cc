@@ -0,0 +1,323 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstring>
+#include <vector>
+
+#include "ns3/test.h"
+#include "../model/shared-memory-ring.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup mpi
+ * \defgroup mpi-test mpi module tests
+ */
+
+/**
+ * \ingroup mpi-test
+ * \ingroup tests
+ *
+ * \brief Base class of the SharedMemoryRing tests
+ *
+ * The ring lives in private memory: a writer and a reader are attached
+ * to it, as the two processes sharing a segment would be.
+ */
+class SharedMemoryRingTestCase : public TestCase
+{
+public:
+  /**
+   * \param name the name of the test
+   */
+  SharedMemoryRingTestCase (std::string name);
+
+protected:
+  /**
+   * Format a new ring, and attach the writer and the reader to it.
+   *
+   * \param capacity the size of the record storage, in bytes
+   */
+  void CreateRing (uint32_t capacity);
+  /**
+   * Reserve a record filled with a pattern.
+   *
+   * \param size the size of the record
+   * \param seed the first byte of the pattern
+   * \returns true if the record was reserved
+   */
+  bool Push (uint32_t size, uint8_t seed);
+  /**
+   * Check and release the oldest record.
+   *
+   * \param size the expected size of the record
+   * \param seed the expected first byte of the pattern
+   */
+  void Pop (uint32_t size, uint8_t seed);
+
+  SharedMemoryRing m_writer;  //!< The writer side of the ring
+  SharedMemoryRing m_reader;  //!< The reader side of the ring
+
+private:
+  std::vector<uint8_t> m_memory;  //!< The memory holding the ring
+  uint8_t *m_start;               //!< The 64-byte aligned start of the ring
+  uint32_t m_capacity;            //!< The capacity of the ring
+};
+
+SharedMemoryRingTestCase::SharedMemoryRingTestCase (std::string name)
+  : TestCase (name),
+    m_start (0),
+    m_capacity (0)
+{
+}
+
+void
+SharedMemoryRingTestCase::CreateRing (uint32_t capacity)
+{
+  m_memory.assign (SharedMemoryRing::GetStorageSize (capacity) + 64, 0);
+  uintptr_t address = reinterpret_cast<uintptr_t> (&m_memory[0]);
+  m_start = &m_memory[0] + (64 - address % 64) % 64;
+  m_capacity = capacity;
+  SharedMemoryRing::Format (m_start, capacity);
+  m_writer.Attach (m_start, capacity);
+  m_reader.Attach (m_start, capacity);
+}
+
+bool
+SharedMemoryRingTestCase::Push (uint32_t size, uint8_t seed)
+{
+  uint8_t *record = m_writer.Reserve (size);
+  if (record == 0)
+    {
+      return false;
+    }
+  NS_TEST_EXPECT_MSG_EQ ((record >= m_start + SharedMemoryRing::GetStorageSize (0)
+                          && record + size <= m_start + SharedMemoryRing::GetStorageSize (m_capacity)),
+                         true, "Record outside of the storage");
+  for (uint32_t i = 0; i < size; i++)
+    {
+      record[i] = static_cast<uint8_t> (seed + i);
+    }
+  return true;
+}
+
+void
+SharedMemoryRingTestCase::Pop (uint32_t size, uint8_t seed)
+{
+  uint32_t recordSize = 0;
+  const uint8_t *record = m_reader.Peek (&recordSize);
+  NS_TEST_ASSERT_MSG_EQ ((record != 0), true, "Missing record");
+  NS_TEST_ASSERT_MSG_EQ (recordSize, size, "Unexpected record size");
+  bool same = true;
+  for (uint32_t i = 0; i < size; i++)
+    {
+      same = same && record[i] == static_cast<uint8_t> (seed + i);
+    }
+  NS_TEST_EXPECT_MSG_EQ (same, true, "Corrupted record");
+  m_reader.Release ();
+}
+
+/**
+ * \ingroup mpi-test
+ * \ingroup tests
+ *
+ * \brief Records are read back in order, once committed
+ */
+class SharedMemoryRingPushPopTestCase : public SharedMemoryRingTestCase
+{
+public:
+  SharedMemoryRingPushPopTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SharedMemoryRingPushPopTestCase::SharedMemoryRingPushPopTestCase ()
+  : SharedMemoryRingTestCase ("Check that the records of a SharedMemoryRing are read in order")
+{
+}
+
+void
+SharedMemoryRingPushPopTestCase::DoRun (void)
+{
+  CreateRing (1024);
+  uint32_t size;
+  NS_TEST_EXPECT_MSG_EQ ((m_reader.Peek (&size) == 0), true, "A new ring is not empty");
+  NS_TEST_EXPECT_MSG_EQ (m_writer.HasReserved (), false, "A new ring has reserved records");
+
+  // records of all the sizes modulo 8, and an empty one.
+  const uint32_t sizes[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 100 };
+  const uint32_t nSizes = sizeof (sizes) / sizeof (sizes[0]);
+  for (uint32_t i = 0; i < nSizes; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (Push (sizes[i], i), true, "Could not reserve a record");
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_writer.HasReserved (), true, "The records are not reserved");
+  NS_TEST_EXPECT_MSG_EQ ((m_reader.Peek (&size) == 0), true, "A record is visible before Commit");
+
+  m_writer.Commit ();
+  NS_TEST_EXPECT_MSG_EQ (m_writer.HasReserved (), false, "The records were not published");
+  for (uint32_t i = 0; i < nSizes; i++)
+    {
+      Pop (sizes[i], i);
+    }
+  NS_TEST_EXPECT_MSG_EQ ((m_reader.Peek (&size) == 0), true, "The ring is not empty");
+
+  // a reader attached later starts at the oldest record.
+  NS_TEST_ASSERT_MSG_EQ (Push (10, 42), true, "Could not reserve a record");
+  m_writer.Commit ();
+  SharedMemoryRing reader = m_reader;
+  const uint8_t *first = reader.Peek (&size);
+  NS_TEST_EXPECT_MSG_EQ ((first == m_reader.Peek (&size)), true, "Copies disagree on the oldest record");
+  Pop (10, 42);
+}
+
+/**
+ * \ingroup mpi-test
+ * \ingroup tests
+ *
+ * \brief Records which do not fit before the end of the storage start
+ * again at its beginning
+ */
+class SharedMemoryRingWrapTestCase : public SharedMemoryRingTestCase
+{
+public:
+  SharedMemoryRingWrapTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SharedMemoryRingWrapTestCase::SharedMemoryRingWrapTestCase ()
+  : SharedMemoryRingTestCase ("Check that the records of a SharedMemoryRing wrap around")
+{
+}
+
+void
+SharedMemoryRingWrapTestCase::DoRun (void)
+{
+  // 48-byte records in 256 bytes: the end of the storage is padded
+  // at a different offset on each pass.
+  CreateRing (256);
+  uint32_t pushed = 0;
+  uint32_t popped = 0;
+  for (uint32_t round = 0; round < 200; round++)
+    {
+      uint32_t n = 1 + round % 3;
+      for (uint32_t i = 0; i < n; i++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (Push (40, pushed), true, "Could not reserve a record");
+          pushed++;
+        }
+      m_writer.Commit ();
+      while (pushed - popped > 1)
+        {
+          Pop (40, popped);
+          popped++;
+        }
+    }
+  while (popped < pushed)
+    {
+      Pop (40, popped);
+      popped++;
+    }
+  uint32_t size;
+  NS_TEST_EXPECT_MSG_EQ ((m_reader.Peek (&size) == 0), true, "The ring is not empty");
+}
+
+/**
+ * \ingroup mpi-test
+ * \ingroup tests
+ *
+ * \brief The writer stops when the ring is full, and resumes once the
+ * reader frees some room
+ */
+class SharedMemoryRingFullTestCase : public SharedMemoryRingTestCase
+{
+public:
+  SharedMemoryRingFullTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SharedMemoryRingFullTestCase::SharedMemoryRingFullTestCase ()
+  : SharedMemoryRingTestCase ("Check that a full SharedMemoryRing refuses records")
+{
+}
+
+void
+SharedMemoryRingFullTestCase::DoRun (void)
+{
+  // 8 records of 32 bytes, headers included, fill the storage exactly.
+  CreateRing (256);
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (Push (24, i), true, "Could not reserve a record");
+    }
+  NS_TEST_EXPECT_MSG_EQ (Push (0, 0), false, "A record was reserved in a full ring");
+  m_writer.Commit ();
+  NS_TEST_EXPECT_MSG_EQ (Push (0, 0), false, "A record was reserved in a full ring");
+
+  // a released record frees its room, but not more.
+  Pop (24, 0);
+  NS_TEST_EXPECT_MSG_EQ (Push (32, 0), false, "A record larger than the free room was reserved");
+  NS_TEST_ASSERT_MSG_EQ (Push (24, 8), true, "Could not reserve a record in the free room");
+  m_writer.Commit ();
+  for (uint32_t i = 1; i < 9; i++)
+    {
+      Pop (24, i);
+    }
+  uint32_t size;
+  NS_TEST_EXPECT_MSG_EQ ((m_reader.Peek (&size) == 0), true, "The ring is not empty");
+
+  // the whole storage can be used by a single record, once empty and
+  // back at its beginning.
+  for (uint32_t i = 0; i < 7; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (Push (24, i), true, "Could not reserve a record");
+    }
+  m_writer.Commit ();
+  for (uint32_t i = 0; i < 7; i++)
+    {
+      Pop (24, i);
+    }
+  NS_TEST_EXPECT_MSG_EQ (Push (256, 0), false, "A record larger than the storage was reserved");
+  NS_TEST_ASSERT_MSG_EQ (Push (248, 7), true, "Could not reserve a record as large as the storage");
+  m_writer.Commit ();
+  Pop (248, 7);
+}
+
+/**
+ * \ingroup mpi-test
+ * \ingroup tests
+ *
+ * \brief TestSuite of the SharedMemoryRing
+ */
+class SharedMemoryRingTestSuite : public TestSuite
+{
+public:
+  SharedMemoryRingTestSuite ();
+};
+
+SharedMemoryRingTestSuite::SharedMemoryRingTestSuite ()
+  : TestSuite ("mpi-shared-memory-ring", UNIT)
+{
+  AddTestCase (new SharedMemoryRingPushPopTestCase, TestCase::QUICK);
+  AddTestCase (new SharedMemoryRingWrapTestCase, TestCase::QUICK);
+  AddTestCase (new SharedMemoryRingFullTestCase, TestCase::QUICK);
+}
+
+static SharedMemoryRingTestSuite g_sharedMemoryRingTestSuite; //!< Static variable for test initialization
@@ -19,6 +19,13 @@
 #include <stdint.h>
 #include <string>
 #include <fstream>
+#include <map>
+#include <vector>
+
+#include "ns3/core-config.h"
+#ifdef NS3_MULTITHREADED
+#include <mutex>
+#endif
 
 #include "ns3/abort.h"
 #include "ns3/assert.h"
@@ -27,7 +34,10 @@
 #include "ns3/node.h"
 #include "ns3/names.h"
 #include "ns3/net-device.h"
+#include "ns3/queue.h"
+#include "ns3/pointer.h"
 #include "ns3/pcap-file-wrapper.h"
+#include "ns3/pcapng-file.h"
 
 #include "trace-helper.h"
 
@@ -35,6 +45,91 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("TraceHelper");
 
+namespace {
+
+/// How the files created by PcapHelper are shared
+PcapHelper::PcapngMode g_pcapngMode = PcapHelper::PCAPNG_NONE;
+/// Whether the pcapng files are compressed
+bool g_pcapngGzip = false;
+/// The pcapng file of each pcap file name computed by PcapHelper
+std::map<std::string, std::string> g_pcapngNames;
+/// The pcapng files opened, by name
+std::map<std::string, Ptr<PcapngFile> > g_pcapngFiles;
+
+#ifdef NS3_MULTITHREADED
+/// Protects g_pcapngNames and g_pcapngFiles, which the partitions of the
+/// MultithreadedSimulatorImpl may update concurrently
+std::mutex g_pcapngMutex;
+/// Lock g_pcapngMutex until the end of the enclosing scope
+#define PCAPNG_FILES_LOCK std::lock_guard<std::mutex> pcapngLock (g_pcapngMutex)
+#else
+#define PCAPNG_FILES_LOCK
+#endif
+
+/**
+ * \brief Forget the pcapng files at the end of the simulation, so that
+ * they are closed when the devices writing to them are destroyed.
+ */
+void
+ForgetPcapngFiles (void)
+{
+  PCAPNG_FILES_LOCK;
+  g_pcapngNames.clear ();
+  g_pcapngFiles.clear ();
+}
+
+/**
+ * \param filename a pcap file name
+ * \returns the name of the pcapng file shared by the file
+ */
+std::string
+GetPcapngName (std::string const &filename)
+{
+  std::string name;
+  std::map<std::string, std::string>::const_iterator it = g_pcapngNames.find (filename);
+  if (it != g_pcapngNames.end ())
+    {
+      name = it->second;
+    }
+  else
+    {
+      std::string::size_type dot = filename.rfind (".pcap");
+      name = (dot != std::string::npos && dot + 5 == filename.size ()) ? filename.substr (0, dot) : filename;
+      name += ".pcapng";
+    }
+  if (g_pcapngGzip)
+    {
+      name += ".gz";
+    }
+  return name;
+}
+
+/**
+ * \brief Record the pcapng file of a pcap file name
+ *
+ * \param filename the pcap file name
+ * \param prefix the prefix of the file name
+ * \param node the name of the node in the file name
+ */
+void
+SetPcapngName (std::string const &filename, std::string const &prefix, std::string const &node)
+{
+  PCAPNG_FILES_LOCK;
+  switch (g_pcapngMode)
+    {
+    case PcapHelper::PCAPNG_PER_NODE:
+      g_pcapngNames[filename] = prefix + "-" + node + ".pcapng";
+      break;
+    case PcapHelper::PCAPNG_SINGLE:
+      g_pcapngNames[filename] = prefix + ".pcapng";
+      break;
+    default:
+      break;
+    }
+}
+
+} // unnamed namespace
+
 PcapHelper::PcapHelper ()
 {
   NS_LOG_FUNCTION_NOARGS ();
@@ -56,8 +151,36 @@ PcapHelper::CreateFile (
   NS_LOG_FUNCTION (filename << filemode << dataLinkType << snapLen << tzCorrection);
 
   Ptr<PcapFileWrapper> file = CreateObject<PcapFileWrapper> ();
-  file->Open (filename, filemode);
-  NS_ABORT_MSG_IF (file->Fail (), "Unable to Open " << filename << " for mode " << filemode);
+  if (g_pcapngMode != PCAPNG_NONE)
+    {
+      PCAPNG_FILES_LOCK;
+      std::string name = GetPcapngName (filename);
+      Ptr<PcapngFile> pcapng;
+      std::map<std::string, Ptr<PcapngFile> >::const_iterator it = g_pcapngFiles.find (name);
+      if (it != g_pcapngFiles.end ())
+        {
+          pcapng = it->second;
+        }
+      else
+        {
+          if (g_pcapngFiles.empty ())
+            {
+              Simulator::ScheduleDestroy (&ForgetPcapngFiles);
+            }
+          pcapng = Create<PcapngFile> ();
+          pcapng->Open (name, g_pcapngGzip);
+          NS_ABORT_MSG_IF (pcapng->Fail (), "Unable to Open " << name);
+          g_pcapngFiles[name] = pcapng;
+        }
+      std::string::size_type slash = filename.find_last_of ('/');
+      std::string interfaceName = (slash == std::string::npos) ? filename : filename.substr (slash + 1);
+      file->OpenPcapng (pcapng, interfaceName);
+    }
+  else
+    {
+      file->Open (filename, filemode);
+      NS_ABORT_MSG_IF (file->Fail (), "Unable to Open " << filename << " for mode " << filemode);
+    }
 
   file->Init (dataLinkType, snapLen, tzCorrection);
   NS_ABORT_MSG_IF (file->Fail (), "Unable to Init " << filename);
@@ -76,6 +199,16 @@ PcapHelper::CreateFile (
   return file;
 }
 
+void
+PcapHelper::SetPcapngMode (PcapngMode mode, bool gzip)
+{
+  NS_LOG_FUNCTION (mode << gzip);
+  NS_ABORT_MSG_IF (gzip && !PcapngFile::IsGzipSupported (),
+                   "Compressed pcapng files need ns-3 to be built with zlib");
+  g_pcapngMode = mode;
+  g_pcapngGzip = gzip;
+}
+
 std::string
 PcapHelper::GetFilenameFromDevice (std::string prefix, Ptr<NetDevice> device, bool useObjectNames)
 {
@@ -118,6 +251,13 @@ PcapHelper::GetFilenameFromDevice (std::string prefix, Ptr<NetDevice> device, bo
 
   oss << ".pcap";
 
+  if (nodename.empty ())
+    {
+      std::ostringstream id;
+      id << node->GetId ();
+      nodename = id.str ();
+    }
+  SetPcapngName (oss.str (), prefix, nodename);
   return oss.str ();
 }
 
@@ -156,6 +296,13 @@ PcapHelper::GetFilenameFromInterfacePair (std::string prefix, Ptr<Object> object
 
   oss << "-i" << interface << ".pcap";
 
+  if (nodename.empty ())
+    {
+      std::ostringstream id;
+      id << node->GetId ();
+      nodename = id.str ();
+    }
+  SetPcapngName (oss.str (), prefix, nodename);
   return oss.str ();
 }
 
@@ -397,6 +544,110 @@ AsciiTraceHelper::DefaultReceiveSinkWithContext (Ptr<OutputStreamWrapper> stream
   *stream->GetStream () << "r " << Simulator::Now ().GetSeconds () << " " << context << " " << *p << std::endl;
 }
 
+BinaryTraceHelper::BinaryTraceHelper ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+BinaryTraceHelper::~BinaryTraceHelper ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+Ptr<BinaryTraceFile>
+BinaryTraceHelper::CreateFile (std::string filename)
+{
+  NS_LOG_FUNCTION (filename);
+
+  Ptr<BinaryTraceFile> file = Create<BinaryTraceFile> ();
+  file->Open (filename);
+  NS_ABORT_MSG_IF (file->Fail (), "Unable to Open " << filename);
+  return file;
+}
+
+bool
+BinaryTraceHelper::ConnectSink (Ptr<Object> object, std::string traceName, Ptr<BinaryTraceFile> file,
+                                BinaryTraceFile::EventType event, Ptr<NetDevice> device)
+{
+  NS_LOG_FUNCTION (object << traceName << file << event << device);
+  Ptr<BinaryTraceSink> sink = Create<BinaryTraceSink> (file, device->GetNode ()->GetId (),
+                                                       device->GetIfIndex (), event);
+  return object->TraceConnectWithoutContext (traceName, MakeCallback (&BinaryTraceSink::Trace, sink));
+}
+
+void
+BinaryTraceHelper::EnableBinary (Ptr<BinaryTraceFile> file, Ptr<NetDevice> nd)
+{
+  NS_LOG_FUNCTION (file << nd);
+
+  // the sources are those of the point-to-point devices: the events of
+  // the devices which lack some of them are not traced.
+  std::vector<std::string> missing;
+  PointerValue ptr;
+  if (nd->GetAttributeFailSafe ("TxQueue", ptr) && ptr.Get<Queue> () != 0)
+    {
+      Ptr<Queue> queue = ptr.Get<Queue> ();
+      if (!ConnectSink (queue, "Enqueue", file, BinaryTraceFile::ENQUEUE, nd))
+        {
+          missing.push_back ("TxQueue/Enqueue");
+        }
+      if (!ConnectSink (queue, "Dequeue", file, BinaryTraceFile::DEQUEUE, nd))
+        {
+          missing.push_back ("TxQueue/Dequeue");
+        }
+      if (!ConnectSink (queue, "Drop", file, BinaryTraceFile::DROP, nd))
+        {
+          missing.push_back ("TxQueue/Drop");
+        }
+    }
+  else
+    {
+      missing.push_back ("TxQueue");
+    }
+  if (!ConnectSink (nd, "MacRx", file, BinaryTraceFile::RECEIVE, nd))
+    {
+      missing.push_back ("MacRx");
+    }
+  if (!ConnectSink (nd, "PhyRxDrop", file, BinaryTraceFile::DROP, nd))
+    {
+      missing.push_back ("PhyRxDrop");
+    }
+  for (std::vector<std::string>::const_iterator i = missing.begin (); i != missing.end (); ++i)
+    {
+      NS_LOG_WARN ("device " << nd->GetInstanceTypeId ().GetName ()
+                   << " of node " << nd->GetNode ()->GetId () << " interface " << nd->GetIfIndex ()
+                   << " has no \"" << *i << "\" trace source, its events are not traced");
+    }
+}
+
+void
+BinaryTraceHelper::EnableBinary (Ptr<BinaryTraceFile> file, NetDeviceContainer d)
+{
+  for (NetDeviceContainer::Iterator i = d.Begin (); i != d.End (); ++i)
+    {
+      EnableBinary (file, *i);
+    }
+}
+
+void
+BinaryTraceHelper::EnableBinary (Ptr<BinaryTraceFile> file, NodeContainer n)
+{
+  for (NodeContainer::Iterator i = n.Begin (); i != n.End (); ++i)
+    {
+      Ptr<Node> node = *i;
+      for (uint32_t j = 0; j < node->GetNDevices (); ++j)
+        {
+          EnableBinary (file, node->GetDevice (j));
+        }
+    }
+}
+
+void
+BinaryTraceHelper::EnableBinaryAll (Ptr<BinaryTraceFile> file)
+{
+  EnableBinary (file, NodeContainer::GetGlobal ());
+}
+
 void 
 PcapHelperForDevice::EnablePcap (std::string prefix, Ptr<NetDevice> nd, bool promiscuous, bool explicitFilename)
 {
@@ -25,6 +25,7 @@
 #include "ns3/simulator.h"
 #include "ns3/pcap-file-wrapper.h"
 #include "ns3/output-stream-wrapper.h"
+#include "ns3/binary-trace-file.h"
 
 namespace ns3 {
 
@@ -33,6 +34,11 @@ namespace ns3 {
  *
  * Handling pcap files is a common operation for ns-3 devices.  It is useful to
  * provide a common base class for dealing with these ops.
+ *
+ * By default, each device gets a pcap file of its own.  With SetPcapngMode,
+ * the devices of each node, or all the devices of the simulation, share a
+ * single pcapng file instead, where each device is described by an
+ * Interface Description Block named after its pcap file.
  */
 
 class PcapHelper
@@ -60,6 +66,15 @@ public:
     DLT_NETLINK = 253
   };
 
+  /**
+   * This enumeration holds the ways devices can share pcapng files.
+   */
+  enum PcapngMode {
+    PCAPNG_NONE,     //!< One pcap file per device
+    PCAPNG_PER_NODE, //!< One pcapng file per node, named prefix-node.pcapng
+    PCAPNG_SINGLE    //!< One pcapng file per prefix, named prefix.pcapng
+  };
+
   /**
    * @brief Create a pcap helper.
    */
@@ -94,8 +109,26 @@ public:
   std::string GetFilenameFromInterfacePair (std::string prefix, Ptr<Object> object, 
                                             uint32_t interface, bool useObjectNames = true);
 
+  /**
+   * @brief Select how the files created by the pcap helpers are shared.
+   *
+   * The mode applies to the files created afterwards, and to file names
+   * obtained from GetFilenameFromDevice or GetFilenameFromInterfacePair.
+   * Files created from other names each get a pcapng file of their own,
+   * named after them.  The pcapng files are closed once all the devices
+   * writing to them are destroyed.
+   *
+   * @param mode how files are shared
+   * @param gzip whether to compress the pcapng files with gzip, which
+   *        appends ".gz" to their names
+   */
+  static void SetPcapngMode (PcapngMode mode, bool gzip = false);
+
   /**
    * @brief Create and initialize a pcap file.
+   *
+   * In pcapng mode, an interface is added to the shared pcapng file
+   * instead, and the file mode is ignored.
    * 
    * @param filename file name
    * @param filemode file mode
@@ -545,6 +578,113 @@ AsciiTraceHelper::HookDefaultReceiveSinkWithContext (
                  << tracename << "\"");
 }
 
+/**
+ * \brief Manage binary trace files for device models
+ *
+ * This is a cheaper alternative to ascii traces for large runs: instead of
+ * formatting each packet as text, the queue and receive events of devices
+ * are stored as fixed-width records in a BinaryTraceFile, to be loaded
+ * with utils/read-binary-trace.py.  A single file can be shared by all
+ * the devices of a simulation, since each record holds its node and
+ * device.
+ */
+class BinaryTraceHelper
+{
+public:
+  /**
+   * @brief Create a binary trace helper.
+   */
+  BinaryTraceHelper ();
+
+  /**
+   * @brief Destroy a binary trace helper.
+   */
+  ~BinaryTraceHelper ();
+
+  /**
+   * @brief Create and open a binary trace file.
+   *
+   * The file is closed when the devices writing to it are destroyed.
+   *
+   * @param filename file name
+   * @returns a smart pointer to the file
+   */
+  Ptr<BinaryTraceFile> CreateFile (std::string filename);
+
+  /**
+   * @brief Hook a trace source to a sink writing records to a file.
+   *
+   * @param object object
+   * @param traceName trace source name, which must carry a packet
+   * @param file the file to write to
+   * @param event event type of the records
+   * @param device the device the records are attributed to
+   */
+  template <typename T>
+  void HookDefaultSink (Ptr<T> object, std::string traceName, Ptr<BinaryTraceFile> file,
+                        BinaryTraceFile::EventType event, Ptr<NetDevice> device);
+
+  /**
+   * @brief Trace the packets of a device to a file.
+   *
+   * The Enqueue, Dequeue and Drop trace sources of the queue of the device
+   * (its TxQueue attribute) and the MacRx and PhyRxDrop trace sources of
+   * the device are traced, when they exist.  Each missing trace source,
+   * for instance on a WifiNetDevice, which has no TxQueue, is reported
+   * by a warning of the TraceHelper log component.
+   *
+   * @param file the file to write to
+   * @param nd the device
+   */
+  void EnableBinary (Ptr<BinaryTraceFile> file, Ptr<NetDevice> nd);
+
+  /**
+   * @brief Trace the packets of a set of devices to a file.
+   *
+   * @param file the file to write to
+   * @param d the devices
+   */
+  void EnableBinary (Ptr<BinaryTraceFile> file, NetDeviceContainer d);
+
+  /**
+   * @brief Trace the packets of all the devices of a set of nodes to a file.
+   *
+   * @param file the file to write to
+   * @param n the nodes
+   */
+  void EnableBinary (Ptr<BinaryTraceFile> file, NodeContainer n);
+
+  /**
+   * @brief Trace the packets of all the devices to a file.
+   *
+   * @param file the file to write to
+   */
+  void EnableBinaryAll (Ptr<BinaryTraceFile> file);
+
+private:
+  /**
+   * @brief Connect a trace source to a sink writing records to a file.
+   *
+   * @param object object
+   * @param traceName trace source name
+   * @param file the file to write to
+   * @param event event type of the records
+   * @param device the device the records are attributed to
+   * @returns true if the trace source exists
+   */
+  static bool ConnectSink (Ptr<Object> object, std::string traceName, Ptr<BinaryTraceFile> file,
+                           BinaryTraceFile::EventType event, Ptr<NetDevice> device);
+};
+
+template <typename T> void
+BinaryTraceHelper::HookDefaultSink (Ptr<T> object, std::string tracename, Ptr<BinaryTraceFile> file,
+                                    BinaryTraceFile::EventType event, Ptr<NetDevice> device)
+{
+  bool result = ConnectSink (object, tracename, file, event, device);
+  NS_ASSERT_MSG (result == true, "BinaryTraceHelper::HookDefaultSink():  Unable to hook \""
+                 << tracename << "\"");
+}
+
 /**
  * \brief Base class providing common user-level pcap operations for helpers
  * representing net devices.
@@ -20,6 +20,7 @@
 #include "buffer.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
+#include "ns3/unused.h"
 
 #define LOG_INTERNAL_STATE(y)                                                                    \
   NS_LOG_LOGIC (y << "start="<<m_start<<", end="<<m_end<<", zero start="<<m_zeroAreaStart<<              \
@@ -50,16 +51,16 @@ namespace ns3 {
 NS_LOG_COMPONENT_DEFINE ("Buffer");
 
 
-uint32_t Buffer::g_recommendedStart = 0;
+NS_THREAD_LOCAL uint32_t Buffer::g_recommendedStart = 0;
 #ifdef BUFFER_FREE_LIST
 /* The following macros are pretty evil but they are needed to allow us to
- * keep track of 3 possible states for the g_freeList variable:
+ * keep track of 3 possible states for the g_pool variable:
  *  - uninitialized means that no one has created a buffer yet
- *    so no one has created the associated free list (it is created
+ *    so no one has created the associated pool (it is created
  *    on-demand when the first buffer is created)
- *  - initialized means that the free list exists and is valid
+ *  - initialized means that the pool exists and is valid
  *  - destroyed means that the static destructors of this compilation unit
- *    have run so, the free list has been cleared from its content
+ *    have run so, the pool has been cleared from its content
  * The key is that in destroyed state, we are careful not re-create it
  * which is a typical weakness of lazy evaluation schemes which use 
  * '0' as a special value to indicate both un-initialized and destroyed.
@@ -68,50 +69,81 @@ uint32_t Buffer::g_recommendedStart = 0;
  * which the compiler assigns to zero-memory which is initialized to _zero_
  * before the constructors run so this ensures perfect handling of crazy 
  * constructor orderings.
+ *
+ * Each thread owns its own pool: a Buffer::Data released by another
+ * thread than the one which created it simply ends up in the pool of
+ * the releasing thread, and the pool of a thread is cleared when the
+ * thread exits.
  */
 #define MAGIC_DESTROYED (~(long) 0)
-#define IS_UNINITIALIZED(x) (x == (Buffer::FreeList*)0)
-#define IS_DESTROYED(x) (x == (Buffer::FreeList*)MAGIC_DESTROYED)
+#define IS_UNINITIALIZED(x) (x == (Buffer::Pool*)0)
+#define IS_DESTROYED(x) (x == (Buffer::Pool*)MAGIC_DESTROYED)
 #define IS_INITIALIZED(x) (!IS_UNINITIALIZED (x) && !IS_DESTROYED (x))
-#define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
-#define UNINITIALIZED ((Buffer::FreeList*)0)
-uint32_t Buffer::g_maxSize = 0;
-Buffer::FreeList *Buffer::g_freeList = 0;
-struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
+#define DESTROYED ((Buffer::Pool*)MAGIC_DESTROYED)
+#define UNINITIALIZED ((Buffer::Pool*)0)
+NS_THREAD_LOCAL Buffer::Pool *Buffer::g_pool = 0;
+NS_THREAD_LOCAL struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
 
 Buffer::LocalStaticDestructor::~LocalStaticDestructor(void)
 {
   NS_LOG_FUNCTION (this);
-  if (IS_INITIALIZED (g_freeList))
+  if (IS_INITIALIZED (g_pool))
     {
-      for (Buffer::FreeList::iterator i = g_freeList->begin ();
-           i != g_freeList->end (); i++)
+      for (uint32_t c = 0; c < POOL_N_SIZE_CLASSES; c++)
         {
-          Buffer::Deallocate (*i);
+          Buffer::FreeList &freeList = g_pool->freeLists[c];
+          for (Buffer::FreeList::iterator i = freeList.begin ();
+               i != freeList.end (); i++)
+            {
+              Buffer::Deallocate (*i);
+            }
         }
-      delete g_freeList;
-      g_freeList = DESTROYED;
+      delete g_pool;
+      g_pool = DESTROYED;
     }
 }
 
+uint32_t
+Buffer::GetSizeClass (uint32_t size)
+{
+  uint32_t sizeClass = 0;
+  uint32_t classSize = 1 << POOL_MIN_SIZE_SHIFT;
+  while (classSize < size && sizeClass < POOL_N_SIZE_CLASSES)
+    {
+      classSize <<= 1;
+      sizeClass++;
+    }
+  return sizeClass;
+}
+
 void
 Buffer::Recycle (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
-  NS_ASSERT (!IS_UNINITIALIZED (g_freeList));
-  g_maxSize = std::max (g_maxSize, data->m_size);
-  /* feed into free list */
-  if (data->m_size < g_maxSize ||
-      IS_DESTROYED (g_freeList) ||
-      g_freeList->size () > 1000)
+  if (IS_UNINITIALIZED (g_pool))
+    {
+      // the storage was created by another thread.
+      g_pool = new Buffer::Pool ();
+      NS_UNUSED (&g_localStaticDestructor);
+    }
+  uint32_t sizeClass = GetSizeClass (data->m_size);
+  /* feed into the free list of its size class, if the storage
+   * was sized by the pool and the free list is not full. */
+  if (IS_DESTROYED (g_pool) ||
+      sizeClass == POOL_N_SIZE_CLASSES ||
+      data->m_size != (1U << (sizeClass + POOL_MIN_SIZE_SHIFT)) ||
+      (g_pool->freeLists[sizeClass].size () + 1) * data->m_size > POOL_MAX_CLASS_BYTES)
     {
       Buffer::Deallocate (data);
     }
   else
     {
-      NS_ASSERT (IS_INITIALIZED (g_freeList));
-      g_freeList->push_back (data);
+      NS_ASSERT (IS_INITIALIZED (g_pool));
+      g_pool->freeLists[sizeClass].push_back (data);
+      PoolStatistics &stats = g_pool->stats;
+      stats.cachedBytes += data->m_size;
+      stats.peakBytes = std::max (stats.peakBytes, stats.cachedBytes);
     }
 }
 
@@ -119,29 +151,58 @@ Buffer::Data *
 Buffer::Create (uint32_t dataSize)
 {
   NS_LOG_FUNCTION (dataSize);
-  /* try to find a buffer correctly sized. */
-  if (IS_UNINITIALIZED (g_freeList))
+  if (IS_UNINITIALIZED (g_pool))
     {
-      g_freeList = new Buffer::FreeList ();
+      g_pool = new Buffer::Pool ();
+      // thread-local objects are only constructed, and their destructor
+      // registered, once they are used by a thread.
+      NS_UNUSED (&g_localStaticDestructor);
     }
-  else if (IS_INITIALIZED (g_freeList))
+  uint32_t sizeClass = GetSizeClass (dataSize);
+  if (IS_INITIALIZED (g_pool))
     {
-      while (!g_freeList->empty ()) 
+      if (sizeClass < POOL_N_SIZE_CLASSES && !g_pool->freeLists[sizeClass].empty ())
         {
-          struct Buffer::Data *data = g_freeList->back ();
-          g_freeList->pop_back ();
-          if (data->m_size >= dataSize) 
-            {
-              data->m_count = 1;
-              return data;
-            }
-          Buffer::Deallocate (data);
+          /* a free storage of the right size class. */
+          struct Buffer::Data *data = g_pool->freeLists[sizeClass].back ();
+          g_pool->freeLists[sizeClass].pop_back ();
+          g_pool->stats.cachedBytes -= data->m_size;
+          g_pool->stats.hits++;
+          data->m_count = 1;
+          return data;
         }
+      g_pool->stats.misses++;
+    }
+  if (sizeClass < POOL_N_SIZE_CLASSES)
+    {
+      dataSize = 1 << (sizeClass + POOL_MIN_SIZE_SHIFT);
     }
   struct Buffer::Data *data = Buffer::Allocate (dataSize);
   NS_ASSERT (data->m_count == 1);
   return data;
 }
+
+Buffer::PoolStatistics
+Buffer::GetPoolStatistics (void)
+{
+  if (IS_INITIALIZED (g_pool))
+    {
+      return g_pool->stats;
+    }
+  PoolStatistics stats = {0, 0, 0, 0};
+  return stats;
+}
+
+void
+Buffer::ResetPoolStatistics (void)
+{
+  if (IS_INITIALIZED (g_pool))
+    {
+      g_pool->stats.hits = 0;
+      g_pool->stats.misses = 0;
+      g_pool->stats.peakBytes = g_pool->stats.cachedBytes;
+    }
+}
 #else /* BUFFER_FREE_LIST */
 void
 Buffer::Recycle (struct Buffer::Data *data)
@@ -157,6 +218,18 @@ Buffer::Create (uint32_t size)
   NS_LOG_FUNCTION (size);
   return Allocate (size);
 }
+
+Buffer::PoolStatistics
+Buffer::GetPoolStatistics (void)
+{
+  PoolStatistics stats = {0, 0, 0, 0};
+  return stats;
+}
+
+void
+Buffer::ResetPoolStatistics (void)
+{
+}
 #endif /* BUFFER_FREE_LIST */
 
 struct Buffer::Data *
@@ -244,7 +317,7 @@ void
 Buffer::Initialize (uint32_t zeroSize)
 {
   NS_LOG_FUNCTION (this << zeroSize);
-  m_data = Buffer::Create (0);
+  m_data = Buffer::Create (g_recommendedStart);
   m_start = std::min (m_data->m_size, g_recommendedStart);
   m_maxZeroAreaStart = m_start;
   m_zeroAreaStart = m_start;
@@ -400,17 +473,27 @@ void
 Buffer::AddAtEnd (const Buffer &o)
 {
   NS_LOG_FUNCTION (this << &o);
-  if (m_data->m_count == 1 &&
-      m_end == m_zeroAreaEnd &&
-      m_end == m_data->m_dirtyEnd &&
+  bool emptyZeroArea = m_zeroAreaStart == m_zeroAreaEnd;
+  if ((m_end == m_zeroAreaEnd || emptyZeroArea) &&
       o.m_start == o.m_zeroAreaStart &&
       o.m_zeroAreaEnd - o.m_zeroAreaStart > 0)
     {
       /**
        * This is an optimization which kicks in when
        * we attempt to aggregate two buffers which contain
-       * adjacent zero areas.
+       * adjacent zero areas. The merged zero area moves the
+       * end of the data of this buffer so the (real) bytes
+       * of this buffer are made private first.
        */
+      Unshare ();
+      m_data->m_dirtyEnd = m_end;
+      uint32_t maxZeroAreaStart = m_maxZeroAreaStart;
+      if (emptyZeroArea)
+        {
+          // an empty zero area can be moved anywhere: move it to the end.
+          m_zeroAreaStart = m_end;
+          m_zeroAreaEnd = m_end;
+        }
       uint32_t zeroSize = o.m_zeroAreaEnd - o.m_zeroAreaStart;
       m_zeroAreaEnd += zeroSize;
       m_end = m_zeroAreaEnd;
@@ -422,18 +505,33 @@ Buffer::AddAtEnd (const Buffer &o)
       Buffer::Iterator src = o.End ();
       src.Prev (endData);
       dst.Write (src, o.End ());
+      if (emptyZeroArea)
+        {
+          // the moved zero area does not reflect the room used by headers.
+          m_maxZeroAreaStart = maxZeroAreaStart;
+        }
       NS_ASSERT (CheckInternalState ());
       return;
     }
 
-  Buffer dst = CreateFullCopy ();
-  Buffer src = o.CreateFullCopy ();
-
-  dst.AddAtEnd (src.GetSize ());
-  Buffer::Iterator destStart = dst.End ();
-  destStart.Prev (src.GetSize ());
-  destStart.Write (src.Begin (), src.End ());
-  *this = dst;
+  // A buffer has a single zero area: keep the largest one virtual and
+  // write the other one out as real bytes.
+  if (m_zeroAreaEnd - m_zeroAreaStart >= o.m_zeroAreaEnd - o.m_zeroAreaStart)
+    {
+      Buffer src = o.CreateFullCopy ();
+      AddAtEnd (src.GetSize ());
+      Buffer::Iterator destStart = End ();
+      destStart.Prev (src.GetSize ());
+      destStart.Write (src.Begin (), src.End ());
+    }
+  else
+    {
+      Buffer src = CreateFullCopy ();
+      Buffer dst = o;
+      dst.AddAtStart (src.GetSize ());
+      dst.Begin ().Write (src.Begin (), src.End ());
+      *this = dst;
+    }
   NS_ASSERT (CheckInternalState ());
 }
 
@@ -555,6 +653,31 @@ Buffer::CreateFullCopy (void) const
   return *this;
 }
 
+void
+Buffer::Unshare (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (CheckInternalState ());
+  if (m_data->m_count == 1)
+    {
+      return;
+    }
+  // keep the same layout, including the virtual zero area, so that
+  // none of the offsets of this buffer change.
+  uint32_t internalEnd = m_end - (m_zeroAreaEnd - m_zeroAreaStart);
+  struct Buffer::Data *newData = Buffer::Create (m_data->m_size);
+  memcpy (newData->m_data + m_start, m_data->m_data + m_start, internalEnd - m_start);
+  newData->m_dirtyStart = m_start;
+  newData->m_dirtyEnd = m_end;
+  m_data->m_count--;
+  if (m_data->m_count == 0)
+    {
+      Recycle (m_data);
+    }
+  m_data = newData;
+  NS_ASSERT (CheckInternalState ());
+}
+
 uint32_t 
 Buffer::GetSerializedSize (void) const
 {
@@ -843,27 +966,28 @@ Buffer::Iterator::Write (Iterator start, Iterator end)
   uint32_t size = end.m_current - start.m_current;
   NS_ASSERT_MSG (CheckNoZero (m_current, m_current + size),
                  GetWriteErrorMessage ());
+  // the destination range is either before or after the zero area.
+  uint8_t *to = &m_data[m_current < m_zeroStart ? m_current : m_current - (m_zeroEnd - m_zeroStart)];
+  m_current += size;
   if (start.m_current <= start.m_zeroStart)
     {
       uint32_t toCopy = std::min (size, start.m_zeroStart - start.m_current);
-      memcpy (&m_data[m_current], &start.m_data[start.m_current], toCopy);
+      memcpy (to, &start.m_data[start.m_current], toCopy);
       start.m_current += toCopy;
-      m_current += toCopy;
+      to += toCopy;
       size -= toCopy;
     }
   if (start.m_current <= start.m_zeroEnd)
     {
       uint32_t toCopy = std::min (size, start.m_zeroEnd - start.m_current);
-      memset (&m_data[m_current], 0, toCopy);
+      memset (to, 0, toCopy);
       start.m_current += toCopy;
-      m_current += toCopy;
+      to += toCopy;
       size -= toCopy;
     }
   uint32_t toCopy = std::min (size, start.m_dataEnd - start.m_current);
   uint8_t *from = &start.m_data[start.m_current - (start.m_zeroEnd-start.m_zeroStart)];
-  uint8_t *to = &m_data[m_current];
   memcpy (to, from, toCopy);
-  m_current += toCopy;
 }
 
 void 
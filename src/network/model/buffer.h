@@ -24,6 +24,7 @@
 #include <vector>
 #include <ostream>
 #include "ns3/assert.h"
+#include "ns3/thread-local.h"
 
 #define BUFFER_FREE_LIST 1
 
@@ -38,9 +39,9 @@ namespace ns3 {
  * automatically adjusted to hold any data prepended
  * or appended by the user. Its implementation is optimized
  * to ensure that the number of buffer resizes is minimized,
- * by creating new Buffers of the maximum size ever used.
- * The correct maximum size is learned at runtime during use by 
- * recording the maximum size of each packet.
+ * by reserving in new Buffers room for the largest headers ever
+ * added. The correct header room is learned at runtime during use
+ * by recording the maximum header size of each packet.
  *
  * \internal
  * The implementation of the Buffer class uses a COW (Copy On Write)
@@ -88,6 +89,12 @@ namespace ns3 {
  * \endverbatim
  *
  * A simple state invariant is that m_start <= m_zeroStart <= m_zeroEnd <= m_end
+ *
+ * The BufferData storages are recycled through a pool owned by each
+ * thread. The storage sizes are rounded up to a power of two, from
+ * 64 bytes to 64 KiB, and each of these size classes has its own free
+ * list, so that a small acknowledgment never takes, nor wastes, a storage
+ * sized for a large segment. Larger storages are not pooled.
  */
 class Buffer 
 {
@@ -554,6 +561,16 @@ private:
    */
   Buffer CreateFragment (uint32_t start, uint32_t length) const;
 
+  /**
+   * Make sure the bytes of this buffer are not shared with any other
+   * Buffer instance, copying them if needed.
+   *
+   * Buffers which share their bytes update a common reference count:
+   * a buffer must be unshared before it can be handed over to another
+   * thread.
+   */
+  void Unshare (void);
+
   /**
    * \return an Iterator which points to the
    * start of this Buffer.
@@ -610,6 +627,27 @@ private:
    */
   uint32_t CopyData (uint8_t *buffer, uint32_t size) const;
 
+  /**
+   * \brief Statistics of the buffer data pool of a thread
+   */
+  struct PoolStatistics
+  {
+    uint64_t hits;        //!< Storages taken from a free list
+    uint64_t misses;      //!< Storages allocated because no free list could provide one
+    uint64_t cachedBytes; //!< Bytes currently kept in the free lists
+    uint64_t peakBytes;   //!< Maximum value of cachedBytes
+  };
+  /**
+   * \brief Get the statistics of the buffer data pool of the calling thread
+   * \returns the statistics, all zero if the pool is disabled
+   */
+  static PoolStatistics GetPoolStatistics (void);
+  /**
+   * \brief Reset the hits, misses and peak bytes of the buffer data pool
+   * of the calling thread
+   */
+  static void ResetPoolStatistics (void);
+
   /**
    * \brief Copy constructor
    * \param o the buffer to copy
@@ -764,9 +802,11 @@ private:
   /**
    * location in a newly-allocated buffer where you should start
    * writing data. i.e., m_start should be initialized to this 
-   * value.
+   * value. Like the free list below, this is tracked per thread so that
+   * buffers can be created concurrently by the threads of a parallel
+   * simulator.
    */
-  static uint32_t g_recommendedStart;
+  static NS_THREAD_LOCAL uint32_t g_recommendedStart;
 
   /**
    * offset to the start of the virtual zero area from the start
@@ -790,16 +830,34 @@ private:
   uint32_t m_end;
 
 #ifdef BUFFER_FREE_LIST
+  /// Size classes of the buffer data pool
+  enum
+  {
+    POOL_MIN_SIZE_SHIFT = 6,  //!< The smallest size class holds 64 bytes
+    POOL_N_SIZE_CLASSES = 11, //!< The largest size class holds 64 KiB
+    POOL_MAX_CLASS_BYTES = 4 * 1024 * 1024 //!< Max bytes kept in the free list of a size class
+  };
   /// Container for buffer data
   typedef std::vector<struct Buffer::Data*> FreeList;
+  /// Buffer data pool of a thread: one free list per size class
+  struct Pool
+  {
+    FreeList freeLists[POOL_N_SIZE_CLASSES]; //!< Free lists, indexed by size class
+    PoolStatistics stats; //!< Pool statistics
+  };
+  /**
+   * \brief Get the size class of a buffer data storage
+   * \param size the storage size
+   * \returns the size class, POOL_N_SIZE_CLASSES if the size is too large to be pooled
+   */
+  static uint32_t GetSizeClass (uint32_t size);
   /// Local static destructor structure
   struct LocalStaticDestructor 
   {
     ~LocalStaticDestructor ();
   };
-  static uint32_t g_maxSize; //!< Max observed data size
-  static FreeList *g_freeList; //!< Buffer data container
-  static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
+  static NS_THREAD_LOCAL Pool *g_pool; //!< Buffer data pool, per thread
+  static NS_THREAD_LOCAL struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor, per thread
 #endif
 };
 
@@ -19,6 +19,7 @@
  */
 #include "byte-tag-list.h"
 #include "ns3/log.h"
+#include "ns3/thread-local.h"
 #include <vector>
 #include <cstring>
 
@@ -52,12 +53,18 @@ struct ByteTagListData {
  *
  * Internal use only.
  */
-static class ByteTagListDataFreeList : public std::vector<struct ByteTagListData *>
+static NS_THREAD_LOCAL class ByteTagListDataFreeList : public std::vector<struct ByteTagListData *>
 {
 public:
   ~ByteTagListDataFreeList ();
-} g_freeList; //!< Container for struct ByteTagListData
-static uint32_t g_maxSize = 0; //!< maximum data size (used for allocation)
+} g_freeList; //!< Container for struct ByteTagListData, per thread
+static NS_THREAD_LOCAL uint32_t g_maxSize = 0; //!< maximum data size (used for allocation)
+/**
+ * Set when the free list of the thread has been destroyed, so that tags
+ * released afterwards, typically by static destructors, are not fed
+ * into it.
+ */
+static NS_THREAD_LOCAL bool g_freeListDestroyed = false;
 
 ByteTagListDataFreeList::~ByteTagListDataFreeList ()
 {
@@ -68,6 +75,8 @@ ByteTagListDataFreeList::~ByteTagListDataFreeList ()
       uint8_t *buffer = (uint8_t *)(*i);
       delete [] buffer;
     }
+  clear ();
+  g_freeListDestroyed = true;
 }
 #endif /* USE_FREE_LIST */
 
@@ -250,6 +259,21 @@ ByteTagList::RemoveAll (void)
   m_used = 0;
 }
 
+void
+ByteTagList::Unshare (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_data == 0 || m_data->count == 1)
+    {
+      return;
+    }
+  struct ByteTagListData *newData = Allocate (m_used);
+  std::memcpy (&newData->data, &m_data->data, m_used);
+  newData->dirty = m_used;
+  Deallocate (m_data);
+  m_data = newData;
+}
+
 ByteTagList::Iterator 
 ByteTagList::BeginAll (void) const
 {
@@ -378,7 +402,8 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
   data->count--;
   if (data->count == 0)
     {
-      if (g_freeList.size () > FREE_LIST_SIZE ||
+      if (g_freeListDestroyed ||
+          g_freeList.size () > FREE_LIST_SIZE ||
           data->size < g_maxSize)
         {
           uint8_t *buffer = (uint8_t *)data;
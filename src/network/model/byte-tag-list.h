@@ -188,6 +188,13 @@ private:
    */ 
   void RemoveAll (void);
 
+  /**
+   * Give this list a private copy of the tag data, so that it no longer
+   * shares any storage with other lists, for example before handing it
+   * over to another thread.
+   */
+  void Unshare (void);
+
   /**
    * \param offsetStart the offset which uniquely identifies the first data byte 
    *        present in the byte buffer associated to this ByteTagList.
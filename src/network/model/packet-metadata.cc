@@ -17,6 +17,7 @@
  *
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
+#include <algorithm>
 #include <utility>
 #include <list>
 #include "ns3/assert.h"
@@ -34,9 +35,14 @@ NS_LOG_COMPONENT_DEFINE ("PacketMetadata");
 bool PacketMetadata::m_enable = false;
 bool PacketMetadata::m_enableChecking = false;
 bool PacketMetadata::m_metadataSkipped = false;
-uint32_t PacketMetadata::m_maxSize = 0;
+NS_THREAD_LOCAL uint32_t PacketMetadata::m_maxSize = 0;
+#ifdef NS3_MULTITHREADED
+std::atomic<uint16_t> PacketMetadata::m_chunkUid (0);
+#else
 uint16_t PacketMetadata::m_chunkUid = 0;
-PacketMetadata::DataFreeList PacketMetadata::m_freeList;
+#endif
+NS_THREAD_LOCAL PacketMetadata::DataFreeList PacketMetadata::m_freeList;
+NS_THREAD_LOCAL bool PacketMetadata::m_freeListDestroyed = false;
 
 PacketMetadata::DataFreeList::~DataFreeList ()
 {
@@ -45,7 +51,8 @@ PacketMetadata::DataFreeList::~DataFreeList ()
     {
       PacketMetadata::Deallocate (*i);
     }
-  PacketMetadata::m_enable = false;
+  clear ();
+  PacketMetadata::m_freeListDestroyed = true;
 }
 
 void 
@@ -75,12 +82,15 @@ PacketMetadata::ReserveCopy (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
   struct PacketMetadata::Data *newData = PacketMetadata::Create (m_used + size);
-  memcpy (newData->m_data, m_data->m_data, m_used);
   newData->m_dirtyEnd = m_used;
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
+  if (m_data != 0)
     {
-      PacketMetadata::Recycle (m_data);
+      memcpy (newData->m_data, m_data->m_data, m_used);
+      m_data->m_count--;
+      if (m_data->m_count == 0) 
+        {
+          PacketMetadata::Recycle (m_data);
+        }
     }
   m_data = newData;
   if (m_head != 0xffff)
@@ -96,11 +106,28 @@ PacketMetadata::ReserveCopy (uint32_t size)
     }
 }
 void
+PacketMetadata::Unshare (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_data != 0 && m_data->m_count > 1)
+    {
+      ReserveCopy (0);
+    }
+  if (m_journal != 0 && m_journal->m_count > 1)
+    {
+      struct PacketMetadata::Data *newJournal = PacketMetadata::Create (m_journalUsed);
+      memcpy (newJournal->m_data, m_journal->m_data, m_journalUsed);
+      newJournal->m_dirtyEnd = m_journalUsed;
+      m_journal->m_count--;
+      m_journal = newJournal;
+    }
+}
+void
 PacketMetadata::Reserve (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
-  NS_ASSERT (m_data != 0);
-  if (m_data->m_size >= m_used + size &&
+  if (m_data != 0 &&
+      m_data->m_size >= m_used + size &&
       (m_head == 0xffff ||
        m_data->m_count == 1 ||
        m_data->m_dirtyEnd == m_used))
@@ -133,7 +160,8 @@ bool
 PacketMetadata::IsStateOk (void) const
 {
   NS_LOG_FUNCTION (this);
-  bool ok = m_used <= m_data->m_size;
+  bool ok = (m_data == 0) ? (m_used == 0 && m_head == 0xffff) : (m_used <= m_data->m_size);
+  ok &= (m_journal == 0) ? (m_journalUsed == 0) : (m_journalUsed <= m_journal->m_size);
   ok &= IsPointerOk (m_head);
   ok &= IsPointerOk (m_tail);
   uint16_t current = m_head;
@@ -375,12 +403,12 @@ uint16_t
 PacketMetadata::AddSmall (const struct PacketMetadata::SmallItem *item)
 {
   NS_LOG_FUNCTION (this << item->next << item->prev << item->typeUid << item->size << item->chunkUid);
-  NS_ASSERT (m_data != 0);
   NS_ASSERT (m_used != item->prev && m_used != item->next);
   uint32_t typeUidSize = GetUleb128Size (item->typeUid);
   uint32_t sizeSize = GetUleb128Size (item->size);
   uint32_t n =  2 + 2 + typeUidSize + sizeSize + 2;
-  if (m_used + n > m_data->m_size ||
+  if (m_data == 0 ||
+      m_used + n > m_data->m_size ||
       (m_head != 0xffff &&
        m_data->m_count != 1 &&
        m_used != m_data->m_dirtyEnd))
@@ -408,7 +436,6 @@ PacketMetadata::AddBig (uint32_t next, uint32_t prev,
   NS_LOG_FUNCTION (this << next << prev <<
                    item->next << item->prev << item->typeUid << item->size << item->chunkUid <<
                    extraItem->fragmentStart << extraItem->fragmentEnd << extraItem->packetUid);
-  NS_ASSERT (m_data != 0);
   uint32_t typeUid = ((item->typeUid & 0x1) == 0x1) ? item->typeUid : item->typeUid+1;
   NS_ASSERT (m_used != prev && m_used != next);
 
@@ -418,7 +445,8 @@ PacketMetadata::AddBig (uint32_t next, uint32_t prev,
   uint32_t fragEndSize = GetUleb128Size (extraItem->fragmentEnd);
   uint32_t n = 2 + 2 + typeUidSize + sizeSize + 2 + fragStartSize + fragEndSize + 4;
 
-  if (m_used + n > m_data->m_size ||
+  if (m_data == 0 ||
+      m_used + n > m_data->m_size ||
       (m_head != 0xffff &&
        m_data->m_count != 1 &&
        m_used != m_data->m_dirtyEnd))
@@ -576,7 +604,7 @@ PacketMetadata::Create (uint32_t size)
     {
       m_maxSize = size;
     }
-  while (!m_freeList.empty ()) 
+  while (!m_freeListDestroyed && !m_freeList.empty ()) 
     {
       struct PacketMetadata::Data *data = m_freeList.back ();
       m_freeList.pop_back ();
@@ -597,7 +625,7 @@ void
 PacketMetadata::Recycle (struct PacketMetadata::Data *data)
 {
   NS_LOG_FUNCTION (data);
-  if (!m_enable)
+  if (!m_enable || m_freeListDestroyed)
     {
       PacketMetadata::Deallocate (data);
       return;
@@ -669,17 +697,114 @@ PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size)
       m_metadataSkipped = true;
       return;
     }
-
+  Journal (JOURNAL_ADD_HEADER, uid, size, m_chunkUid++);
+}
+void
+PacketMetadata::AddHeaderItem (uint32_t uid, uint32_t size, uint16_t chunkUid)
+{
+  NS_LOG_FUNCTION (this << uid << size << chunkUid);
   struct PacketMetadata::SmallItem item;
   item.next = m_head;
   item.prev = 0xffff;
   item.typeUid = uid;
   item.size = size;
-  item.chunkUid = m_chunkUid;
-  m_chunkUid++;
+  item.chunkUid = chunkUid;
   uint16_t written = AddSmall (&item);
   UpdateHead (written);
 }
+void
+PacketMetadata::Journal (uint32_t op, uint32_t uid, uint32_t size, uint16_t chunkUid)
+{
+  NS_LOG_FUNCTION (this << op << uid << size << chunkUid);
+  NS_ASSERT (size < (1U << 30));
+  uint32_t n = sizeof (struct PacketMetadata::JournalRecord);
+  if (m_journalUsed + n > 0xffff)
+    {
+      // the journal is full: replay it to start a new one.
+      Materialize ();
+    }
+  if (m_journal == 0 ||
+      m_journalUsed + n > m_journal->m_size ||
+      (m_journal->m_count != 1 &&
+       m_journalUsed != m_journal->m_dirtyEnd))
+    {
+      // not enough room, or some other copy appended its own records.
+      uint32_t capacity = std::min (std::max (2 * (m_journalUsed + n), 4 * n), 0xffff - 0xffff % n);
+      struct PacketMetadata::Data *newJournal = PacketMetadata::Create (capacity);
+      if (m_journal != 0)
+        {
+          memcpy (newJournal->m_data, m_journal->m_data, m_journalUsed);
+          m_journal->m_count--;
+          if (m_journal->m_count == 0)
+            {
+              PacketMetadata::Recycle (m_journal);
+            }
+        }
+      m_journal = newJournal;
+    }
+  struct PacketMetadata::JournalRecord record;
+  record.typeUid = uid >> 1;
+  record.chunkUid = chunkUid;
+  record.opSize = (op << 30) | size;
+  memcpy (&m_journal->m_data[m_journalUsed], &record, n);
+  m_journalUsed += n;
+  m_journal->m_dirtyEnd = m_journalUsed;
+}
+bool
+PacketMetadata::IsLastRecord (uint32_t op, uint32_t uid, uint32_t size) const
+{
+  NS_LOG_FUNCTION (this << op << uid << size);
+  if (m_journalUsed == 0)
+    {
+      return false;
+    }
+  struct PacketMetadata::JournalRecord record;
+  memcpy (&record, &m_journal->m_data[m_journalUsed - sizeof (record)], sizeof (record));
+  return record.opSize == ((op << 30) | size) && record.typeUid == (uid >> 1);
+}
+void
+PacketMetadata::Materialize (void) const
+{
+  if (m_journalUsed == 0)
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this);
+  // detach the journal first: the operations replayed below apply
+  // directly to the linked list.
+  PacketMetadata *self = const_cast<PacketMetadata *> (this);
+  struct PacketMetadata::Data *journal = m_journal;
+  uint16_t used = m_journalUsed;
+  self->m_journal = 0;
+  self->m_journalUsed = 0;
+  for (uint16_t offset = 0; offset < used; offset += sizeof (struct PacketMetadata::JournalRecord))
+    {
+      struct PacketMetadata::JournalRecord record;
+      memcpy (&record, &journal->m_data[offset], sizeof (record));
+      uint32_t size = record.opSize & ((1U << 30) - 1);
+      switch (record.opSize >> 30)
+        {
+        case JOURNAL_ADD_HEADER:
+          self->AddHeaderItem (record.typeUid << 1, size, record.chunkUid);
+          break;
+        case JOURNAL_ADD_TRAILER:
+          self->AddTrailerItem (record.typeUid << 1, size, record.chunkUid);
+          break;
+        case JOURNAL_REMOVE_AT_START:
+          self->DoRemoveAtStart (size);
+          break;
+        case JOURNAL_REMOVE_AT_END:
+          self->DoRemoveAtEnd (size);
+          break;
+        }
+    }
+  journal->m_count--;
+  if (journal->m_count == 0)
+    {
+      PacketMetadata::Recycle (journal);
+    }
+  NS_ASSERT (IsStateOk ());
+}
 void 
 PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
 {
@@ -691,6 +816,21 @@ PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
       m_metadataSkipped = true;
       return;
     }
+  if (IsLastRecord (JOURNAL_ADD_HEADER, uid, size))
+    {
+      // removing the header added last.
+      m_journalUsed -= sizeof (struct PacketMetadata::JournalRecord);
+      return;
+    }
+  Materialize ();
+  if (m_head == 0xffff)
+    {
+      if (m_enableChecking)
+        {
+          NS_FATAL_ERROR ("Removing unexpected header.");
+        }
+      return;
+    }
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t read = ReadItems (m_head, &item, &extraItem);
@@ -728,6 +868,37 @@ PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
     }
   NS_ASSERT (IsStateOk ());
 }
+void
+PacketMetadata::ModifyHeader (const Header &header, uint32_t size) const
+{
+  uint32_t uid = header.GetInstanceTypeId ().GetUid () << 1;
+  NS_LOG_FUNCTION (this << &header << size);
+  NS_ASSERT (IsStateOk ());
+  if (!m_enable || !m_enableChecking ||
+      IsLastRecord (JOURNAL_ADD_HEADER, uid, size))
+    {
+      return;
+    }
+  Materialize ();
+  if (m_head == 0xffff)
+    {
+      NS_FATAL_ERROR ("Modifying unexpected header.");
+    }
+  struct PacketMetadata::SmallItem item;
+  struct PacketMetadata::ExtraItem extraItem;
+  ReadItems (m_head, &item, &extraItem);
+  if ((item.typeUid & 0xfffffffe) != uid ||
+      item.size != size)
+    {
+      NS_FATAL_ERROR ("Modifying unexpected header.");
+    }
+  else if (item.typeUid != uid &&
+           (extraItem.fragmentStart != 0 ||
+            extraItem.fragmentEnd != size))
+    {
+      NS_FATAL_ERROR ("Modifying incomplete header.");
+    }
+}
 void 
 PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
 {
@@ -739,16 +910,21 @@ PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
       m_metadataSkipped = true;
       return;
     }
+  Journal (JOURNAL_ADD_TRAILER, uid, size, m_chunkUid++);
+  NS_ASSERT (IsStateOk ());
+}
+void
+PacketMetadata::AddTrailerItem (uint32_t uid, uint32_t size, uint16_t chunkUid)
+{
+  NS_LOG_FUNCTION (this << uid << size << chunkUid);
   struct PacketMetadata::SmallItem item;
   item.next = 0xffff;
   item.prev = m_tail;
   item.typeUid = uid;
   item.size = size;
-  item.chunkUid = m_chunkUid;
-  m_chunkUid++;
+  item.chunkUid = chunkUid;
   uint16_t written = AddSmall (&item);
   UpdateTail (written);
-  NS_ASSERT (IsStateOk ());
 }
 void 
 PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
@@ -761,6 +937,21 @@ PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
       m_metadataSkipped = true;
       return;
     }
+  if (IsLastRecord (JOURNAL_ADD_TRAILER, uid, size))
+    {
+      // removing the trailer added last.
+      m_journalUsed -= sizeof (struct PacketMetadata::JournalRecord);
+      return;
+    }
+  Materialize ();
+  if (m_tail == 0xffff)
+    {
+      if (m_enableChecking)
+        {
+          NS_FATAL_ERROR ("Removing unexpected trailer.");
+        }
+      return;
+    }
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t read = ReadItems (m_tail, &item, &extraItem);
@@ -808,6 +999,8 @@ PacketMetadata::AddAtEnd (PacketMetadata const&o)
       m_metadataSkipped = true;
       return;
     }
+  Materialize ();
+  o.Materialize ();
   if (m_tail == 0xffff)
     {
       // We have no items so 'AddAtEnd' is 
@@ -896,7 +1089,15 @@ PacketMetadata::RemoveAtStart (uint32_t start)
       m_metadataSkipped = true;
       return;
     }
-  NS_ASSERT (m_data != 0);
+  if (start > 0)
+    {
+      Journal (JOURNAL_REMOVE_AT_START, 0, start, 0);
+    }
+}
+void
+PacketMetadata::DoRemoveAtStart (uint32_t start)
+{
+  NS_LOG_FUNCTION (this << start);
   uint32_t leftToRemove = start;
   uint16_t current = m_head;
   while (current != 0xffff && leftToRemove > 0)
@@ -959,8 +1160,15 @@ PacketMetadata::RemoveAtEnd (uint32_t end)
       m_metadataSkipped = true;
       return;
     }
-  NS_ASSERT (m_data != 0);
-
+  if (end > 0)
+    {
+      Journal (JOURNAL_REMOVE_AT_END, 0, end, 0);
+    }
+}
+void
+PacketMetadata::DoRemoveAtEnd (uint32_t end)
+{
+  NS_LOG_FUNCTION (this << end);
   uint32_t leftToRemove = end;
   uint16_t current = m_tail;
   while (current != 0xffff && leftToRemove > 0)
@@ -1018,6 +1226,7 @@ uint32_t
 PacketMetadata::GetTotalSize (void) const
 {
   NS_LOG_FUNCTION (this);
+  Materialize ();
   uint32_t totalSize = 0;
   uint16_t current = m_head;
   uint16_t tail = m_tail;
@@ -1047,6 +1256,7 @@ PacketMetadata::ItemIterator
 PacketMetadata::BeginItem (Buffer buffer) const
 {
   NS_LOG_FUNCTION (this << &buffer);
+  Materialize ();
   return ItemIterator (this, buffer);
 }
 PacketMetadata::ItemIterator::ItemIterator (const PacketMetadata *metadata, Buffer buffer)
@@ -1147,6 +1357,7 @@ PacketMetadata::GetSerializedSize (void) const
       return totalSize;
     }
 
+  Materialize ();
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t current = m_head;
@@ -1179,6 +1390,7 @@ uint32_t
 PacketMetadata::Serialize (uint8_t* buffer, uint32_t maxSize) const
 {
   NS_LOG_FUNCTION (this << &buffer << maxSize);
+  Materialize ();
   uint8_t* start = buffer;
 
   buffer = AddToRawU64 (m_packetUid, start, buffer, maxSize);
@@ -1280,6 +1492,7 @@ uint32_t
 PacketMetadata::Deserialize (const uint8_t* buffer, uint32_t size)
 {
   NS_LOG_FUNCTION (this << &buffer << size);
+  Materialize ();
   const uint8_t* start = buffer;
   uint32_t desSize = size - 4;
 
@@ -23,9 +23,11 @@
 #include <stdint.h>
 #include <vector>
 #include <limits>
+#include <atomic>
 #include "ns3/callback.h"
 #include "ns3/assert.h"
 #include "ns3/type-id.h"
+#include "ns3/thread-local.h"
 #include "buffer.h"
 
 namespace ns3 {
@@ -74,6 +76,21 @@ class Trailer;
  * integers, and some others as variable-size 32-bit integers.
  * The variable-size 32 bit integers are stored using the uleb128
  * encoding.
+ *
+ * Maintaining this linked list on every operation is costly, and most
+ * packets are never printed. The operations which add headers or
+ * trailers, or which remove bytes at the start or at the end of the
+ * packet, are thus first recorded in an append-only journal of
+ * fixed-size 8-byte records, which hold the TypeId uid of the header
+ * or trailer, its chunk uid and the size involved. Removing the header
+ * or trailer recorded last simply drops the last record. The journal
+ * is replayed into the linked list, and then emptied, only when the
+ * linked list is needed: when the items are iterated (BeginItem, used
+ * by Packet::Print), when the metadata is serialized, when packets are
+ * aggregated or when a removal does not match the last record. Like the
+ * linked list, the journal storage is shared between copies.
+ *
+ * No storage is allocated when the packet metadata is not enabled.
  */
 class PacketMetadata 
 {
@@ -191,6 +208,13 @@ private:
    * \param size header serialized size
    */
   void RemoveHeader (Header const &header, uint32_t size);
+  /**
+   * \brief Check that an header about to be rewritten in place is the
+   * first item of the packet
+   * \param header header to rewrite
+   * \param size header serialized size
+   */
+  void ModifyHeader (Header const &header, uint32_t size) const;
 
   /**
    * Add a trailer
@@ -237,6 +261,11 @@ private:
    * \param end the size of metadata to remove
    */
   void RemoveAtEnd (uint32_t end);
+  /**
+   * \brief Make sure the metadata storage is not shared with any
+   * other PacketMetadata instance
+   */
+  void Unshare (void);
 
   /**
    * \brief Get the packet Uid
@@ -500,6 +529,30 @@ public:
     ~DataFreeList ();
   };
 
+  /**
+   * \brief Operations recorded in the journal
+   */
+  enum JournalOp
+  {
+    JOURNAL_ADD_HEADER = 0,       //!< AddHeader
+    JOURNAL_ADD_TRAILER = 1,      //!< AddTrailer
+    JOURNAL_REMOVE_AT_START = 2,  //!< RemoveAtStart
+    JOURNAL_REMOVE_AT_END = 3     //!< RemoveAtEnd
+  };
+
+  /**
+   * \brief Journal record: one operation on the linked list
+   */
+  struct JournalRecord
+  {
+    /** TypeId uid of the header or trailer, zero for payload. */
+    uint16_t typeUid;
+    /** chunk uid of the header or trailer. */
+    uint16_t chunkUid;
+    /** the JournalOp in the 2 high bits, the size in the other bits. */
+    uint32_t opSize;
+  };
+
   friend DataFreeList::~DataFreeList ();
   friend class ItemIterator;
 
@@ -615,6 +668,54 @@ public:
    * \param size header serialized size
    */
   void DoAddHeader (uint32_t uid, uint32_t size);
+  /**
+   * \brief Add an header item to the linked list
+   * \param uid header's uid to add
+   * \param size header serialized size
+   * \param chunkUid header's chunk uid
+   */
+  void AddHeaderItem (uint32_t uid, uint32_t size, uint16_t chunkUid);
+  /**
+   * \brief Add a trailer item to the linked list
+   * \param uid trailer's uid to add
+   * \param size trailer serialized size
+   * \param chunkUid trailer's chunk uid
+   */
+  void AddTrailerItem (uint32_t uid, uint32_t size, uint16_t chunkUid);
+  /**
+   * \brief Remove a chunk of the linked list at its start
+   * \param start the size of metadata to remove
+   */
+  void DoRemoveAtStart (uint32_t start);
+  /**
+   * \brief Remove a chunk of the linked list at its end
+   * \param end the size of metadata to remove
+   */
+  void DoRemoveAtEnd (uint32_t end);
+
+  /**
+   * \brief Append a record to the journal
+   * \param op the JournalOp
+   * \param uid header's or trailer's uid, as stored in the linked list
+   * \param size the size involved
+   * \param chunkUid header's or trailer's chunk uid
+   */
+  void Journal (uint32_t op, uint32_t uid, uint32_t size, uint16_t chunkUid);
+  /**
+   * \brief Check the last record of the journal
+   * \param op the JournalOp
+   * \param uid header's or trailer's uid, as stored in the linked list
+   * \param size the size involved
+   * \returns true if the last record matches
+   */
+  bool IsLastRecord (uint32_t op, uint32_t uid, uint32_t size) const;
+  /**
+   * \brief Replay the journal into the linked list, and empty it
+   *
+   * The metadata is logically unchanged, so this can be called from
+   * the const methods which read the linked list.
+   */
+  void Materialize (void) const;
   /**
    * \brief Check if the metadata state is ok
    * \returns true if the internal state is ok
@@ -656,7 +757,12 @@ public:
    */
   static void Deallocate (struct PacketMetadata::Data *data);
 
-  static DataFreeList m_freeList; //!< the metadata data storage
+  static NS_THREAD_LOCAL DataFreeList m_freeList; //!< the metadata data storage, per thread
+  /**
+   * Set when the free list of the thread has been destroyed: metadata
+   * released afterwards is deallocated directly.
+   */
+  static NS_THREAD_LOCAL bool m_freeListDestroyed;
   static bool m_enable; //!< Enable the packet metadata
   static bool m_enableChecking; //!< Enable the packet metadata checking
 
@@ -667,10 +773,15 @@ public:
    */
   static bool m_metadataSkipped;
 
-  static uint32_t m_maxSize; //!< maximum metadata size
+  static NS_THREAD_LOCAL uint32_t m_maxSize; //!< maximum metadata size, per thread
+#ifdef NS3_MULTITHREADED
+  static std::atomic<uint16_t> m_chunkUid; //!< Chunk Uid, shared by all the threads
+#else
   static uint16_t m_chunkUid; //!< Chunk Uid
+#endif
 
-  struct Data *m_data; //!< Metadata storage
+  struct Data *m_data; //!< Metadata storage, 0 if none
+  struct Data *m_journal; //!< Journal storage, 0 if none
   /*
      head -(next)-> tail
        ^             |
@@ -679,6 +790,7 @@ public:
   uint16_t m_head; //!< list head
   uint16_t m_tail; //!< list tail
   uint16_t m_used; //!< used portion
+  uint16_t m_journalUsed; //!< used portion of the journal
   uint64_t m_packetUid; //!< packet Uid
 };
 
@@ -687,13 +799,14 @@ public:
 namespace ns3 {
 
 PacketMetadata::PacketMetadata (uint64_t uid, uint32_t size)
-  : m_data (PacketMetadata::Create (10)),
+  : m_data (0),
+    m_journal (0),
     m_head (0xffff),
     m_tail (0xffff),
     m_used (0),
+    m_journalUsed (0),
     m_packetUid (uid)
 {
-  memset (m_data->m_data, 0xff, 4);
   if (size > 0)
     {
       DoAddHeader (0, size);
@@ -701,14 +814,23 @@ PacketMetadata::PacketMetadata (uint64_t uid, uint32_t size)
 }
 PacketMetadata::PacketMetadata (PacketMetadata const &o)
   : m_data (o.m_data),
+    m_journal (o.m_journal),
     m_head (o.m_head),
     m_tail (o.m_tail),
     m_used (o.m_used),
+    m_journalUsed (o.m_journalUsed),
     m_packetUid (o.m_packetUid)
 {
-  NS_ASSERT (m_data != 0);
-  NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
-  m_data->m_count++;
+  if (m_data != 0)
+    {
+      NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
+      m_data->m_count++;
+    }
+  if (m_journal != 0)
+    {
+      NS_ASSERT (m_journal->m_count < std::numeric_limits<uint32_t>::max());
+      m_journal->m_count++;
+    }
 }
 PacketMetadata &
 PacketMetadata::operator = (PacketMetadata const& o)
@@ -716,29 +838,60 @@ PacketMetadata::operator = (PacketMetadata const& o)
   if (m_data != o.m_data) 
     {
       // not self assignment
-      NS_ASSERT (m_data != 0);
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      if (m_data != 0)
         {
-          PacketMetadata::Recycle (m_data);
+          m_data->m_count--;
+          if (m_data->m_count == 0) 
+            {
+              PacketMetadata::Recycle (m_data);
+            }
         }
       m_data = o.m_data;
-      NS_ASSERT (m_data != 0);
-      m_data->m_count++;
+      if (m_data != 0)
+        {
+          m_data->m_count++;
+        }
+    }
+  if (m_journal != o.m_journal)
+    {
+      if (m_journal != 0)
+        {
+          m_journal->m_count--;
+          if (m_journal->m_count == 0)
+            {
+              PacketMetadata::Recycle (m_journal);
+            }
+        }
+      m_journal = o.m_journal;
+      if (m_journal != 0)
+        {
+          m_journal->m_count++;
+        }
     }
   m_head = o.m_head;
   m_tail = o.m_tail;
   m_used = o.m_used;
+  m_journalUsed = o.m_journalUsed;
   m_packetUid = o.m_packetUid;
   return *this;
 }
 PacketMetadata::~PacketMetadata ()
 {
-  NS_ASSERT (m_data != 0);
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
+  if (m_data != 0)
+    {
+      m_data->m_count--;
+      if (m_data->m_count == 0) 
+        {
+          PacketMetadata::Recycle (m_data);
+        }
+    }
+  if (m_journal != 0)
     {
-      PacketMetadata::Recycle (m_data);
+      m_journal->m_count--;
+      if (m_journal->m_count == 0)
+        {
+          PacketMetadata::Recycle (m_journal);
+        }
     }
 }
 
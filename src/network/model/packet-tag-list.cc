@@ -154,9 +154,34 @@ PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
 
 }
 
+uint32_t
+PacketTagList::FindInline (TypeId tid) const
+{
+  uint32_t i = 0;
+  while (i < m_nInline && m_inlineTid[i] != tid)
+    {
+      ++i;
+    }
+  return i;
+}
+
 bool
 PacketTagList::Remove (Tag & tag)
 {
+  uint32_t i = FindInline (tag.GetInstanceTypeId ());
+  if (i < m_nInline)
+    {
+      NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
+      tag.Deserialize (TagBuffer (m_inlineData[i],
+                                  m_inlineData[i] + TagData::MAX_SIZE));
+      m_nInline--;
+      for (; i < m_nInline; ++i)
+        {
+          m_inlineTid[i] = m_inlineTid[i + 1];
+          memcpy (m_inlineData[i], m_inlineData[i + 1], TagData::MAX_SIZE);
+        }
+      return true;
+    }
   return COWTraverse (tag, &PacketTagList::RemoveWriter);
 }
 
@@ -196,6 +221,14 @@ PacketTagList::RemoveWriter (Tag & tag, bool preMerge,
 bool
 PacketTagList::Replace (Tag & tag)
 {
+  uint32_t i = FindInline (tag.GetInstanceTypeId ());
+  if (i < m_nInline)
+    {
+      NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
+      tag.Serialize (TagBuffer (m_inlineData[i],
+                                m_inlineData[i] + tag.GetSerializedSize ()));
+      return true;
+    }
   bool found = COWTraverse (tag, &PacketTagList::ReplaceWriter);
   if (!found)
     {
@@ -245,16 +278,28 @@ PacketTagList::Add (const Tag &tag) const
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
   // ensure this id was not yet added
+  NS_ASSERT_MSG (FindInline (tag.GetInstanceTypeId ()) == m_nInline, "Error: cannot add the same kind of tag twice.");
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
     {
       NS_ASSERT_MSG (cur->tid != tag.GetInstanceTypeId (), "Error: cannot add the same kind of tag twice.");
     }
+  NS_ASSERT (tag.GetSerializedSize () <= TagData::MAX_SIZE);
+  if (m_next == 0 && m_nInline < INLINE_TAGS)
+    {
+      // the tree is empty, so this tag is the most recent one
+      PacketTagList *self = const_cast<PacketTagList *> (this);
+      uint8_t *data = self->m_inlineData[m_nInline];
+      memset (data, 0, TagData::MAX_SIZE);
+      tag.Serialize (TagBuffer (data, data + tag.GetSerializedSize ()));
+      self->m_inlineTid[m_nInline] = tag.GetInstanceTypeId ();
+      self->m_nInline++;
+      return;
+    }
   struct TagData * head = new struct TagData ();
   head->count = 1;
   head->next = 0;
   head->tid = tag.GetInstanceTypeId ();
   head->next = m_next;
-  NS_ASSERT (tag.GetSerializedSize () <= TagData::MAX_SIZE);
   tag.Serialize (TagBuffer (head->data, head->data + tag.GetSerializedSize ()));
 
   const_cast<PacketTagList *> (this)->m_next = head;
@@ -265,6 +310,13 @@ PacketTagList::Peek (Tag &tag) const
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
   TypeId tid = tag.GetInstanceTypeId ();
+  uint32_t i = FindInline (tid);
+  if (i < m_nInline)
+    {
+      tag.Deserialize (TagBuffer (const_cast<uint8_t *> (m_inlineData[i]),
+                                  const_cast<uint8_t *> (m_inlineData[i]) + TagData::MAX_SIZE));
+      return true;
+    }
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
     {
       if (cur->tid == tid) 
@@ -278,6 +330,29 @@ PacketTagList::Peek (Tag &tag) const
   return false;
 }
 
+void
+PacketTagList::Unshare (void)
+{
+  NS_LOG_FUNCTION (this);
+  // the inline tags are never shared
+  struct TagData * head = 0;
+  struct TagData ** prevNext = &head;
+  for (struct TagData * cur = m_next; cur != 0; cur = cur->next)
+    {
+      struct TagData * copy = new struct TagData ();
+      copy->tid = cur->tid;
+      copy->count = 1;
+      memcpy (copy->data, cur->data, TagData::MAX_SIZE);
+      copy->next = 0;
+      *prevNext = copy;
+      prevNext = &copy->next;
+    }
+  uint32_t nInline = m_nInline;
+  RemoveAll ();
+  m_next = head;
+  m_nInline = nInline;
+}
+
 const struct PacketTagList::TagData *
 PacketTagList::Head (void) const
 {
@@ -27,6 +27,7 @@
 
 #include <stdint.h>
 #include <ostream>
+#include <cstring>
 #include "ns3/type-id.h"
 
 namespace ns3 {
@@ -120,6 +121,18 @@ class Tag;
  *       shared. This portion is copied before the #Remove or #Replace is
  *       performed.
  *
+ * \par <b> Inline storage: </b>
+ * \n
+ * Most packets carry only a few packet tags, so the first #INLINE_TAGS
+ * tags added to an empty tree are not stored in TagData at all, but
+ * serialized in slots held by the PacketTagList itself, next to a
+ * compact array of their TypeIds which #Peek scans before the tree.
+ * Adding, finding and removing these tags never allocates memory.
+ * The slots are copied along with the PacketTagList, which gives them
+ * the same value semantics as the copy-on-write tree.  Once the slots
+ * are full, or as soon as the tree is not empty, tags are added to the
+ * tree, so the tree always holds the most recent tags.
+ *
  * \par <b> Memory Management: </b>
  * \n
  * Packet tags must serialize to a finite maximum size, see TagData
@@ -167,6 +180,14 @@ public:
     uint32_t count;           /**< Number of incoming links */
   };  /* struct TagData */
 
+  /**
+   * Number of packet tags stored in the PacketTagList itself.
+   */
+  enum InlineTags_e
+  {
+    INLINE_TAGS = 4           /**< Number of inline tag slots */
+  };
+
   /**
    * Create a new PacketTagList.
    */
@@ -234,9 +255,32 @@ public:
    */
   inline void RemoveAll (void);
   /**
-   * \returns pointer to head of tag list
+   * Replace the tags of this list by private copies, so that this list
+   * no longer shares any TagData with other lists.
+   *
+   * Unlike the copy constructor, this makes the list safe to hand over
+   * to another thread.
+   */
+  void Unshare (void);
+  /**
+   * \returns pointer to head of the tree of tags which are not stored
+   *          inline, the most recent ones
    */
   const struct PacketTagList::TagData *Head (void) const;
+  /**
+   * \returns the number of tags stored inline
+   */
+  inline uint32_t GetNInlineTags (void) const;
+  /**
+   * \param [in] i The index of an inline tag, the oldest tag first.
+   * \returns the type of the tag
+   */
+  inline TypeId GetInlineTypeId (uint32_t i) const;
+  /**
+   * \param [in] i The index of an inline tag, the oldest tag first.
+   * \returns the TagData::MAX_SIZE bytes of the serialized tag
+   */
+  inline const uint8_t *GetInlineData (uint32_t i) const;
 
 private:
   /**
@@ -286,11 +330,27 @@ private:
    * \returns True, since tag value will definitely be replaced.
    */
   bool ReplaceWriter (Tag & tag, bool preMerge, struct TagData * cur, struct TagData ** prevNext);
+  /**
+   * Find an inline tag.
+   *
+   * \param [in] tid The type of the tag.
+   * \returns The index of the tag, or #m_nInline if not found.
+   */
+  uint32_t FindInline (TypeId tid) const;
+  /**
+   * Copy the inline tags of another list.
+   *
+   * \param [in] o The PacketTagList to copy.
+   */
+  inline void CopyInline (PacketTagList const &o);
 
   /**
    * Pointer to first \ref TagData on the list
    */
   struct TagData *m_next;
+  uint32_t m_nInline;                                   //!< Number of inline tags
+  TypeId m_inlineTid[INLINE_TAGS];                      //!< Types of the inline tags, oldest first
+  uint8_t m_inlineData[INLINE_TAGS][TagData::MAX_SIZE]; //!< Serialized inline tags
 };
 
 } // namespace ns3
@@ -302,7 +362,8 @@ private:
 namespace ns3 {
 
 PacketTagList::PacketTagList ()
-  : m_next ()
+  : m_next (),
+    m_nInline (0)
 {
 }
 
@@ -313,22 +374,27 @@ PacketTagList::PacketTagList (PacketTagList const &o)
     {
       m_next->count++;
     }
+  CopyInline (o);
 }
 
 PacketTagList &
 PacketTagList::operator = (PacketTagList const &o)
 {
   // self assignment
-  if (m_next == o.m_next) 
+  if (this == &o)
     {
       return *this;
     }
-  RemoveAll ();
-  m_next = o.m_next;
-  if (m_next != 0) 
+  if (m_next != o.m_next)
     {
-      m_next->count++;
+      RemoveAll ();
+      m_next = o.m_next;
+      if (m_next != 0)
+        {
+          m_next->count++;
+        }
     }
+  CopyInline (o);
   return *this;
 }
 
@@ -359,6 +425,36 @@ PacketTagList::RemoveAll (void)
       delete prev;
     }
   m_next = 0;
+  m_nInline = 0;
+}
+
+uint32_t
+PacketTagList::GetNInlineTags (void) const
+{
+  return m_nInline;
+}
+
+TypeId
+PacketTagList::GetInlineTypeId (uint32_t i) const
+{
+  return m_inlineTid[i];
+}
+
+const uint8_t *
+PacketTagList::GetInlineData (uint32_t i) const
+{
+  return m_inlineData[i];
+}
+
+void
+PacketTagList::CopyInline (PacketTagList const &o)
+{
+  m_nInline = o.m_nInline;
+  for (uint32_t i = 0; i < m_nInline; ++i)
+    {
+      m_inlineTid[i] = o.m_inlineTid[i];
+    }
+  std::memcpy (m_inlineData, o.m_inlineData, m_nInline * TagData::MAX_SIZE);
 }
 
 } // namespace ns3
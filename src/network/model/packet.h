@@ -21,6 +21,7 @@
 #define PACKET_H
 
 #include <stdint.h>
+#include <atomic>
 #include "buffer.h"
 #include "header.h"
 #include "trailer.h"
@@ -34,6 +35,7 @@
 #include "ns3/assert.h"
 #include "ns3/ptr.h"
 #include "ns3/deprecated.h"
+#include "ns3/thread-local.h"
 
 namespace ns3 {
 
@@ -152,10 +154,12 @@ private:
     friend class PacketTagIterator;
     /**
      * Constructor
-     * \param data the data to copy.
+     * \param tid the type of the tag.
+     * \param data the serialized tag.
      */
-    Item (const struct PacketTagList::TagData *data);
-    const struct PacketTagList::TagData *m_data; //!< the tag data
+    Item (TypeId tid, const uint8_t *data);
+    TypeId m_tid;          //!< the type of the tag
+    const uint8_t *m_data; //!< the serialized tag
   };
   /**
    * \returns true if calling Next is safe, false otherwise.
@@ -169,10 +173,12 @@ private:
   friend class Packet;
   /**
    * Constructor
-   * \param head head of the items
+   * \param list the tags to iterate over
    */
-  PacketTagIterator (const struct PacketTagList::TagData *head);
-  const struct PacketTagList::TagData *m_current;  //!< actual position over the set of tags in a packet
+  PacketTagIterator (const PacketTagList *list);
+  const PacketTagList *m_list;                     //!< the tags of the packet
+  const struct PacketTagList::TagData *m_current;  //!< actual position over the tree of tags
+  uint32_t m_nInline;                              //!< number of inline tags not visited yet
 };
 
 /**
@@ -327,6 +333,24 @@ public:
    * \returns the number of bytes read from the packet.
    */
   uint32_t PeekHeader (Header &header) const;
+  /**
+   * \brief Rewrite in place the header at the start of the packet.
+   *
+   * This method invokes Header::Serialize over the bytes of the
+   * header already at the start of the packet, typically read with
+   * PeekHeader and then changed, e.g., to decrement a TTL or to update
+   * a checksum. Unlike a RemoveHeader and AddHeader pair, the packet
+   * size and metadata are left untouched. The bytes are first copied
+   * if they are shared with other packets, so that the copies of this
+   * packet still see the previous header.
+   *
+   * The serialized size of \p header must be the size of the header
+   * it replaces.
+   *
+   * \param header a reference to the header to write to the packet.
+   * \returns the number of bytes written.
+   */
+  uint32_t ModifyHeader (const Header &header);
   /**
    * \brief Add trailer to this packet.
    *
@@ -424,6 +448,19 @@ public:
    */
   Ptr<Packet> Copy (void) const;
 
+  /**
+   * \brief performs a deep copy of the packet.
+   *
+   * \returns a copy of the packet which does not share any internal
+   * data with the original packet.
+   *
+   * Unlike Copy, the returned packet can be handed over to another
+   * thread, for example by the MultithreadedSimulatorImpl, while the
+   * original packet keeps being used by the calling thread.  The copy
+   * keeps the uid of the original packet.
+   */
+  Ptr<Packet> DeepCopy (void) const;
+
   /**
    * \brief Returns the packet's Uid.
    *
@@ -727,7 +764,11 @@ private:
   /* Please see comments above about nix-vector */
   Ptr<NixVector> m_nixVector; //!< the packet's Nix vector
 
+#ifdef NS3_MULTITHREADED
+  static std::atomic<uint32_t> m_globalUid; //!< Global counter of packets Uid, shared by all the threads
+#else
   static uint32_t m_globalUid; //!< Global counter of packets Uid
+#endif
 };
 
 /**
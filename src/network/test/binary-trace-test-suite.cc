@@ -0,0 +1,237 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/binary-trace-file.h"
+#include "ns3/trace-helper.h"
+#include "ns3/node.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simulator.h"
+#include "ns3/mac48-address.h"
+
+using namespace ns3;
+
+namespace {
+
+/// A record read back from a binary trace file
+struct Record
+{
+  int64_t time;      //!< Time, in nanoseconds
+  uint64_t uid;      //!< Packet uid
+  uint32_t node;     //!< Node id
+  uint32_t device;   //!< Device index
+  uint32_t size;     //!< Packet size
+  uint8_t event;     //!< Event type
+};
+
+/**
+ * \param filename the name of a binary trace file
+ * \param records [out] the records of the file
+ * \param chunks [out] the number of chunks of the file
+ * \returns true if the file is well formed
+ */
+bool
+ReadRecords (std::string const &filename, std::vector<Record> &records, uint32_t &chunks)
+{
+  std::ifstream file (filename.c_str (), std::ios::in | std::ios::binary);
+  std::vector<char> data ((std::istreambuf_iterator<char> (file)), std::istreambuf_iterator<char> ());
+  uint32_t version;
+  if (data.size () < 16 || std::memcmp (&data[0], "ns3trace", 8) != 0)
+    {
+      return false;
+    }
+  std::memcpy (&version, &data[8], 4);
+  if (version != BinaryTraceFile::VERSION)
+    {
+      return false;
+    }
+  chunks = 0;
+  uint32_t offset = 16;
+  while (offset + 8 <= data.size ())
+    {
+      if (offset % 8 != 0)
+        {
+          return false;
+        }
+      uint32_t n;
+      std::memcpy (&n, &data[offset], 4);
+      uint32_t chunkSize = 8 + ((n * (8 + 8 + 4 + 4 + 4 + 1) + 7) & ~7U);
+      if (offset + chunkSize > data.size ())
+        {
+          return false;
+        }
+      char const *column = &data[offset + 8];
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          Record r;
+          std::memcpy (&r.time, column + 8 * i, 8);
+          std::memcpy (&r.uid, column + 8 * n + 8 * i, 8);
+          std::memcpy (&r.node, column + 16 * n + 4 * i, 4);
+          std::memcpy (&r.device, column + 20 * n + 4 * i, 4);
+          std::memcpy (&r.size, column + 24 * n + 4 * i, 4);
+          std::memcpy (&r.event, column + 28 * n + i, 1);
+          records.push_back (r);
+        }
+      offset += chunkSize;
+      ++chunks;
+    }
+  return offset == data.size ();
+}
+
+} // unnamed namespace
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Check the chunks of columns written to a binary trace file
+ */
+class BinaryTraceWriteTestCase : public TestCase
+{
+public:
+  BinaryTraceWriteTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BinaryTraceWriteTestCase::BinaryTraceWriteTestCase ()
+  : TestCase ("Check writing a binary trace file")
+{
+}
+
+void
+BinaryTraceWriteTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("write.bin");
+  Ptr<BinaryTraceFile> file = Create<BinaryTraceFile> (3);
+  file->Open (filename);
+  NS_TEST_ASSERT_MSG_EQ (file->Fail (), false, "Could not open " << filename);
+  for (uint32_t i = 0; i < 10; ++i)
+    {
+      file->Write (NanoSeconds (1000 * i + 1), i / 3, i % 3, BinaryTraceFile::EventType (i % 4),
+                   (uint64_t (1) << 40) + i, 100 + i);
+    }
+  file->Close ();
+  NS_TEST_ASSERT_MSG_EQ (file->Fail (), false, "Could not write " << filename);
+
+  std::vector<Record> records;
+  uint32_t chunks;
+  NS_TEST_ASSERT_MSG_EQ (ReadRecords (filename, records, chunks), true, "Malformed file");
+  NS_TEST_EXPECT_MSG_EQ (chunks, 4, "Expected chunks of 3, 3, 3 and 1 records");
+  NS_TEST_ASSERT_MSG_EQ (records.size (), 10, "Unexpected number of records");
+  for (uint32_t i = 0; i < records.size (); ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (records[i].time, 1000 * i + 1, "Unexpected time");
+      NS_TEST_EXPECT_MSG_EQ (records[i].uid, (uint64_t (1) << 40) + i, "Unexpected uid");
+      NS_TEST_EXPECT_MSG_EQ (records[i].node, i / 3, "Unexpected node");
+      NS_TEST_EXPECT_MSG_EQ (records[i].device, i % 3, "Unexpected device");
+      NS_TEST_EXPECT_MSG_EQ (records[i].size, 100 + i, "Unexpected size");
+      NS_TEST_EXPECT_MSG_EQ (uint32_t (records[i].event), i % 4, "Unexpected event");
+    }
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Check that BinaryTraceHelper records the queue events of a device
+ */
+class BinaryTraceHelperTestCase : public TestCase
+{
+public:
+  BinaryTraceHelperTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BinaryTraceHelperTestCase::BinaryTraceHelperTestCase ()
+  : TestCase ("Check tracing devices to a binary trace file")
+{
+}
+
+void
+BinaryTraceHelperTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("helper.bin");
+
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  NodeContainer nodes;
+  nodes.Create (2);
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      device->SetChannel (channel);
+      nodes.Get (i)->AddDevice (device);
+      devices.Add (device);
+    }
+
+  BinaryTraceHelper helper;
+  Ptr<BinaryTraceFile> file = helper.CreateFile (filename);
+  helper.EnableBinary (file, devices.Get (0));
+
+  Ptr<Packet> p = Create<Packet> (50);
+  Simulator::Schedule (Seconds (1), &NetDevice::Send, devices.Get (0), p, devices.Get (1)->GetAddress (), 0x800);
+  Simulator::Run ();
+  Simulator::Destroy ();
+  file->Close ();
+
+  std::vector<Record> records;
+  uint32_t chunks;
+  NS_TEST_ASSERT_MSG_EQ (ReadRecords (filename, records, chunks), true, "Malformed file");
+  NS_TEST_ASSERT_MSG_EQ (records.size (), 2, "Expected the enqueue and dequeue of the packet");
+  NS_TEST_EXPECT_MSG_EQ (uint32_t (records[0].event), BinaryTraceFile::ENQUEUE, "Unexpected event");
+  NS_TEST_EXPECT_MSG_EQ (uint32_t (records[1].event), BinaryTraceFile::DEQUEUE, "Unexpected event");
+  for (uint32_t i = 0; i < records.size (); ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (records[i].time, Seconds (1).GetNanoSeconds (), "Unexpected time");
+      NS_TEST_EXPECT_MSG_EQ (records[i].node, nodes.Get (0)->GetId (), "Unexpected node");
+      NS_TEST_EXPECT_MSG_EQ (records[i].device, 0, "Unexpected device");
+      NS_TEST_EXPECT_MSG_EQ (records[i].uid, p->GetUid (), "Unexpected uid");
+      NS_TEST_EXPECT_MSG_EQ (records[i].size, 50, "Unexpected size");
+    }
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Test suite for binary trace files
+ */
+class BinaryTraceTestSuite : public TestSuite
+{
+public:
+  BinaryTraceTestSuite ();
+};
+
+BinaryTraceTestSuite::BinaryTraceTestSuite ()
+  : TestSuite ("binary-trace", UNIT)
+{
+  AddTestCase (new BinaryTraceWriteTestCase, TestCase::QUICK);
+  AddTestCase (new BinaryTraceHelperTestCase, TestCase::QUICK);
+}
+
+static BinaryTraceTestSuite binaryTraceTestSuite; //!< Static variable for test initialization
@@ -359,6 +359,78 @@ BufferTest::DoRun (void)
   val2 <<= 8;
   val2 |= i.ReadU8 ();
   NS_TEST_ASSERT_MSG_EQ (val1, val2, "Bad ReadNtohU16()");
+
+  // the zero areas stay virtual when buffers are aggregated, even when
+  // the data of the buffer is shared.
+  Buffer header;
+  header.AddAtStart (4);
+  header.Begin ().WriteHtonU32 (0x01020304);
+  Buffer shared = header;
+  shared.AddAtEnd (Buffer (10000));
+  NS_TEST_ASSERT_MSG_EQ (shared.GetSize (), 10004, "Bad size after aggregation");
+  NS_TEST_ASSERT_MSG_LT (shared.GetSerializedSize (), 100, "The zero area should stay virtual");
+  NS_TEST_ASSERT_MSG_EQ (header.GetSize (), 4, "The shared buffer should not change");
+  i = shared.Begin ();
+  NS_TEST_ASSERT_MSG_EQ (i.ReadNtohU32 (), 0x01020304, "Bad header after aggregation");
+  i.Next (9999);
+  NS_TEST_ASSERT_MSG_EQ (i.ReadU8 (), 0, "Bad zero area after aggregation");
+
+  // when both buffers have data around their zero area, only the
+  // smallest zero area is written out.
+  Buffer large = Buffer (10000);
+  large.AddAtStart (1);
+  large.Begin ().WriteU8 (0x11);
+  large.AddAtEnd (1);
+  i = large.End ();
+  i.Prev (1);
+  i.WriteU8 (0x22);
+  Buffer small = Buffer (100);
+  small.AddAtStart (1);
+  small.Begin ().WriteU8 (0x33);
+  Buffer largeFirst = large;
+  largeFirst.AddAtEnd (small);
+  NS_TEST_ASSERT_MSG_EQ (largeFirst.GetSize (), 10103, "Bad size after aggregation");
+  NS_TEST_ASSERT_MSG_LT (largeFirst.GetSerializedSize (), 300, "The largest zero area should stay virtual");
+  i = largeFirst.Begin ();
+  NS_TEST_ASSERT_MSG_EQ (i.ReadU8 (), 0x11, "Bad data after aggregation");
+  i.Next (10000);
+  NS_TEST_ASSERT_MSG_EQ (i.ReadU8 (), 0x22, "Bad data after aggregation");
+  NS_TEST_ASSERT_MSG_EQ (i.ReadU8 (), 0x33, "Bad data after aggregation");
+  i.Next (99);
+  NS_TEST_ASSERT_MSG_EQ (i.ReadU8 (), 0, "Bad data after aggregation");
+  NS_TEST_ASSERT_MSG_EQ (i.IsEnd (), true, "Bad size after aggregation");
+  Buffer smallFirst = small;
+  smallFirst.AddAtEnd (large);
+  NS_TEST_ASSERT_MSG_EQ (smallFirst.GetSize (), 10103, "Bad size after aggregation");
+  NS_TEST_ASSERT_MSG_LT (smallFirst.GetSerializedSize (), 300, "The largest zero area should stay virtual");
+  i = smallFirst.Begin ();
+  NS_TEST_ASSERT_MSG_EQ (i.ReadU8 (), 0x33, "Bad data after aggregation");
+  i.Next (100);
+  NS_TEST_ASSERT_MSG_EQ (i.ReadU8 (), 0x11, "Bad data after aggregation");
+  i.Next (10000);
+  NS_TEST_ASSERT_MSG_EQ (i.ReadU8 (), 0x22, "Bad data after aggregation");
+  NS_TEST_ASSERT_MSG_EQ (i.IsEnd (), true, "Bad size after aggregation");
+
+#ifdef BUFFER_FREE_LIST
+  // storages are recycled through the free list of their size class.
+  {
+    Buffer::ResetPoolStatistics ();
+    {
+      Buffer segment;
+      segment.AddAtStart (20000);
+    }
+    Buffer::PoolStatistics first = Buffer::GetPoolStatistics ();
+    NS_TEST_ASSERT_MSG_GT (first.peakBytes, 20000, "The storage was not recycled");
+    {
+      Buffer segment;
+      segment.AddAtStart (20000);
+    }
+    Buffer::PoolStatistics second = Buffer::GetPoolStatistics ();
+    NS_TEST_ASSERT_MSG_GT (second.hits, first.hits, "The storage was not reused");
+    NS_TEST_ASSERT_MSG_EQ (second.misses, first.misses, "The storage was allocated again");
+    NS_TEST_ASSERT_MSG_EQ (second.cachedBytes, first.cachedBytes, "The storage was not recycled");
+  }
+#endif
 }
 //-----------------------------------------------------------------------------
 class BufferTestSuite : public TestSuite
@@ -821,6 +821,40 @@ PacketMetadataTest::DoRun (void)
                                  p3->GetSize ());
   delete [] buf;
   NS_TEST_EXPECT_MSG_EQ (msg, std::string ("hello world"), "Could not find original data in received packet");
+
+  p = Create<Packet> (10);
+  ADD_HEADER (p, 1);
+  ADD_HEADER (p, 2);
+  p1 = p->Copy ();
+  {
+    HistoryHeader<2> header;
+    p->ModifyHeader (header);
+  }
+  CHECK_HISTORY (p, 3, 2, 1, 10);
+  CHECK_HISTORY (p1, 3, 2, 1, 10);
+
+  // copies share their operations until they diverge.
+  p = Create<Packet> (10);
+  ADD_HEADER (p, 1);
+  p1 = p->Copy ();
+  ADD_HEADER (p, 2);
+  REM_HEADER (p, 2);
+  ADD_HEADER (p, 3);
+  ADD_TRAILER (p1, 4);
+  REM_HEADER (p1, 1);
+  CHECK_HISTORY (p, 3, 3, 1, 10);
+  CHECK_HISTORY (p1, 2, 10, 4);
+  p->RemoveAtStart (3);
+  CHECK_HISTORY (p, 2, 1, 10);
+
+  // long sequences of operations.
+  p = Create<Packet> (20000);
+  for (uint32_t i = 0; i < 5000; i++)
+    {
+      p->RemoveAtStart (1);
+      p->RemoveAtEnd (1);
+    }
+  CHECK_HISTORY (p, 1, 10000);
 }
 //-----------------------------------------------------------------------------
 class PacketMetadataTestSuite : public TestSuite
@@ -256,6 +256,46 @@ public:
 
 };
 
+class ATestValueHeader : public Header
+{
+public:
+  /**
+   * Register this type.
+   * \return The TypeId.
+   */
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("anon::ATestValueHeader")
+      .SetParent<Header> ()
+      .SetGroupName ("Network")
+      .HideFromDocumentation ()
+      .AddConstructor<ATestValueHeader> ()
+    ;
+    return tid;
+  }
+  virtual TypeId GetInstanceTypeId (void) const {
+    return GetTypeId ();
+  }
+  virtual uint32_t GetSerializedSize (void) const {
+    return 4;
+  }
+  virtual void Serialize (Buffer::Iterator iter) const {
+    iter.WriteHtonU16 (m_value);
+    iter.WriteHtonU16 (~m_value);
+  }
+  virtual uint32_t Deserialize (Buffer::Iterator iter) {
+    m_value = iter.ReadNtohU16 ();
+    m_error = (iter.ReadNtohU16 () != static_cast<uint16_t> (~m_value));
+    return 4;
+  }
+  virtual void Print (std::ostream &os) const {
+  }
+  ATestValueHeader (uint16_t value = 0)
+    : m_value (value), m_error (false) {}
+
+  uint16_t m_value;
+  bool m_error;
+};
 
 struct Expected
 {
@@ -805,7 +845,54 @@ PacketTagListTest::DoRun (void)
     ReplaceCheck (6);
     ReplaceCheck (7);
   }
-  
+
+  { // Inline and tree storage
+    std::cout << GetName () << "check inline tags" << std::endl;
+    MAKE_TEST_TAGS ;
+    PacketTagList ptl;
+    ptl.Add (t1);
+    ptl.Add (t2);
+    ptl.Add (t3);
+    PacketTagList cpy = ptl;
+    cpy.Remove (t2);
+    t3.m_data = 2;
+    cpy.Replace (t3);
+    CheckRef (ptl, t1, "inline copy, orig");
+    CheckRef (ptl, t2, "inline copy, orig");
+    CheckRef (cpy, t2, "inline copy, copy", true);
+    CheckRef (cpy, t3, "inline copy, copy");
+    t3.m_data = 1;
+    CheckRef (ptl, t3, "inline copy, orig");
+
+    // tags are iterated from the most recent one, whether they are
+    // stored inline or in the tree.
+    Ptr<Packet> p = Create<Packet> ();
+    p->AddPacketTag (t1);
+    p->AddPacketTag (t2);
+    p->AddPacketTag (t3);
+    p->AddPacketTag (t4);
+    p->AddPacketTag (t5);
+    p->AddPacketTag (t6);
+    p->RemovePacketTag (t2);
+    p->AddPacketTag (t7);
+    TypeId expected[] = { t7.GetTypeId (), t6.GetTypeId (), t5.GetTypeId (),
+                          t4.GetTypeId (), t3.GetTypeId (), t1.GetTypeId () };
+    uint32_t n = 0;
+    PacketTagIterator i = p->GetPacketTagIterator ();
+    while (i.HasNext ())
+      {
+        PacketTagIterator::Item item = i.Next ();
+        NS_TEST_EXPECT_MSG_EQ ((n < 6 && item.GetTypeId () == expected[n]), true,
+                               "packet tag " << n << " is " << item.GetTypeId ().GetName ());
+        ATestTagBase *tag = dynamic_cast<ATestTagBase *> (item.GetTypeId ().GetConstructor () ());
+        item.GetTag (*tag);
+        NS_TEST_EXPECT_MSG_EQ (tag->GetData (), 1, "packet tag " << n << " value");
+        delete tag;
+        n++;
+      }
+    NS_TEST_EXPECT_MSG_EQ (n, 6, "number of packet tags");
+  }
+
   { // Timing
     std::cout << GetName () << "add+remove timing" << std::endl;
     int flm = std::numeric_limits<int>::max ();
@@ -847,6 +934,49 @@ PacketTagListTest::DoRun (void)
     
 }
 
+//-----------------------------------------------------------------------------
+class PacketModifyHeaderTest : public TestCase
+{
+public:
+  PacketModifyHeaderTest ();
+  virtual void DoRun (void);
+};
+
+PacketModifyHeaderTest::PacketModifyHeaderTest ()
+  : TestCase ("Rewrite headers in place")
+{
+}
+
+void
+PacketModifyHeaderTest::DoRun (void)
+{
+  Ptr<Packet> p = Create<Packet> (100);
+  p->AddHeader (ATestValueHeader (64));
+  Ptr<Packet> copy = p->Copy ();
+
+  ATestValueHeader header;
+  p->PeekHeader (header);
+  header.m_value--;
+  NS_TEST_EXPECT_MSG_EQ (p->ModifyHeader (header), 4, "Bad number of bytes written");
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 104, "The packet size changed");
+
+  ATestValueHeader peeked;
+  p->PeekHeader (peeked);
+  NS_TEST_EXPECT_MSG_EQ (peeked.m_value, 63, "The header was not rewritten");
+  NS_TEST_EXPECT_MSG_EQ (peeked.m_error, false, "The header was not rewritten entirely");
+  copy->PeekHeader (peeked);
+  NS_TEST_EXPECT_MSG_EQ (peeked.m_value, 64, "The header of the copy was rewritten");
+
+  // rewriting again, once the bytes are not shared anymore.
+  header.m_value--;
+  p->ModifyHeader (header);
+  ATestValueHeader removed;
+  p->RemoveHeader (removed);
+  NS_TEST_EXPECT_MSG_EQ (removed.m_value, 62, "The header was not rewritten");
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 100, "Bad size after the header removal");
+  copy->RemoveHeader (removed);
+  NS_TEST_EXPECT_MSG_EQ (removed.m_value, 64, "The header of the copy was rewritten");
+}
 //-----------------------------------------------------------------------------
 class PacketTestSuite : public TestSuite
 {
@@ -859,6 +989,7 @@ PacketTestSuite::PacketTestSuite ()
 {
   AddTestCase (new PacketTest, TestCase::QUICK);
   AddTestCase (new PacketTagListTest, TestCase::QUICK);
+  AddTestCase (new PacketModifyHeaderTest, TestCase::QUICK);
 }
 
 static PacketTestSuite g_packetTestSuite;
@@ -25,6 +25,9 @@
 #include "ns3/log.h"
 #include "ns3/test.h"
 #include "ns3/pcap-file.h"
+#include "ns3/pcap-file-wrapper.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
 
 using namespace ns3;
 
@@ -1121,6 +1124,222 @@ DiffTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (usec, 3696, "Files are different from 2.3696 seconds");
 }
 
+// ===========================================================================
+// Test case to make sure that the packets written by the background thread
+// of a PcapFileWrapper can be read back, in order.
+// ===========================================================================
+class AsynchronousWriteTestCase : public TestCase
+{
+public:
+  AsynchronousWriteTestCase ();
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  std::string m_testFilename;
+};
+
+AsynchronousWriteTestCase::AsynchronousWriteTestCase ()
+  : TestCase ("Check that PcapFileWrapper writes packets from a background thread")
+{
+}
+
+void
+AsynchronousWriteTestCase::DoSetup (void)
+{
+  std::stringstream filename;
+  uint32_t n = rand ();
+  filename << n;
+  m_testFilename = CreateTempDirFilename (filename.str () + ".pcap");
+}
+
+void
+AsynchronousWriteTestCase::DoTeardown (void)
+{
+  if (remove (m_testFilename.c_str ()))
+    {
+      NS_LOG_ERROR ("Failed to delete file " << m_testFilename);
+    }
+}
+
+void
+AsynchronousWriteTestCase::DoRun (void)
+{
+  const uint32_t nPackets = 1000;
+  const uint32_t snapLen = 100;
+  uint8_t data[300];
+  for (uint32_t i = 0; i < sizeof (data); ++i)
+    {
+      data[i] = i;
+    }
+
+  //
+  // Use batches much smaller than the packets written, so that many
+  // batches are handed over to the writer thread.
+  //
+  Ptr<PcapFileWrapper> w = CreateObject<PcapFileWrapper> ();
+  w->SetAttribute ("Asynchronous", BooleanValue (true));
+  w->SetAttribute ("BatchSize", UintegerValue (1000));
+  w->Open (m_testFilename, std::ios::out);
+  NS_TEST_ASSERT_MSG_EQ (w->Fail (), false, "Open (" << m_testFilename << ", \"std::ios::out\") returns error");
+  w->Init (1, snapLen);
+  for (uint32_t i = 0; i < nPackets; ++i)
+    {
+      uint32_t size = (i * 37) % sizeof (data);
+      if (i % 2)
+        {
+          w->Write (MicroSeconds (i * 1001), Create<Packet> (data, size));
+        }
+      else
+        {
+          w->Write (MicroSeconds (i * 1001), data, size);
+        }
+    }
+  w->Flush ();
+  NS_TEST_ASSERT_MSG_EQ (w->Fail (), false, "Write returns error");
+  w->Close ();
+
+  PcapFile f;
+  f.Open (m_testFilename, std::ios::in);
+  NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Open (" << m_testFilename << ", \"std::ios::in\") returns error");
+  NS_TEST_ASSERT_MSG_EQ (f.GetSnapLen (), snapLen, "snaplen not written");
+
+  uint8_t buffer[sizeof (data)];
+  uint32_t tsSec, tsUsec, inclLen, origLen, readLen;
+  for (uint32_t i = 0; i < nPackets; ++i)
+    {
+      uint32_t size = (i * 37) % sizeof (data);
+      f.Read (buffer, sizeof (buffer), tsSec, tsUsec, inclLen, origLen, readLen);
+      NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Read() of packet " << i << " returns error");
+      NS_TEST_EXPECT_MSG_EQ (tsSec * 1000000 + tsUsec, i * 1001, "Wrong timestamp of packet " << i);
+      NS_TEST_EXPECT_MSG_EQ (origLen, size, "Wrong original length of packet " << i);
+      NS_TEST_ASSERT_MSG_EQ (inclLen, std::min (size, snapLen), "Wrong captured length of packet " << i);
+      NS_TEST_EXPECT_MSG_EQ (memcmp (buffer, data, inclLen), 0, "Wrong data in packet " << i);
+    }
+  f.Read (buffer, sizeof (buffer), tsSec, tsUsec, inclLen, origLen, readLen);
+  NS_TEST_EXPECT_MSG_EQ (f.Eof (), true, "Unexpected packets at the end of the file");
+  f.Close ();
+}
+
+// ===========================================================================
+// Test case to make sure that several PcapFileWrapper objects, whose
+// batches are written by a shared background thread, each write their
+// own packets, in order, including when one of them is closed first.
+// ===========================================================================
+class SharedAsynchronousWriteTestCase : public TestCase
+{
+public:
+  SharedAsynchronousWriteTestCase ();
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  static const uint32_t N_FILES = 3;
+  std::string m_testFilename[N_FILES];
+};
+
+SharedAsynchronousWriteTestCase::SharedAsynchronousWriteTestCase ()
+  : TestCase ("Check that several PcapFileWrapper write their packets from a shared background thread")
+{
+}
+
+void
+SharedAsynchronousWriteTestCase::DoSetup (void)
+{
+  for (uint32_t j = 0; j < N_FILES; ++j)
+    {
+      std::stringstream filename;
+      uint32_t n = rand ();
+      filename << n << "-" << j;
+      m_testFilename[j] = CreateTempDirFilename (filename.str () + ".pcap");
+    }
+}
+
+void
+SharedAsynchronousWriteTestCase::DoTeardown (void)
+{
+  for (uint32_t j = 0; j < N_FILES; ++j)
+    {
+      if (remove (m_testFilename[j].c_str ()))
+        {
+          NS_LOG_ERROR ("Failed to delete file " << m_testFilename[j]);
+        }
+    }
+}
+
+void
+SharedAsynchronousWriteTestCase::DoRun (void)
+{
+  const uint32_t nPackets = 1000;
+  uint8_t data[200];
+  for (uint32_t i = 0; i < sizeof (data); ++i)
+    {
+      data[i] = i;
+    }
+
+  Ptr<PcapFileWrapper> w[N_FILES];
+  for (uint32_t j = 0; j < N_FILES; ++j)
+    {
+      w[j] = CreateObject<PcapFileWrapper> ();
+      w[j]->SetAttribute ("Asynchronous", BooleanValue (true));
+      w[j]->SetAttribute ("BatchSize", UintegerValue (500 * (j + 1)));
+      w[j]->Open (m_testFilename[j], std::ios::out);
+      NS_TEST_ASSERT_MSG_EQ (w[j]->Fail (), false, "Open (" << m_testFilename[j] << ", \"std::ios::out\") returns error");
+      w[j]->Init (1, sizeof (data));
+    }
+  //
+  // The packets of the files are interleaved, and the first file is
+  // closed half way, while the others keep the thread running.
+  //
+  for (uint32_t i = 0; i < nPackets; ++i)
+    {
+      for (uint32_t j = 0; j < N_FILES; ++j)
+        {
+          if (j == 0 && i >= nPackets / 2)
+            {
+              continue;
+            }
+          w[j]->Write (MicroSeconds (i * 1001), data, (i * 37 + j) % sizeof (data));
+        }
+      if (i == nPackets / 2 - 1)
+        {
+          w[0]->Close ();
+        }
+    }
+  for (uint32_t j = 0; j < N_FILES; ++j)
+    {
+      NS_TEST_ASSERT_MSG_EQ (w[j]->Fail (), false, "Write returns error");
+      w[j]->Close ();
+    }
+
+  for (uint32_t j = 0; j < N_FILES; ++j)
+    {
+      PcapFile f;
+      f.Open (m_testFilename[j], std::ios::in);
+      NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Open (" << m_testFilename[j] << ", \"std::ios::in\") returns error");
+
+      uint8_t buffer[sizeof (data)];
+      uint32_t tsSec, tsUsec, inclLen, origLen, readLen;
+      uint32_t n = j == 0 ? nPackets / 2 : nPackets;
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          uint32_t size = (i * 37 + j) % sizeof (data);
+          f.Read (buffer, sizeof (buffer), tsSec, tsUsec, inclLen, origLen, readLen);
+          NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Read() of packet " << i << " of file " << j << " returns error");
+          NS_TEST_EXPECT_MSG_EQ (tsSec * 1000000 + tsUsec, i * 1001, "Wrong timestamp of packet " << i << " of file " << j);
+          NS_TEST_ASSERT_MSG_EQ (inclLen, size, "Wrong length of packet " << i << " of file " << j);
+          NS_TEST_EXPECT_MSG_EQ (memcmp (buffer, data, inclLen), 0, "Wrong data in packet " << i << " of file " << j);
+        }
+      f.Read (buffer, sizeof (buffer), tsSec, tsUsec, inclLen, origLen, readLen);
+      NS_TEST_EXPECT_MSG_EQ (f.Eof (), true, "Unexpected packets at the end of file " << j);
+      f.Close ();
+    }
+}
+
 class PcapFileTestSuite : public TestSuite
 {
 public:
@@ -1138,6 +1357,8 @@ PcapFileTestSuite::PcapFileTestSuite ()
   AddTestCase (new RecordHeaderTestCase, TestCase::QUICK);
   AddTestCase (new ReadFileTestCase, TestCase::QUICK);
   AddTestCase (new DiffTestCase, TestCase::QUICK);
+  AddTestCase (new AsynchronousWriteTestCase, TestCase::QUICK);
+  AddTestCase (new SharedAsynchronousWriteTestCase, TestCase::QUICK);
 }
 
 static PcapFileTestSuite pcapFileTestSuite;
@@ -0,0 +1,324 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/pcapng-file.h"
+#include "ns3/pcap-file-wrapper.h"
+#include "ns3/trace-helper.h"
+#include "ns3/node.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simulator.h"
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+using namespace ns3;
+
+namespace {
+
+/// A block read back from a pcapng file
+struct Block
+{
+  uint32_t type;              //!< Block type
+  std::vector<uint8_t> body;  //!< Block body, with its padding
+};
+
+/**
+ * \param data the content of a pcapng file
+ * \param blocks [out] the blocks of the file
+ * \returns true if the blocks are well formed
+ */
+bool
+ParseBlocks (std::vector<uint8_t> const &data, std::vector<Block> &blocks)
+{
+  uint32_t offset = 0;
+  while (offset + 12 <= data.size ())
+    {
+      uint32_t type;
+      uint32_t length;
+      uint32_t trailer;
+      std::memcpy (&type, &data[offset], 4);
+      std::memcpy (&length, &data[offset + 4], 4);
+      if (length < 12 || length % 4 != 0 || offset + length > data.size ())
+        {
+          return false;
+        }
+      std::memcpy (&trailer, &data[offset + length - 4], 4);
+      if (trailer != length)
+        {
+          return false;
+        }
+      Block block;
+      block.type = type;
+      block.body.assign (data.begin () + offset + 8, data.begin () + offset + length - 4);
+      blocks.push_back (block);
+      offset += length;
+    }
+  return offset == data.size ();
+}
+
+/**
+ * \param filename the name of a file
+ * \returns the content of the file
+ */
+std::vector<uint8_t>
+ReadFile (std::string const &filename)
+{
+  std::ifstream file (filename.c_str (), std::ios::in | std::ios::binary);
+  return std::vector<uint8_t> ((std::istreambuf_iterator<char> (file)), std::istreambuf_iterator<char> ());
+}
+
+/**
+ * \param body the body of an Interface Description Block
+ * \returns the if_name option of the interface
+ */
+std::string
+GetInterfaceName (std::vector<uint8_t> const &body)
+{
+  uint32_t offset = 8;
+  while (offset + 4 <= body.size ())
+    {
+      uint16_t code;
+      uint16_t length;
+      std::memcpy (&code, &body[offset], 2);
+      std::memcpy (&length, &body[offset + 2], 2);
+      if (code == 2)
+        {
+          return std::string (body.begin () + offset + 4, body.begin () + offset + 4 + length);
+        }
+      offset += 4 + ((length + 3) & ~3U);
+    }
+  return "";
+}
+
+} // unnamed namespace
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Check the blocks written to a pcapng file
+ */
+class PcapngWriteTestCase : public TestCase
+{
+public:
+  /**
+   * \param gzip whether to compress the file
+   */
+  PcapngWriteTestCase (bool gzip);
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \param filename the name of the file
+   * \returns the uncompressed content of the file
+   */
+  std::vector<uint8_t> Read (std::string const &filename);
+
+  bool m_gzip;  //!< Whether to compress the file
+};
+
+PcapngWriteTestCase::PcapngWriteTestCase (bool gzip)
+  : TestCase (gzip ? "Check writing a compressed pcapng file" : "Check writing a pcapng file"),
+    m_gzip (gzip)
+{
+}
+
+std::vector<uint8_t>
+PcapngWriteTestCase::Read (std::string const &filename)
+{
+  if (!m_gzip)
+    {
+      return ReadFile (filename);
+    }
+  std::vector<uint8_t> data;
+#ifdef HAVE_ZLIB
+  gzFile file = gzopen (filename.c_str (), "rb");
+  uint8_t buffer[4096];
+  int n;
+  while (file != 0 && (n = gzread (file, buffer, sizeof (buffer))) > 0)
+    {
+      data.insert (data.end (), buffer, buffer + n);
+    }
+  if (file != 0)
+    {
+      gzclose (file);
+    }
+#endif
+  return data;
+}
+
+void
+PcapngWriteTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename (m_gzip ? "write.pcapng.gz" : "write.pcapng");
+
+  uint8_t data[100];
+  for (uint32_t i = 0; i < sizeof (data); ++i)
+    {
+      data[i] = i;
+    }
+
+  Ptr<PcapngFile> file = Create<PcapngFile> ();
+  file->Open (filename, m_gzip);
+  NS_TEST_ASSERT_MSG_EQ (file->Fail (), false, "Could not open " << filename);
+  uint32_t eth = file->AddInterface (PcapHelper::DLT_EN10MB, 65535, "eth0");
+  uint32_t ppp = file->AddInterface (PcapHelper::DLT_PPP, 32, "ppp0");
+  NS_TEST_ASSERT_MSG_EQ (eth, 0, "Unexpected interface id");
+  NS_TEST_ASSERT_MSG_EQ (ppp, 1, "Unexpected interface id");
+  file->Write (ppp, 5000000000ULL, data, sizeof (data));
+  file->Write (eth, 5000000001ULL, Create<Packet> (data, 10));
+  file->Close ();
+  NS_TEST_ASSERT_MSG_EQ (file->Fail (), false, "Could not write " << filename);
+
+  std::vector<Block> blocks;
+  NS_TEST_ASSERT_MSG_EQ (ParseBlocks (Read (filename), blocks), true, "Malformed blocks");
+  NS_TEST_ASSERT_MSG_EQ (blocks.size (), 5, "Unexpected number of blocks");
+
+  uint32_t magic;
+  std::memcpy (&magic, &blocks[0].body[0], 4);
+  NS_TEST_EXPECT_MSG_EQ (blocks[0].type, 0x0a0d0d0a, "Expected a Section Header Block");
+  NS_TEST_EXPECT_MSG_EQ (magic, 0x1a2b3c4d, "Unexpected byte order magic");
+
+  uint16_t linkType;
+  uint32_t snapLen;
+  NS_TEST_EXPECT_MSG_EQ (blocks[1].type, 1, "Expected an Interface Description Block");
+  std::memcpy (&linkType, &blocks[1].body[0], 2);
+  NS_TEST_EXPECT_MSG_EQ (linkType, PcapHelper::DLT_EN10MB, "Unexpected link type");
+  NS_TEST_EXPECT_MSG_EQ (GetInterfaceName (blocks[1].body), "eth0", "Unexpected interface name");
+  NS_TEST_EXPECT_MSG_EQ (blocks[2].type, 1, "Expected an Interface Description Block");
+  std::memcpy (&linkType, &blocks[2].body[0], 2);
+  std::memcpy (&snapLen, &blocks[2].body[4], 4);
+  NS_TEST_EXPECT_MSG_EQ (linkType, PcapHelper::DLT_PPP, "Unexpected link type");
+  NS_TEST_EXPECT_MSG_EQ (snapLen, 32, "Unexpected snapshot length");
+  NS_TEST_EXPECT_MSG_EQ (GetInterfaceName (blocks[2].body), "ppp0", "Unexpected interface name");
+
+  uint32_t fields[5];
+  NS_TEST_EXPECT_MSG_EQ (blocks[3].type, 6, "Expected an Enhanced Packet Block");
+  std::memcpy (fields, &blocks[3].body[0], 20);
+  NS_TEST_EXPECT_MSG_EQ (fields[0], ppp, "Unexpected interface");
+  NS_TEST_EXPECT_MSG_EQ (((uint64_t (fields[1]) << 32) | fields[2]), 5000000000ULL, "Unexpected timestamp");
+  NS_TEST_EXPECT_MSG_EQ (fields[3], 32, "Packet not truncated to the snapshot length");
+  NS_TEST_EXPECT_MSG_EQ (fields[4], sizeof (data), "Unexpected packet length");
+  NS_TEST_EXPECT_MSG_EQ (std::memcmp (&blocks[3].body[20], data, 32), 0, "Unexpected packet data");
+
+  NS_TEST_EXPECT_MSG_EQ (blocks[4].type, 6, "Expected an Enhanced Packet Block");
+  std::memcpy (fields, &blocks[4].body[0], 20);
+  NS_TEST_EXPECT_MSG_EQ (fields[0], eth, "Unexpected interface");
+  NS_TEST_EXPECT_MSG_EQ (((uint64_t (fields[1]) << 32) | fields[2]), 5000000001ULL, "Unexpected timestamp");
+  NS_TEST_EXPECT_MSG_EQ (fields[3], 10, "Unexpected captured length");
+  NS_TEST_EXPECT_MSG_EQ (std::memcmp (&blocks[4].body[20], data, 10), 0, "Unexpected packet data");
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Check that PcapHelper gathers the devices of each node in a
+ * pcapng file
+ */
+class PcapngHelperTestCase : public TestCase
+{
+public:
+  PcapngHelperTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+PcapngHelperTestCase::PcapngHelperTestCase ()
+  : TestCase ("Check sharing pcapng files between the devices of a node")
+{
+}
+
+void
+PcapngHelperTestCase::DoRun (void)
+{
+  std::string prefix = CreateTempDirFilename ("helper");
+  PcapHelper helper;
+  PcapHelper::SetPcapngMode (PcapHelper::PCAPNG_PER_NODE);
+
+  std::vector<Ptr<Node> > nodes;
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      Ptr<Node> node = CreateObject<Node> ();
+      for (uint32_t j = 0; j < 2; ++j)
+        {
+          Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+          node->AddDevice (device);
+          std::string filename = helper.GetFilenameFromDevice (prefix, device, false);
+          Ptr<PcapFileWrapper> file = helper.CreateFile (filename, std::ios::out, PcapHelper::DLT_EN10MB);
+          file->Write (Seconds (1), Create<Packet> (10 + j));
+        }
+      nodes.push_back (node);
+    }
+  PcapHelper::SetPcapngMode (PcapHelper::PCAPNG_NONE);
+  Simulator::Destroy ();
+
+  for (uint32_t i = 0; i < nodes.size (); ++i)
+    {
+      std::ostringstream filename;
+      filename << prefix << "-" << nodes[i]->GetId () << ".pcapng";
+      std::vector<Block> blocks;
+      NS_TEST_ASSERT_MSG_EQ (ParseBlocks (ReadFile (filename.str ()), blocks), true, "Malformed blocks in " << filename.str ());
+      NS_TEST_ASSERT_MSG_EQ (blocks.size (), 5, "Unexpected number of blocks in " << filename.str ());
+      for (uint32_t j = 0; j < 2; ++j)
+        {
+          std::ostringstream name;
+          name << "helper-" << nodes[i]->GetId () << "-" << j << ".pcap";
+          NS_TEST_EXPECT_MSG_EQ (blocks[1 + 2 * j].type, 1, "Expected an Interface Description Block");
+          NS_TEST_EXPECT_MSG_EQ (GetInterfaceName (blocks[1 + 2 * j].body), name.str (), "Unexpected interface name");
+          uint32_t fields[5];
+          std::memcpy (fields, &blocks[2 + 2 * j].body[0], 20);
+          NS_TEST_EXPECT_MSG_EQ (blocks[2 + 2 * j].type, 6, "Expected an Enhanced Packet Block");
+          NS_TEST_EXPECT_MSG_EQ (fields[0], j, "Unexpected interface");
+          NS_TEST_EXPECT_MSG_EQ (fields[4], 10 + j, "Unexpected packet length");
+        }
+    }
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Test suite for pcapng files
+ */
+class PcapngFileTestSuite : public TestSuite
+{
+public:
+  PcapngFileTestSuite ();
+};
+
+PcapngFileTestSuite::PcapngFileTestSuite ()
+  : TestSuite ("pcapng-file", UNIT)
+{
+  AddTestCase (new PcapngWriteTestCase (false), TestCase::QUICK);
+  if (PcapngFile::IsGzipSupported ())
+    {
+      AddTestCase (new PcapngWriteTestCase (true), TestCase::QUICK);
+    }
+  AddTestCase (new PcapngHelperTestCase, TestCase::QUICK);
+}
+
+static PcapngFileTestSuite pcapngFileTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,351 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "async-pcap-writer.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ns3/core-config.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AsyncPcapWriter");
+
+/**
+ * \brief The thread which writes the batches of all the writers
+ *
+ * It runs while at least one writer is open.  The object itself is
+ * never destroyed, so that writers closed during the destruction of
+ * static objects can still use it.
+ */
+class AsyncPcapWriter::Thread
+{
+public:
+  /**
+   * \returns the thread shared by all the writers
+   */
+  static Thread * Get (void);
+  /**
+   * \brief Start the thread if no writer was open
+   */
+  void Start (void);
+  /**
+   * \brief Stop the thread if no other writer is open
+   *
+   * The writer must have been flushed.
+   */
+  void Stop (void);
+  /**
+   * \brief Queue the current batch of a writer, and give the writer its
+   * spare batch instead
+   *
+   * Blocks while the queued batches hold too many bytes.
+   *
+   * \param writer the writer
+   */
+  void Submit (AsyncPcapWriter *writer);
+  /**
+   * \brief Wait until all the batches of a writer are written
+   *
+   * \param writer the writer
+   */
+  void Wait (AsyncPcapWriter *writer);
+  /**
+   * \brief Take the spare batch of a writer
+   *
+   * \param writer the writer
+   * \param spare [out] the spare batch, empty if there is none
+   */
+  void TakeSpare (AsyncPcapWriter *writer, std::vector<uint8_t> &spare);
+
+private:
+  /// A batch to write, and its writer
+  struct Job
+  {
+    AsyncPcapWriter *writer;  //!< The writer
+    Batch batch;              //!< The batch
+  };
+
+  Thread ();
+  /**
+   * \brief Body of the thread
+   */
+  void Run (void);
+
+  std::mutex m_startStop;                 //!< Serializes Start and Stop
+  std::thread m_thread;                   //!< The thread
+  uint32_t m_nWriters;                    //!< Number of open writers
+  std::mutex m_mutex;                     //!< Protects the fields below
+  std::condition_variable m_submitted;    //!< Signaled when a batch is queued
+  std::condition_variable m_written;      //!< Signaled when a batch is written
+  std::deque<Job> m_jobs;                 //!< Batches to write, in order
+  uint64_t m_buffered;                    //!< Bytes held by the batches queued or being written
+  bool m_stop;                            //!< Whether the thread must exit
+};
+
+AsyncPcapWriter::Thread *
+AsyncPcapWriter::Thread::Get (void)
+{
+  static Thread *thread = new Thread ();
+  return thread;
+}
+
+AsyncPcapWriter::Thread::Thread ()
+  : m_nWriters (0),
+    m_buffered (0),
+    m_stop (false)
+{
+}
+
+void
+AsyncPcapWriter::Thread::Start (void)
+{
+  std::unique_lock<std::mutex> startStop (m_startStop);
+  if (m_nWriters++ == 0)
+    {
+      NS_LOG_LOGIC ("start the writer thread");
+      m_stop = false;
+      m_thread = std::thread (&AsyncPcapWriter::Thread::Run, this);
+    }
+}
+
+void
+AsyncPcapWriter::Thread::Stop (void)
+{
+  std::unique_lock<std::mutex> startStop (m_startStop);
+  NS_ASSERT (m_nWriters > 0);
+  if (--m_nWriters == 0)
+    {
+      NS_LOG_LOGIC ("stop the writer thread");
+      {
+        std::unique_lock<std::mutex> lock (m_mutex);
+        m_stop = true;
+      }
+      m_submitted.notify_one ();
+      m_thread.join ();
+    }
+}
+
+void
+AsyncPcapWriter::Thread::Submit (AsyncPcapWriter *writer)
+{
+  Batch &batch = writer->m_batch;
+  std::unique_lock<std::mutex> lock (m_mutex);
+  // a batch larger than the limit is queued alone
+  while (m_buffered != 0 && m_buffered + batch.data.size () > MAX_BUFFERED)
+    {
+      m_written.wait (lock);
+    }
+  m_jobs.push_back (Job ());
+  m_jobs.back ().writer = writer;
+  m_jobs.back ().batch.data.swap (batch.data);
+  m_jobs.back ().batch.used = batch.used;
+  m_buffered += m_jobs.back ().batch.data.size ();
+  writer->m_nPending++;
+  batch.data.swap (writer->m_spare);
+  batch.used = 0;
+  lock.unlock ();
+  m_submitted.notify_one ();
+}
+
+void
+AsyncPcapWriter::Thread::Wait (AsyncPcapWriter *writer)
+{
+  std::unique_lock<std::mutex> lock (m_mutex);
+  while (writer->m_nPending != 0)
+    {
+      m_written.wait (lock);
+    }
+}
+
+void
+AsyncPcapWriter::Thread::TakeSpare (AsyncPcapWriter *writer, std::vector<uint8_t> &spare)
+{
+  std::unique_lock<std::mutex> lock (m_mutex);
+  spare.swap (writer->m_spare);
+}
+
+void
+AsyncPcapWriter::Thread::Run (void)
+{
+  std::unique_lock<std::mutex> lock (m_mutex);
+  while (true)
+    {
+      while (m_jobs.empty () && !m_stop)
+        {
+          m_submitted.wait (lock);
+        }
+      if (m_jobs.empty ())
+        {
+          break;
+        }
+      Job job;
+      job.writer = m_jobs.front ().writer;
+      job.batch.data.swap (m_jobs.front ().batch.data);
+      job.batch.used = m_jobs.front ().batch.used;
+      m_jobs.pop_front ();
+      lock.unlock ();
+
+      job.writer->Write (job.batch);
+
+      lock.lock ();
+      m_buffered -= job.batch.data.size ();
+      if (job.writer->m_spare.empty ())
+        {
+          job.writer->m_spare.swap (job.batch.data);
+        }
+      job.writer->m_nPending--;
+      m_written.notify_all ();
+    }
+}
+
+AsyncPcapWriter::AsyncPcapWriter ()
+  : m_batchSize (0),
+    m_open (false),
+    m_fail (false),
+    m_nPending (0)
+{
+  NS_LOG_FUNCTION (this);
+  m_batch.used = 0;
+}
+
+AsyncPcapWriter::~AsyncPcapWriter ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+bool
+AsyncPcapWriter::Open (std::string const &filename, uint32_t batchSize)
+{
+  NS_LOG_FUNCTION (this << filename << batchSize);
+  NS_ASSERT (!IsOpen ());
+  m_file.open (filename.c_str (), std::ios::out | std::ios::app | std::ios::binary);
+  if (!m_file)
+    {
+      NS_LOG_WARN ("cannot open " << filename);
+      return false;
+    }
+  m_batchSize = batchSize;
+  m_batch.used = 0;
+  m_fail = false;
+  m_open = true;
+#ifdef HAVE_PTHREAD_H
+  Thread::Get ()->Start ();
+#endif
+  return true;
+}
+
+bool
+AsyncPcapWriter::IsOpen (void) const
+{
+  return m_open;
+}
+
+uint8_t *
+AsyncPcapWriter::Reserve (uint32_t size)
+{
+  NS_ASSERT (IsOpen ());
+  if (m_batch.used + size > m_batch.data.size ())
+    {
+      if (m_batch.used != 0 && m_batch.used + size > m_batchSize)
+        {
+          Submit ();
+        }
+      if (m_batch.used + size > m_batch.data.size ())
+        {
+          // double the batch up to its full size; a record larger
+          // than a batch gets a batch of its own
+          uint64_t grown = std::min<uint64_t> (std::max<uint64_t> (2 * m_batch.data.size (), 4096), m_batchSize);
+          m_batch.data.resize (std::max<uint64_t> (m_batch.used + size, grown));
+        }
+    }
+  uint8_t *record = &m_batch.data[m_batch.used];
+  m_batch.used += size;
+  return record;
+}
+
+void
+AsyncPcapWriter::Submit (void)
+{
+  NS_LOG_FUNCTION (this << m_batch.used);
+#ifdef HAVE_PTHREAD_H
+  Thread::Get ()->Submit (this);
+#else
+  // no writer thread: write the batch now, and reuse it.
+  Write (m_batch);
+  m_batch.used = 0;
+#endif
+}
+
+void
+AsyncPcapWriter::Write (Batch const &batch)
+{
+  m_file.write (reinterpret_cast<const char *> (&batch.data[0]), batch.used);
+  m_file.flush ();
+  if (!m_file)
+    {
+      m_fail = true;
+    }
+}
+
+void
+AsyncPcapWriter::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!IsOpen ())
+    {
+      return;
+    }
+  if (m_batch.used != 0)
+    {
+      Submit ();
+    }
+#ifdef HAVE_PTHREAD_H
+  Thread::Get ()->Wait (this);
+#endif
+}
+
+void
+AsyncPcapWriter::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!IsOpen ())
+    {
+      return;
+    }
+  Flush ();
+#ifdef HAVE_PTHREAD_H
+  Thread::Get ()->Stop ();
+  std::vector<uint8_t> spare;
+  Thread::Get ()->TakeSpare (this, spare);
+#endif
+  m_file.close ();
+  m_open = false;
+  std::vector<uint8_t> ().swap (m_batch.data);
+}
+
+bool
+AsyncPcapWriter::Fail (void) const
+{
+  return m_fail;
+}
+
+} // namespace ns3
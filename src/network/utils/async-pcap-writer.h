@@ -0,0 +1,134 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ASYNC_PCAP_WRITER_H
+#define ASYNC_PCAP_WRITER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ *
+ * \brief Appends records to a file from a background thread
+ *
+ * Records are serialized by the caller into large in-memory batches,
+ * obtained with Reserve.  Each full batch is handed over to a thread
+ * which writes it to the file with a single call, so the simulation
+ * only pays for a memory copy per record.
+ *
+ * A single thread, running while at least one writer is open, writes
+ * the batches of all the writers, taken in order from a single queue.
+ * The batches in the queue hold at most MAX_BUFFERED bytes over all
+ * the writers: when the disk cannot keep up, Reserve blocks until a
+ * batch has been written, so memory use stays bounded however many
+ * files are traced.  The batch being filled grows as records come in,
+ * so a file which sees few packets does not hold a full batch.
+ *
+ * The writer only appends, so the file header, if any, must be written
+ * before Open.  This is how PcapFileWrapper writes pcap records when
+ * its Asynchronous attribute is set.
+ *
+ * When ns-3 is built without thread support, there is no writer thread:
+ * each full batch is written by the caller, which still saves a write
+ * per record.
+ */
+class AsyncPcapWriter
+{
+public:
+  AsyncPcapWriter ();
+  ~AsyncPcapWriter ();
+
+  /**
+   * \brief Open a file for appending, and start the writer thread if
+   * no other writer is open
+   *
+   * \param filename the name of the file
+   * \param batchSize the size of each batch of records, in bytes
+   * \returns true on success
+   */
+  bool Open (std::string const &filename, uint32_t batchSize);
+  /**
+   * \returns true if the writer was opened and not closed yet
+   */
+  bool IsOpen (void) const;
+  /**
+   * \brief Reserve room for a record
+   *
+   * The record is written after all the records reserved before it.
+   *
+   * \param size the size of the record
+   * \returns a pointer to \p size bytes, valid until the next call
+   */
+  uint8_t * Reserve (uint32_t size);
+  /**
+   * \brief Write all the reserved records to the file, and wait until
+   * they are written
+   */
+  void Flush (void);
+  /**
+   * \brief Flush and close the file, and stop the writer thread if no
+   * other writer is open
+   */
+  void Close (void);
+  /**
+   * \returns true if a write to the file failed
+   */
+  bool Fail (void) const;
+
+private:
+  /// Maximum number of bytes in the batches queued for the writer thread
+  static const uint32_t MAX_BUFFERED = 32 << 20;
+
+  class Thread;
+  friend class Thread;
+
+  /// A batch of records
+  struct Batch
+  {
+    std::vector<uint8_t> data;  //!< The records
+    uint32_t used;              //!< Bytes used in data
+  };
+
+  /**
+   * \brief Hand the current batch over to the writer thread
+   */
+  void Submit (void);
+  /**
+   * \brief Write a batch to the file
+   *
+   * \param batch the batch
+   */
+  void Write (Batch const &batch);
+
+  Batch m_batch;                  //!< Batch being filled
+  uint32_t m_batchSize;           //!< Size of the batches
+  std::ofstream m_file;           //!< The file, written by the thread only
+  bool m_open;                    //!< Whether the file is open
+  std::atomic<bool> m_fail;       //!< Whether a write failed
+  // protected by the lock of the writer thread
+  uint32_t m_nPending;            //!< Batches queued or being written
+  std::vector<uint8_t> m_spare;   //!< A written batch, for reuse
+};
+
+} // namespace ns3
+
+#endif /* ASYNC_PCAP_WRITER_H */
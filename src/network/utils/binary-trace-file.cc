@@ -0,0 +1,161 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "binary-trace-file.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("BinaryTraceFile");
+
+const uint32_t BinaryTraceFile::VERSION;
+
+namespace {
+
+/**
+ * \param file the file to write to
+ * \param column the column to write
+ */
+template <typename T>
+void
+WriteColumn (std::ofstream &file, std::vector<T> const &column)
+{
+  file.write (reinterpret_cast<const char *> (&column[0]), column.size () * sizeof (T));
+}
+
+} // unnamed namespace
+
+BinaryTraceFile::BinaryTraceFile (uint32_t chunkSize)
+  : m_fail (false),
+    m_chunkSize (chunkSize)
+{
+  NS_LOG_FUNCTION (this << chunkSize);
+  NS_ASSERT (chunkSize > 0);
+}
+
+BinaryTraceFile::~BinaryTraceFile ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+void
+BinaryTraceFile::Open (std::string const &filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  NS_ASSERT (!m_file.is_open ());
+  m_file.open (filename.c_str (), std::ios::out | std::ios::binary);
+  m_fail = !m_file;
+  if (m_fail)
+    {
+      return;
+    }
+  uint32_t header[2] = { VERSION, 0 };
+  m_file.write ("ns3trace", 8);
+  m_file.write (reinterpret_cast<const char *> (header), sizeof (header));
+
+  m_time.reserve (m_chunkSize);
+  m_uid.reserve (m_chunkSize);
+  m_node.reserve (m_chunkSize);
+  m_device.reserve (m_chunkSize);
+  m_size.reserve (m_chunkSize);
+  m_event.reserve (m_chunkSize + 7);
+}
+
+bool
+BinaryTraceFile::Fail (void) const
+{
+  return m_fail;
+}
+
+void
+BinaryTraceFile::Flush (void)
+{
+  NS_LOG_FUNCTION (this << m_time.size ());
+  if (m_time.empty () || !m_file.is_open ())
+    {
+      return;
+    }
+  uint32_t count[2] = { static_cast<uint32_t> (m_time.size ()), 0 };
+  m_file.write (reinterpret_cast<const char *> (count), sizeof (count));
+  WriteColumn (m_file, m_time);
+  WriteColumn (m_file, m_uid);
+  WriteColumn (m_file, m_node);
+  WriteColumn (m_file, m_device);
+  WriteColumn (m_file, m_size);
+  // pad the chunk, so that the 64-bit columns of the next one are aligned
+  uint32_t columnsSize = count[0] * (8 + 8 + 4 + 4 + 4 + 1);
+  m_event.resize (m_event.size () + (((columnsSize + 7) & ~7U) - columnsSize), 0);
+  WriteColumn (m_file, m_event);
+  m_file.flush ();
+  m_fail = m_fail || !m_file;
+
+  m_time.clear ();
+  m_uid.clear ();
+  m_node.clear ();
+  m_device.clear ();
+  m_size.clear ();
+  m_event.clear ();
+}
+
+void
+BinaryTraceFile::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  Flush ();
+  if (m_file.is_open ())
+    {
+      m_file.close ();
+    }
+}
+
+void
+BinaryTraceFile::Write (Time t, uint32_t node, uint32_t device, EventType event, uint64_t uid, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << t << node << device << event << uid << size);
+  m_time.push_back (t.GetNanoSeconds ());
+  m_uid.push_back (uid);
+  m_node.push_back (node);
+  m_device.push_back (device);
+  m_size.push_back (size);
+  m_event.push_back (event);
+  if (m_time.size () >= m_chunkSize)
+    {
+      Flush ();
+    }
+}
+
+BinaryTraceSink::BinaryTraceSink (Ptr<BinaryTraceFile> file, uint32_t node, uint32_t device,
+                                  BinaryTraceFile::EventType event)
+  : m_file (file),
+    m_node (node),
+    m_device (device),
+    m_event (event)
+{
+  NS_LOG_FUNCTION (this << file << node << device << event);
+}
+
+void
+BinaryTraceSink::Trace (Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (this << p);
+  m_file->Write (Simulator::Now (), m_node, m_device, m_event, p->GetUid (), p->GetSize ());
+}
+
+} // namespace ns3
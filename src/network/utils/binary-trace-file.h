@@ -0,0 +1,160 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef BINARY_TRACE_FILE_H
+#define BINARY_TRACE_FILE_H
+
+#include <stdint.h>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+class Packet;
+
+/**
+ * \ingroup packet
+ *
+ * \brief A file of fixed-width packet trace records, stored by columns
+ *
+ * Each record holds the time of a packet event, the node and device
+ * where it happened, its type, and the uid and size of the packet.
+ * Records are gathered in memory and written in chunks, each chunk
+ * storing every field of its records contiguously, so that the file
+ * can be loaded column by column into numpy, pandas or Arrow without
+ * any parsing.  utils/read-binary-trace.py reads these files.
+ *
+ * The file starts with the 8 bytes "ns3trace", followed by a 32-bit
+ * format version and 32 reserved bits.  Each chunk then holds a 32-bit
+ * record count n, 32 reserved bits, and the columns:
+ *   - n 64-bit times, in nanoseconds
+ *   - n 64-bit packet uids
+ *   - n 32-bit node ids
+ *   - n 32-bit device indexes
+ *   - n 32-bit packet sizes
+ *   - n 8-bit event types
+ *   - zero bytes up to the next multiple of 64 bits of the chunk size
+ *
+ * so that the chunks, and all their 64-bit columns, are aligned on 64
+ * bits from the start of the file.
+ *
+ * All the integers are stored in the byte order of the host.
+ */
+class BinaryTraceFile : public SimpleRefCount<BinaryTraceFile>
+{
+public:
+  /// The packet events
+  enum EventType
+  {
+    ENQUEUE = 0,    //!< Packet enqueued, '+' in ascii traces
+    DEQUEUE = 1,    //!< Packet dequeued, '-' in ascii traces
+    DROP = 2,       //!< Packet dropped, 'd' in ascii traces
+    RECEIVE = 3     //!< Packet received, 'r' in ascii traces
+  };
+
+  /// The version of the file format
+  static const uint32_t VERSION = 1;
+
+  /**
+   * \param chunkSize the number of records in each chunk
+   */
+  BinaryTraceFile (uint32_t chunkSize = 65536);
+  ~BinaryTraceFile ();
+
+  /**
+   * \brief Create a new file and write its header.
+   *
+   * \param filename the name of the file
+   */
+  void Open (std::string const &filename);
+  /**
+   * \returns true if opening or writing the file failed.
+   */
+  bool Fail (void) const;
+  /**
+   * \brief Write the pending records to the file, as a chunk.
+   */
+  void Flush (void);
+  /**
+   * \brief Flush and close the file.
+   */
+  void Close (void);
+
+  /**
+   * \brief Add a record.
+   *
+   * \param t the time of the event
+   * \param node the node id
+   * \param device the device index
+   * \param event the event type
+   * \param uid the packet uid
+   * \param size the packet size
+   */
+  void Write (Time t, uint32_t node, uint32_t device, EventType event, uint64_t uid, uint32_t size);
+
+private:
+  std::ofstream m_file;              //!< The file
+  bool m_fail;                       //!< Whether opening or writing the file failed
+  uint32_t m_chunkSize;              //!< Number of records in a chunk
+  std::vector<int64_t> m_time;       //!< Time column of the pending records
+  std::vector<uint64_t> m_uid;       //!< Uid column of the pending records
+  std::vector<uint32_t> m_node;      //!< Node column of the pending records
+  std::vector<uint32_t> m_device;    //!< Device column of the pending records
+  std::vector<uint32_t> m_size;      //!< Size column of the pending records
+  std::vector<uint8_t> m_event;      //!< Event column of the pending records
+};
+
+/**
+ * \ingroup packet
+ *
+ * \brief A trace sink writing the packets it receives to a BinaryTraceFile
+ *
+ * The sink records the node, device and event type of the trace source it
+ * is connected to, so that the trace source does not need a context.
+ */
+class BinaryTraceSink : public SimpleRefCount<BinaryTraceSink>
+{
+public:
+  /**
+   * \param file the file to write to
+   * \param node the node id of the records
+   * \param device the device index of the records
+   * \param event the event type of the records
+   */
+  BinaryTraceSink (Ptr<BinaryTraceFile> file, uint32_t node, uint32_t device,
+                   BinaryTraceFile::EventType event);
+
+  /**
+   * \brief Write a record for a packet, at the current time.
+   *
+   * \param p the packet
+   */
+  void Trace (Ptr<const Packet> p);
+
+private:
+  Ptr<BinaryTraceFile> m_file;           //!< The file to write to
+  uint32_t m_node;                       //!< Node id of the records
+  uint32_t m_device;                     //!< Device index of the records
+  BinaryTraceFile::EventType m_event;    //!< Event type of the records
+};
+
+} // namespace ns3
+
+#endif /* BINARY_TRACE_FILE_H */
@@ -22,6 +22,7 @@
 #include "ns3/buffer.h"
 #include "ns3/header.h"
 #include "pcap-file-wrapper.h"
+#include <algorithm>
 
 namespace ns3 {
 
@@ -46,6 +47,17 @@ PcapFileWrapper::GetTypeId (void)
                    BooleanValue (false),
                    MakeBooleanAccessor (&PcapFileWrapper::m_nanosecMode),
                    MakeBooleanChecker())
+    .AddAttribute ("Asynchronous",
+                   "Whether packets are written to the file in batches, from a background thread. "
+                   "The file is then only complete once the wrapper is closed or destroyed.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PcapFileWrapper::m_asynchronous),
+                   MakeBooleanChecker ())
+    .AddAttribute ("BatchSize",
+                   "Size of the batches of packets written by the background thread, in bytes.",
+                   UintegerValue (1 << 20),
+                   MakeUintegerAccessor (&PcapFileWrapper::m_batchSize),
+                   MakeUintegerChecker<uint32_t> (PcapFile::RECORD_HEADER_SIZE))
   ;
   return tid;
 }
@@ -66,6 +78,14 @@ bool
 PcapFileWrapper::Fail (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_pcapng != 0)
+    {
+      return m_pcapng->Fail ();
+    }
+  if (m_writer.IsOpen ())
+    {
+      return m_writer.Fail ();
+    }
   return m_file.Fail ();
 }
 
@@ -86,14 +106,48 @@ void
 PcapFileWrapper::Close (void)
 {
   NS_LOG_FUNCTION (this);
-  m_file.Close ();
+  if (m_pcapng != 0)
+    {
+      // the file is closed with its last interface
+      m_pcapng = 0;
+    }
+  else if (m_writer.IsOpen ())
+    {
+      // m_file was closed once the file header was written
+      m_writer.Close ();
+    }
+  else
+    {
+      m_file.Close ();
+    }
+}
+
+void
+PcapFileWrapper::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_pcapng != 0)
+    {
+      m_pcapng->Flush ();
+    }
+  m_writer.Flush ();
 }
 
 void
 PcapFileWrapper::Open (std::string const &filename, std::ios::openmode mode)
 {
   NS_LOG_FUNCTION (this << filename << mode);
+  m_writer.Close ();
   m_file.Open (filename, mode);
+  m_filename = filename;
+}
+
+void
+PcapFileWrapper::OpenPcapng (Ptr<PcapngFile> file, std::string const &interfaceName)
+{
+  NS_LOG_FUNCTION (this << file << interfaceName);
+  m_pcapng = file;
+  m_interfaceName = interfaceName;
 }
 
 void
@@ -105,6 +159,13 @@ PcapFileWrapper::Init (uint32_t dataLinkType, uint32_t snapLen, int32_t tzCorrec
   // a snaplen, we use the one provided.
   //
   NS_LOG_FUNCTION (this << dataLinkType << snapLen << tzCorrection);
+  if (m_pcapng != 0)
+    {
+      // pcapng timestamps are always UTC
+      uint32_t len = (snapLen != std::numeric_limits<uint32_t>::max ()) ? snapLen : m_snapLen;
+      m_interface = m_pcapng->AddInterface (dataLinkType, len, m_interfaceName);
+      return;
+    }
   if (snapLen != std::numeric_limits<uint32_t>::max ())
     {
       m_file.Init (dataLinkType, snapLen, tzCorrection, false, m_nanosecMode);
@@ -113,66 +174,105 @@ PcapFileWrapper::Init (uint32_t dataLinkType, uint32_t snapLen, int32_t tzCorrec
     {
       m_file.Init (dataLinkType, m_snapLen, tzCorrection, false, m_nanosecMode);
     } 
+  if (m_asynchronous && !m_file.Fail ())
+    {
+      // the file header is written: the records are appended by the
+      // writer thread from now on.
+      m_file.Close ();
+      m_writer.Open (m_filename, m_batchSize);
+    }
 }
 
 void
-PcapFileWrapper::Write (Time t, Ptr<const Packet> p)
+PcapFileWrapper::GetTimestamp (Time t, uint32_t &tsSec, uint32_t &tsFrac)
 {
-  NS_LOG_FUNCTION (this << t << p);
-  if (m_file.IsNanoSecMode())
+  if (m_file.IsNanoSecMode ())
     {
       uint64_t current = t.GetNanoSeconds ();
-      uint64_t s       = current / 1000000000;
-      uint64_t ns      = current % 1000000000;
-      m_file.Write (s, ns, p);
+      tsSec  = current / 1000000000;
+      tsFrac = current % 1000000000;
     }
   else
     {
       uint64_t current = t.GetMicroSeconds ();
-      uint64_t s       = current / 1000000;
-      uint64_t us      = current % 1000000;
-      m_file.Write (s, us, p);
+      tsSec  = current / 1000000;
+      tsFrac = current % 1000000;
+    }
+}
+
+void
+PcapFileWrapper::Write (Time t, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (this << t << p);
+  if (m_pcapng != 0)
+    {
+      m_pcapng->Write (m_interface, t.GetNanoSeconds (), p);
+      return;
+    }
+  uint32_t tsSec, tsFrac;
+  GetTimestamp (t, tsSec, tsFrac);
+  if (m_writer.IsOpen ())
+    {
+      uint32_t inclLen = std::min (p->GetSize (), m_file.GetSnapLen ());
+      uint8_t *record = m_writer.Reserve (PcapFile::RECORD_HEADER_SIZE + inclLen);
+      m_file.SerializePacketHeader (tsSec, tsFrac, p->GetSize (), record);
+      p->CopyData (record + PcapFile::RECORD_HEADER_SIZE, inclLen);
+      return;
     }
+  m_file.Write (tsSec, tsFrac, p);
 }
 
 void
 PcapFileWrapper::Write (Time t, const Header &header, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (this << t << &header << p);
-  if (m_file.IsNanoSecMode())
+  if (m_pcapng != 0)
     {
-      uint64_t current = t.GetNanoSeconds ();
-      uint64_t s       = current / 1000000000;
-      uint64_t ns      = current % 1000000000;
-      m_file.Write (s, ns, header, p);
+      m_pcapng->Write (m_interface, t.GetNanoSeconds (), header, p);
+      return;
     }
-  else
+  uint32_t tsSec, tsFrac;
+  GetTimestamp (t, tsSec, tsFrac);
+  if (m_writer.IsOpen ())
     {
-      uint64_t current = t.GetMicroSeconds ();
-      uint64_t s       = current / 1000000;
-      uint64_t us      = current % 1000000;
-      m_file.Write (s, us, header, p);
+      uint32_t headerSize = header.GetSerializedSize ();
+      uint32_t totalSize = headerSize + p->GetSize ();
+      uint32_t inclLen = std::min (totalSize, m_file.GetSnapLen ());
+      uint8_t *record = m_writer.Reserve (PcapFile::RECORD_HEADER_SIZE + inclLen);
+      m_file.SerializePacketHeader (tsSec, tsFrac, totalSize, record);
+      record += PcapFile::RECORD_HEADER_SIZE;
+
+      Buffer headerBuffer;
+      headerBuffer.AddAtStart (headerSize);
+      header.Serialize (headerBuffer.Begin ());
+      uint32_t toCopy = std::min (headerSize, inclLen);
+      headerBuffer.CopyData (record, toCopy);
+      p->CopyData (record + toCopy, inclLen - toCopy);
+      return;
     }
+  m_file.Write (tsSec, tsFrac, header, p);
 }
 
 void
 PcapFileWrapper::Write (Time t, uint8_t const *buffer, uint32_t length)
 {
   NS_LOG_FUNCTION (this << t << &buffer << length);
-  if (m_file.IsNanoSecMode())
+  if (m_pcapng != 0)
     {
-      uint64_t current = t.GetNanoSeconds ();
-      uint64_t s       = current / 1000000000;
-      uint64_t ns      = current % 1000000000;
-      m_file.Write (s, ns, buffer, length);
+      m_pcapng->Write (m_interface, t.GetNanoSeconds (), buffer, length);
+      return;
     }
-  else
+  uint32_t tsSec, tsFrac;
+  GetTimestamp (t, tsSec, tsFrac);
+  if (m_writer.IsOpen ())
     {
-      uint64_t current = t.GetMicroSeconds ();
-      uint64_t s       = current / 1000000;
-      uint64_t us      = current % 1000000;
-      m_file.Write (s, us, buffer, length);
+      uint32_t inclLen = std::min (length, m_file.GetSnapLen ());
+      uint8_t *record = m_writer.Reserve (PcapFile::RECORD_HEADER_SIZE + inclLen);
+      m_file.SerializePacketHeader (tsSec, tsFrac, length, record);
+      std::memcpy (record + PcapFile::RECORD_HEADER_SIZE, buffer, inclLen);
+      return;
     }
+  m_file.Write (tsSec, tsFrac, buffer, length);
 }
 
 Ptr<Packet> 
@@ -27,6 +27,8 @@
 #include "ns3/object.h"
 #include "ns3/nstime.h"
 #include "pcap-file.h"
+#include "async-pcap-writer.h"
+#include "pcapng-file.h"
 
 namespace ns3 {
 
@@ -35,6 +37,15 @@ namespace ns3 {
  * ns-3 interface to the low-level public methods of PcapFile.  Users are
  * encouraged to use this object instead of class ns3::PcapFile in ns-3
  * public APIs.
+ *
+ * When the Asynchronous attribute is set, the packets are serialized
+ * into large batches which an AsyncPcapWriter writes from a background
+ * thread, so that tracing many devices does not stall the simulation
+ * on file I/O.  Only the captured part of each packet, see CaptureSize,
+ * is copied.
+ *
+ * A wrapper can also capture the packets of one interface of a pcapng
+ * file shared with other wrappers, see OpenPcapng.
  */
 class PcapFileWrapper : public Object
 {
@@ -77,11 +88,27 @@ public:
    */
   void Open (std::string const &filename, std::ios::openmode mode);
 
+  /**
+   * Write the packets to a new interface of a pcapng file instead of a
+   * pcap file of their own.  The Interface Description Block is
+   * written by Init.
+   *
+   * \param file The pcapng file, possibly shared with other wrappers.
+   * \param interfaceName The name of the interface in the file.
+   */
+  void OpenPcapng (Ptr<PcapngFile> file, std::string const &interfaceName);
+
   /**
    * Close the underlying pcap file.
    */
   void Close (void);
 
+  /**
+   * Wait until all the packets written so far are in the file.  This
+   * is only needed when the Asynchronous attribute is set.
+   */
+  void Flush (void);
+
   /**
    * Initialize the pcap file associated with this wrapper.  This file must have
    * been previously opened with write permissions.
@@ -221,9 +248,25 @@ public:
   uint32_t GetDataLinkType (void);
 
 private:
+  /**
+   * \brief Split a timestamp as stored in the records of the file
+   *
+   * \param t Packet timestamp as ns3::Time.
+   * \param tsSec [out] The seconds part of the timestamp.
+   * \param tsFrac [out] The microseconds, or nanoseconds, part of the timestamp.
+   */
+  void GetTimestamp (Time t, uint32_t &tsSec, uint32_t &tsFrac);
+
   PcapFile m_file; //!< Pcap file
   uint32_t m_snapLen; //!< max length of saved packets
   bool     m_nanosecMode; //!< Timestamps in nanosecond mode
+  bool     m_asynchronous; //!< Whether records are written by m_writer
+  uint32_t m_batchSize; //!< Size of the batches of m_writer
+  std::string m_filename; //!< Name of the file
+  AsyncPcapWriter m_writer; //!< Background writer of the records
+  Ptr<PcapngFile> m_pcapng; //!< The pcapng file written instead of m_file, if any
+  std::string m_interfaceName; //!< Name of the interface in m_pcapng
+  uint32_t m_interface; //!< Identifier of the interface in m_pcapng
 };
 
 } // namespace ns3
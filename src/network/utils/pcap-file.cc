@@ -400,10 +400,9 @@ PcapFile::Init (uint32_t dataLinkType, uint32_t snapLen, int32_t timeZoneCorrect
 }
 
 uint32_t
-PcapFile::WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen)
+PcapFile::SerializePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen, uint8_t *buffer)
 {
-  NS_LOG_FUNCTION (this << tsSec << tsUsec << totalLen);
-  NS_ASSERT (m_file.good ());
+  NS_LOG_FUNCTION (this << tsSec << tsUsec << totalLen << &buffer);
 
   uint32_t inclLen = totalLen > m_fileHeader.m_snapLen ? m_fileHeader.m_snapLen : totalLen;
 
@@ -419,13 +418,25 @@ PcapFile::WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen)
     }
 
   //
-  // Watch out for memory alignment differences between machines, so write
+  // Watch out for memory alignment differences between machines, so copy
   // them all individually.
   //
-  m_file.write ((const char *)&header.m_tsSec, sizeof(header.m_tsSec));
-  m_file.write ((const char *)&header.m_tsUsec, sizeof(header.m_tsUsec));
-  m_file.write ((const char *)&header.m_inclLen, sizeof(header.m_inclLen));
-  m_file.write ((const char *)&header.m_origLen, sizeof(header.m_origLen));
+  memcpy (buffer, &header.m_tsSec, sizeof(header.m_tsSec));
+  memcpy (buffer + 4, &header.m_tsUsec, sizeof(header.m_tsUsec));
+  memcpy (buffer + 8, &header.m_inclLen, sizeof(header.m_inclLen));
+  memcpy (buffer + 12, &header.m_origLen, sizeof(header.m_origLen));
+  return inclLen;
+}
+
+uint32_t
+PcapFile::WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen)
+{
+  NS_LOG_FUNCTION (this << tsSec << tsUsec << totalLen);
+  NS_ASSERT (m_file.good ());
+
+  uint8_t buffer[RECORD_HEADER_SIZE];
+  uint32_t inclLen = SerializePacketHeader (tsSec, tsUsec, totalLen, buffer);
+  m_file.write ((const char *)buffer, RECORD_HEADER_SIZE);
   NS_BUILD_DEBUG(m_file.flush());
   return inclLen;
 }
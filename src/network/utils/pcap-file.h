@@ -44,6 +44,7 @@ class PcapFile
 public:
   static const int32_t  ZONE_DEFAULT    = 0;           /**< Time zone offset for current location */
   static const uint32_t SNAPLEN_DEFAULT = 65535;       /**< Default value for maximum octets to save per packet */
+  static const uint32_t RECORD_HEADER_SIZE = 16;      /**< Size of the header of each record, in the file */
 
 public:
   PcapFile ();
@@ -153,6 +154,20 @@ public:
    */
   void Write (uint32_t tsSec, uint32_t tsUsec, const Header &header, Ptr<const Packet> p);
 
+  /**
+   * \brief Serialize a record header, as Write would write it
+   *
+   * This lets a caller buffer records itself, for instance to write
+   * them from another thread, after the file header was written by Init.
+   *
+   * \param tsSec       Packet timestamp, seconds
+   * \param tsUsec      Packet timestamp, microseconds
+   * \param totalLen    Total packet length
+   * \param buffer      [out] RECORD_HEADER_SIZE bytes to store the header into
+   * \returns the number of packet bytes to store after the header
+   */
+  uint32_t SerializePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen, uint8_t *buffer);
+
 
   /**
    * \brief Read next packet from file
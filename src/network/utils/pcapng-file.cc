@@ -0,0 +1,295 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cstring>
+#include "ns3/assert.h"
+#include "ns3/fatal-error.h"
+#include "ns3/log.h"
+#include "ns3/packet.h"
+#include "ns3/header.h"
+#include "ns3/buffer.h"
+#include "pcapng-file.h"
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PcapngFile");
+
+namespace {
+
+const uint32_t BLOCK_SHB = 0x0a0d0d0a;        //!< Section Header Block type
+const uint32_t BLOCK_IDB = 0x00000001;        //!< Interface Description Block type
+const uint32_t BLOCK_EPB = 0x00000006;        //!< Enhanced Packet Block type
+const uint32_t BYTE_ORDER_MAGIC = 0x1a2b3c4d; //!< Byte order magic of the Section Header Block
+
+const uint16_t OPT_ENDOFOPT = 0;              //!< End of the options
+const uint16_t OPT_IF_NAME = 2;               //!< Interface name option
+const uint16_t OPT_IF_TSRESOL = 9;            //!< Interface timestamp resolution option
+
+const uint32_t BUFFER_SIZE = 1 << 18;         //!< Size of the block buffer
+
+#ifdef NS3_MULTITHREADED
+/// Lock the mutex of the file until the end of the enclosing scope
+#define PCAPNG_LOCK std::lock_guard<std::mutex> lock (m_mutex)
+#else
+#define PCAPNG_LOCK
+#endif
+
+/**
+ * \param length a length
+ * \returns the length rounded up to 32 bits
+ */
+uint32_t
+Pad (uint32_t length)
+{
+  return (length + 3) & ~3U;
+}
+
+} // unnamed namespace
+
+PcapngFile::PcapngFile ()
+  : m_gzFile (0),
+    m_fail (false),
+    m_used (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+PcapngFile::~PcapngFile ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+bool
+PcapngFile::IsGzipSupported (void)
+{
+#ifdef HAVE_ZLIB
+  return true;
+#else
+  return false;
+#endif
+}
+
+void
+PcapngFile::Open (std::string const &filename, bool gzip)
+{
+  NS_LOG_FUNCTION (this << filename << gzip);
+  PCAPNG_LOCK;
+  NS_ASSERT (!m_file.is_open () && m_gzFile == 0);
+  m_fail = false;
+  if (gzip)
+    {
+#ifdef HAVE_ZLIB
+      m_gzFile = gzopen (filename.c_str (), "wb");
+      m_fail = (m_gzFile == 0);
+#else
+      NS_FATAL_ERROR ("gzip compression of " << filename << " needs zlib");
+#endif
+    }
+  else
+    {
+      m_file.open (filename.c_str (), std::ios::out | std::ios::binary);
+      m_fail = !m_file;
+    }
+  if (m_fail)
+    {
+      return;
+    }
+  m_buffer.resize (BUFFER_SIZE);
+  m_used = 0;
+  m_snapLen.clear ();
+
+  uint8_t *body = AddBlock (BLOCK_SHB, 16);
+  uint32_t magic = BYTE_ORDER_MAGIC;
+  uint16_t major = 1;
+  uint16_t minor = 0;
+  int64_t sectionLength = -1;
+  std::memcpy (body, &magic, 4);
+  std::memcpy (body + 4, &major, 2);
+  std::memcpy (body + 6, &minor, 2);
+  std::memcpy (body + 8, &sectionLength, 8);
+}
+
+bool
+PcapngFile::Fail (void) const
+{
+  return m_fail;
+}
+
+void
+PcapngFile::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  PCAPNG_LOCK;
+  DoFlush ();
+}
+
+void
+PcapngFile::DoFlush (void)
+{
+  if (m_used == 0)
+    {
+      return;
+    }
+#ifdef HAVE_ZLIB
+  if (m_gzFile != 0)
+    {
+      if (gzwrite (m_gzFile, &m_buffer[0], m_used) != static_cast<int> (m_used))
+        {
+          m_fail = true;
+        }
+      m_used = 0;
+      return;
+    }
+#endif
+  m_file.write (reinterpret_cast<const char *> (&m_buffer[0]), m_used);
+  m_fail = m_fail || !m_file;
+  m_used = 0;
+}
+
+void
+PcapngFile::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  PCAPNG_LOCK;
+  DoFlush ();
+#ifdef HAVE_ZLIB
+  if (m_gzFile != 0)
+    {
+      gzclose (m_gzFile);
+      m_gzFile = 0;
+    }
+#endif
+  if (m_file.is_open ())
+    {
+      m_file.close ();
+    }
+  std::vector<uint8_t> ().swap (m_buffer);
+}
+
+uint8_t *
+PcapngFile::AddBlock (uint32_t type, uint32_t bodyLen)
+{
+  uint32_t blockLen = 12 + Pad (bodyLen);
+  if (m_used + blockLen > m_buffer.size ())
+    {
+      DoFlush ();
+      if (blockLen > m_buffer.size ())
+        {
+          m_buffer.resize (blockLen);
+        }
+    }
+  uint8_t *block = &m_buffer[m_used];
+  m_used += blockLen;
+  std::memcpy (block, &type, 4);
+  std::memcpy (block + 4, &blockLen, 4);
+  std::memset (block + 8 + bodyLen, 0, Pad (bodyLen) - bodyLen);
+  std::memcpy (block + blockLen - 4, &blockLen, 4);
+  return block + 8;
+}
+
+uint8_t *
+PcapngFile::WriteOption (uint8_t *buffer, uint16_t code, void const *value, uint16_t length)
+{
+  std::memcpy (buffer, &code, 2);
+  std::memcpy (buffer + 2, &length, 2);
+  if (length != 0)
+    {
+      std::memcpy (buffer + 4, value, length);
+    }
+  return buffer + 4 + Pad (length);
+}
+
+uint32_t
+PcapngFile::AddInterface (uint32_t dataLinkType, uint32_t snapLen, std::string const &name)
+{
+  NS_LOG_FUNCTION (this << dataLinkType << snapLen << name);
+  PCAPNG_LOCK;
+  NS_ASSERT (name.size () <= 0xffff);
+  uint8_t tsresol = 9;
+  uint32_t bodyLen = 8 + (4 + Pad (name.size ())) + (4 + Pad (1)) + 4;
+  uint8_t *body = AddBlock (BLOCK_IDB, bodyLen);
+  uint16_t linkType = dataLinkType;
+  uint16_t reserved = 0;
+  std::memcpy (body, &linkType, 2);
+  std::memcpy (body + 2, &reserved, 2);
+  std::memcpy (body + 4, &snapLen, 4);
+  body += 8;
+  body = WriteOption (body, OPT_IF_NAME, name.data (), name.size ());
+  body = WriteOption (body, OPT_IF_TSRESOL, &tsresol, 1);
+  WriteOption (body, OPT_ENDOFOPT, 0, 0);
+  m_snapLen.push_back (snapLen);
+  return m_snapLen.size () - 1;
+}
+
+uint8_t *
+PcapngFile::AddPacketBlock (uint32_t interfaceId, uint64_t timestamp, uint32_t totalLen, uint32_t &capLen)
+{
+  NS_ASSERT (interfaceId < m_snapLen.size ());
+  capLen = std::min (totalLen, m_snapLen[interfaceId]);
+  uint8_t *body = AddBlock (BLOCK_EPB, 20 + capLen);
+  uint32_t fields[5] = { interfaceId,
+                         static_cast<uint32_t> (timestamp >> 32),
+                         static_cast<uint32_t> (timestamp),
+                         capLen,
+                         totalLen };
+  std::memcpy (body, fields, 20);
+  return body + 20;
+}
+
+void
+PcapngFile::Write (uint32_t interfaceId, uint64_t timestamp, uint8_t const *data, uint32_t totalLen)
+{
+  NS_LOG_FUNCTION (this << interfaceId << timestamp << &data << totalLen);
+  PCAPNG_LOCK;
+  uint32_t capLen;
+  uint8_t *packet = AddPacketBlock (interfaceId, timestamp, totalLen, capLen);
+  std::memcpy (packet, data, capLen);
+}
+
+void
+PcapngFile::Write (uint32_t interfaceId, uint64_t timestamp, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (this << interfaceId << timestamp << p);
+  PCAPNG_LOCK;
+  uint32_t capLen;
+  uint8_t *packet = AddPacketBlock (interfaceId, timestamp, p->GetSize (), capLen);
+  p->CopyData (packet, capLen);
+}
+
+void
+PcapngFile::Write (uint32_t interfaceId, uint64_t timestamp, const Header &header, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (this << interfaceId << timestamp << &header << p);
+  PCAPNG_LOCK;
+  uint32_t headerSize = header.GetSerializedSize ();
+  uint32_t capLen;
+  uint8_t *packet = AddPacketBlock (interfaceId, timestamp, headerSize + p->GetSize (), capLen);
+
+  Buffer headerBuffer;
+  headerBuffer.AddAtStart (headerSize);
+  header.Serialize (headerBuffer.Begin ());
+  uint32_t toCopy = std::min (headerSize, capLen);
+  headerBuffer.CopyData (packet, toCopy);
+  p->CopyData (packet + toCopy, capLen - toCopy);
+}
+
+} // namespace ns3
@@ -0,0 +1,180 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PCAPNG_FILE_H
+#define PCAPNG_FILE_H
+
+#include <stdint.h>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "ns3/core-config.h"
+#ifdef NS3_MULTITHREADED
+#include <mutex>
+#endif
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+
+struct gzFile_s;
+
+namespace ns3 {
+
+class Packet;
+class Header;
+
+/**
+ * \ingroup packet
+ *
+ * \brief A pcapng file, shared by the packets captured on several
+ * interfaces
+ *
+ * The file is made of a Section Header Block, followed by an Interface
+ * Description Block for each interface added with AddInterface and by
+ * the Enhanced Packet Blocks of the packets written, which refer to
+ * their interface.  All the timestamps have a nanosecond resolution.
+ *
+ * Blocks are gathered in a memory buffer which is written to the file
+ * when it is full, and the file can be compressed on the fly with gzip
+ * when ns-3 was built with zlib.  The file is closed when the last
+ * reference to this object is released.
+ *
+ * When ns-3 is built with --enable-multithreaded-simulator, the methods
+ * which add blocks or write the file hold a mutex, so that interfaces
+ * in different partitions can share a file.
+ *
+ * See https://github.com/pcapng/pcapng for the file format.
+ */
+class PcapngFile : public SimpleRefCount<PcapngFile>
+{
+public:
+  PcapngFile ();
+  ~PcapngFile ();
+
+  /**
+   * \returns true if gzip compression is supported by this build.
+   */
+  static bool IsGzipSupported (void);
+
+  /**
+   * \brief Create a new pcapng file and write its Section Header Block.
+   *
+   * \param filename the name of the file
+   * \param gzip whether to compress the file with gzip, which must
+   *        be supported
+   */
+  void Open (std::string const &filename, bool gzip = false);
+  /**
+   * \returns true if opening or writing the file failed.
+   */
+  bool Fail (void) const;
+  /**
+   * \brief Write the buffered blocks to the file.
+   */
+  void Flush (void);
+  /**
+   * \brief Flush and close the file.
+   */
+  void Close (void);
+
+  /**
+   * \brief Add an interface, writing its Interface Description Block.
+   *
+   * \param dataLinkType the data link type of the packets captured on
+   *        the interface, as in the pcap format
+   * \param snapLen the maximum length of the packet data stored
+   * \param name the name of the interface, stored in the if_name option
+   * \returns the identifier of the interface
+   */
+  uint32_t AddInterface (uint32_t dataLinkType, uint32_t snapLen, std::string const &name);
+
+  /**
+   * \brief Write a packet captured on an interface.
+   *
+   * \param interfaceId the interface identifier
+   * \param timestamp the capture time, in nanoseconds
+   * \param data the packet data
+   * \param totalLen the packet length
+   */
+  void Write (uint32_t interfaceId, uint64_t timestamp, uint8_t const *data, uint32_t totalLen);
+  /**
+   * \brief Write a packet captured on an interface.
+   *
+   * \param interfaceId the interface identifier
+   * \param timestamp the capture time, in nanoseconds
+   * \param p the packet
+   */
+  void Write (uint32_t interfaceId, uint64_t timestamp, Ptr<const Packet> p);
+  /**
+   * \brief Write a packet captured on an interface.
+   *
+   * \param interfaceId the interface identifier
+   * \param timestamp the capture time, in nanoseconds
+   * \param header a header to write in front of the packet
+   * \param p the packet
+   */
+  void Write (uint32_t interfaceId, uint64_t timestamp, const Header &header, Ptr<const Packet> p);
+
+private:
+  /**
+   * \brief Write the buffered blocks to the file, with the mutex held.
+   */
+  void DoFlush (void);
+  /**
+   * \brief Append a block to the buffer.
+   *
+   * The block type, total length fields and the padding of the body
+   * to 32 bits are filled by this method.
+   *
+   * \param type the block type
+   * \param bodyLen the length of the block body, unpadded
+   * \returns a pointer to the body of the block
+   */
+  uint8_t * AddBlock (uint32_t type, uint32_t bodyLen);
+  /**
+   * \brief Append an Enhanced Packet Block to the buffer.
+   *
+   * \param interfaceId the interface identifier
+   * \param timestamp the capture time, in nanoseconds
+   * \param totalLen the packet length
+   * \param capLen [out] the number of packet bytes to store
+   * \returns a pointer to the capLen bytes of packet data to fill
+   */
+  uint8_t * AddPacketBlock (uint32_t interfaceId, uint64_t timestamp, uint32_t totalLen, uint32_t &capLen);
+  /**
+   * \brief Append an option to a block body.
+   *
+   * \param buffer where to write the option
+   * \param code the option code
+   * \param value the option value
+   * \param length the length of the value
+   * \returns a pointer after the option, padded to 32 bits
+   */
+  static uint8_t * WriteOption (uint8_t *buffer, uint16_t code, void const *value, uint16_t length);
+
+  std::ofstream m_file;               //!< The file, when not compressed
+  struct gzFile_s *m_gzFile;          //!< The file, when compressed
+  bool m_fail;                        //!< Whether opening or writing the file failed
+  std::vector<uint8_t> m_buffer;      //!< Blocks not written to the file yet
+  uint32_t m_used;                    //!< Bytes used in m_buffer
+  std::vector<uint32_t> m_snapLen;    //!< Snapshot length of each interface
+#ifdef NS3_MULTITHREADED
+  std::mutex m_mutex;                 //!< Protects the file and the buffer
+#endif
+};
+
+} // namespace ns3
+
+#endif /* PCAPNG_FILE_H */
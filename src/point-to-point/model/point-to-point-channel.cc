@@ -20,8 +20,11 @@
 #include "point-to-point-net-device.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/packet.h"
+#include "ns3/node.h"
 #include "ns3/simulator.h"
+#include "ns3/simulator-impl.h"
 #include "ns3/log.h"
+#include "ns3/core-config.h"
 
 namespace ns3 {
 
@@ -80,6 +83,30 @@ PointToPointChannel::Attach (Ptr<PointToPointNetDevice> device)
       m_link[1].m_dst = m_link[0].m_src;
       m_link[0].m_state = IDLE;
       m_link[1].m_state = IDLE;
+      UpdateNodes ();
+    }
+}
+
+void
+PointToPointChannel::UpdateNodes (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_nDevices < N_DEVICES)
+    {
+      return;
+    }
+  for (uint32_t i = 0; i < N_DEVICES; i++)
+    {
+      Ptr<Node> src = m_link[i].m_src->GetNode ();
+      Ptr<Node> dst = m_link[i].m_dst->GetNode ();
+      if (src == 0 || dst == 0)
+        {
+          m_link[i].m_nodesKnown = false;
+          continue;
+        }
+      m_link[i].m_dstNodeId = dst->GetId ();
+      m_link[i].m_crossSystem = src->GetSystemId () != dst->GetSystemId ();
+      m_link[i].m_nodesKnown = true;
     }
 }
 
@@ -96,8 +123,30 @@ PointToPointChannel::TransmitStart (
   NS_ASSERT (m_link[1].m_state != INITIALIZING);
 
   uint32_t wire = src == m_link[0].m_src ? 0 : 1;
+  if (!m_link[wire].m_nodesKnown)
+    {
+      UpdateNodes ();
+    }
+  NS_ASSERT (m_link[wire].m_nodesKnown);
+
+#ifdef NS3_MULTITHREADED
+  static TypeId multithreaded = TypeId::LookupByName ("ns3::MultithreadedSimulatorImpl");
+  if (m_link[wire].m_crossSystem
+      && Simulator::GetImplementation ()->GetInstanceTypeId () == multithreaded)
+    {
+      // The receiver is run by another thread of the
+      // MultithreadedSimulatorImpl: hand it a private copy of the
+      // packet and do not touch the reference count of its device.
+      // For the same reason, the animation trace is not fired, as is
+      // the case for the PointToPointRemoteChannel.
+      Simulator::ScheduleWithContext (m_link[wire].m_dstNodeId,
+                                      txTime + m_delay, &PointToPointNetDevice::Receive,
+                                      PeekPointer (m_link[wire].m_dst), p->DeepCopy ());
+      return true;
+    }
+#endif
 
-  Simulator::ScheduleWithContext (m_link[wire].m_dst->GetNode ()->GetId (),
+  Simulator::ScheduleWithContext (m_link[wire].m_dstNodeId,
                                   txTime + m_delay, &PointToPointNetDevice::Receive,
                                   m_link[wire].m_dst, p);
 
@@ -71,6 +71,15 @@ public:
    */
   void Attach (Ptr<PointToPointNetDevice> device);
 
+  /**
+   * \brief Record the nodes the devices of this channel belong to
+   *
+   * Called by the devices when they are attached to the channel or
+   * added to a node, so that TransmitStart never needs to look up
+   * the node of the receiving device.
+   */
+  void UpdateNodes (void);
+
   /**
    * \brief Transmit a packet over this channel
    * \param p Packet to transmit
@@ -194,11 +203,15 @@ public:
     /** \brief Create the link, it will be in INITIALIZING state
      *
      */
-    Link() : m_state (INITIALIZING), m_src (0), m_dst (0) {}
+    Link() : m_state (INITIALIZING), m_src (0), m_dst (0),
+             m_dstNodeId (0), m_nodesKnown (false), m_crossSystem (false) {}
 
     WireState                  m_state; //!< State of the link
     Ptr<PointToPointNetDevice> m_src;   //!< First NetDevice
     Ptr<PointToPointNetDevice> m_dst;   //!< Second NetDevice
+    uint32_t                   m_dstNodeId;   //!< Id of the node of m_dst
+    bool                       m_nodesKnown;  //!< Whether m_dstNodeId and m_crossSystem are valid
+    bool                       m_crossSystem; //!< Whether both nodes have different system ids
   };
 
   Link    m_link[N_DEVICES]; //!< Link model
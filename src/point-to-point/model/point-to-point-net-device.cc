@@ -683,6 +683,10 @@ PointToPointNetDevice::SetNode (Ptr<Node> node)
 {
   NS_LOG_FUNCTION (this);
   m_node = node;
+  if (m_channel != 0)
+    {
+      m_channel->UpdateNodes ();
+    }
 }
 
 bool
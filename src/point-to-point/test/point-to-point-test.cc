@@ -23,6 +23,12 @@
 #include "ns3/simulator.h"
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/point-to-point-channel.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/data-rate.h"
+#include "ns3/node.h"
+#include <map>
 
 using namespace ns3;
 
@@ -100,6 +106,169 @@ PointToPointTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \brief Test the MultithreadedSimulatorImpl over a PointToPointChannel
+ *
+ * Two nodes in different partitions exchange packets over a
+ * point-to-point link while run by two threads: every packet sent
+ * by the first node is echoed by the second one, and the round trip
+ * times must be the same as with the default simulator.
+ */
+class PointToPointMultithreadedTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointMultithreadedTest ();
+
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+private:
+  /**
+   * \brief Send one packet and record its send time
+   *
+   * \param device NetDevice to send from
+   */
+  void SendOnePacket (Ptr<PointToPointNetDevice> device);
+  /**
+   * \brief Receive an echoed packet on the first node
+   *
+   * \param device the receiving NetDevice
+   * \param packet the packet
+   * \param protocol the protocol number
+   * \param from the source address
+   * \returns true
+   */
+  bool ReceiveA (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+  /**
+   * \brief Echo a packet received on the second node
+   *
+   * \param device the receiving NetDevice
+   * \param packet the packet
+   * \param protocol the protocol number
+   * \param from the source address
+   * \returns true
+   */
+  bool ReceiveB (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  std::map<uint64_t, Time> m_sent;  //!< Send time of each packet, by uid
+  std::vector<Time> m_rtt;          //!< Round trip times seen by the first node
+  uint32_t m_rxA;                   //!< Packets received by the first node
+  uint32_t m_rxB;                   //!< Packets received by the second node
+  bool m_systemIdOkA;               //!< Whether the first receiver ran in its partition
+  bool m_systemIdOkB;               //!< Whether the second receiver ran in its partition
+};
+
+PointToPointMultithreadedTest::PointToPointMultithreadedTest ()
+  : TestCase ("PointToPoint with the multithreaded simulator"),
+    m_rxA (0),
+    m_rxB (0),
+    m_systemIdOkA (true),
+    m_systemIdOkB (true)
+{
+}
+
+void
+PointToPointMultithreadedTest::SendOnePacket (Ptr<PointToPointNetDevice> device)
+{
+  Ptr<Packet> p = Create<Packet> (1000);
+  m_sent[p->GetUid ()] = Simulator::Now ();
+  device->Send (p, device->GetBroadcast (), 0x800);
+}
+
+bool
+PointToPointMultithreadedTest::ReceiveA (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                         uint16_t protocol, const Address &from)
+{
+  m_rxA++;
+  m_systemIdOkA = m_systemIdOkA && Simulator::GetSystemId () == 0;
+  m_rtt.push_back (Simulator::Now () - m_sent[packet->GetUid ()]);
+  return true;
+}
+
+bool
+PointToPointMultithreadedTest::ReceiveB (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                         uint16_t protocol, const Address &from)
+{
+  m_rxB++;
+  m_systemIdOkB = m_systemIdOkB && Simulator::GetSystemId () == 1;
+  device->Send (packet->Copy (), device->GetBroadcast (), protocol);
+  return true;
+}
+
+void
+PointToPointMultithreadedTest::DoRun (void)
+{
+  TypeId tid;
+  if (!TypeId::LookupByNameFailSafe ("ns3::MultithreadedSimulatorImpl", &tid))
+    {
+      // built without thread support.
+      return;
+    }
+  Simulator::Destroy ();
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::MultithreadedSimulatorImpl"));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (2));
+
+  Ptr<Node> a = CreateObject<Node> (0);
+  Ptr<Node> b = CreateObject<Node> (1);
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (MilliSeconds (2)));
+  DataRate rate ("8Mbps");
+
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue> ());
+  devA->SetDataRate (rate);
+  devB->Attach (channel);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue> ());
+  devB->SetDataRate (rate);
+
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+
+  Ptr<NetDeviceQueueInterface> ifaceA = CreateObject<NetDeviceQueueInterface> ();
+  devA->AggregateObject (ifaceA);
+  ifaceA->CreateTxQueues ();
+  Ptr<NetDeviceQueueInterface> ifaceB = CreateObject<NetDeviceQueueInterface> ();
+  devB->AggregateObject (ifaceB);
+  ifaceB->CreateTxQueues ();
+
+  devA->SetReceiveCallback (MakeCallback (&PointToPointMultithreadedTest::ReceiveA, this));
+  devB->SetReceiveCallback (MakeCallback (&PointToPointMultithreadedTest::ReceiveB, this));
+
+  const uint32_t nPackets = 20;
+  for (uint32_t i = 0; i < nPackets; i++)
+    {
+      Simulator::ScheduleWithContext (a->GetId (), Seconds (1.0) + MilliSeconds (10 * i),
+                                      &PointToPointMultithreadedTest::SendOnePacket, this, devA);
+    }
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  // 1000 bytes of payload and a 2-byte PPP header, in both directions.
+  Time rtt = 2 * (rate.CalculateBytesTxTime (1002) + MilliSeconds (2));
+  NS_TEST_EXPECT_MSG_EQ (m_rxB, nPackets, "Packets lost on the way to the second node");
+  NS_TEST_EXPECT_MSG_EQ (m_rxA, nPackets, "Packets lost on the way back");
+  // each flag is only written by the thread of its partition.
+  NS_TEST_EXPECT_MSG_EQ ((m_systemIdOkA && m_systemIdOkB), true, "Packet received outside of its partition");
+  for (std::vector<Time>::const_iterator i = m_rtt.begin (); i != m_rtt.end (); ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (*i, rtt, "Unexpected round trip time");
+    }
+}
+
+void
+PointToPointMultithreadedTest::DoTeardown (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+}
+
 /**
  * \brief TestSuite for PointToPoint module
  */
@@ -116,6 +285,7 @@ PointToPointTestSuite::PointToPointTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new PointToPointTest, TestCase::QUICK);
+  AddTestCase (new PointToPointMultithreadedTest, TestCase::QUICK);
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite; //!< The testsuite
@@ -0,0 +1,182 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "caching-propagation-loss-model.h"
+#include "ns3/log.h"
+#include "ns3/pointer.h"
+#include "ns3/mobility-model.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CachingPropagationLossModel");
+
+NS_OBJECT_ENSURE_REGISTERED (CachingPropagationLossModel);
+
+TypeId
+CachingPropagationLossModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CachingPropagationLossModel")
+    .SetParent<PropagationLossModel> ()
+    .SetGroupName ("Propagation")
+    .AddConstructor<CachingPropagationLossModel> ()
+    .AddAttribute ("PropagationLossModel",
+                   "The deterministic propagation loss model whose loss is cached.",
+                   PointerValue (),
+                   MakePointerAccessor (&CachingPropagationLossModel::SetPropagationLossModel,
+                                        &CachingPropagationLossModel::GetPropagationLossModel),
+                   MakePointerChecker<PropagationLossModel> ())
+  ;
+  return tid;
+}
+
+CachingPropagationLossModel::CachingPropagationLossModel ()
+  : m_hits (0),
+    m_misses (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+CachingPropagationLossModel::~CachingPropagationLossModel ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+CachingPropagationLossModel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  Clear ();
+  m_model = 0;
+  PropagationLossModel::DoDispose ();
+}
+
+void
+CachingPropagationLossModel::SetPropagationLossModel (Ptr<PropagationLossModel> model)
+{
+  NS_LOG_FUNCTION (this << model);
+  m_model = model;
+  Clear ();
+}
+
+Ptr<PropagationLossModel>
+CachingPropagationLossModel::GetPropagationLossModel (void) const
+{
+  return m_model;
+}
+
+uint64_t
+CachingPropagationLossModel::GetHits (void) const
+{
+  return m_hits;
+}
+
+uint64_t
+CachingPropagationLossModel::GetMisses (void) const
+{
+  return m_misses;
+}
+
+void
+CachingPropagationLossModel::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (Epochs::const_iterator i = m_epochs.begin (); i != m_epochs.end (); ++i)
+    {
+      ConstCast<MobilityModel> (i->first)->TraceDisconnectWithoutContext ("CourseChange",
+                                                                         MakeCallback (&CachingPropagationLossModel::CourseChanged, this));
+    }
+  m_epochs.clear ();
+  m_cache.clear ();
+  m_hits = 0;
+  m_misses = 0;
+}
+
+uint32_t
+CachingPropagationLossModel::GetEpoch (Ptr<MobilityModel> mobility) const
+{
+  Epochs::iterator i = m_epochs.find (mobility);
+  if (i != m_epochs.end ())
+    {
+      return i->second;
+    }
+  mobility->TraceConnectWithoutContext ("CourseChange",
+                                        MakeCallback (&CachingPropagationLossModel::CourseChanged, this));
+  m_epochs[mobility] = 0;
+  return 0;
+}
+
+void
+CachingPropagationLossModel::CourseChanged (Ptr<const MobilityModel> mobility) const
+{
+  NS_LOG_FUNCTION (this << mobility);
+  // the losses of the old positions are now stale: they are computed
+  // again, and replaced, when they are next looked up.
+  m_epochs[mobility]++;
+}
+
+double
+CachingPropagationLossModel::DoCalcRxPower (double txPowerDbm,
+                                            Ptr<MobilityModel> a,
+                                            Ptr<MobilityModel> b) const
+{
+  NS_ASSERT_MSG (m_model != 0, "CachingPropagationLossModel needs a PropagationLossModel");
+  Vector va = a->GetVelocity ();
+  Vector vb = b->GetVelocity ();
+  if (va.x != 0 || va.y != 0 || va.z != 0 || vb.x != 0 || vb.y != 0 || vb.z != 0)
+    {
+      NS_LOG_LOGIC ("moving nodes, not cached");
+      m_misses++;
+      return m_model->CalcRxPower (txPowerDbm, a, b);
+    }
+
+  uint32_t epochA = GetEpoch (a);
+  uint32_t epochB = GetEpoch (b);
+  Cache::key_type key = std::make_pair (PeekPointer (a), PeekPointer (b));
+  Cache::iterator i = m_cache.find (key);
+  if (i != m_cache.end () && i->second.epochA == epochA && i->second.epochB == epochB)
+    {
+      m_hits++;
+      return txPowerDbm - i->second.lossDb;
+    }
+  m_misses++;
+  double rxPowerDbm = m_model->CalcRxPower (txPowerDbm, a, b);
+  Entry entry;
+  entry.lossDb = txPowerDbm - rxPowerDbm;
+  entry.epochA = epochA;
+  entry.epochB = epochB;
+  if (i == m_cache.end ())
+    {
+      m_cache.insert (std::make_pair (key, entry));
+    }
+  else
+    {
+      i->second = entry;
+    }
+  NS_LOG_LOGIC ("cached loss " << entry.lossDb << " dB");
+  return rxPowerDbm;
+}
+
+int64_t
+CachingPropagationLossModel::DoAssignStreams (int64_t stream)
+{
+  if (m_model == 0)
+    {
+      return 0;
+    }
+  return m_model->AssignStreams (stream);
+}
+
+} // namespace ns3
@@ -0,0 +1,139 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef CACHING_PROPAGATION_LOSS_MODEL_H
+#define CACHING_PROPAGATION_LOSS_MODEL_H
+
+#include "propagation-loss-model.h"
+#include <map>
+#include <utility>
+
+namespace ns3 {
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Remembers the loss computed by another propagation loss model
+ * for each pair of nodes which do not move
+ *
+ * The loss of the PropagationLossModel attribute, and of the models
+ * chained to it, is computed once for each (transmitter, receiver) pair,
+ * and reused until the mobility model of one of them notifies a course
+ * change.  The loss is computed again each time when one of the nodes
+ * moves, as its position then changes without notification.
+ *
+ * The cached models must be deterministic, and their loss must not
+ * depend on the transmission power.  Random models, like
+ * NakagamiPropagationLossModel, should be chained to this model with
+ * SetNext instead, so that they are evaluated for each packet:
+ *
+ * \code
+ *   Ptr<CachingPropagationLossModel> loss = CreateObject<CachingPropagationLossModel> ();
+ *   loss->SetPropagationLossModel (CreateObject<LogDistancePropagationLossModel> ());
+ *   loss->SetNext (CreateObject<NakagamiPropagationLossModel> ());
+ * \endcode
+ */
+class CachingPropagationLossModel : public PropagationLossModel
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  CachingPropagationLossModel ();
+  virtual ~CachingPropagationLossModel ();
+
+  /**
+   * \param model the propagation loss model whose loss is cached
+   */
+  void SetPropagationLossModel (Ptr<PropagationLossModel> model);
+  /**
+   * \returns the propagation loss model whose loss is cached
+   */
+  Ptr<PropagationLossModel> GetPropagationLossModel (void) const;
+
+  /**
+   * \returns the number of losses found in the cache
+   */
+  uint64_t GetHits (void) const;
+  /**
+   * \returns the number of losses computed by the cached model
+   */
+  uint64_t GetMisses (void) const;
+  /**
+   * \brief Forget the cached losses, and reset the hit and miss counters.
+   */
+  void Clear (void);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   */
+  CachingPropagationLossModel (const CachingPropagationLossModel &);
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   * \returns
+   */
+  CachingPropagationLossModel & operator = (const CachingPropagationLossModel &);
+
+  virtual double DoCalcRxPower (double txPowerDbm,
+                                Ptr<MobilityModel> a,
+                                Ptr<MobilityModel> b) const;
+  virtual int64_t DoAssignStreams (int64_t stream);
+
+  /**
+   * \param mobility a mobility model
+   * \returns the number of course changes of \p mobility, listening to
+   *          them if it is the first time it is seen
+   */
+  uint32_t GetEpoch (Ptr<MobilityModel> mobility) const;
+  /**
+   * \param mobility the mobility model whose course changed
+   */
+  void CourseChanged (Ptr<const MobilityModel> mobility) const;
+
+  /// A loss, and the epochs of the mobility models it was computed at
+  struct Entry
+  {
+    double lossDb;      //!< The loss, in dB
+    uint32_t epochA;    //!< The epoch of the transmitter
+    uint32_t epochB;    //!< The epoch of the receiver
+  };
+
+  /// The cached losses, by (transmitter, receiver) pair
+  typedef std::map<std::pair<const MobilityModel *, const MobilityModel *>, Entry> Cache;
+  /// The number of course changes of each mobility model
+  typedef std::map<Ptr<const MobilityModel>, uint32_t> Epochs;
+
+  Ptr<PropagationLossModel> m_model;    //!< The model whose loss is cached
+  mutable Cache m_cache;                //!< The cached losses
+  mutable Epochs m_epochs;              //!< The mobility models listened to
+  mutable uint64_t m_hits;              //!< The number of losses found in the cache
+  mutable uint64_t m_misses;            //!< The number of losses computed
+};
+
+} // namespace ns3
+
+#endif /* CACHING_PROPAGATION_LOSS_MODEL_H */
@@ -22,7 +22,9 @@
 #include "ns3/config.h"
 #include "ns3/double.h"
 #include "ns3/propagation-loss-model.h"
+#include "ns3/caching-propagation-loss-model.h"
 #include "ns3/constant-position-mobility-model.h"
+#include "ns3/constant-velocity-mobility-model.h"
 #include "ns3/simulator.h"
 
 using namespace ns3;
@@ -436,6 +438,73 @@ RangePropagationLossModelTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+class CachingPropagationLossModelTestCase : public TestCase
+{
+public:
+  CachingPropagationLossModelTestCase ();
+  virtual ~CachingPropagationLossModelTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+CachingPropagationLossModelTestCase::CachingPropagationLossModelTestCase ()
+  : TestCase ("Test CachingPropagationLossModel")
+{
+}
+
+CachingPropagationLossModelTestCase::~CachingPropagationLossModelTestCase ()
+{
+}
+
+void
+CachingPropagationLossModelTestCase::DoRun (void)
+{
+  Ptr<MobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  a->SetPosition (Vector (0,0,0));
+  Ptr<MobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+  b->SetPosition (Vector (100,0,0));
+
+  Ptr<LogDistancePropagationLossModel> logDistance = CreateObject<LogDistancePropagationLossModel> ();
+  Ptr<CachingPropagationLossModel> lossModel = CreateObject<CachingPropagationLossModel> ();
+  lossModel->SetPropagationLossModel (logDistance);
+
+  double tolerance = 1e-9;
+  double expected = logDistance->CalcRxPower (10.0, a, b);
+  double resultdBm = lossModel->CalcRxPower (10.0, a, b);
+  NS_TEST_EXPECT_MSG_EQ_TOL (resultdBm, expected, tolerance, "Got unexpected rcv power");
+  NS_TEST_EXPECT_MSG_EQ (lossModel->GetMisses (), 1, "First lookup should compute the loss");
+  resultdBm = lossModel->CalcRxPower (10.0, a, b);
+  NS_TEST_EXPECT_MSG_EQ_TOL (resultdBm, expected, tolerance, "Got unexpected rcv power");
+  NS_TEST_EXPECT_MSG_EQ (lossModel->GetHits (), 1, "Second lookup should be cached");
+  resultdBm = lossModel->CalcRxPower (20.0, a, b);
+  NS_TEST_EXPECT_MSG_EQ_TOL (resultdBm, expected + 10.0, tolerance, "Cached loss should not depend on tx power");
+  NS_TEST_EXPECT_MSG_EQ (lossModel->GetHits (), 2, "Tx power should not invalidate the cache");
+
+  // the reverse direction is a different entry
+  lossModel->CalcRxPower (10.0, b, a);
+  NS_TEST_EXPECT_MSG_EQ (lossModel->GetMisses (), 2, "Reverse lookup should compute the loss");
+
+  // a course change invalidates the entries of the node
+  b->SetPosition (Vector (200,0,0));
+  expected = logDistance->CalcRxPower (10.0, a, b);
+  resultdBm = lossModel->CalcRxPower (10.0, a, b);
+  NS_TEST_EXPECT_MSG_EQ_TOL (resultdBm, expected, tolerance, "Stale loss after a course change");
+  NS_TEST_EXPECT_MSG_EQ (lossModel->GetMisses (), 3, "Course change should invalidate the cache");
+  lossModel->CalcRxPower (10.0, a, b);
+  NS_TEST_EXPECT_MSG_EQ (lossModel->GetHits (), 3, "New loss should be cached");
+
+  // moving nodes are never cached
+  Ptr<ConstantVelocityMobilityModel> c = CreateObject<ConstantVelocityMobilityModel> ();
+  c->SetPosition (Vector (50,0,0));
+  c->SetVelocity (Vector (1,0,0));
+  lossModel->CalcRxPower (10.0, a, c);
+  lossModel->CalcRxPower (10.0, a, c);
+  NS_TEST_EXPECT_MSG_EQ (lossModel->GetHits (), 3, "Moving nodes should not be cached");
+  NS_TEST_EXPECT_MSG_EQ (lossModel->GetMisses (), 5, "Moving nodes should always be computed");
+  Simulator::Destroy ();
+}
+
 class PropagationLossModelsTestSuite : public TestSuite
 {
 public:
@@ -450,6 +519,7 @@ PropagationLossModelsTestSuite::PropagationLossModelsTestSuite ()
   AddTestCase (new LogDistancePropagationLossModelTestCase, TestCase::QUICK);
   AddTestCase (new MatrixPropagationLossModelTestCase, TestCase::QUICK);
   AddTestCase (new RangePropagationLossModelTestCase, TestCase::QUICK);
+  AddTestCase (new CachingPropagationLossModelTestCase, TestCase::QUICK);
 }
 
 static PropagationLossModelsTestSuite propagationLossModelsTestSuite;
@@ -33,18 +33,22 @@ using namespace ns3;
 class PieQueueDiscTestItem : public QueueDiscItem
 {
 public:
-  PieQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol);
+  PieQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol, uint8_t ecn = 0);
   virtual ~PieQueueDiscTestItem ();
   virtual void AddHeader (void);
+  virtual bool Mark (void);
+  virtual bool GetUint8Value (QueueItem::Uint8Values field, uint8_t &value) const;
 
 private:
   PieQueueDiscTestItem ();
   PieQueueDiscTestItem (const PieQueueDiscTestItem &);
   PieQueueDiscTestItem &operator = (const PieQueueDiscTestItem &);
+  uint8_t m_ecn;  //!< ECN codepoint of the packet
 };
 
-PieQueueDiscTestItem::PieQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol)
-  : QueueDiscItem (p, addr, protocol)
+PieQueueDiscTestItem::PieQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol, uint8_t ecn)
+  : QueueDiscItem (p, addr, protocol),
+    m_ecn (ecn)
 {
 }
 
@@ -57,6 +61,69 @@ PieQueueDiscTestItem::AddHeader (void)
 {
 }
 
+bool
+PieQueueDiscTestItem::Mark (void)
+{
+  if (m_ecn == 0)
+    {
+      return false;
+    }
+  m_ecn = 3;
+  return true;
+}
+
+bool
+PieQueueDiscTestItem::GetUint8Value (QueueItem::Uint8Values field, uint8_t &value) const
+{
+  value = m_ecn;
+  return field == QueueItem::IP_DSFIELD;
+}
+
+namespace {
+
+/**
+ * Enqueue a packet of 1000 bytes.
+ *
+ * \param queue the queue disc
+ * \param ecn the ECN codepoint of the packet
+ */
+void
+EnqueueEcn (Ptr<QueueDisc> queue, uint8_t ecn)
+{
+  Address dest;
+  queue->Enqueue (Create<PieQueueDiscTestItem> (Create<Packet> (1000), dest, 0, ecn));
+}
+
+/**
+ * Dequeue a packet, if any.
+ *
+ * \param queue the queue disc
+ */
+void
+DequeueItem (Ptr<QueueDisc> queue)
+{
+  Ptr<QueueDiscItem> item = queue->Dequeue ();
+}
+
+/**
+ * Schedule 400 packets of 1000 bytes, one every 10 ms, and 400
+ * dequeues, one every 12 ms.
+ *
+ * \param queue the queue disc
+ * \param ecn the ECN codepoint of the packets
+ */
+void
+AddTraffic (Ptr<QueueDisc> queue, uint8_t ecn)
+{
+  for (uint32_t i = 0; i < 400; i++)
+    {
+      Simulator::Schedule (Time (Seconds ((i + 1) * 0.01)), &EnqueueEcn, queue, ecn);
+      Simulator::Schedule (Time (Seconds ((i + 1) * 0.012)), &DequeueItem, queue);
+    }
+}
+
+} // unnamed namespace
+
 class PieQueueDiscTestCase : public TestCase
 {
 public:
@@ -345,6 +412,110 @@ PieQueueDiscTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \ingroup traffic-control
+ * \ingroup tests
+ *
+ * \brief Check that a shared PiController updates PieQueueDisc
+ *        as its own timer does
+ */
+class PieControllerTestCase : public TestCase
+{
+public:
+  PieControllerTestCase ();
+  virtual void DoRun (void);
+};
+
+PieControllerTestCase::PieControllerTestCase ()
+  : TestCase ("Check that a shared PiController computes the same drop probabilities as the PIE timer")
+{
+}
+
+void
+PieControllerTestCase::DoRun (void)
+{
+  Ptr<PiController> controller = CreateObject<PiController> ();
+  controller->SetAttribute ("Period", TimeValue (Seconds (0.03)));
+
+  // the queue disc updated by its own timer has a twin updated by the
+  // controller; the mode is set as PieQueueDiscTestCase changes its default
+  Ptr<PieQueueDisc> pie[2];
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      pie[i] = CreateObjectWithAttributes<PieQueueDisc> ("Mode", StringValue ("QUEUE_MODE_PACKETS"),
+                                                         "QueueLimit", UintegerValue (300),
+                                                         "Tupdate", TimeValue (Seconds (0.03)));
+      if (i == 1)
+        {
+          pie[i]->SetAttribute ("Controller", PointerValue (controller));
+        }
+      pie[i]->AssignStreams (2);
+      pie[i]->Initialize ();
+      AddTraffic (pie[i], 0);
+    }
+
+  Simulator::Stop (Seconds (8.0));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_NE (pie[0]->GetStats ().unforcedDrop, 0, "There should be some unforced drops");
+  NS_TEST_EXPECT_MSG_EQ (pie[1]->GetStats ().unforcedDrop, pie[0]->GetStats ().unforcedDrop,
+                         "The controller should drop the same packets as the PIE timer");
+  NS_TEST_EXPECT_MSG_EQ (pie[1]->GetQueueDelay (), pie[0]->GetQueueDelay (),
+                         "The controller should estimate the same queue delay as the PIE timer");
+
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      pie[i]->Dispose ();
+    }
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control
+ * \ingroup tests
+ *
+ * \brief Check ECN marking in PieQueueDisc
+ */
+class PieEcnTestCase : public TestCase
+{
+public:
+  PieEcnTestCase ();
+  virtual void DoRun (void);
+};
+
+PieEcnTestCase::PieEcnTestCase ()
+  : TestCase ("Check ECN marking in the pie queue implementation")
+{
+}
+
+void
+PieEcnTestCase::DoRun (void)
+{
+  // ECT(0) packets, marked as long as the probability does not exceed the threshold
+  Ptr<PieQueueDisc> ect = CreateObjectWithAttributes<PieQueueDisc> ("Mode", StringValue ("QUEUE_MODE_PACKETS"),
+                                                                    "QueueLimit", UintegerValue (300),
+                                                                    "UseEcn", BooleanValue (true),
+                                                                    "MarkEcnThreshold", DoubleValue (1.0));
+  // Not-ECT packets, which can only be dropped
+  Ptr<PieQueueDisc> notEct = CreateObjectWithAttributes<PieQueueDisc> ("Mode", StringValue ("QUEUE_MODE_PACKETS"),
+                                                                       "QueueLimit", UintegerValue (300),
+                                                                       "UseEcn", BooleanValue (true));
+  ect->Initialize ();
+  notEct->Initialize ();
+  AddTraffic (ect, 2);
+  AddTraffic (notEct, 0);
+  Simulator::Stop (Seconds (8.0));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_NE (ect->GetStats ().unforcedMark, 0, "There should be some unforced marks");
+  NS_TEST_EXPECT_MSG_EQ (notEct->GetStats ().unforcedMark, 0, "Not-ECT packets should not be marked");
+  NS_TEST_EXPECT_MSG_NE (notEct->GetStats ().unforcedDrop, 0, "There should be some unforced drops");
+
+  ect->Dispose ();
+  notEct->Dispose ();
+  Simulator::Destroy ();
+}
+
 static class PieQueueDiscTestSuite : public TestSuite
 {
 public:
@@ -352,5 +523,7 @@ public:
     : TestSuite ("pie-queue-disc", UNIT)
   {
     AddTestCase (new PieQueueDiscTestCase (), TestCase::QUICK);
+    AddTestCase (new PieControllerTestCase (), TestCase::QUICK);
+    AddTestCase (new PieEcnTestCase (), TestCase::QUICK);
   }
 } g_pieQueueTestSuite;
@@ -0,0 +1,359 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <algorithm>
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "pi-controller.h"
+#include "pi-square-queue-disc.h"
+#include "pie-queue-disc.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PiController");
+
+NS_OBJECT_ENSURE_REGISTERED (PiController);
+
+TypeId PiController::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::PiController")
+    .SetParent<Object> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<PiController> ()
+    .AddAttribute ("Start",
+                   "Time of the first drop probability update",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&PiController::m_start),
+                   MakeTimeChecker ())
+    .AddAttribute ("Period",
+                   "Time period to calculate the drop probability of all the queue discs",
+                   TimeValue (Seconds (0.03)),
+                   MakeTimeAccessor (&PiController::m_period),
+                   MakeTimeChecker ())
+  ;
+
+  return tid;
+}
+
+PiController::PiController ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+PiController::~PiController ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+PiController::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  Simulator::Remove (m_event);
+  m_piSquare.clear ();
+  m_pie.clear ();
+  Object::DoDispose ();
+}
+
+void
+PiController::Add (PiSquareQueueDisc *disc)
+{
+  NS_LOG_FUNCTION (this << disc);
+  m_piSquare.push_back (disc);
+  Start ();
+}
+
+void
+PiController::Remove (PiSquareQueueDisc *disc)
+{
+  NS_LOG_FUNCTION (this << disc);
+  m_piSquare.erase (std::remove (m_piSquare.begin (), m_piSquare.end (), disc), m_piSquare.end ());
+  Stop ();
+}
+
+void
+PiController::Add (PieQueueDisc *disc)
+{
+  NS_LOG_FUNCTION (this << disc);
+  m_pie.push_back (disc);
+  Start ();
+}
+
+void
+PiController::Remove (PieQueueDisc *disc)
+{
+  NS_LOG_FUNCTION (this << disc);
+  m_pie.erase (std::remove (m_pie.begin (), m_pie.end (), disc), m_pie.end ());
+  Stop ();
+}
+
+Time
+PiController::GetPeriod (void) const
+{
+  return m_period;
+}
+
+void
+PiController::Start (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_event.IsRunning ())
+    {
+      return;
+    }
+  Time delay = (m_start > Simulator::Now ()) ? m_start - Simulator::Now () : Time (0);
+  m_event = Simulator::Schedule (delay, &PiController::Update, this);
+}
+
+void
+PiController::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_piSquare.empty () && m_pie.empty ())
+    {
+      Simulator::Remove (m_event);
+    }
+}
+
+void
+PiController::Batch::Resize (uint32_t n)
+{
+  qDelay.resize (n);
+  qDelayOld.resize (n);
+  dropProb.resize (n);
+  avgDqRate.resize (n);
+  resetDqRate.resize (n);
+  a.resize (n);
+  b.resize (n);
+  qDelayRef.resize (n);
+}
+
+Time
+PiController::EstimateQueueDelay (uint32_t nBytes, double avgDqRate)
+{
+  if (avgDqRate > 0)
+    {
+      return Time (Seconds (nBytes / avgDqRate));
+    }
+  return Time (Seconds (0));
+}
+
+void
+PiController::UpdatePiSquare (uint32_t n, const double *qDelay, double *qDelayOld, double *dropProb,
+                              double *avgDqRate, uint8_t *resetDqRate,
+                              const double *a, const double *b, const double *qDelayRef)
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      bool missingInitFlag = !(avgDqRate[i] > 0);
+
+      // Calculate the drop probability
+      double p = a[i] * (qDelay[i] - qDelayRef[i]) + b[i] * (qDelay[i] - qDelayOld[i]);
+      p += dropProb[i];
+
+      // For non-linear drop in prob
+      if (qDelay[i] == 0 && qDelayOld[i] == 0)
+        {
+          p *= 0.98;
+        }
+
+      dropProb[i] = (p > 0) ? p : 0;
+
+      bool reset = (qDelay[i] < 0.5 * qDelayRef[i]) && (qDelayOld[i] < 0.5 * qDelayRef[i])
+        && (dropProb[i] == 0) && !missingInitFlag;
+      resetDqRate[i] = reset;
+      avgDqRate[i] = reset ? 0.0 : avgDqRate[i];
+      qDelayOld[i] = qDelay[i];
+    }
+}
+
+void
+PiController::UpdatePie (uint32_t n, const double *qDelay, double *qDelayOld, double *dropProb,
+                         double *avgDqRate, uint8_t *resetDqRate,
+                         const double *a, const double *b, const double *qDelayRef,
+                         int64_t *burstAllowance, uint8_t *burstState, uint32_t *burstReset,
+                         int64_t tUpdate)
+{
+  uint32_t burstResetLimit = BURST_RESET_TIMEOUT / TimeStep (tUpdate).GetSeconds ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      bool missingInitFlag = !(avgDqRate[i] > 0);
+      double p = 0.0;
+
+      if (burstAllowance[i] > 0)
+        {
+          dropProb[i] = 0;
+        }
+      else
+        {
+          p = a[i] * (qDelay[i] - qDelayRef[i]) + b[i] * (qDelay[i] - qDelayOld[i]);
+          if (dropProb[i] < 0.001)
+            {
+              p /= 32;
+            }
+          else if (dropProb[i] < 0.01)
+            {
+              p /= 8;
+            }
+          else if (dropProb[i] < 0.1)
+            {
+              p /= 2;
+            }
+          else if (dropProb[i] < 1)
+            {
+              p /= 0.5;
+            }
+          else if (dropProb[i] < 10)
+            {
+              p /= 0.125;
+            }
+          else
+            {
+              p /= 0.03125;
+            }
+          if ((dropProb[i] >= 0.1) && (p > 0.02))
+            {
+              p = 0.02;
+            }
+        }
+
+      p += dropProb[i];
+
+      // For non-linear drop in prob
+      if (qDelay[i] == 0 && qDelayOld[i] == 0)
+        {
+          p *= 0.98;
+        }
+      else if (qDelay[i] > 0.2)
+        {
+          p += 0.02;
+        }
+
+      dropProb[i] = (p > 0) ? p : 0;
+      burstAllowance[i] = (burstAllowance[i] < tUpdate) ? 0 : burstAllowance[i] - tUpdate;
+
+      bool low = (qDelay[i] < 0.5 * qDelayRef[i]) && (qDelayOld[i] < 0.5 * qDelayRef[i]) && (dropProb[i] == 0);
+      bool reset = low && !missingInitFlag;
+      resetDqRate[i] = reset;
+      avgDqRate[i] = reset ? 0.0 : avgDqRate[i];
+      if (low && burstAllowance[i] == 0)
+        {
+          if (burstState[i] == PieQueueDisc::IN_BURST_PROTECTING)
+            {
+              burstState[i] = PieQueueDisc::IN_BURST;
+              burstReset[i] = 0;
+            }
+          else if (burstState[i] == PieQueueDisc::IN_BURST)
+            {
+              burstReset[i]++;
+              if (burstReset[i] > burstResetLimit)
+                {
+                  burstReset[i] = 0;
+                  burstState[i] = PieQueueDisc::NO_BURST;
+                }
+            }
+        }
+      else if (burstState[i] == PieQueueDisc::IN_BURST)
+        {
+          burstReset[i] = 0;
+        }
+      qDelayOld[i] = qDelay[i];
+    }
+}
+
+void
+PiController::Update (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // PI Square queue discs
+  uint32_t n = m_piSquare.size ();
+  Batch &sq = m_piSquareBatch;
+  sq.Resize (n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      PiSquareQueueDisc *disc = m_piSquare[i];
+      disc->m_qDelay = disc->ComputeQueueDelay ();
+      sq.qDelay[i] = disc->m_qDelay.GetSeconds ();
+      sq.qDelayOld[i] = disc->m_qDelayOld.GetSeconds ();
+      sq.dropProb[i] = disc->m_dropProb;
+      sq.avgDqRate[i] = disc->m_avgDqRate;
+      sq.a[i] = disc->m_a;
+      sq.b[i] = disc->m_b;
+      sq.qDelayRef[i] = disc->m_qDelayRef.GetSeconds ();
+    }
+  UpdatePiSquare (n, sq.qDelay.data (), sq.qDelayOld.data (), sq.dropProb.data (),
+                  sq.avgDqRate.data (), sq.resetDqRate.data (),
+                  sq.a.data (), sq.b.data (), sq.qDelayRef.data ());
+  for (uint32_t i = 0; i < n; i++)
+    {
+      PiSquareQueueDisc *disc = m_piSquare[i];
+      disc->m_dropProb = sq.dropProb[i];
+      disc->m_avgDqRate = sq.avgDqRate[i];
+      if (sq.resetDqRate[i])
+        {
+          disc->m_dqCount = -1;
+        }
+      disc->m_qDelayOld = disc->m_qDelay;
+    }
+
+  // PIE queue discs
+  n = m_pie.size ();
+  Batch &pie = m_pieBatch;
+  pie.Resize (n);
+  pie.burstAllowance.resize (n);
+  pie.burstState.resize (n);
+  pie.burstReset.resize (n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      PieQueueDisc *disc = m_pie[i];
+      disc->m_qDelay = EstimateQueueDelay (disc->GetInternalQueue (0)->GetNBytes (), disc->m_avgDqRate);
+      pie.qDelay[i] = disc->m_qDelay.GetSeconds ();
+      pie.qDelayOld[i] = disc->m_qDelayOld.GetSeconds ();
+      pie.dropProb[i] = disc->m_dropProb;
+      pie.avgDqRate[i] = disc->m_avgDqRate;
+      pie.a[i] = disc->m_a;
+      pie.b[i] = disc->m_b;
+      pie.qDelayRef[i] = disc->m_qDelayRef.GetSeconds ();
+      pie.burstAllowance[i] = disc->m_burstAllowance.GetTimeStep ();
+      pie.burstState[i] = disc->m_burstState;
+      pie.burstReset[i] = disc->m_burstReset;
+    }
+  UpdatePie (n, pie.qDelay.data (), pie.qDelayOld.data (), pie.dropProb.data (),
+             pie.avgDqRate.data (), pie.resetDqRate.data (),
+             pie.a.data (), pie.b.data (), pie.qDelayRef.data (),
+             pie.burstAllowance.data (), pie.burstState.data (), pie.burstReset.data (),
+             m_period.GetTimeStep ());
+  for (uint32_t i = 0; i < n; i++)
+    {
+      PieQueueDisc *disc = m_pie[i];
+      disc->m_dropProb = pie.dropProb[i];
+      disc->m_avgDqRate = pie.avgDqRate[i];
+      if (pie.resetDqRate[i])
+        {
+          disc->m_dqCount = -1;
+        }
+      disc->m_burstAllowance = TimeStep (pie.burstAllowance[i]);
+      disc->m_burstState = static_cast<PieQueueDisc::BurstStateT> (pie.burstState[i]);
+      disc->m_burstReset = pie.burstReset[i];
+      disc->m_qDelayOld = disc->m_qDelay;
+    }
+
+  m_event = Simulator::Schedule (m_period, &PiController::Update, this);
+}
+
+} //namespace ns3
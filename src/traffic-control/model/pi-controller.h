@@ -0,0 +1,211 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef PI_CONTROLLER_H
+#define PI_CONTROLLER_H
+
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+
+namespace ns3 {
+
+class PiSquareQueueDisc;
+class PieQueueDisc;
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief Updates the drop probability of many PI Square and PIE queue
+ * discs in a single event per period
+ *
+ * Each PiSquareQueueDisc and PieQueueDisc normally schedules its own
+ * CalculateP event every Tupdate.  Queue discs whose Controller
+ * attribute points to a PiController are instead updated together by
+ * the controller, every Period, starting at Start: with thousands of
+ * queue discs this replaces thousands of scheduler events per period
+ * with one.  The Tupdate and Supdate attributes of these queue discs
+ * are ignored.
+ *
+ * On each update the controller state of the queue discs is gathered
+ * in a structure of arrays, one per queue disc type, the update laws
+ * run over the arrays in tight loops without any branch on the queue
+ * disc type, and the results are scattered back.  The same update
+ * laws are used by the queue discs which update themselves, so both
+ * modes compute the same drop probabilities.
+ */
+class PiController : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief PiController Constructor
+   */
+  PiController ();
+
+  /**
+   * \brief PiController Destructor
+   */
+  virtual ~PiController ();
+
+  /**
+   * \brief Add a PI Square queue disc to the controller
+   * \param disc the queue disc
+   */
+  void Add (PiSquareQueueDisc *disc);
+
+  /**
+   * \brief Remove a PI Square queue disc from the controller
+   * \param disc the queue disc
+   */
+  void Remove (PiSquareQueueDisc *disc);
+
+  /**
+   * \brief Add a PIE queue disc to the controller
+   * \param disc the queue disc
+   */
+  void Add (PieQueueDisc *disc);
+
+  /**
+   * \brief Remove a PIE queue disc from the controller
+   * \param disc the queue disc
+   */
+  void Remove (PieQueueDisc *disc);
+
+  /**
+   * \brief Get the update period
+   * \returns the time between two updates
+   */
+  Time GetPeriod (void) const;
+
+  /**
+   * \brief Get the queue delay estimated from the dequeue rate
+   * \param nBytes bytes in the queue
+   * \param avgDqRate time averaged dequeue rate, in bytes per second
+   * \returns the queue delay, zero if the dequeue rate is not known yet
+   */
+  static Time EstimateQueueDelay (uint32_t nBytes, double avgDqRate);
+
+  /**
+   * \brief PI Square drop probability update law
+   *
+   * All the times are in seconds.
+   *
+   * \param n number of controllers
+   * \param qDelay current queue delays
+   * \param qDelayOld previous queue delays, set to qDelay
+   * \param dropProb drop probabilities, updated
+   * \param avgDqRate dequeue rates, reset to zero with the measurement
+   * \param resetDqRate set to 1 if the dequeue rate measurement is reset, else 0
+   * \param a alpha parameters
+   * \param b beta parameters
+   * \param qDelayRef desired queue delays
+   */
+  static void UpdatePiSquare (uint32_t n, const double *qDelay, double *qDelayOld, double *dropProb,
+                              double *avgDqRate, uint8_t *resetDqRate,
+                              const double *a, const double *b, const double *qDelayRef);
+
+  /**
+   * \brief PIE drop probability update law
+   *
+   * All the times are in seconds, except the burst allowances and the
+   * update period which are in time steps.
+   *
+   * \param n number of controllers
+   * \param qDelay current queue delays
+   * \param qDelayOld previous queue delays, set to qDelay
+   * \param dropProb drop probabilities, updated
+   * \param avgDqRate dequeue rates, reset to zero with the measurement
+   * \param resetDqRate set to 1 if the dequeue rate measurement is reset, else 0
+   * \param a alpha parameters
+   * \param b beta parameters
+   * \param qDelayRef desired queue delays
+   * \param burstAllowance remaining burst allowances, updated
+   * \param burstState burst states, updated
+   * \param burstReset burst reset counters, updated
+   * \param tUpdate time between two updates
+   */
+  static void UpdatePie (uint32_t n, const double *qDelay, double *qDelayOld, double *dropProb,
+                         double *avgDqRate, uint8_t *resetDqRate,
+                         const double *a, const double *b, const double *qDelayRef,
+                         int64_t *burstAllowance, uint8_t *burstState, uint32_t *burstReset,
+                         int64_t tUpdate);
+
+protected:
+  /**
+   * \brief Dispose of the object
+   */
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \brief Controller state of a set of queue discs, as a structure of arrays
+   */
+  struct Batch
+  {
+    /**
+     * \brief Set the number of controllers
+     * \param n the number of controllers
+     */
+    void Resize (uint32_t n);
+
+    std::vector<double> qDelay;             //!< Current queue delays
+    std::vector<double> qDelayOld;          //!< Previous queue delays
+    std::vector<double> dropProb;           //!< Drop probabilities
+    std::vector<double> avgDqRate;          //!< Time averaged dequeue rates
+    std::vector<uint8_t> resetDqRate;       //!< Whether the dequeue rate measurements are reset
+    std::vector<double> a;                  //!< Alpha parameters
+    std::vector<double> b;                  //!< Beta parameters
+    std::vector<double> qDelayRef;          //!< Desired queue delays
+    std::vector<int64_t> burstAllowance;    //!< PIE remaining burst allowances
+    std::vector<uint8_t> burstState;        //!< PIE burst states
+    std::vector<uint32_t> burstReset;       //!< PIE burst reset counters
+  };
+
+  /**
+   * \brief Start the periodic update if needed
+   */
+  void Start (void);
+
+  /**
+   * \brief Stop the periodic update if there is no queue disc left
+   */
+  void Stop (void);
+
+  /**
+   * \brief Update the drop probability of all the queue discs
+   */
+  void Update (void);
+
+  Time m_start;                                 //!< Time of the first update
+  Time m_period;                                //!< Time between two updates
+  EventId m_event;                              //!< Next update event
+  std::vector<PiSquareQueueDisc *> m_piSquare;  //!< PI Square queue discs
+  Batch m_piSquareBatch;                        //!< PI Square controller state
+  std::vector<PieQueueDisc *> m_pie;            //!< PIE queue discs
+  Batch m_pieBatch;                             //!< PIE controller state
+};
+
+};   // namespace ns3
+
+#endif
@@ -19,12 +19,15 @@
  *
  */
 
+#include <algorithm>
 #include "ns3/log.h"
 #include "ns3/enum.h"
 #include "ns3/uinteger.h"
 #include "ns3/double.h"
+#include "ns3/boolean.h"
 #include "ns3/simulator.h"
 #include "ns3/abort.h"
+#include "ns3/pointer.h"
 #include "pi-square-queue-disc.h"
 #include "ns3/drop-tail-queue.h"
 
@@ -86,6 +89,46 @@ TypeId PiSquareQueueDisc::GetTypeId (void)
                    TimeValue (Seconds (0.02)),
                    MakeTimeAccessor (&PiSquareQueueDisc::m_qDelayRef),
                    MakeTimeChecker ())
+    .AddAttribute ("DualQueue",
+                   "True to store the packets of scalable (L4S) flows in a separate, coupled queue",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PiSquareQueueDisc::m_dualQueue),
+                   MakeBooleanChecker ())
+    .AddAttribute ("CouplingFactor",
+                   "Ratio between the L4S marking probability and the base probability",
+                   DoubleValue (2.0),
+                   MakeDoubleAccessor (&PiSquareQueueDisc::m_k),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("L4SMarkThreshold",
+                   "Sojourn time in the L4S queue above which packets are always marked",
+                   TimeValue (MilliSeconds (1)),
+                   MakeTimeAccessor (&PiSquareQueueDisc::m_l4sThreshold),
+                   MakeTimeChecker ())
+    .AddAttribute ("TimeShift",
+                   "Head start given to the L4S queue by the time-shifted FIFO scheduler",
+                   TimeValue (MilliSeconds (40)),
+                   MakeTimeAccessor (&PiSquareQueueDisc::m_tShift),
+                   MakeTimeChecker ())
+    .AddAttribute ("UseTimestamp",
+                   "True to use the sojourn time of the packet at the head of the queue as queue delay, instead of estimating it from the dequeue rate",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PiSquareQueueDisc::m_useTimestamp),
+                   MakeBooleanChecker ())
+    .AddAttribute ("UseEcn",
+                   "True to use ECN (packets are marked instead of being dropped)",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PiSquareQueueDisc::m_useEcn),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MarkEcnThreshold",
+                   "ECN marking threshold: packets are dropped instead of being marked above this squared drop probability",
+                   DoubleValue (0.1),
+                   MakeDoubleAccessor (&PiSquareQueueDisc::m_markEcnTh),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("Controller",
+                   "Shared controller updating the drop probability instead of a per queue disc timer",
+                   PointerValue (),
+                   MakePointerAccessor (&PiSquareQueueDisc::m_controller),
+                   MakePointerChecker<PiController> ())
   ;
 
   return tid;
@@ -110,6 +153,11 @@ PiSquareQueueDisc::DoDispose (void)
   NS_LOG_FUNCTION (this);
   m_uv = 0;
   Simulator::Remove (m_rtrsEvent);
+  if (m_controller)
+    {
+      m_controller->Remove (this);
+      m_controller = 0;
+    }
   QueueDisc::DoDispose ();
 }
 
@@ -140,11 +188,16 @@ PiSquareQueueDisc::GetQueueSize (void)
   NS_LOG_FUNCTION (this);
   if (GetMode () == Queue::QUEUE_MODE_BYTES)
     {
-      return GetInternalQueue (0)->GetNBytes ();
+      return GetNQueuedBytes ();
     }
   else if (GetMode () == Queue::QUEUE_MODE_PACKETS)
     {
-      return GetInternalQueue (0)->GetNPackets ();
+      uint32_t nPackets = 0;
+      for (uint32_t i = 0; i < GetNInternalQueues (); i++)
+        {
+          nPackets += GetInternalQueue (i)->GetNPackets ();
+        }
+      return nPackets;
     }
   else
     {
@@ -189,22 +242,35 @@ PiSquareQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
       m_stats.forcedDrop++;
       return false;
     }
-  else if (DropEarly (item, nQueued))
+
+  // Packets of scalable flows are only marked, when they are dequeued
+  uint32_t queue = (m_dualQueue && IsL4s (item)) ? L4S : CLASSIC;
+
+  if (queue == CLASSIC && DropEarly (item, nQueued))
     {
-      // Early probability drop: proactive
-      Drop (item);
-      m_stats.unforcedDrop++;
-      return false;
+      if (m_useEcn && m_dropProb * m_dropProb <= m_markEcnTh && item->Mark ())
+        {
+          // Early probability mark: proactive
+          m_stats.unforcedMark++;
+        }
+      else
+        {
+          // Early probability drop: proactive
+          Drop (item);
+          m_stats.unforcedDrop++;
+          return false;
+        }
     }
 
   // No drop
-  bool retval = GetInternalQueue (0)->Enqueue (item);
+  item->SetTimeStamp (Simulator::Now ());
+  bool retval = GetInternalQueue (queue)->Enqueue (item);
 
   // If Queue::Enqueue fails, QueueDisc::Drop is called by the internal queue
   // because QueueDisc::AddInternalQueue sets the drop callback
 
-  NS_LOG_LOGIC ("\t bytesInQueue  " << GetInternalQueue (0)->GetNBytes ());
-  NS_LOG_LOGIC ("\t packetsInQueue  " << GetInternalQueue (0)->GetNPackets ());
+  NS_LOG_LOGIC ("\t bytesInQueue  " << GetInternalQueue (queue)->GetNBytes ());
+  NS_LOG_LOGIC ("\t packetsInQueue  " << GetInternalQueue (queue)->GetNPackets ());
 
   return retval;
 }
@@ -221,6 +287,15 @@ PiSquareQueueDisc::InitializeParams (void)
   m_qDelayOld = Time (Seconds (0));
   m_stats.forcedDrop = 0;
   m_stats.unforcedDrop = 0;
+  m_stats.unforcedMark = 0;
+  m_stats.l4sMark = 0;
+
+  if (m_controller)
+    {
+      // the controller updates the drop probability from now on
+      Simulator::Remove (m_rtrsEvent);
+      m_controller->Add (this);
+    }
 }
 
 bool PiSquareQueueDisc::DropEarly (Ptr<QueueDiscItem> item, uint32_t qSize)
@@ -263,42 +338,84 @@ bool PiSquareQueueDisc::DropEarly (Ptr<QueueDiscItem> item, uint32_t qSize)
 void PiSquareQueueDisc::CalculateP ()
 {
   NS_LOG_FUNCTION (this);
-  Time qDelay;
-  double p = 0.0;
-  bool missingInitFlag = false;
-  if (m_avgDqRate > 0)
+  m_qDelay = ComputeQueueDelay ();
+
+  double qDelay = m_qDelay.GetSeconds ();
+  double qDelayOld = m_qDelayOld.GetSeconds ();
+  double qDelayRef = m_qDelayRef.GetSeconds ();
+  uint8_t resetDqRate;
+  PiController::UpdatePiSquare (1, &qDelay, &qDelayOld, &m_dropProb, &m_avgDqRate, &resetDqRate,
+                                &m_a, &m_b, &qDelayRef);
+  if (resetDqRate)
     {
-      qDelay = Time (Seconds (GetInternalQueue (0)->GetNBytes () / m_avgDqRate));
+      m_dqCount = -1;
     }
-  else
+
+  m_qDelayOld = m_qDelay;
+  m_rtrsEvent = Simulator::Schedule (m_tUpdate, &PiSquareQueueDisc::CalculateP, this);
+}
+
+Time
+PiSquareQueueDisc::ComputeQueueDelay (void) const
+{
+  if (!m_useTimestamp)
     {
-      qDelay = Time (Seconds (0));
-      missingInitFlag = true;
+      return PiController::EstimateQueueDelay (GetNQueuedBytes (), m_avgDqRate);
     }
 
-  m_qDelay = qDelay;
-
-  // Calculate the drop probability
-  p = m_a * (qDelay.GetSeconds () - m_qDelayRef.GetSeconds ()) + m_b * (qDelay.GetSeconds () - m_qDelayOld.GetSeconds ());
-  p += m_dropProb;
+  // sojourn time of the oldest packet at the head of the internal queues
+  Time qDelay = Seconds (0);
+  for (uint32_t i = 0; i < GetNInternalQueues (); i++)
+    {
+      if (!GetInternalQueue (i)->IsEmpty ())
+        {
+          Ptr<const QueueDiscItem> item = StaticCast<const QueueDiscItem> (GetInternalQueue (i)->Peek ());
+          qDelay = Max (qDelay, Simulator::Now () - item->GetTimeStamp ());
+        }
+    }
+  return qDelay;
+}
 
-  // For non-linear drop in prob
+bool
+PiSquareQueueDisc::IsL4s (Ptr<const QueueDiscItem> item) const
+{
+  uint8_t tos;
+  // ECT(1) and CE have the least significant bit of the ECN field set
+  return item->GetUint8Value (QueueItem::IP_DSFIELD, tos) && (tos & 0x01);
+}
 
-  if (qDelay.GetSeconds () == 0 && m_qDelayOld.GetSeconds () == 0)
+uint32_t
+PiSquareQueueDisc::SelectQueue (void) const
+{
+  if (!m_dualQueue || GetInternalQueue (L4S)->IsEmpty ())
     {
-      p *= 0.98;
+      return CLASSIC;
+    }
+  if (GetInternalQueue (CLASSIC)->IsEmpty ())
+    {
+      return L4S;
     }
 
-  m_dropProb = (p > 0) ? p : 0;
-
-  if ( (qDelay.GetSeconds () < 0.5 * m_qDelayRef.GetSeconds ()) && (m_qDelayOld.GetSeconds () < (0.5 * m_qDelayRef.GetSeconds ())) && (m_dropProb == 0) && !missingInitFlag )
+  // Time-shifted FIFO: serve the L4S head unless the classic head has
+  // been waiting m_tShift longer
+  Ptr<const QueueDiscItem> c = StaticCast<const QueueDiscItem> (GetInternalQueue (CLASSIC)->Peek ());
+  Ptr<const QueueDiscItem> l = StaticCast<const QueueDiscItem> (GetInternalQueue (L4S)->Peek ());
+  if (l->GetTimeStamp () - m_tShift <= c->GetTimeStamp ())
     {
-      m_dqCount = -1;
-      m_avgDqRate = 0.0;
+      return L4S;
     }
+  return CLASSIC;
+}
 
-  m_qDelayOld = qDelay;
-  m_rtrsEvent = Simulator::Schedule (m_tUpdate, &PiSquareQueueDisc::CalculateP, this);
+uint32_t
+PiSquareQueueDisc::GetNQueuedBytes (void) const
+{
+  uint32_t nBytes = 0;
+  for (uint32_t i = 0; i < GetNInternalQueues (); i++)
+    {
+      nBytes += GetInternalQueue (i)->GetNBytes ();
+    }
+  return nBytes;
 }
 
 Ptr<QueueDiscItem>
@@ -306,20 +423,40 @@ PiSquareQueueDisc::DoDequeue ()
 {
   NS_LOG_FUNCTION (this);
 
-  if (GetInternalQueue (0)->IsEmpty ())
+  uint32_t queue = SelectQueue ();
+  if (GetInternalQueue (queue)->IsEmpty ())
     {
       NS_LOG_LOGIC ("Queue empty");
       return 0;
     }
 
-  Ptr<QueueDiscItem> item = StaticCast<QueueDiscItem> (GetInternalQueue (0)->Dequeue ());
+  Ptr<QueueDiscItem> item = StaticCast<QueueDiscItem> (GetInternalQueue (queue)->Dequeue ());
   double now = Simulator::Now ().GetSeconds ();
   uint32_t pktSize = item->GetPacketSize ();
 
+  if (queue == L4S)
+    {
+      // Mark with the coupled probability, or always if the queue is too long
+      if (Simulator::Now () - item->GetTimeStamp () > m_l4sThreshold
+          || m_uv->GetValue () < std::min (m_k * m_dropProb, 1.0))
+        {
+          if (item->Mark ())
+            {
+              m_stats.l4sMark++;
+            }
+        }
+    }
+
+  if (m_useTimestamp)
+    {
+      // the queue delay is measured from the time stamps
+      return item;
+    }
+
   // if not in a measurement cycle and the queue has built up to dq_threshold,
   // start the measurement cycle
 
-  if ( (GetInternalQueue (0)->GetNBytes () >= m_dqThreshold) && (!m_inMeasurement) )
+  if ( (GetNQueuedBytes () >= m_dqThreshold) && (!m_inMeasurement) )
     {
       m_dqStart = now;
       m_dqCount = 0;
@@ -349,7 +486,7 @@ PiSquareQueueDisc::DoDequeue ()
             }
 
           // restart a measurement cycle if there is enough data
-          if (GetInternalQueue (0)->GetNBytes () > m_dqThreshold)
+          if (GetNQueuedBytes () > m_dqThreshold)
             {
               m_dqStart = now;
               m_dqCount = 0;
@@ -370,16 +507,17 @@ Ptr<const QueueDiscItem>
 PiSquareQueueDisc::DoPeek () const
 {
   NS_LOG_FUNCTION (this);
-  if (GetInternalQueue (0)->IsEmpty ())
+  uint32_t queue = SelectQueue ();
+  if (GetInternalQueue (queue)->IsEmpty ())
     {
       NS_LOG_LOGIC ("Queue empty");
       return 0;
     }
 
-  Ptr<const QueueDiscItem> item = StaticCast<const QueueDiscItem> (GetInternalQueue (0)->Peek ());
+  Ptr<const QueueDiscItem> item = StaticCast<const QueueDiscItem> (GetInternalQueue (queue)->Peek ());
 
-  NS_LOG_LOGIC ("Number packets " << GetInternalQueue (0)->GetNPackets ());
-  NS_LOG_LOGIC ("Number bytes " << GetInternalQueue (0)->GetNBytes ());
+  NS_LOG_LOGIC ("Number packets " << GetInternalQueue (queue)->GetNPackets ());
+  NS_LOG_LOGIC ("Number bytes " << GetInternalQueue (queue)->GetNBytes ());
 
   return item;
 }
@@ -400,38 +538,46 @@ PiSquareQueueDisc::CheckConfig (void)
       return false;
     }
 
+  uint32_t nQueues = m_dualQueue ? 2 : 1;
+
   if (GetNInternalQueues () == 0)
     {
-      // create a DropTail queue
-      Ptr<Queue> queue = CreateObjectWithAttributes<DropTailQueue> ("Mode", EnumValue (m_mode));
-      if (m_mode == Queue::QUEUE_MODE_PACKETS)
-        {
-          queue->SetMaxPackets (m_queueLimit);
-        }
-      else
+      // create the DropTail queues
+      for (uint32_t i = 0; i < nQueues; i++)
         {
-          queue->SetMaxBytes (m_queueLimit);
+          Ptr<Queue> queue = CreateObjectWithAttributes<DropTailQueue> ("Mode", EnumValue (m_mode));
+          if (m_mode == Queue::QUEUE_MODE_PACKETS)
+            {
+              queue->SetMaxPackets (m_queueLimit);
+            }
+          else
+            {
+              queue->SetMaxBytes (m_queueLimit);
+            }
+          AddInternalQueue (queue);
         }
-      AddInternalQueue (queue);
     }
 
-  if (GetNInternalQueues () != 1)
+  if (GetNInternalQueues () != nQueues)
     {
-      NS_LOG_ERROR ("PiSquareQueueDisc needs 1 internal queue");
+      NS_LOG_ERROR ("PiSquareQueueDisc needs " << nQueues << " internal queue(s)");
       return false;
     }
 
-  if (GetInternalQueue (0)->GetMode () != m_mode)
+  for (uint32_t i = 0; i < nQueues; i++)
     {
-      NS_LOG_ERROR ("The mode of the provided queue does not match the mode set on the PiSquareQueueDisc");
-      return false;
-    }
+      if (GetInternalQueue (i)->GetMode () != m_mode)
+        {
+          NS_LOG_ERROR ("The mode of the provided queue does not match the mode set on the PiSquareQueueDisc");
+          return false;
+        }
 
-  if ((m_mode ==  Queue::QUEUE_MODE_PACKETS && GetInternalQueue (0)->GetMaxPackets () < m_queueLimit)
-      || (m_mode ==  Queue::QUEUE_MODE_BYTES && GetInternalQueue (0)->GetMaxBytes () < m_queueLimit))
-    {
-      NS_LOG_ERROR ("The size of the internal queue is less than the queue disc limit");
-      return false;
+      if ((m_mode ==  Queue::QUEUE_MODE_PACKETS && GetInternalQueue (i)->GetMaxPackets () < m_queueLimit)
+          || (m_mode ==  Queue::QUEUE_MODE_BYTES && GetInternalQueue (i)->GetMaxBytes () < m_queueLimit))
+        {
+          NS_LOG_ERROR ("The size of the internal queue is less than the queue disc limit");
+          return false;
+        }
     }
 
   return true;
@@ -31,6 +31,7 @@
 #include "ns3/timer.h"
 #include "ns3/event-id.h"
 #include "ns3/random-variable-stream.h"
+#include "pi-controller.h"
 
 namespace ns3 {
 
@@ -41,6 +42,25 @@ class UniformRandomVariable;
  * \ingroup traffic-control
  *
  * \brief Implements PI Square queue discipline
+ *
+ * When the DualQueue attribute is set, the queue disc implements the
+ * coupled dual queue variant of PI Square (DualPI2): packets of scalable
+ * flows, whose ECN field is ECT(1) or CE, are stored in a separate low
+ * latency (L4S) queue.  The PI controller computes the base probability
+ * p' from the delay of the queue disc; classic packets are dropped with
+ * probability p'^2, as in single queue mode, while L4S packets are ECN
+ * marked at dequeue with the coupled probability min (k * p', 1), or
+ * always once they waited more than L4SMarkThreshold.  The two queues
+ * are served by a time-shifted FIFO scheduler: the head of the L4S queue
+ * is served first unless the head of the classic queue has been waiting
+ * TimeShift longer.
+ *
+ * The queue delay fed to the controller is estimated, by default, from
+ * the number of bytes queued and the dequeue rate, measured over
+ * measurement cycles of DequeueThreshold bytes.  When the UseTimestamp
+ * attribute is set, it is instead the sojourn time of the packet at the
+ * head of the queue, computed from its enqueue time stamp, and the
+ * dequeue rate is not measured.
  */
 class PiSquareQueueDisc : public QueueDisc
 {
@@ -68,6 +88,8 @@ public:
   {
     uint32_t unforcedDrop;      //!< Early probability drops: proactive
     uint32_t forcedDrop;        //!< Drops due to queue limit: reactive
+    uint32_t unforcedMark;      //!< Early probability marks: proactive
+    uint32_t l4sMark;           //!< Marks of packets of the L4S queue
   } Stats;
 
   /**
@@ -132,6 +154,8 @@ private:
   virtual Ptr<const QueueDiscItem> DoPeek (void) const;
   virtual bool CheckConfig (void);
 
+  friend class PiController;
+
   /**
    * \brief Initialize the queue parameters.
    */
@@ -150,6 +174,41 @@ private:
    */
   void CalculateP ();
 
+  /**
+   * \brief Get the current queue delay, as seen by the controller
+   * \returns the sojourn time of the oldest packet in timestamp mode, the
+   * queue delay estimated from the dequeue rate otherwise
+   */
+  Time ComputeQueueDelay (void) const;
+
+  /**
+   * \brief Check if a packet belongs to a scalable flow
+   * \param item queue item
+   * \returns true if the ECN field of the packet is ECT(1) or CE
+   */
+  bool IsL4s (Ptr<const QueueDiscItem> item) const;
+
+  /**
+   * \brief Select the internal queue to serve next
+   * \returns the index of the internal queue, CLASSIC in single queue mode
+   */
+  uint32_t SelectQueue (void) const;
+
+  /**
+   * \brief Get the number of bytes in all the internal queues
+   * \returns the number of bytes queued
+   */
+  uint32_t GetNQueuedBytes (void) const;
+
+  /**
+   * \brief Indices of the internal queues
+   */
+  enum QueueIndex
+  {
+    CLASSIC = 0,                                //!< Classic queue
+    L4S = 1,                                    //!< L4S queue, in dual queue mode
+  };
+
   Stats m_stats;                                //!< PI Square statistics
 
   // ** Variables supplied by user
@@ -162,6 +221,13 @@ private:
   double m_a;                                   //!< Parameter to PI Square controller
   double m_b;                                   //!< Parameter to PI Square controller
   uint32_t m_dqThreshold;                       //!< Minimum queue size in bytes before dequeue rate is measured
+  bool m_useTimestamp;                          //!< True to use the sojourn time instead of the dequeue rate
+  bool m_useEcn;                                //!< True if ECN is used (packets are marked instead of being dropped)
+  double m_markEcnTh;                           //!< ECN marking threshold: above this squared drop probability, packets are dropped
+  bool m_dualQueue;                             //!< Whether L4S packets are stored in a separate queue
+  double m_k;                                   //!< Coupling factor between the classic and L4S probabilities
+  Time m_l4sThreshold;                          //!< Sojourn time above which L4S packets are always marked
+  Time m_tShift;                                //!< Time shift of the L4S queue in the scheduler
 
   // ** Variables maintained by PI Square
   double m_dropProb;                            //!< Variable used in calculation of drop probability
@@ -172,6 +238,7 @@ private:
   double m_dqStart;                             //!< Start timestamp of current measurement cycle
   uint32_t m_dqCount;                           //!< Number of bytes departed since current measurement cycle starts
   EventId m_rtrsEvent;                          //!< Event used to decide the decision of interval of drop probability calculation
+  Ptr<PiController> m_controller;               //!< Shared controller updating the drop probability, if any
   Ptr<UniformRandomVariable> m_uv;              //!< Rng stream
 };
 
@@ -31,6 +31,7 @@
 #include "ns3/double.h"
 #include "ns3/simulator.h"
 #include "ns3/abort.h"
+#include "ns3/pointer.h"
 #include "pie-queue-disc.h"
 #include "ns3/drop-tail-queue.h"
 
@@ -92,6 +93,21 @@ TypeId PieQueueDisc::GetTypeId (void)
                    TimeValue (Seconds (0.02)),
                    MakeTimeAccessor (&PieQueueDisc::m_qDelayRef),
                    MakeTimeChecker ())
+    .AddAttribute ("UseEcn",
+                   "True to use ECN (packets are marked instead of being dropped)",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PieQueueDisc::m_useEcn),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MarkEcnThreshold",
+                   "ECN marking threshold: packets are dropped instead of being marked above this drop probability",
+                   DoubleValue (0.1),
+                   MakeDoubleAccessor (&PieQueueDisc::m_markEcnTh),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("Controller",
+                   "Shared controller updating the drop probability instead of a per queue disc timer",
+                   PointerValue (),
+                   MakePointerAccessor (&PieQueueDisc::m_controller),
+                   MakePointerChecker<PiController> ())
     .AddAttribute ("MaxBurstAllowance",
                    "Current max burst allowance in seconds before random drop",
                    TimeValue (Seconds (0.1)),
@@ -121,6 +137,11 @@ PieQueueDisc::DoDispose (void)
   NS_LOG_FUNCTION (this);
   m_uv = 0;
   Simulator::Remove (m_rtrsEvent);
+  if (m_controller)
+    {
+      m_controller->Remove (this);
+      m_controller = 0;
+    }
   QueueDisc::DoDispose ();
 }
 
@@ -202,10 +223,18 @@ PieQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
     }
   else if (DropEarly (item, nQueued))
     {
-      // Early probability drop: proactive
-      Drop (item);
-      m_stats.unforcedDrop++;
-      return false;
+      if (m_useEcn && m_dropProb <= m_markEcnTh && item->Mark ())
+        {
+          // Early probability mark: proactive
+          m_stats.unforcedMark++;
+        }
+      else
+        {
+          // Early probability drop: proactive
+          Drop (item);
+          m_stats.unforcedDrop++;
+          return false;
+        }
     }
 
   // No drop
@@ -230,9 +259,18 @@ PieQueueDisc::InitializeParams (void)
   m_avgDqRate = 0.0;
   m_dqStart = 0;
   m_burstState = NO_BURST;
+  m_burstReset = 0;
   m_qDelayOld = Time (Seconds (0));
   m_stats.forcedDrop = 0;
   m_stats.unforcedDrop = 0;
+  m_stats.unforcedMark = 0;
+
+  if (m_controller)
+    {
+      // the controller updates the drop probability from now on
+      Simulator::Remove (m_rtrsEvent);
+      m_controller->Add (this);
+    }
 }
 
 bool PieQueueDisc::DropEarly (Ptr<QueueDiscItem> item, uint32_t qSize)
@@ -289,110 +327,25 @@ bool PieQueueDisc::DropEarly (Ptr<QueueDiscItem> item, uint32_t qSize)
 void PieQueueDisc::CalculateP ()
 {
   NS_LOG_FUNCTION (this);
-  Time qDelay;
-  double p = 0.0;
-  bool missingInitFlag = false;
-  if (m_avgDqRate > 0)
-    {
-      qDelay = Time (Seconds (GetInternalQueue (0)->GetNBytes () / m_avgDqRate));
-    }
-  else
-    {
-      qDelay = Time (Seconds (0));
-      missingInitFlag = true;
-    }
-
-  m_qDelay = qDelay;
-
-  if (m_burstAllowance.GetSeconds () > 0)
-    {
-      m_dropProb = 0;
-    }
-  else
-    {
-      p = m_a * (qDelay.GetSeconds () - m_qDelayRef.GetSeconds ()) + m_b * (qDelay.GetSeconds () - m_qDelayOld.GetSeconds ());
-      if (m_dropProb < 0.001)
-        {
-          p /= 32;
-        }
-      else if (m_dropProb < 0.01)
-        {
-          p /= 8;
-        }
-      else if (m_dropProb < 0.1)
-        {
-          p /= 2;
-        }
-      else if (m_dropProb < 1)
-        {
-          p /= 0.5;
-        }
-      else if (m_dropProb < 10)
-        {
-          p /= 0.125;
-        }
-      else
-        {
-          p /= 0.03125;
-        }
-      if ((m_dropProb >= 0.1) && (p > 0.02))
-        {
-          p = 0.02;
-        }
-    }
-
-  p += m_dropProb;
-
-  // For non-linear drop in prob
-
-  if (qDelay.GetSeconds () == 0 && m_qDelayOld.GetSeconds () == 0)
-    {
-      p *= 0.98;
-    }
-  else if (qDelay.GetSeconds () > 0.2)
-    {
-      p += 0.02;
-    }
-
-  m_dropProb = (p > 0) ? p : 0;
-  if (m_burstAllowance < m_tUpdate)
-    {
-      m_burstAllowance =  Time (Seconds (0));
-    }
-  else
-    {
-      m_burstAllowance -= m_tUpdate;
-    }
-
-  uint32_t burstResetLimit = BURST_RESET_TIMEOUT / m_tUpdate.GetSeconds ();
-  if ( (qDelay.GetSeconds () < 0.5 * m_qDelayRef.GetSeconds ()) && (m_qDelayOld.GetSeconds () < (0.5 * m_qDelayRef.GetSeconds ())) && (m_dropProb == 0) && !missingInitFlag )
+  m_qDelay = PiController::EstimateQueueDelay (GetInternalQueue (0)->GetNBytes (), m_avgDqRate);
+
+  double qDelay = m_qDelay.GetSeconds ();
+  double qDelayOld = m_qDelayOld.GetSeconds ();
+  double qDelayRef = m_qDelayRef.GetSeconds ();
+  uint8_t resetDqRate;
+  int64_t burstAllowance = m_burstAllowance.GetTimeStep ();
+  uint8_t burstState = m_burstState;
+  PiController::UpdatePie (1, &qDelay, &qDelayOld, &m_dropProb, &m_avgDqRate, &resetDqRate,
+                           &m_a, &m_b, &qDelayRef, &burstAllowance, &burstState, &m_burstReset,
+                           m_tUpdate.GetTimeStep ());
+  if (resetDqRate)
     {
       m_dqCount = -1;
-      m_avgDqRate = 0.0;
-    }
-  if ( (qDelay.GetSeconds () < 0.5 * m_qDelayRef.GetSeconds ()) && (m_qDelayOld.GetSeconds () < (0.5 * m_qDelayRef.GetSeconds ())) && (m_dropProb == 0) && (m_burstAllowance.GetSeconds () == 0))
-    {
-      if (m_burstState == IN_BURST_PROTECTING)
-        {
-          m_burstState = IN_BURST;
-          m_burstReset = 0;
-        }
-      else if (m_burstState == IN_BURST)
-        {
-          m_burstReset++;
-          if (m_burstReset > burstResetLimit)
-            {
-              m_burstReset = 0;
-              m_burstState = NO_BURST;
-            }
-        }
-    }
-  else if (m_burstState == IN_BURST)
-    {
-      m_burstReset = 0;
     }
+  m_burstAllowance = TimeStep (burstAllowance);
+  m_burstState = static_cast<BurstStateT> (burstState);
 
-  m_qDelayOld = qDelay;
+  m_qDelayOld = m_qDelay;
   m_rtrsEvent = Simulator::Schedule (m_tUpdate, &PieQueueDisc::CalculateP, this);
 }
 
@@ -37,6 +37,7 @@
 #include "ns3/timer.h"
 #include "ns3/event-id.h"
 #include "ns3/random-variable-stream.h"
+#include "pi-controller.h"
 
 #define BURST_RESET_TIMEOUT 1.5
 
@@ -76,6 +77,7 @@ public:
   {
     uint32_t unforcedDrop;      //!< Early probability drops: proactive
     uint32_t forcedDrop;        //!< Drops due to queue limit: reactive
+    uint32_t unforcedMark;      //!< Early probability marks: proactive
   } Stats;
 
   /**
@@ -150,6 +152,8 @@ private:
   virtual Ptr<const QueueDiscItem> DoPeek (void) const;
   virtual bool CheckConfig (void);
 
+  friend class PiController;
+
   /**
    * \brief Initialize the queue parameters.
    */
@@ -183,6 +187,8 @@ private:
   double m_a;                                   //!< Parameter to pie controller
   double m_b;                                   //!< Parameter to pie controller
   uint32_t m_dqThreshold;                       //!< Minimum queue size in bytes before dequeue rate is measured
+  bool m_useEcn;                                //!< True if ECN is used (packets are marked instead of being dropped)
+  double m_markEcnTh;                           //!< ECN marking threshold: above this drop probability, packets are dropped
 
   // ** Variables maintained by PIE
   double m_dropProb;                            //!< Variable used in calculation of drop probability
@@ -196,6 +202,7 @@ private:
   double m_dqStart;                             //!< Start timestamp of current measurement cycle
   uint32_t m_dqCount;                           //!< Number of bytes departed since current measurement cycle starts
   EventId m_rtrsEvent;                          //!< Event used to decide the decision of interval of drop probability calculation
+  Ptr<PiController> m_controller;               //!< Shared controller updating the drop probability, if any
   Ptr<UniformRandomVariable> m_uv;              //!< Rng stream
 };
 
@@ -68,6 +68,24 @@ QueueDiscItem::SetTxQueueIndex (uint8_t txq)
   m_txq = txq;
 }
 
+Time
+QueueDiscItem::GetTimeStamp (void) const
+{
+  return m_tstamp;
+}
+
+void
+QueueDiscItem::SetTimeStamp (Time t)
+{
+  m_tstamp = t;
+}
+
+bool
+QueueDiscItem::Mark (void)
+{
+  return false;
+}
+
 void
 QueueDiscItem::Print (std::ostream& os) const
 {
@@ -24,6 +24,7 @@
 #include "ns3/traced-value.h"
 #include <ns3/queue.h>
 #include "ns3/net-device.h"
+#include "ns3/nstime.h"
 #include <vector>
 #include "packet-filter.h"
 
@@ -76,6 +77,18 @@ public:
    */
   void SetTxQueueIndex (uint8_t txq);
 
+  /**
+   * \brief Get the time at which the item was enqueued
+   * \return the time at which the item was enqueued, if set by the queue disc
+   */
+  Time GetTimeStamp (void) const;
+
+  /**
+   * \brief Set the time at which the item is enqueued
+   * \param t the time at which the item is enqueued
+   */
+  void SetTimeStamp (Time t);
+
   /**
    * \brief Add the header to the packet
    *
@@ -85,6 +98,16 @@ public:
    */
   virtual void AddHeader (void) = 0;
 
+  /**
+   * \brief Mark the packet as having experienced congestion, if possible
+   *
+   * Subclasses storing packets of an ECN capable transport set the ECN
+   * field of the header to CE.  The default implementation marks nothing.
+   *
+   * \return true if the packet is ECN capable and was marked
+   */
+  virtual bool Mark (void);
+
   /**
    * \brief Print the item contents.
    * \param os output stream in which the data should be printed.
@@ -115,6 +138,7 @@ private:
   Address m_address;      //!< MAC destination address
   uint16_t m_protocol;    //!< L3 Protocol number
   uint8_t m_txq;          //!< Transmission queue index
+  Time m_tstamp;          //!< Enqueue time stamp
 };
 
 
@@ -21,10 +21,13 @@
 
 #include "ns3/test.h"
 #include "ns3/pi-square-queue-disc.h"
+#include "ns3/pi-controller.h"
+#include "ns3/pointer.h"
 #include "ns3/drop-tail-queue.h"
 #include "ns3/uinteger.h"
 #include "ns3/string.h"
 #include "ns3/double.h"
+#include "ns3/boolean.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 
@@ -64,6 +67,107 @@ PiSquareQueueDiscTestItem::Mark (void)
   return false;
 }
 
+/**
+ * \ingroup traffic-control
+ * \ingroup tests
+ *
+ * \brief Queue disc item carrying an ECN codepoint
+ */
+class PiSquareQueueDiscEcnTestItem : public QueueDiscItem
+{
+public:
+  PiSquareQueueDiscEcnTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol, uint8_t ecn);
+  virtual ~PiSquareQueueDiscEcnTestItem ();
+  virtual void AddHeader (void);
+  virtual bool Mark (void);
+  virtual bool GetUint8Value (QueueItem::Uint8Values field, uint8_t &value) const;
+
+private:
+  PiSquareQueueDiscEcnTestItem ();
+  PiSquareQueueDiscEcnTestItem (const PiSquareQueueDiscEcnTestItem &);
+  PiSquareQueueDiscEcnTestItem &operator = (const PiSquareQueueDiscEcnTestItem &);
+  uint8_t m_ecn;
+};
+
+PiSquareQueueDiscEcnTestItem::PiSquareQueueDiscEcnTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol, uint8_t ecn)
+  : QueueDiscItem (p, addr, protocol),
+    m_ecn (ecn)
+{
+}
+
+PiSquareQueueDiscEcnTestItem::~PiSquareQueueDiscEcnTestItem ()
+{
+}
+
+void
+PiSquareQueueDiscEcnTestItem::AddHeader (void)
+{
+}
+
+bool
+PiSquareQueueDiscEcnTestItem::Mark (void)
+{
+  if (m_ecn == 0)
+    {
+      return false;
+    }
+  m_ecn = 3;
+  return true;
+}
+
+bool
+PiSquareQueueDiscEcnTestItem::GetUint8Value (QueueItem::Uint8Values field, uint8_t &value) const
+{
+  value = m_ecn;
+  return field == QueueItem::IP_DSFIELD;
+}
+
+namespace {
+
+/**
+ * Enqueue a packet of 1000 bytes.
+ *
+ * \param queue the queue disc
+ * \param ecn the ECN codepoint of the packet
+ */
+void
+EnqueueEcn (Ptr<QueueDisc> queue, uint8_t ecn)
+{
+  Address dest;
+  queue->Enqueue (Create<PiSquareQueueDiscEcnTestItem> (Create<Packet> (1000), dest, 0, ecn));
+}
+
+/**
+ * Dequeue a packet, if any.
+ *
+ * \param queue the queue disc
+ */
+void
+DequeueItem (Ptr<QueueDisc> queue)
+{
+  Ptr<QueueDiscItem> item = queue->Dequeue ();
+}
+
+/**
+ * Schedule the traffic shared by the test cases: 400 packets of 1000
+ * bytes, one every 10 ms, and 400 dequeues, by default one every 12 ms.
+ *
+ * \param queue the queue disc
+ * \param ecn the ECN codepoint of the packets
+ * \param dequeueDelay the time between two dequeues, in seconds
+ */
+void
+AddTraffic (Ptr<QueueDisc> queue, uint8_t ecn, double dequeueDelay = 0.012)
+{
+  for (uint32_t i = 0; i < 400; i++)
+    {
+      Simulator::Schedule (Time (Seconds ((i + 1) * 0.01)), &EnqueueEcn, queue, ecn);
+      Simulator::Schedule (Time (Seconds ((i + 1) * dequeueDelay)), &DequeueItem, queue);
+    }
+}
+
+} // unnamed namespace
+
 class PiSquareQueueDiscTestCase : public TestCase
 {
 public:
@@ -297,6 +401,267 @@ PiSquareQueueDiscTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \ingroup traffic-control
+ * \ingroup tests
+ *
+ * \brief Check that a shared PiController updates PiSquareQueueDisc
+ *        as its own timer does
+ */
+class PiControllerTestCase : public TestCase
+{
+public:
+  PiControllerTestCase ();
+  virtual void DoRun (void);
+};
+
+PiControllerTestCase::PiControllerTestCase ()
+  : TestCase ("Check that a shared PiController computes the same drop probabilities as the PI Square timer")
+{
+}
+
+void
+PiControllerTestCase::DoRun (void)
+{
+  Ptr<PiController> controller = CreateObject<PiController> ();
+  controller->SetAttribute ("Period", TimeValue (Seconds (0.03)));
+
+  // the queue disc updated by its own timer has a twin updated by the controller
+  Ptr<PiSquareQueueDisc> piSquare[2];
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      piSquare[i] = CreateObjectWithAttributes<PiSquareQueueDisc> ("QueueLimit", UintegerValue (300),
+                                                                   "Tupdate", TimeValue (Seconds (0.03)));
+      if (i == 1)
+        {
+          piSquare[i]->SetAttribute ("Controller", PointerValue (controller));
+        }
+      piSquare[i]->AssignStreams (1);
+      piSquare[i]->Initialize ();
+      AddTraffic (piSquare[i], 0);
+    }
+
+  Simulator::Stop (Seconds (8.0));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_NE (piSquare[0]->GetStats ().unforcedDrop, 0, "There should be some unforced drops");
+  NS_TEST_EXPECT_MSG_EQ (piSquare[1]->GetStats ().unforcedDrop, piSquare[0]->GetStats ().unforcedDrop,
+                         "The controller should drop the same packets as the PI Square timer");
+  NS_TEST_EXPECT_MSG_EQ (piSquare[1]->GetQueueDelay (), piSquare[0]->GetQueueDelay (),
+                         "The controller should estimate the same queue delay as the PI Square timer");
+
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      piSquare[i]->Dispose ();
+    }
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control
+ * \ingroup tests
+ *
+ * \brief Check the coupled dual queue (DualPI2) mode of PiSquareQueueDisc
+ */
+class PiSquareDualQueueTestCase : public TestCase
+{
+public:
+  PiSquareDualQueueTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Dequeue a packet, and account for its sojourn time.
+   * \param queue the queue disc
+   */
+  void Dequeue (Ptr<PiSquareQueueDisc> queue);
+  uint32_t m_nDequeued[2];  //!< Number of classic and L4S packets dequeued
+  Time m_sojourn[2];        //!< Total sojourn time of the classic and L4S packets
+};
+
+PiSquareDualQueueTestCase::PiSquareDualQueueTestCase ()
+  : TestCase ("Check the coupled dual queue (DualPI2) mode of the pi square queue implementation")
+{
+}
+
+void
+PiSquareDualQueueTestCase::Dequeue (Ptr<PiSquareQueueDisc> queue)
+{
+  Ptr<QueueDiscItem> item = queue->Dequeue ();
+  if (item != 0)
+    {
+      uint8_t ecn;
+      item->GetUint8Value (QueueItem::IP_DSFIELD, ecn);
+      uint32_t l4s = ecn & 0x01;
+      m_nDequeued[l4s]++;
+      m_sojourn[l4s] += Simulator::Now () - item->GetTimeStamp ();
+    }
+}
+
+void
+PiSquareDualQueueTestCase::DoRun (void)
+{
+  m_nDequeued[0] = m_nDequeued[1] = 0;
+  m_sojourn[0] = m_sojourn[1] = Seconds (0);
+
+  Ptr<PiSquareQueueDisc> queue = CreateObjectWithAttributes<PiSquareQueueDisc> ("QueueLimit", UintegerValue (300),
+                                                                                "DualQueue", BooleanValue (true));
+  queue->Initialize ();
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNInternalQueues (), 2, "There should be a classic and a L4S queue");
+
+  // classic (Not-ECT) and scalable (ECT(1)) flows, together faster than the dequeue rate
+  for (uint32_t i = 0; i < 400; i++)
+    {
+      Simulator::Schedule (Time (Seconds ((i + 1) * 0.02)), &EnqueueEcn, queue, 0);
+      Simulator::Schedule (Time (Seconds ((i + 1) * 0.02 + 0.01)), &EnqueueEcn, queue, 1);
+      Simulator::Schedule (Time (Seconds ((i + 1) * 0.012)), &PiSquareDualQueueTestCase::Dequeue, this, queue);
+    }
+  Simulator::Stop (Seconds (8.0));
+  Simulator::Run ();
+
+  PiSquareQueueDisc::Stats st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_NE (st.unforcedDrop, 0, "There should be some unforced drops of classic packets");
+  NS_TEST_EXPECT_MSG_EQ (st.forcedDrop, 0, "There should be zero forced drops");
+  NS_TEST_EXPECT_MSG_NE (st.l4sMark, 0, "There should be some marks of L4S packets");
+  NS_TEST_EXPECT_MSG_GT (m_nDequeued[0], 0, "Some classic packets should be dequeued");
+  NS_TEST_EXPECT_MSG_GT (m_nDequeued[1], 0, "Some L4S packets should be dequeued");
+  NS_TEST_EXPECT_MSG_LT (m_sojourn[1] / m_nDequeued[1], m_sojourn[0] / m_nDequeued[0],
+                         "L4S packets should wait less than classic packets");
+
+  queue->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control
+ * \ingroup tests
+ *
+ * \brief Check ECN marking in PiSquareQueueDisc
+ */
+class PiSquareEcnTestCase : public TestCase
+{
+public:
+  PiSquareEcnTestCase ();
+  virtual void DoRun (void);
+};
+
+PiSquareEcnTestCase::PiSquareEcnTestCase ()
+  : TestCase ("Check ECN marking in the pi square queue implementation")
+{
+}
+
+void
+PiSquareEcnTestCase::DoRun (void)
+{
+  // ECT(0) packets, marked as long as the probability does not exceed the threshold
+  Ptr<PiSquareQueueDisc> piSquareEct = CreateObjectWithAttributes<PiSquareQueueDisc> ("QueueLimit", UintegerValue (300),
+                                                                                      "UseEcn", BooleanValue (true),
+                                                                                      "MarkEcnThreshold", DoubleValue (1.0));
+  // Not-ECT packets, which can only be dropped
+  Ptr<PiSquareQueueDisc> piSquareNotEct = CreateObjectWithAttributes<PiSquareQueueDisc> ("QueueLimit", UintegerValue (300),
+                                                                                         "UseEcn", BooleanValue (true));
+  // ECT(0) packets, with a threshold too low to ever mark
+  Ptr<PiSquareQueueDisc> piSquareLowTh = CreateObjectWithAttributes<PiSquareQueueDisc> ("QueueLimit", UintegerValue (300),
+                                                                                        "UseEcn", BooleanValue (true),
+                                                                                        "MarkEcnThreshold", DoubleValue (0.0));
+  piSquareEct->Initialize ();
+  piSquareNotEct->Initialize ();
+  piSquareLowTh->Initialize ();
+  AddTraffic (piSquareEct, 2);
+  AddTraffic (piSquareNotEct, 0);
+  AddTraffic (piSquareLowTh, 2);
+  Simulator::Stop (Seconds (8.0));
+  Simulator::Run ();
+
+  // the traffic does not react to the marks, so the probability
+  // eventually exceeds the threshold and some packets are dropped
+  PiSquareQueueDisc::Stats ect = piSquareEct->GetStats ();
+  PiSquareQueueDisc::Stats notEct = piSquareNotEct->GetStats ();
+  NS_TEST_EXPECT_MSG_NE (ect.unforcedMark, 0, "There should be some unforced marks");
+  NS_TEST_EXPECT_MSG_EQ (notEct.unforcedMark, 0, "Not-ECT packets should not be marked");
+  NS_TEST_EXPECT_MSG_NE (notEct.unforcedDrop, 0, "There should be some unforced drops");
+  PiSquareQueueDisc::Stats lowTh = piSquareLowTh->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (lowTh.unforcedMark, 0, "Packets should be dropped above the marking threshold");
+  NS_TEST_EXPECT_MSG_NE (lowTh.unforcedDrop, 0, "There should be some unforced drops");
+
+  piSquareEct->Dispose ();
+  piSquareNotEct->Dispose ();
+  piSquareLowTh->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control
+ * \ingroup tests
+ *
+ * \brief Check the timestamp based queue delay of PiSquareQueueDisc
+ */
+class PiSquareTimestampTestCase : public TestCase
+{
+public:
+  PiSquareTimestampTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Record the queue delay seen by the controller.
+   * \param queue the queue disc
+   */
+  void CheckQueueDelay (Ptr<PiSquareQueueDisc> queue);
+  /**
+   * Run a queue disc fed with a packet every 10 ms, in a simulation of its own.
+   * \param dequeueDelay the interval between two dequeues, in seconds
+   * \returns the queue disc, once the simulation is destroyed
+   */
+  Ptr<PiSquareQueueDisc> RunQueue (double dequeueDelay);
+  Time m_maxQueueDelay;  //!< Largest queue delay seen by the controller
+};
+
+PiSquareTimestampTestCase::PiSquareTimestampTestCase ()
+  : TestCase ("Check the timestamp based queue delay of the pi square queue implementation")
+{
+}
+
+void
+PiSquareTimestampTestCase::CheckQueueDelay (Ptr<PiSquareQueueDisc> queue)
+{
+  m_maxQueueDelay = Max (m_maxQueueDelay, queue->GetQueueDelay ());
+}
+
+Ptr<PiSquareQueueDisc>
+PiSquareTimestampTestCase::RunQueue (double dequeueDelay)
+{
+  Ptr<PiSquareQueueDisc> queue = CreateObjectWithAttributes<PiSquareQueueDisc> ("QueueLimit", UintegerValue (300),
+                                                                                "A", DoubleValue (0.125),
+                                                                                "B", DoubleValue (1.25),
+                                                                                "UseTimestamp", BooleanValue (true));
+  queue->Initialize ();
+  AddTraffic (queue, 0, dequeueDelay);
+  for (uint32_t i = 0; i < 400; i++)
+    {
+      Simulator::Schedule (Time (Seconds ((i + 1) * 0.01 + 0.005)), &PiSquareTimestampTestCase::CheckQueueDelay, this, queue);
+    }
+  Simulator::Stop (Seconds (8.0));
+  Simulator::Run ();
+  queue->Dispose ();
+  Simulator::Destroy ();
+  return queue;
+}
+
+void
+PiSquareTimestampTestCase::DoRun (void)
+{
+  m_maxQueueDelay = Seconds (0);
+  PiSquareQueueDisc::Stats fast = RunQueue (0.012)->GetStats ();
+  NS_TEST_EXPECT_MSG_GT (m_maxQueueDelay, Seconds (0), "The queue delay should be measured");
+  // 300 packets at most, dequeued every 12 ms
+  NS_TEST_EXPECT_MSG_LT (m_maxQueueDelay, Seconds (3.6), "The queue delay should be a sojourn time");
+  NS_TEST_EXPECT_MSG_NE (fast.unforcedDrop, 0, "There should be some unforced drops");
+  NS_TEST_EXPECT_MSG_EQ (fast.forcedDrop, 0, "There should be zero forced drops");
+
+  PiSquareQueueDisc::Stats slow = RunQueue (0.015)->GetStats ();
+  NS_TEST_EXPECT_MSG_GT (slow.unforcedDrop, fast.unforcedDrop, "A lower dequeue rate should cause more unforced drops");
+  NS_TEST_EXPECT_MSG_EQ (slow.forcedDrop, 0, "There should be zero forced drops");
+}
+
 static class PiSquareQueueDiscTestSuite : public TestSuite
 {
 public:
@@ -304,5 +669,9 @@ public:
     : TestSuite ("pi-square-queue-disc", UNIT)
   {
     AddTestCase (new PiSquareQueueDiscTestCase (), TestCase::QUICK);
+    AddTestCase (new PiControllerTestCase (), TestCase::QUICK);
+    AddTestCase (new PiSquareDualQueueTestCase (), TestCase::QUICK);
+    AddTestCase (new PiSquareEcnTestCase (), TestCase::QUICK);
+    AddTestCase (new PiSquareTimestampTestCase (), TestCase::QUICK);
   }
 } g_piSquareQueueTestSuite;
@@ -37,6 +37,12 @@ namespace ns3 {
 /**
  * \ingroup wifi
  * \brief handles interference calculations
+ *
+ * The signals on the medium are kept in a time-ordered ledger of power
+ * changes, along with the total power of the changes which are already
+ * over.  The changes are folded into that total as soon as no reception
+ * needs them anymore, so that the SNIR and PER of a packet are computed
+ * in place from the changes which overlap it.
  */
 class InterferenceHelper
 {
@@ -278,12 +284,14 @@ private:
   /**
    * Calculate noise and interference power in W.
    *
-   * \param event
-   * \param ni
+   * \param event the event being received
+   * \param end [out] the change of m_niChanges which ends \p event; the
+   *        changes between m_niChanges.begin () + 1 and \p end are those
+   *        which happen during \p event
    *
-   * \return noise and interference power
+   * \return noise and interference power at the start of \p event
    */
-  double CalculateNoiseInterferenceW (Ptr<Event> event, NiChanges *ni) const;
+  double CalculateNoiseInterferenceW (Ptr<Event> event, NiChanges::const_iterator *end) const;
   /**
    * Calculate SNR (linear ratio) from the given signal power and noise+interference power.
    * (Mode is not currently used)
@@ -311,31 +319,49 @@ private:
    * Calculate the error rate of the given plcp payload. The plcp payload can be divided into
    * multiple chunks (e.g. due to interference from other transmissions).
    *
-   * \param event
-   * \param ni
+   * The chunks are read in place from m_niChanges, so that the cost
+   * only depends on the number of signals overlapping \p event.
+   *
+   * \param event the event being received
+   * \param noiseInterferenceW noise and interference power at the start of \p event
+   * \param end the end of the changes during \p event,
+   *        as returned by CalculateNoiseInterferenceW
    *
    * \return the error rate of the packet
    */
-  double CalculatePlcpPayloadPer (Ptr<const Event> event, NiChanges *ni) const;
+  double CalculatePlcpPayloadPer (Ptr<const Event> event, double noiseInterferenceW,
+                                  NiChanges::const_iterator end) const;
   /**
    * Calculate the error rate of the plcp header. The plcp header can be divided into
    * multiple chunks (e.g. due to interference from other transmissions).
    *
-   * \param event
-   * \param ni
+   * The chunks are read in place from m_niChanges, so that the cost
+   * only depends on the number of signals overlapping \p event.
+   *
+   * \param event the event being received
+   * \param noiseInterferenceW noise and interference power at the start of \p event
+   * \param end the end of the changes during \p event,
+   *        as returned by CalculateNoiseInterferenceW
    *
    * \return the error rate of the packet
    */
-  double CalculatePlcpHeaderPer (Ptr<const Event> event, NiChanges *ni) const;
+  double CalculatePlcpHeaderPer (Ptr<const Event> event, double noiseInterferenceW,
+                                 NiChanges::const_iterator end) const;
 
   double m_noiseFigure; /**< noise figure (linear) */
   Ptr<ErrorRateModel> m_errorRateModel;
-  /// Experimental: needed for energy duration calculation
+  /// The pending changes of noise and interference power, sorted by time
   NiChanges m_niChanges;
-  double m_firstPower;
+  double m_firstPower; //!< The power before the first change of m_niChanges
   bool m_rxing;
   /// Returns an iterator to the first nichange, which is later than moment
   NiChanges::iterator GetPosition (Time moment);
+  /**
+   * Fold the changes before \p end into m_firstPower, and erase them.
+   *
+   * \param end the first change to keep
+   */
+  void EraseChanges (NiChanges::iterator end);
   /**
    * Add NiChange to the list at the appropriate position.
    *
@@ -0,0 +1,380 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include "table-error-rate-model.h"
+#include "nist-error-rate-model.h"
+#include "ns3/double.h"
+#include "ns3/string.h"
+#include "ns3/pointer.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TableErrorRateModel");
+
+NS_OBJECT_ENSURE_REGISTERED (TableErrorRateModel);
+
+namespace {
+
+/// Version of the format of the table files
+const uint32_t TABLE_FILE_VERSION = 1;
+
+/// Bounds of the per-bit error exponents stored, so that their logarithm is finite
+const double MIN_EXPONENT = 1e-300;
+const double MAX_EXPONENT = 1e300;
+
+/**
+ * \param file the file to write to
+ * \param value the value to write
+ */
+template <typename T>
+void
+WriteValue (std::ofstream &file, T value)
+{
+  file.write (reinterpret_cast<const char *> (&value), sizeof (T));
+}
+
+/**
+ * \param file the file to read from
+ * \param value [out] the value read
+ *
+ * \return true if the value could be read
+ */
+template <typename T>
+bool
+ReadValue (std::ifstream &file, T &value)
+{
+  file.read (reinterpret_cast<char *> (&value), sizeof (T));
+  return file.good ();
+}
+
+/**
+ * \param file the file to write to
+ * \param s the string to write, preceded by its length
+ */
+void
+WriteString (std::ofstream &file, std::string const &s)
+{
+  WriteValue<uint32_t> (file, s.size ());
+  file.write (s.data (), s.size ());
+}
+
+/**
+ * \param file the file to read from
+ * \param s [out] the string read
+ *
+ * \return true if the string could be read
+ */
+bool
+ReadString (std::ifstream &file, std::string &s)
+{
+  uint32_t size;
+  if (!ReadValue (file, size) || size > 1024)
+    {
+      return false;
+    }
+  s.resize (size);
+  if (size > 0)
+    {
+      file.read (&s[0], size);
+    }
+  return file.good ();
+}
+
+} // unnamed namespace
+
+TypeId
+TableErrorRateModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TableErrorRateModel")
+    .SetParent<ErrorRateModel> ()
+    .SetGroupName ("Wifi")
+    .AddConstructor<TableErrorRateModel> ()
+    .AddAttribute ("ErrorRateModel",
+                   "The error rate model to tabulate. NistErrorRateModel is used if none is set.",
+                   PointerValue (),
+                   MakePointerAccessor (&TableErrorRateModel::SetErrorRateModel,
+                                        &TableErrorRateModel::GetErrorRateModel),
+                   MakePointerChecker<ErrorRateModel> ())
+    .AddAttribute ("MinSnr",
+                   "The lowest SNR of the tables, in dB.",
+                   DoubleValue (-10.0),
+                   MakeDoubleAccessor (&TableErrorRateModel::m_minSnrDb),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("MaxSnr",
+                   "The highest SNR of the tables, in dB.",
+                   DoubleValue (50.0),
+                   MakeDoubleAccessor (&TableErrorRateModel::m_maxSnrDb),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("SnrStep",
+                   "The step between two points of the tables, in dB.",
+                   DoubleValue (0.05),
+                   MakeDoubleAccessor (&TableErrorRateModel::m_stepDb),
+                   MakeDoubleChecker<double> (1e-6))
+    .AddAttribute ("TableFile",
+                   "The file written by TableErrorRateModel::Save to load the tables from, if any.",
+                   StringValue (""),
+                   MakeStringAccessor (&TableErrorRateModel::m_tableFile),
+                   MakeStringChecker ())
+  ;
+  return tid;
+}
+
+TableErrorRateModel::TableErrorRateModel ()
+  : m_initialized (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TableErrorRateModel::~TableErrorRateModel ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TableErrorRateModel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_model = 0;
+  m_tables.clear ();
+  ErrorRateModel::DoDispose ();
+}
+
+void
+TableErrorRateModel::SetErrorRateModel (Ptr<ErrorRateModel> model)
+{
+  NS_LOG_FUNCTION (this << model);
+  m_model = model;
+  m_tables.clear ();
+}
+
+Ptr<ErrorRateModel>
+TableErrorRateModel::GetErrorRateModel (void) const
+{
+  return m_model;
+}
+
+bool
+TableErrorRateModel::TableKey::operator < (const TableKey &o) const
+{
+  if (mode != o.mode)
+    {
+      return mode < o.mode;
+    }
+  if (channelWidth != o.channelWidth)
+    {
+      return channelWidth < o.channelWidth;
+    }
+  if (shortGuardInterval != o.shortGuardInterval)
+    {
+      return shortGuardInterval < o.shortGuardInterval;
+    }
+  return nss < o.nss;
+}
+
+TableErrorRateModel::TableKey
+TableErrorRateModel::GetKey (WifiMode mode, WifiTxVector txVector)
+{
+  TableKey key;
+  key.mode = mode.GetUid ();
+  key.channelWidth = txVector.GetChannelWidth ();
+  key.shortGuardInterval = txVector.IsShortGuardInterval ();
+  key.nss = txVector.GetNss ();
+  return key;
+}
+
+uint32_t
+TableErrorRateModel::GetNPoints (void) const
+{
+  NS_ASSERT (m_maxSnrDb > m_minSnrDb);
+  return static_cast<uint32_t> (std::floor ((m_maxSnrDb - m_minSnrDb) / m_stepDb + 1e-9)) + 1;
+}
+
+void
+TableErrorRateModel::InitializeTables (void) const
+{
+  if (m_initialized)
+    {
+      return;
+    }
+  m_initialized = true;
+  if (m_model == 0)
+    {
+      m_model = CreateObject<NistErrorRateModel> ();
+    }
+  if (!m_tableFile.empty () && !DoLoad (m_tableFile))
+    {
+      NS_LOG_WARN ("Could not load " << m_tableFile << ", the tables are computed");
+    }
+}
+
+const std::vector<double> &
+TableErrorRateModel::GetTable (WifiMode mode, WifiTxVector txVector) const
+{
+  TableKey key = GetKey (mode, txVector);
+  Tables::iterator i = m_tables.find (key);
+  if (i != m_tables.end ())
+    {
+      return i->second.lnExponents;
+    }
+  NS_LOG_FUNCTION (this << mode << txVector);
+  uint32_t nPoints = GetNPoints ();
+  Table &entry = m_tables[key];
+  entry.mode = mode;
+  std::vector<double> &table = entry.lnExponents;
+  table.reserve (nPoints);
+  for (uint32_t j = 0; j < nPoints; j++)
+    {
+      double snr = std::pow (10.0, (m_minSnrDb + j * m_stepDb) / 10.0);
+      double exponent = -std::log (m_model->GetChunkSuccessRate (mode, txVector, snr, 1));
+      exponent = std::min (std::max (exponent, MIN_EXPONENT), MAX_EXPONENT);
+      table.push_back (std::log (exponent));
+    }
+  return table;
+}
+
+void
+TableErrorRateModel::BuildTable (WifiMode mode, WifiTxVector txVector) const
+{
+  InitializeTables ();
+  GetTable (mode, txVector);
+}
+
+double
+TableErrorRateModel::GetChunkSuccessRate (WifiMode mode, WifiTxVector txVector, double snr, uint32_t nbits) const
+{
+  NS_LOG_FUNCTION (this << mode << txVector.GetMode () << snr << nbits);
+  InitializeTables ();
+  const std::vector<double> &table = GetTable (mode, txVector);
+  double x = (10.0 * std::log10 (snr) - m_minSnrDb) / m_stepDb;
+  if (!(x >= 0) || x >= table.size () - 1)
+    {
+      NS_LOG_LOGIC ("snr out of the tables");
+      return m_model->GetChunkSuccessRate (mode, txVector, snr, nbits);
+    }
+  uint32_t i = static_cast<uint32_t> (x);
+  double lnExponent = table[i] + (x - i) * (table[i + 1] - table[i]);
+  return std::exp (-std::exp (lnExponent) * nbits);
+}
+
+bool
+TableErrorRateModel::Save (std::string filename) const
+{
+  NS_LOG_FUNCTION (this << filename);
+  InitializeTables ();
+  std::ofstream file (filename.c_str (), std::ios::out | std::ios::binary);
+  if (!file)
+    {
+      return false;
+    }
+  file.write ("ns3erate", 8);
+  WriteValue<uint32_t> (file, TABLE_FILE_VERSION);
+  WriteValue<uint32_t> (file, GetNPoints ());
+  WriteValue<double> (file, m_minSnrDb);
+  WriteValue<double> (file, m_stepDb);
+  WriteString (file, m_model->GetInstanceTypeId ().GetName ());
+  WriteValue<uint32_t> (file, m_tables.size ());
+  for (Tables::const_iterator i = m_tables.begin (); i != m_tables.end (); ++i)
+    {
+      std::vector<double> const &table = i->second.lnExponents;
+      WriteString (file, i->second.mode.GetUniqueName ());
+      WriteValue<uint32_t> (file, i->first.channelWidth);
+      WriteValue<uint8_t> (file, i->first.shortGuardInterval);
+      WriteValue<uint8_t> (file, i->first.nss);
+      file.write (reinterpret_cast<const char *> (&table[0]), table.size () * sizeof (double));
+    }
+  file.close ();
+  return !file.fail ();
+}
+
+bool
+TableErrorRateModel::Load (std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  InitializeTables ();
+  return DoLoad (filename);
+}
+
+bool
+TableErrorRateModel::DoLoad (std::string filename) const
+{
+  NS_LOG_FUNCTION (this << filename);
+  std::ifstream file (filename.c_str (), std::ios::in | std::ios::binary);
+  char magic[8];
+  uint32_t version, nPoints, nTables;
+  double minSnrDb, stepDb;
+  std::string modelName;
+  file.read (magic, 8);
+  if (!file || std::string (magic, 8) != "ns3erate"
+      || !ReadValue (file, version) || version != TABLE_FILE_VERSION
+      || !ReadValue (file, nPoints) || !ReadValue (file, minSnrDb) || !ReadValue (file, stepDb)
+      || !ReadString (file, modelName) || !ReadValue (file, nTables))
+    {
+      NS_LOG_WARN (filename << " is not a table file");
+      return false;
+    }
+  if (nPoints != GetNPoints () || minSnrDb != m_minSnrDb || stepDb != m_stepDb
+      || modelName != m_model->GetInstanceTypeId ().GetName ())
+    {
+      NS_LOG_WARN (filename << " was written for " << modelName << " with other SNRs");
+      return false;
+    }
+  Tables tables;
+  for (uint32_t i = 0; i < nTables; i++)
+    {
+      std::string modeName;
+      uint32_t channelWidth;
+      uint8_t shortGuardInterval, nss;
+      if (!ReadString (file, modeName) || !ReadValue (file, channelWidth)
+          || !ReadValue (file, shortGuardInterval) || !ReadValue (file, nss))
+        {
+          NS_LOG_WARN (filename << " is truncated");
+          return false;
+        }
+      WifiMode mode;
+      if (!WifiModeFactory::LookupByNameFailSafe (modeName, &mode))
+        {
+          // the tables are built again for the modes of this build
+          NS_LOG_WARN (filename << " has a table for the unknown mode " << modeName);
+          return false;
+        }
+      TableKey key;
+      key.mode = mode.GetUid ();
+      key.channelWidth = channelWidth;
+      key.shortGuardInterval = shortGuardInterval != 0;
+      key.nss = nss;
+      Table &entry = tables[key];
+      entry.mode = mode;
+      std::vector<double> &table = entry.lnExponents;
+      table.resize (nPoints);
+      file.read (reinterpret_cast<char *> (&table[0]), nPoints * sizeof (double));
+      if (!file)
+        {
+          NS_LOG_WARN (filename << " is truncated");
+          return false;
+        }
+    }
+  for (Tables::const_iterator i = tables.begin (); i != tables.end (); ++i)
+    {
+      m_tables[i->first] = i->second;
+    }
+  return true;
+}
+
+} //namespace ns3
@@ -0,0 +1,172 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TABLE_ERROR_RATE_MODEL_H
+#define TABLE_ERROR_RATE_MODEL_H
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "error-rate-model.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ * \brief an error rate model which interpolates the results of another
+ * error rate model, tabulated over a grid of SNRs
+ *
+ * All the error rate models of this module give a chunk success rate of
+ * the form \f$(1 - p_e(snr))^{nbits}\f$.  For each WifiMode, and each
+ * channel width, guard interval and number of spatial streams it is used
+ * with, this model evaluates the model of its ErrorRateModel attribute
+ * (NistErrorRateModel if none is set) once for each point of a grid of
+ * SNRs in dB, between the MinSnr and MaxSnr attributes, and stores the
+ * logarithm of \f$-\ln(1 - p_e)\f$.  The success rate of a chunk is
+ * then found by linear interpolation in that table, at the cost of a
+ * logarithm and two exponentials.  SNRs outside of the grid are passed
+ * to the tabulated model.
+ *
+ * With the default step of 0.05 dB, the chunk success rates differ from
+ * those of NistErrorRateModel, YansErrorRateModel and DsssErrorRateModel
+ * by less than 1e-3 for all the OFDM, HT, VHT and DSSS modes, and all
+ * the chunk sizes.  The error grows with the square of the step.
+ *
+ * The tables are built the first time a mode is used, or when
+ * BuildTable is called, and the grid attributes must not be changed
+ * afterwards.  They can be saved to, and loaded from, a binary file, to
+ * avoid computing them in each run.
+ */
+class TableErrorRateModel : public ErrorRateModel
+{
+public:
+  static TypeId GetTypeId (void);
+
+  TableErrorRateModel ();
+  virtual ~TableErrorRateModel ();
+
+  /**
+   * \param model the error rate model to tabulate
+   */
+  void SetErrorRateModel (Ptr<ErrorRateModel> model);
+  /**
+   * \return the error rate model tabulated
+   */
+  Ptr<ErrorRateModel> GetErrorRateModel (void) const;
+
+  /**
+   * Build the table of a mode, if it does not exist yet.
+   *
+   * \param mode the Wi-Fi mode
+   * \param txVector the channel width, guard interval and number of
+   *        spatial streams the mode is used with
+   */
+  void BuildTable (WifiMode mode, WifiTxVector txVector) const;
+  /**
+   * Write the tables built so far to a file.
+   *
+   * \param filename the name of the file
+   *
+   * \return true if the file could be written
+   */
+  bool Save (std::string filename) const;
+  /**
+   * Add the tables of a file written by Save.  The file must have been
+   * written for the same error rate model and grid of SNRs.
+   *
+   * \param filename the name of the file
+   *
+   * \return true if the tables of the file were added
+   */
+  bool Load (std::string filename);
+
+  virtual double GetChunkSuccessRate (WifiMode mode, WifiTxVector txVector, double snr, uint32_t nbits) const;
+
+
+private:
+  virtual void DoDispose (void);
+
+  /**
+   * The parameters a table depends on
+   */
+  struct TableKey
+  {
+    uint32_t mode;            //!< uid of the Wi-Fi mode
+    uint32_t channelWidth;    //!< channel width, in MHz
+    bool shortGuardInterval;  //!< whether the short guard interval is used
+    uint8_t nss;              //!< number of spatial streams
+
+    /**
+     * \param o the other key
+     * \return true if this key is ordered before \p o
+     */
+    bool operator < (const TableKey &o) const;
+  };
+  /**
+   * The table of a mode
+   */
+  struct Table
+  {
+    WifiMode mode;                    //!< the Wi-Fi mode
+    std::vector<double> lnExponents;  //!< logarithm of the per-bit error exponent, by SNR
+  };
+  /// The tables, by key
+  typedef std::map<TableKey, Table> Tables;
+
+  /**
+   * \param mode the Wi-Fi mode
+   * \param txVector the TXVECTOR of the transmission
+   *
+   * \return the key of the table of \p mode for \p txVector
+   */
+  static TableKey GetKey (WifiMode mode, WifiTxVector txVector);
+  /**
+   * \return the number of points of the grid of SNRs
+   */
+  uint32_t GetNPoints (void) const;
+  /**
+   * Create the default model if none is set, and load the TableFile
+   * attribute if it is set and was not loaded yet.
+   */
+  void InitializeTables (void) const;
+  /**
+   * \param mode the Wi-Fi mode
+   * \param txVector the TXVECTOR of the transmission
+   *
+   * \return the logarithms of the per-bit error exponents of \p mode
+   *         for \p txVector, built if they do not exist yet
+   */
+  const std::vector<double> & GetTable (WifiMode mode, WifiTxVector txVector) const;
+  /**
+   * \param filename the name of a file written by Save
+   *
+   * \return true if the tables of the file were added
+   */
+  bool DoLoad (std::string filename) const;
+
+  mutable Ptr<ErrorRateModel> m_model; //!< the model tabulated
+  double m_minSnrDb;                   //!< SNR of the first point of the grid, in dB
+  double m_maxSnrDb;                   //!< highest SNR of the grid, in dB
+  double m_stepDb;                     //!< step of the grid, in dB
+  std::string m_tableFile;             //!< file to load the tables from
+  mutable bool m_initialized;          //!< whether InitializeTables was called
+  mutable Tables m_tables;             //!< the tables built or loaded so far
+};
+
+} //namespace ns3
+
+#endif /* TABLE_ERROR_RATE_MODEL_H */
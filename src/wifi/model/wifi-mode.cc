@@ -600,26 +600,39 @@ WifiModeFactory::CreateWifiMcs (std::string uniqueName,
   return WifiMode (uid);
 }
 
-WifiMode
-WifiModeFactory::Search (std::string name)
+bool
+WifiModeFactory::LookupByNameFailSafe (std::string name, WifiMode *mode)
 {
-  WifiModeItemList::const_iterator i;
+  WifiModeFactory *factory = GetFactory ();
   uint32_t j = 0;
-  for (i = m_itemList.begin (); i != m_itemList.end (); i++)
+  for (WifiModeItemList::const_iterator i = factory->m_itemList.begin ();
+       i != factory->m_itemList.end (); i++)
     {
       if (i->uniqueUid == name)
         {
-          return WifiMode (j);
+          *mode = WifiMode (j);
+          return true;
         }
       j++;
     }
+  return false;
+}
+
+WifiMode
+WifiModeFactory::Search (std::string name)
+{
+  WifiMode mode;
+  if (LookupByNameFailSafe (name, &mode))
+    {
+      return mode;
+    }
 
   //If we get here then a matching WifiMode was not found above. This
   //is a fatal problem, but we try to be helpful by displaying the
   //list of WifiModes that are supported.
   NS_LOG_UNCOND ("Could not find match for WifiMode named \""
                  << name << "\". Valid options are:");
-  for (i = m_itemList.begin (); i != m_itemList.end (); i++)
+  for (WifiModeItemList::const_iterator i = m_itemList.begin (); i != m_itemList.end (); i++)
     {
       NS_LOG_UNCOND ("  " << i->uniqueUid);
     }
@@ -281,6 +281,15 @@ public:
   static WifiMode CreateWifiMcs (std::string uniqueName,
                                  uint8_t mcsValue,
                                  enum WifiModulationClass modClass);
+  /**
+   * Get a WifiMode by name, without aborting if there is none.
+   *
+   * \param name the name of the WifiMode
+   * \param mode [out] the WifiMode, if found
+   *
+   * \return true if a WifiMode has this name
+   */
+  static bool LookupByNameFailSafe (std::string name, WifiMode *mode);
 
 
 private:
@@ -26,9 +26,13 @@
 #include "ns3/log.h"
 #include "ns3/pointer.h"
 #include "ns3/object-factory.h"
+#include "ns3/double.h"
 #include "yans-wifi-channel.h"
 #include "ns3/propagation-loss-model.h"
 #include "ns3/propagation-delay-model.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace ns3 {
 
@@ -51,11 +55,43 @@ YansWifiChannel::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&YansWifiChannel::m_delay),
                    MakePointerChecker<PropagationDelayModel> ())
+    .AddAttribute ("MaxRange",
+                   "The distance, in meters, beyond which PHYs do not receive the packets "
+                   "sent on this channel, nor their interference. When set, the PHYs are "
+                   "kept in a grid of cells of this size, so that only the PHYs near "
+                   "the sender are considered.",
+                   DoubleValue (std::numeric_limits<double>::max ()),
+                   MakeDoubleAccessor (&YansWifiChannel::SetMaxRange,
+                                       &YansWifiChannel::GetMaxRange),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("RxSensitivity",
+                   "The received power, in dBm, below which PHYs do not receive the packets "
+                   "sent on this channel, nor their interference.",
+                   DoubleValue (-std::numeric_limits<double>::max ()),
+                   MakeDoubleAccessor (&YansWifiChannel::m_rxSensitivity),
+                   MakeDoubleChecker<double> ())
   ;
   return tid;
 }
 
+bool
+YansWifiChannel::GridCell::operator < (const GridCell &o) const
+{
+  if (x != o.x)
+    {
+      return x < o.x;
+    }
+  if (y != o.y)
+    {
+      return y < o.y;
+    }
+  return z < o.z;
+}
+
 YansWifiChannel::YansWifiChannel ()
+  : m_maxRange (std::numeric_limits<double>::max ()),
+    m_rxSensitivity (-std::numeric_limits<double>::max ()),
+    m_indexValid (false)
 {
 }
 
@@ -65,6 +101,14 @@ YansWifiChannel::~YansWifiChannel ()
   m_phyList.clear ();
 }
 
+void
+YansWifiChannel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  ClearIndex ();
+  WifiChannel::DoDispose ();
+}
+
 void
 YansWifiChannel::SetPropagationLossModel (Ptr<PropagationLossModel> loss)
 {
@@ -77,15 +121,40 @@ YansWifiChannel::SetPropagationDelayModel (Ptr<PropagationDelayModel> delay)
   m_delay = delay;
 }
 
+void
+YansWifiChannel::SetMaxRange (double range)
+{
+  NS_LOG_FUNCTION (this << range);
+  NS_ASSERT (range > 0);
+  m_maxRange = range;
+  ClearIndex ();
+}
+
+double
+YansWifiChannel::GetMaxRange (void) const
+{
+  return m_maxRange;
+}
+
 void
 YansWifiChannel::Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double txPowerDbm,
                        WifiTxVector txVector, WifiPreamble preamble, enum mpduType mpdutype, Time duration) const
 {
   Ptr<MobilityModel> senderMobility = sender->GetMobility ()->GetObject<MobilityModel> ();
   NS_ASSERT (senderMobility != 0);
-  uint32_t j = 0;
-  for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++, j++)
+  bool indexed = HasIndex ();
+  std::vector<uint32_t> candidates;
+  if (indexed)
     {
+      UpdateIndex ();
+      GetCandidates (senderMobility->GetPosition (), candidates);
+    }
+  Ptr<Transmission> transmission;
+  uint32_t n = indexed ? candidates.size () : m_phyList.size ();
+  for (uint32_t k = 0; k < n; k++)
+    {
+      uint32_t j = indexed ? candidates[k] : k;
+      PhyList::const_iterator i = m_phyList.begin () + j;
       if (sender != (*i))
         {
           //For now don't account for inter channel interference
@@ -95,11 +164,28 @@ YansWifiChannel::Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double
             }
 
           Ptr<MobilityModel> receiverMobility = (*i)->GetMobility ()->GetObject<MobilityModel> ();
+          if (indexed && senderMobility->GetDistanceFrom (receiverMobility) > m_maxRange)
+            {
+              continue;
+            }
           Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
           double rxPowerDbm = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
           NS_LOG_DEBUG ("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
                         "distance=" << senderMobility->GetDistanceFrom (receiverMobility) << "m, delay=" << delay);
-          Ptr<Packet> copy = packet->Copy ();
+          if (rxPowerDbm < m_rxSensitivity)
+            {
+              continue;
+            }
+          if (transmission == 0)
+            {
+              transmission = Create<Transmission> ();
+              transmission->packet = packet->Copy ();
+              transmission->type = mpdutype;
+              transmission->duration = duration;
+              transmission->txVector = txVector;
+              transmission->preamble = preamble;
+            }
+          transmission->receivers.push_back (std::make_pair (j, rxPowerDbm));
           Ptr<Object> dstNetDevice = m_phyList[j]->GetDevice ();
           uint32_t dstNode;
           if (dstNetDevice == 0)
@@ -111,24 +197,19 @@ YansWifiChannel::Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double
               dstNode = dstNetDevice->GetObject<NetDevice> ()->GetNode ()->GetId ();
             }
 
-          struct Parameters parameters;
-          parameters.rxPowerDbm = rxPowerDbm;
-          parameters.type = mpdutype;
-          parameters.duration = duration;
-          parameters.txVector = txVector;
-          parameters.preamble = preamble;
-
           Simulator::ScheduleWithContext (dstNode,
                                           delay, &YansWifiChannel::Receive, this,
-                                          j, copy, parameters);
+                                          transmission, transmission->receivers.size () - 1);
         }
     }
 }
 
 void
-YansWifiChannel::Receive (uint32_t i, Ptr<Packet> packet, struct Parameters parameters) const
+YansWifiChannel::Receive (Ptr<const Transmission> transmission, uint32_t k) const
 {
-  m_phyList[i]->StartReceivePreambleAndHeader (packet, parameters.rxPowerDbm, parameters.txVector, parameters.preamble, parameters.type, parameters.duration);
+  const std::pair<uint32_t, double> &receiver = transmission->receivers[k];
+  m_phyList[receiver.first]->StartReceivePreambleAndHeader (transmission->packet, receiver.second, transmission->txVector,
+                                                            transmission->preamble, transmission->type, transmission->duration);
 }
 
 uint32_t
@@ -147,6 +228,143 @@ void
 YansWifiChannel::Add (Ptr<YansWifiPhy> phy)
 {
   m_phyList.push_back (phy);
+  m_indexValid = false;
+}
+
+bool
+YansWifiChannel::HasIndex (void) const
+{
+  return m_maxRange < std::numeric_limits<double>::max ();
+}
+
+void
+YansWifiChannel::UpdateIndex (void) const
+{
+  if (m_indexValid)
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this);
+  ClearIndex ();
+  m_inGrid.resize (m_phyList.size (), false);
+  m_cells.resize (m_phyList.size ());
+  for (uint32_t i = 0; i < m_phyList.size (); i++)
+    {
+      Ptr<MobilityModel> mobility = m_phyList[i]->GetMobility ();
+      if (mobility == 0)
+        {
+          // the mobility model may be aggregated later: check this PHY
+          // on each transmission.
+          m_unindexed.insert (i);
+          continue;
+        }
+      std::vector<uint32_t> &phys = m_mobilityPhys[mobility];
+      if (phys.empty ())
+        {
+          mobility->TraceConnectWithoutContext ("CourseChange",
+                                                MakeCallback (&YansWifiChannel::CourseChanged, this));
+        }
+      phys.push_back (i);
+      IndexPhy (i, mobility);
+    }
+  m_indexValid = true;
+}
+
+void
+YansWifiChannel::ClearIndex (void) const
+{
+  NS_LOG_FUNCTION (this);
+  for (MobilityPhys::const_iterator i = m_mobilityPhys.begin (); i != m_mobilityPhys.end (); ++i)
+    {
+      ConstCast<MobilityModel> (i->first)->TraceDisconnectWithoutContext ("CourseChange",
+                                                                         MakeCallback (&YansWifiChannel::CourseChanged, this));
+    }
+  m_mobilityPhys.clear ();
+  m_grid.clear ();
+  m_unindexed.clear ();
+  m_inGrid.clear ();
+  m_cells.clear ();
+  m_indexValid = false;
+}
+
+void
+YansWifiChannel::IndexPhy (uint32_t i, Ptr<const MobilityModel> mobility) const
+{
+  NS_LOG_FUNCTION (this << i << mobility);
+  if (m_inGrid[i])
+    {
+      Grid::iterator cell = m_grid.find (m_cells[i]);
+      NS_ASSERT (cell != m_grid.end ());
+      cell->second.erase (std::find (cell->second.begin (), cell->second.end (), i));
+      if (cell->second.empty ())
+        {
+          m_grid.erase (cell);
+        }
+      m_inGrid[i] = false;
+    }
+  else
+    {
+      m_unindexed.erase (i);
+    }
+  Vector velocity = mobility->GetVelocity ();
+  if (velocity.x != 0 || velocity.y != 0 || velocity.z != 0)
+    {
+      // the position of a moving PHY is only known when asked for.
+      m_unindexed.insert (i);
+      return;
+    }
+  m_cells[i] = GetCell (mobility->GetPosition ());
+  m_grid[m_cells[i]].push_back (i);
+  m_inGrid[i] = true;
+}
+
+void
+YansWifiChannel::CourseChanged (Ptr<const MobilityModel> mobility) const
+{
+  NS_LOG_FUNCTION (this << mobility);
+  MobilityPhys::const_iterator found = m_mobilityPhys.find (mobility);
+  NS_ASSERT (found != m_mobilityPhys.end ());
+  for (std::vector<uint32_t>::const_iterator i = found->second.begin (); i != found->second.end (); ++i)
+    {
+      IndexPhy (*i, mobility);
+    }
+}
+
+YansWifiChannel::GridCell
+YansWifiChannel::GetCell (const Vector &position) const
+{
+  GridCell cell;
+  cell.x = static_cast<int64_t> (std::floor (position.x / m_maxRange));
+  cell.y = static_cast<int64_t> (std::floor (position.y / m_maxRange));
+  cell.z = static_cast<int64_t> (std::floor (position.z / m_maxRange));
+  return cell;
+}
+
+void
+YansWifiChannel::GetCandidates (const Vector &position, std::vector<uint32_t> &candidates) const
+{
+  // the cells are MaxRange wide: the PHYs within MaxRange of the
+  // sender are in the cell of the sender or in one of its neighbours.
+  candidates.assign (m_unindexed.begin (), m_unindexed.end ());
+  GridCell center = GetCell (position);
+  GridCell cell;
+  for (cell.x = center.x - 1; cell.x <= center.x + 1; cell.x++)
+    {
+      for (cell.y = center.y - 1; cell.y <= center.y + 1; cell.y++)
+        {
+          for (cell.z = center.z - 1; cell.z <= center.z + 1; cell.z++)
+            {
+              Grid::const_iterator found = m_grid.find (cell);
+              if (found != m_grid.end ())
+                {
+                  candidates.insert (candidates.end (), found->second.begin (), found->second.end ());
+                }
+            }
+        }
+    }
+  // keep the order of the PHY list, so that the receptions are scheduled
+  // in the same order as without the grid.
+  std::sort (candidates.begin (), candidates.end ());
 }
 
 int64_t
@@ -22,6 +22,8 @@
 #define YANS_WIFI_CHANNEL_H
 
 #include <vector>
+#include <map>
+#include <set>
 #include <stdint.h>
 #include "ns3/packet.h"
 #include "wifi-channel.h"
@@ -30,21 +32,15 @@
 #include "wifi-tx-vector.h"
 #include "yans-wifi-phy.h"
 #include "ns3/nstime.h"
+#include "ns3/vector.h"
+#include "ns3/simple-ref-count.h"
 
 namespace ns3 {
 
 class NetDevice;
 class PropagationLossModel;
 class PropagationDelayModel;
-
-struct Parameters
-{
-  double rxPowerDbm;
-  enum mpduType type;
-  Time duration;
-  WifiTxVector txVector;
-  WifiPreamble preamble;
-};
+class MobilityModel;
 
 /**
  * \brief A Yans wifi channel
@@ -57,6 +53,22 @@ struct Parameters
  * class and contains a ns3::PropagationLossModel and a ns3::PropagationDelayModel.
  * By default, no propagation models are set so, it is the caller's responsability
  * to set them before using the channel.
+ *
+ * Two optional cutoffs reduce the cost of a transmission in large
+ * scenarios, at the price of ignoring the interference of faint signals:
+ *   - the MaxRange attribute skips the receivers further away from the
+ *     sender, before their propagation loss and delay are computed.  The
+ *     receivers which do not move are then kept in a uniform grid of
+ *     MaxRange wide cells, updated on the CourseChange notifications of
+ *     their mobility models, so that only the receivers of the cells
+ *     around the sender are considered;
+ *   - the RxSensitivity attribute skips the receivers whose received
+ *     power is lower, without copying the packet nor scheduling its
+ *     reception.
+ *
+ * All the receivers of a packet share a single copy of it, and the
+ * parameters of its transmission.  Each YansWifiPhy only copies the
+ * packet again if it receives it to the end.
  */
 class YansWifiChannel : public WifiChannel
 {
@@ -85,6 +97,16 @@ public:
    * \param delay the new propagation delay model.
    */
   void SetPropagationDelayModel (Ptr<PropagationDelayModel> delay);
+  /**
+   * \param range the distance, in meters, beyond which PHYs do not
+   *        receive the packets sent on this channel.
+   */
+  void SetMaxRange (double range);
+  /**
+   * \returns the distance, in meters, beyond which PHYs do not receive
+   *          the packets sent on this channel.
+   */
+  double GetMaxRange (void) const;
 
   /**
    * \param sender the device from which the packet is originating.
@@ -121,22 +143,109 @@ private:
    */
   typedef std::vector<Ptr<YansWifiPhy> > PhyList;
 
+  /**
+   * The coordinates of a cell of the grid of PHYs.
+   */
+  struct GridCell
+  {
+    int64_t x;  //!< Index along the x axis
+    int64_t y;  //!< Index along the y axis
+    int64_t z;  //!< Index along the z axis
+
+    /**
+     * \param o the other cell
+     * \returns true if this cell comes before \p o
+     */
+    bool operator < (const GridCell &o) const;
+  };
+
+  /**
+   * The indexes of the PHYs in each cell of the grid.
+   */
+  typedef std::map<GridCell, std::vector<uint32_t> > Grid;
+
+  /**
+   * The indexes of the PHYs of each mobility model.
+   */
+  typedef std::map<Ptr<const MobilityModel>, std::vector<uint32_t> > MobilityPhys;
+
+  virtual void DoDispose (void);
+
+  /**
+   * \returns true if the PHYs are kept in a grid.
+   */
+  bool HasIndex (void) const;
+  /**
+   * Put all the PHYs in the grid if it is out of date.
+   */
+  void UpdateIndex (void) const;
+  /**
+   * Forget the grid, and disconnect from the mobility models.
+   */
+  void ClearIndex (void) const;
+  /**
+   * Move a PHY to the cell of its position, or to the list of the
+   * PHYs checked on each transmission if it is moving.
+   *
+   * \param i index of the PHY in the PHY list
+   * \param mobility the mobility model of the PHY
+   */
+  void IndexPhy (uint32_t i, Ptr<const MobilityModel> mobility) const;
+  /**
+   * Update the place in the grid of the PHYs of a mobility model.
+   *
+   * \param mobility the mobility model whose course changed
+   */
+  void CourseChanged (Ptr<const MobilityModel> mobility) const;
+  /**
+   * \param position a position
+   * \returns the cell of the grid holding \p position
+   */
+  GridCell GetCell (const Vector &position) const;
+  /**
+   * \param position the position of the sender
+   * \param candidates [out] the sorted indexes of the PHYs which may be
+   *        within MaxRange of \p position
+   */
+  void GetCandidates (const Vector &position, std::vector<uint32_t> &candidates) const;
+
+  /**
+   * A packet sent on the channel, shared by all its receivers.
+   */
+  class Transmission : public SimpleRefCount<Transmission>
+  {
+  public:
+    Ptr<const Packet> packet;   //!< The copy of the packet shared by the receivers
+    enum mpduType type;         //!< The type of the MPDU
+    Time duration;              //!< The transmission duration
+    WifiTxVector txVector;      //!< The TXVECTOR of the packet
+    WifiPreamble preamble;      //!< The preamble of the packet
+    /// The index in the PHY list and the received power, in dBm, of each receiver
+    std::vector<std::pair<uint32_t, double> > receivers;
+  };
+
   /**
    * This method is scheduled by Send for each associated YansWifiPhy.
    * The method then calls the corresponding YansWifiPhy that the first
    * bit of the packet has arrived.
    *
-   * \param i index of the corresponding YansWifiPhy in the PHY list
-   * \param packet the packet being sent
-   * \param atts a vector containing the received power in dBm and the packet type
-   * \param txVector the TXVECTOR of the packet
-   * \param preamble the type of preamble being used to send the packet
+   * \param transmission the packet being sent, and its receivers
+   * \param k index of the receiver in the receivers of \p transmission
    */
-  void Receive (uint32_t i, Ptr<Packet> packet, struct Parameters parameters) const;
+  void Receive (Ptr<const Transmission> transmission, uint32_t k) const;
 
   PhyList m_phyList;                   //!< List of YansWifiPhys connected to this YansWifiChannel
   Ptr<PropagationLossModel> m_loss;    //!< Propagation loss model
   Ptr<PropagationDelayModel> m_delay;  //!< Propagation delay model
+  double m_maxRange;                   //!< Distance beyond which PHYs do not receive
+  double m_rxSensitivity;              //!< Power, in dBm, below which PHYs do not receive
+
+  mutable bool m_indexValid;                 //!< Whether the grid holds all the PHYs
+  mutable Grid m_grid;                       //!< The PHYs which do not move, by cell
+  mutable std::set<uint32_t> m_unindexed;    //!< The PHYs checked on each transmission
+  mutable std::vector<bool> m_inGrid;        //!< Whether each PHY is in the grid
+  mutable std::vector<GridCell> m_cells;     //!< The cell of each PHY in the grid
+  mutable MobilityPhys m_mobilityPhys;       //!< The PHYs of the mobility models connected to
 };
 
 } //namespace ns3
@@ -19,10 +19,16 @@
  */
 
 #include <cmath>
+#include <sstream>
+#include <fstream>
+#include <iterator>
 #include "ns3/test.h"
 #include "ns3/dsss-error-rate-model.h"
 #include "ns3/yans-error-rate-model.h"
 #include "ns3/nist-error-rate-model.h"
+#include "ns3/table-error-rate-model.h"
+#include "ns3/double.h"
+#include "ns3/string.h"
 
 using namespace ns3;
 
@@ -279,6 +285,147 @@ WifiErrorRateModelsTestCaseNist::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ_TOL (ps, 0.999, 0.001, "Not equal within tolerance");
 }
 
+class WifiErrorRateModelsTestCaseTable : public TestCase
+{
+public:
+  WifiErrorRateModelsTestCaseTable ();
+  virtual ~WifiErrorRateModelsTestCaseTable ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \param reference the analytic model
+   * \param table the model tabulating \p reference
+   * \param mode the Wi-Fi mode
+   * \param txVector the TXVECTOR of the transmission
+   *
+   * \return the largest difference between the chunk success rates of
+   *         the two models, over SNRs and chunk sizes
+   */
+  double GetMaxError (Ptr<ErrorRateModel> reference, Ptr<ErrorRateModel> table,
+                      WifiMode mode, WifiTxVector txVector);
+};
+
+WifiErrorRateModelsTestCaseTable::WifiErrorRateModelsTestCaseTable ()
+  : TestCase ("WifiErrorRateModel test case Table")
+{
+}
+
+WifiErrorRateModelsTestCaseTable::~WifiErrorRateModelsTestCaseTable ()
+{
+}
+
+double
+WifiErrorRateModelsTestCaseTable::GetMaxError (Ptr<ErrorRateModel> reference, Ptr<ErrorRateModel> table,
+                                               WifiMode mode, WifiTxVector txVector)
+{
+  static const uint32_t nbits[] = { 8, 1000, 16000 };
+  double maxError = 0;
+  for (double snr = -12.0; snr < 52.0; snr += 0.0137)
+    {
+      for (uint32_t i = 0; i < sizeof (nbits) / sizeof (nbits[0]); i++)
+        {
+          double ratio = std::pow (10.0, snr / 10.0);
+          double error = std::fabs (reference->GetChunkSuccessRate (mode, txVector, ratio, nbits[i])
+                                    - table->GetChunkSuccessRate (mode, txVector, ratio, nbits[i]));
+          maxError = std::max (maxError, error);
+        }
+    }
+  return maxError;
+}
+
+void
+WifiErrorRateModelsTestCaseTable::DoRun (void)
+{
+  // the tolerance documented by TableErrorRateModel
+  double tolerance = 1e-3;
+  std::vector<std::pair<std::string, uint32_t> > modes;
+  const char *legacy[] = { "DsssRate1Mbps", "DsssRate2Mbps", "DsssRate5_5Mbps", "DsssRate11Mbps",
+                           "OfdmRate6Mbps", "OfdmRate9Mbps", "OfdmRate12Mbps", "OfdmRate18Mbps",
+                           "OfdmRate24Mbps", "OfdmRate36Mbps", "OfdmRate48Mbps", "OfdmRate54Mbps" };
+  for (uint32_t i = 0; i < sizeof (legacy) / sizeof (legacy[0]); i++)
+    {
+      modes.push_back (std::make_pair (std::string (legacy[i]), 20));
+    }
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      std::ostringstream oss;
+      oss << "HtMcs" << i;
+      modes.push_back (std::make_pair (oss.str (), 40));
+    }
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      std::ostringstream oss;
+      oss << "VhtMcs" << i;
+      modes.push_back (std::make_pair (oss.str (), 80));
+    }
+
+  Ptr<ErrorRateModel> references[] = { CreateObject<NistErrorRateModel> (), CreateObject<YansErrorRateModel> () };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<TableErrorRateModel> table = CreateObject<TableErrorRateModel> ();
+      table->SetErrorRateModel (references[i]);
+      for (uint32_t j = 0; j < modes.size (); j++)
+        {
+          WifiMode mode (modes[j].first);
+          WifiTxVector txVector;
+          txVector.SetMode (mode);
+          txVector.SetChannelWidth (modes[j].second);
+          double error = GetMaxError (references[i], table, mode, txVector);
+          NS_TEST_EXPECT_MSG_LT (error, tolerance, "Table of " << references[i]->GetInstanceTypeId ().GetName ()
+                                 << " too far for " << mode);
+        }
+    }
+
+  // tables saved to a file are loaded for the same model and grid only
+  std::string filename = CreateTempDirFilename ("tables.bin");
+  WifiMode mode ("OfdmRate24Mbps");
+  WifiTxVector txVector;
+  txVector.SetMode (mode);
+  Ptr<TableErrorRateModel> saved = CreateObject<TableErrorRateModel> ();
+  saved->SetAttribute ("SnrStep", DoubleValue (0.5));
+  saved->BuildTable (mode, txVector);
+  NS_TEST_ASSERT_MSG_EQ (saved->Save (filename), true, "Could not write " << filename);
+
+  Ptr<TableErrorRateModel> loaded = CreateObject<TableErrorRateModel> ();
+  loaded->SetAttribute ("SnrStep", DoubleValue (0.5));
+  loaded->SetAttribute ("TableFile", StringValue (filename));
+  // tables are loaded before use, so that a model which does not match
+  // the file would compute them again
+  loaded->SetErrorRateModel (CreateObject<YansErrorRateModel> ());
+  double snr = std::pow (10.0, 12.3 / 10.0);
+  NS_TEST_EXPECT_MSG_NE (loaded->GetChunkSuccessRate (mode, txVector, snr, 1000),
+                         saved->GetChunkSuccessRate (mode, txVector, snr, 1000),
+                         "Tables of NistErrorRateModel should not be loaded for YansErrorRateModel");
+
+  loaded = CreateObject<TableErrorRateModel> ();
+  loaded->SetAttribute ("SnrStep", DoubleValue (0.5));
+  NS_TEST_EXPECT_MSG_EQ (loaded->Load (filename), true, "Could not load " << filename);
+  NS_TEST_EXPECT_MSG_EQ (loaded->GetChunkSuccessRate (mode, txVector, snr, 1000),
+                         saved->GetChunkSuccessRate (mode, txVector, snr, 1000),
+                         "Loaded tables differ from the saved ones");
+
+  loaded = CreateObject<TableErrorRateModel> ();
+  NS_TEST_EXPECT_MSG_EQ (loaded->Load (filename), false, "Tables of another grid should not be loaded");
+
+  // a file with the table of a mode unknown to this build is not loaded
+  std::ifstream in (filename.c_str (), std::ios::in | std::ios::binary);
+  std::string content ((std::istreambuf_iterator<char> (in)), std::istreambuf_iterator<char> ());
+  in.close ();
+  std::string::size_type position = content.find (mode.GetUniqueName ());
+  NS_TEST_ASSERT_MSG_NE (position, std::string::npos, "No table for " << mode << " in " << filename);
+  content.replace (position, mode.GetUniqueName ().size (), "OfdmRate99Mbps");
+  std::ofstream out (filename.c_str (), std::ios::out | std::ios::binary);
+  out << content;
+  out.close ();
+  loaded = CreateObject<TableErrorRateModel> ();
+  loaded->SetAttribute ("SnrStep", DoubleValue (0.5));
+  NS_TEST_EXPECT_MSG_EQ (loaded->Load (filename), false, "Tables of an unknown mode should not be loaded");
+  NS_TEST_EXPECT_MSG_EQ (loaded->GetChunkSuccessRate (mode, txVector, snr, 1000),
+                         saved->GetChunkSuccessRate (mode, txVector, snr, 1000),
+                         "Tables should be built again");
+}
+
 class WifiErrorRateModelsTestSuite : public TestSuite
 {
 public:
@@ -290,6 +437,7 @@ WifiErrorRateModelsTestSuite::WifiErrorRateModelsTestSuite ()
 {
   AddTestCase (new WifiErrorRateModelsTestCaseDsss, TestCase::QUICK);
   AddTestCase (new WifiErrorRateModelsTestCaseNist, TestCase::QUICK);
+  AddTestCase (new WifiErrorRateModelsTestCaseTable, TestCase::QUICK);
 }
 
 static WifiErrorRateModelsTestSuite wifiErrorRateModelsTestSuite;
@@ -28,7 +28,11 @@
 #include "ns3/propagation-delay-model.h"
 #include "ns3/propagation-loss-model.h"
 #include "ns3/yans-error-rate-model.h"
+#include "ns3/nist-error-rate-model.h"
+#include "ns3/interference-helper.h"
 #include "ns3/constant-position-mobility-model.h"
+#include "ns3/constant-velocity-mobility-model.h"
+#include "ns3/double.h"
 #include "ns3/test.h"
 #include "ns3/pointer.h"
 #include "ns3/rng-seed-manager.h"
@@ -1090,6 +1094,373 @@ Bug2222TestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (m_countInternalCollisions, 1, "unexpected number of internal collisions!");
 }
 
+//-----------------------------------------------------------------------------
+/**
+ * Install 802.11a ad hoc devices on nodes, connected to a channel on which
+ * every packet is received at -60 dBm, and give the first nodes fixed
+ * positions.
+ *
+ * \param nodes the nodes
+ * \param channel the channel, whose propagation models are set here
+ * \param positions the positions of the first nodes, in order
+ * \return the devices installed
+ */
+static NetDeviceContainer
+CreateAdhocNetwork (NodeContainer nodes, Ptr<YansWifiChannel> channel, std::vector<Vector> const &positions)
+{
+  channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+  Ptr<FixedRssLossModel> loss = CreateObject<FixedRssLossModel> ();
+  loss->SetRss (-60);
+  channel->SetPropagationLossModel (loss);
+  YansWifiPhyHelper phy = YansWifiPhyHelper::Default ();
+  phy.SetChannel (channel);
+
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211a);
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager");
+  WifiMacHelper mac;
+  mac.SetType ("ns3::AdhocWifiMac");
+  NetDeviceContainer devices = wifi.Install (phy, mac, nodes);
+
+  MobilityHelper mobility;
+  Ptr<ListPositionAllocator> positionAlloc = CreateObject<ListPositionAllocator> ();
+  NodeContainer placed;
+  for (uint32_t i = 0; i < positions.size (); i++)
+    {
+      positionAlloc->Add (positions[i]);
+      placed.Add (nodes.Get (i));
+    }
+  mobility.SetPositionAllocator (positionAlloc);
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (placed);
+  return devices;
+}
+
+/**
+ * \param context the context of a trace source of a node, /NodeList/<id>/...
+ * \return the id of the node
+ */
+static uint32_t
+GetNodeIdFromContext (std::string const &context)
+{
+  return atoi (context.c_str () + std::string ("/NodeList/").size ());
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Make sure that YansWifiChannel only delivers packets to the PHYs within
+ * its MaxRange, as they move, and above its RxSensitivity.
+ */
+
+class YansWifiChannelCullingTestCase : public TestCase
+{
+public:
+  YansWifiChannelCullingTestCase ();
+  virtual ~YansWifiChannelCullingTestCase ();
+
+  virtual void DoRun (void);
+
+
+private:
+  std::vector<uint32_t> m_rxBegin; //!< number of receptions started, by node
+
+  /**
+   * Send two broadcast packets from node 0, at 1 and 10 seconds, while
+   * node 2 jumps from 500 to 20 meters and node 3 drives in from 1050 meters.
+   *
+   * \param maxRange the MaxRange of the channel
+   * \param rxSensitivity the RxSensitivity of the channel
+   */
+  void RunOne (double maxRange, double rxSensitivity);
+  void SendOnePacket (Ptr<NetDevice> dev);
+  void RxBeginTrace (std::string context, Ptr<const Packet> p);
+};
+
+YansWifiChannelCullingTestCase::YansWifiChannelCullingTestCase ()
+  : TestCase ("Test case for the culling of receivers by YansWifiChannel")
+{
+}
+
+YansWifiChannelCullingTestCase::~YansWifiChannelCullingTestCase ()
+{
+}
+
+void
+YansWifiChannelCullingTestCase::SendOnePacket (Ptr<NetDevice> dev)
+{
+  dev->Send (Create<Packet> (100), dev->GetBroadcast (), 1);
+}
+
+void
+YansWifiChannelCullingTestCase::RxBeginTrace (std::string context, Ptr<const Packet> p)
+{
+  m_rxBegin[GetNodeIdFromContext (context)]++;
+}
+
+void
+YansWifiChannelCullingTestCase::RunOne (double maxRange, double rxSensitivity)
+{
+  m_rxBegin.assign (4, 0);
+  NodeContainer nodes;
+  nodes.Create (4);
+
+  Ptr<YansWifiChannel> channel = CreateObject<YansWifiChannel> ();
+  channel->SetAttribute ("MaxRange", DoubleValue (maxRange));
+  channel->SetAttribute ("RxSensitivity", DoubleValue (rxSensitivity));
+  std::vector<Vector> positions;
+  positions.push_back (Vector (0.0, 0.0, 0.0));
+  positions.push_back (Vector (50.0, 0.0, 0.0));
+  positions.push_back (Vector (500.0, 0.0, 0.0));
+  NetDeviceContainer devices = CreateAdhocNetwork (nodes, channel, positions);
+  Ptr<ConstantVelocityMobilityModel> driving = CreateObject<ConstantVelocityMobilityModel> ();
+  driving->SetPosition (Vector (1050.0, 0.0, 0.0));
+  driving->SetVelocity (Vector (-100.0, 0.0, 0.0));
+  nodes.Get (3)->AggregateObject (driving);
+
+  Ptr<MobilityModel> jumping = nodes.Get (2)->GetObject<MobilityModel> ();
+  Simulator::Schedule (Seconds (5.0), &MobilityModel::SetPosition, jumping, Vector (20.0, 0.0, 0.0));
+  Simulator::Schedule (Seconds (1.0), &YansWifiChannelCullingTestCase::SendOnePacket, this, devices.Get (0));
+  Simulator::Schedule (Seconds (10.0), &YansWifiChannelCullingTestCase::SendOnePacket, this, devices.Get (0));
+
+  Config::Connect ("/NodeList/*/DeviceList/*/Phy/PhyRxBegin",
+                   MakeCallback (&YansWifiChannelCullingTestCase::RxBeginTrace, this));
+
+  Simulator::Stop (Seconds (11.0));
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+YansWifiChannelCullingTestCase::DoRun (void)
+{
+  RunOne (std::numeric_limits<double>::max (), -std::numeric_limits<double>::max ());
+  NS_TEST_EXPECT_MSG_EQ (m_rxBegin[1], 2, "without cutoff, every packet should be received");
+  NS_TEST_EXPECT_MSG_EQ (m_rxBegin[2], 2, "without cutoff, every packet should be received");
+  NS_TEST_EXPECT_MSG_EQ (m_rxBegin[3], 2, "without cutoff, every packet should be received");
+
+  RunOne (100.0, -std::numeric_limits<double>::max ());
+  NS_TEST_EXPECT_MSG_EQ (m_rxBegin[0], 0, "the sender should not receive its packets");
+  NS_TEST_EXPECT_MSG_EQ (m_rxBegin[1], 2, "node 1 is always in range");
+  NS_TEST_EXPECT_MSG_EQ (m_rxBegin[2], 1, "node 2 is only in range after its jump");
+  NS_TEST_EXPECT_MSG_EQ (m_rxBegin[3], 1, "node 3 is only in range at 10 seconds");
+
+  RunOne (100.0, -50.0);
+  NS_TEST_EXPECT_MSG_EQ (m_rxBegin[1], 0, "packets below the sensitivity should not be received");
+  NS_TEST_EXPECT_MSG_EQ (m_rxBegin[2], 0, "packets below the sensitivity should not be received");
+  NS_TEST_EXPECT_MSG_EQ (m_rxBegin[3], 0, "packets below the sensitivity should not be received");
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Make sure that the receivers of a packet sent on a YansWifiChannel,
+ * which share a single copy of it, each pass their own copy to their MAC.
+ */
+
+class YansWifiChannelSharedPacketTestCase : public TestCase
+{
+public:
+  YansWifiChannelSharedPacketTestCase ();
+  virtual ~YansWifiChannelSharedPacketTestCase ();
+
+  virtual void DoRun (void);
+
+
+private:
+  std::vector<Ptr<const Packet> > m_rxBegin; //!< packet of the last reception started, by node
+  std::vector<Ptr<const Packet> > m_macRx;   //!< packet of the last MAC reception, by node
+  uint64_t m_uid;                            //!< uid of the packet sent
+
+  void SendOnePacket (Ptr<NetDevice> dev);
+  void RxBeginTrace (std::string context, Ptr<const Packet> p);
+  void MacRxTrace (std::string context, Ptr<const Packet> p);
+};
+
+YansWifiChannelSharedPacketTestCase::YansWifiChannelSharedPacketTestCase ()
+  : TestCase ("Test case for the packet shared by the receivers of YansWifiChannel"),
+    m_uid (0)
+{
+}
+
+YansWifiChannelSharedPacketTestCase::~YansWifiChannelSharedPacketTestCase ()
+{
+}
+
+void
+YansWifiChannelSharedPacketTestCase::SendOnePacket (Ptr<NetDevice> dev)
+{
+  Ptr<Packet> p = Create<Packet> (100);
+  m_uid = p->GetUid ();
+  dev->Send (p, dev->GetBroadcast (), 1);
+}
+
+void
+YansWifiChannelSharedPacketTestCase::RxBeginTrace (std::string context, Ptr<const Packet> p)
+{
+  m_rxBegin[GetNodeIdFromContext (context)] = p;
+}
+
+void
+YansWifiChannelSharedPacketTestCase::MacRxTrace (std::string context, Ptr<const Packet> p)
+{
+  m_macRx[GetNodeIdFromContext (context)] = p;
+}
+
+void
+YansWifiChannelSharedPacketTestCase::DoRun (void)
+{
+  m_rxBegin.assign (3, 0);
+  m_macRx.assign (3, 0);
+  NodeContainer nodes;
+  nodes.Create (3);
+
+  std::vector<Vector> positions;
+  positions.push_back (Vector (0.0, 0.0, 0.0));
+  positions.push_back (Vector (10.0, 0.0, 0.0));
+  positions.push_back (Vector (50.0, 0.0, 0.0));
+  NetDeviceContainer devices = CreateAdhocNetwork (nodes, CreateObject<YansWifiChannel> (), positions);
+
+  Simulator::Schedule (Seconds (1.0), &YansWifiChannelSharedPacketTestCase::SendOnePacket, this, devices.Get (0));
+
+  Config::Connect ("/NodeList/*/DeviceList/*/Phy/PhyRxBegin",
+                   MakeCallback (&YansWifiChannelSharedPacketTestCase::RxBeginTrace, this));
+  Config::Connect ("/NodeList/*/DeviceList/*/Mac/MacRx",
+                   MakeCallback (&YansWifiChannelSharedPacketTestCase::MacRxTrace, this));
+
+  Simulator::Stop (Seconds (2.0));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_NE (m_rxBegin[1], 0, "node 1 should start receiving the packet");
+  NS_TEST_ASSERT_MSG_NE (m_rxBegin[2], 0, "node 2 should start receiving the packet");
+  NS_TEST_EXPECT_MSG_EQ (m_rxBegin[1], m_rxBegin[2], "the receivers should share the packet");
+  NS_TEST_ASSERT_MSG_NE (m_macRx[1], 0, "node 1 should receive the packet");
+  NS_TEST_ASSERT_MSG_NE (m_macRx[2], 0, "node 2 should receive the packet");
+  NS_TEST_EXPECT_MSG_NE (m_macRx[1], m_macRx[2], "each MAC should get its own copy");
+  NS_TEST_EXPECT_MSG_NE (m_macRx[1], m_rxBegin[1], "each MAC should get its own copy");
+  NS_TEST_EXPECT_MSG_EQ (m_macRx[1]->GetUid (), m_uid, "the copies should keep the uid of the packet");
+  NS_TEST_EXPECT_MSG_EQ (m_macRx[2]->GetUid (), m_uid, "the copies should keep the uid of the packet");
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Make sure that InterferenceHelper computes the energy duration and the
+ * SNR and PER of a reception from the signals which overlap it, once
+ * many signals have come and gone on the medium.
+ */
+
+class InterferenceHelperLedgerTestCase : public TestCase
+{
+public:
+  InterferenceHelperLedgerTestCase ();
+  virtual ~InterferenceHelperLedgerTestCase ();
+
+  virtual void DoRun (void);
+
+
+private:
+  InterferenceHelper m_interference;           //!< interference helper under test
+  Ptr<InterferenceHelper::Event> m_event;      //!< event being received
+
+  void AddSignal (Time duration, double rxPowerW);
+  void CheckEnergyDuration (double energyW, Time expected);
+  void StartReceive (Time duration, double rxPowerW);
+  void EndReceive (double expectedSnr, bool success);
+};
+
+InterferenceHelperLedgerTestCase::InterferenceHelperLedgerTestCase ()
+  : TestCase ("Test case for the interference ledger of InterferenceHelper")
+{
+}
+
+InterferenceHelperLedgerTestCase::~InterferenceHelperLedgerTestCase ()
+{
+}
+
+void
+InterferenceHelperLedgerTestCase::AddSignal (Time duration, double rxPowerW)
+{
+  m_interference.AddForeignSignal (duration, rxPowerW);
+}
+
+void
+InterferenceHelperLedgerTestCase::CheckEnergyDuration (double energyW, Time expected)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_interference.GetEnergyDuration (energyW), expected,
+                         "unexpected energy duration at " << Simulator::Now ());
+}
+
+void
+InterferenceHelperLedgerTestCase::StartReceive (Time duration, double rxPowerW)
+{
+  WifiTxVector txVector;
+  txVector.SetMode (WifiPhy::GetOfdmRate6Mbps ());
+  txVector.SetChannelWidth (20);
+  txVector.SetNss (1);
+  m_event = m_interference.Add (750, txVector, WIFI_PREAMBLE_LONG, duration, rxPowerW);
+  m_interference.NotifyRxStart ();
+}
+
+void
+InterferenceHelperLedgerTestCase::EndReceive (double expectedSnr, bool success)
+{
+  struct InterferenceHelper::SnrPer header = m_interference.CalculatePlcpHeaderSnrPer (m_event);
+  struct InterferenceHelper::SnrPer payload = m_interference.CalculatePlcpPayloadSnrPer (m_event);
+  m_interference.NotifyRxEnd ();
+  m_event = 0;
+  NS_TEST_EXPECT_MSG_EQ_TOL (header.snr, expectedSnr, expectedSnr * 1e-6, "unexpected header SNR");
+  NS_TEST_EXPECT_MSG_EQ_TOL (payload.snr, expectedSnr, expectedSnr * 1e-6, "unexpected payload SNR");
+  NS_TEST_EXPECT_MSG_LT (header.per, 0.01, "the header is not interfered with");
+  if (success)
+    {
+      NS_TEST_EXPECT_MSG_LT (payload.per, 0.01, "the payload is not interfered with");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_GT (payload.per, 0.99, "the payload is interfered with");
+    }
+}
+
+void
+InterferenceHelperLedgerTestCase::DoRun (void)
+{
+  m_interference.SetNoiseFigure (1.0);
+  m_interference.SetErrorRateModel (CreateObject<NistErrorRateModel> ());
+  // thermal noise at 290K over 20 MHz, as computed by InterferenceHelper
+  double noiseW = 1.3803e-23 * 290.0 * 20e6;
+
+  Simulator::Schedule (MicroSeconds (0), &InterferenceHelperLedgerTestCase::AddSignal, this,
+                       MicroSeconds (100), 1e-9);
+  Simulator::Schedule (MicroSeconds (10), &InterferenceHelperLedgerTestCase::CheckEnergyDuration, this,
+                       0.5e-9, MicroSeconds (90));
+  // many short signals, which are over before the receptions below
+  for (uint32_t i = 0; i < 50; ++i)
+    {
+      Simulator::Schedule (MicroSeconds (20 + i), &InterferenceHelperLedgerTestCase::AddSignal, this,
+                           MicroSeconds (2), 1e-10);
+      Simulator::Schedule (MicroSeconds (20 + i), &InterferenceHelperLedgerTestCase::CheckEnergyDuration, this,
+                           0.5e-9, MicroSeconds (80 - i));
+    }
+  Simulator::Schedule (MicroSeconds (150), &InterferenceHelperLedgerTestCase::CheckEnergyDuration, this,
+                       1e-12, MicroSeconds (0));
+
+  // a reception alone on the medium
+  Simulator::Schedule (MicroSeconds (200), &InterferenceHelperLedgerTestCase::StartReceive, this,
+                       MilliSeconds (1), 1e-6);
+  Simulator::Schedule (MicroSeconds (1200), &InterferenceHelperLedgerTestCase::EndReceive, this,
+                       1e-6 / noiseW, true);
+
+  // a reception whose payload is interfered with
+  Simulator::Schedule (MicroSeconds (2000), &InterferenceHelperLedgerTestCase::StartReceive, this,
+                       MilliSeconds (1), 1e-6);
+  Simulator::Schedule (MicroSeconds (2500), &InterferenceHelperLedgerTestCase::AddSignal, this,
+                       MicroSeconds (100), 1e-5);
+  Simulator::Schedule (MicroSeconds (3000), &InterferenceHelperLedgerTestCase::EndReceive, this,
+                       1e-6 / noiseW, false);
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
 //-----------------------------------------------------------------------------
 
 class WifiTestSuite : public TestSuite
@@ -1108,6 +1479,9 @@ WifiTestSuite::WifiTestSuite ()
   AddTestCase (new Bug730TestCase, TestCase::QUICK); //Bug 730
   AddTestCase (new SetChannelFrequencyTest, TestCase::QUICK);
   AddTestCase (new Bug2222TestCase, TestCase::QUICK); //Bug 2222
+  AddTestCase (new YansWifiChannelCullingTestCase, TestCase::QUICK);
+  AddTestCase (new YansWifiChannelSharedPacketTestCase, TestCase::QUICK);
+  AddTestCase (new InterferenceHelperLedgerTestCase, TestCase::QUICK);
 }
 
 static WifiTestSuite g_wifiTestSuite;
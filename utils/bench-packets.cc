@@ -302,6 +302,78 @@ benchByteTags (uint32_t n)
     }
 }
 
+static void
+benchAcks (uint32_t n)
+{
+  BenchHeader<20> ipv4;
+  BenchHeader<32> tcp;
+
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = Create<Packet> ();
+      p->AddHeader (tcp);
+      p->AddHeader (ipv4);
+      Ptr<Packet> copy = p->Copy ();
+      copy->RemoveHeader (ipv4);
+      copy->RemoveHeader (tcp);
+    }
+}
+
+static void
+benchMixedSizes (uint32_t n)
+{
+  BenchHeader<20> ipv4;
+  BenchHeader<32> tcp;
+  static uint8_t payload[65000];
+  const uint32_t sizes[] = { 0, 1448, 536, 0, 65000, 1448 };
+  const uint32_t nSizes = sizeof (sizes) / sizeof (sizes[0]);
+  // keep a window of packets alive, like a transmission queue.
+  Ptr<Packet> window[64];
+
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (payload, sizes[i % nSizes]);
+      p->AddHeader (tcp);
+      p->AddHeader (ipv4);
+      window[i % 64] = p;
+    }
+}
+
+template <int N>
+static void
+benchPacketTags (uint32_t n)
+{
+  // the tags of a wifi frame: phy, snr, ampdu and flow monitor tags,
+  // plus a few more when N is larger than the inline storage.
+  BenchTag<4> tag1;
+  BenchTag<8> tag2;
+  BenchTag<12> tag3;
+  BenchTag<16> tag4;
+  BenchTag<5> tag5;
+  BenchTag<9> tag6;
+
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (1500);
+      p->AddPacketTag (tag1);
+      p->AddPacketTag (tag2);
+      p->AddPacketTag (tag3);
+      p->AddPacketTag (tag4);
+      if (N > 4)
+        {
+          p->AddPacketTag (tag5);
+          p->AddPacketTag (tag6);
+        }
+      Ptr<Packet> o = p->Copy ();
+      o->PeekPacketTag (tag1);
+      o->PeekPacketTag (tag4);
+      o->ReplacePacketTag (tag2);
+      o->RemovePacketTag (tag3);
+      p->RemovePacketTag (tag1);
+      p->PeekPacketTag (tag2);
+    }
+}
+
 static uint64_t
 runBenchOneIteration (void (*bench) (uint32_t), uint32_t n)
 {
@@ -331,6 +403,18 @@ runBench (void (*bench) (uint32_t), uint32_t n, uint32_t minIterations, char con
             << std::endl;
 }
 
+static void
+runPoolBench (void (*bench) (uint32_t), uint32_t n, uint32_t minIterations, char const *name)
+{
+  Buffer::ResetPoolStatistics ();
+  runBench (bench, n, minIterations, name);
+  Buffer::PoolStatistics stats = Buffer::GetPoolStatistics ();
+  std::cout << "\tbuffer pool: " << stats.hits << " hits, "
+            << stats.misses << " misses, "
+            << stats.peakBytes << " peak bytes"
+            << std::endl;
+}
+
 int main (int argc, char *argv[])
 {
   uint32_t n = 0;
@@ -359,6 +443,10 @@ int main (int argc, char *argv[])
   runBench (&benchD, n, minIterations, "Intermixed add/remove headers and tags");
   runBench (&benchFragment, n, minIterations, "Fragmentation and concatenation");
   runBench (&benchByteTags, n, minIterations, "Benchmark byte tags");
+  runBench (&benchPacketTags<4>, n, minIterations, "Copy, peek and remove 4 packet tags");
+  runBench (&benchPacketTags<6>, n, minIterations, "Copy, peek and remove 6 packet tags");
+  runPoolBench (&benchAcks, n, minIterations, "Pooled buffers of acknowledgments");
+  runPoolBench (&benchMixedSizes, n, minIterations, "Pooled buffers of mixed sizes");
 
   return 0;
 }
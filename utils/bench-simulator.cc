@@ -185,6 +185,8 @@ int main (int argc, char *argv[])
   bool schedCal  = false;
   bool schedHeap = false;
   bool schedList = false;
+  bool schedLadder = false;
+  bool schedDary = false;
   bool schedMap  = true;
 
   uint32_t pop   =  100000;
@@ -204,6 +206,8 @@ int main (int argc, char *argv[])
   cmd.AddValue ("cal",   "use CalendarSheduler",          schedCal);
   cmd.AddValue ("heap",  "use HeapScheduler",             schedHeap);
   cmd.AddValue ("list",  "use ListSheduler",              schedList);
+  cmd.AddValue ("ladder", "use LadderScheduler",          schedLadder);
+  cmd.AddValue ("dary",  "use DaryHeapScheduler",         schedDary);
   cmd.AddValue ("map",   "use MapScheduler (default)",    schedMap);
   cmd.AddValue ("debug", "enable debugging output",       g_debug);
   cmd.AddValue ("pop",   "event population size (default 1E5)",         pop);
@@ -219,6 +223,8 @@ int main (int argc, char *argv[])
   if (schedCal)  { factory.SetTypeId ("ns3::CalendarScheduler"); }
   if (schedHeap) { factory.SetTypeId ("ns3::HeapScheduler");     }
   if (schedList) { factory.SetTypeId ("ns3::ListScheduler");     }  
+  if (schedLadder) { factory.SetTypeId ("ns3::LadderScheduler"); }
+  if (schedDary) { factory.SetTypeId ("ns3::DaryHeapScheduler"); }
   Simulator::SetScheduler (factory);
 
   LOGME (std::setprecision (g_fwidth - 6));
@@ -270,6 +276,9 @@ int main (int argc, char *argv[])
     }
 
   LOG ("");
+  EventImpl::PoolStats pool = EventImpl::GetPoolStats ();
+  LOGME ("event pool: " << pool.m_hits << " hits, " <<
+         pool.m_misses << " misses, " << pool.m_cached << " cached");
   return 0;
 
   Simulator::Destroy ();
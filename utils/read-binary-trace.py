@@ -0,0 +1,119 @@
+#!/usr/bin/env python
+## -*- Mode: python; py-indent-offset: 4; indent-tabs-mode: nil; coding: utf-8; -*-
+#
+# Read the binary trace files written by ns3::BinaryTraceFile, as
+# created by ns3::BinaryTraceHelper.
+#
+# As a module:
+#
+#   import imp
+#   trace = imp.load_source('trace', 'utils/read-binary-trace.py')
+#   columns = trace.read_columns('run.bin')     # dict of array.array
+#   frame = trace.read_dataframe('run.bin')     # pandas.DataFrame
+#
+# From the command line, the records are printed as CSV:
+#
+#   ./utils/read-binary-trace.py run.bin > run.csv
+
+import array
+import struct
+import sys
+
+MAGIC = b'ns3trace'
+VERSION = 1
+
+# column name, array typecode candidates and width in bytes, in file order
+COLUMNS = [
+    ('time', ('q', 'l'), 8),
+    ('uid', ('Q', 'L'), 8),
+    ('node', ('I', 'L'), 4),
+    ('device', ('I', 'L'), 4),
+    ('size', ('I', 'L'), 4),
+    ('event', ('B',), 1),
+]
+
+EVENTS = ['enqueue', 'dequeue', 'drop', 'receive']
+
+
+def _typecode(candidates, width):
+    for code in candidates:
+        try:
+            if array.array(code).itemsize == width:
+                return code
+        except ValueError:
+            pass
+    raise RuntimeError('no array type of %d bytes' % width)
+
+
+def _read_exactly(f, size):
+    data = f.read(size)
+    if len(data) != size:
+        raise IOError('truncated binary trace file')
+    return data
+
+
+def read_columns(filename):
+    """Return a dict mapping each column name to an array.array of its
+    values, for all the records of the file, in file order."""
+    columns = {}
+    for name, candidates, width in COLUMNS:
+        columns[name] = array.array(_typecode(candidates, width))
+    with open(filename, 'rb') as f:
+        if f.read(8) != MAGIC:
+            raise IOError('%s is not a binary trace file' % filename)
+        version, _ = struct.unpack('=II', _read_exactly(f, 8))
+        if version != VERSION:
+            raise IOError('unsupported binary trace version %d' % version)
+        while True:
+            header = f.read(8)
+            if not header:
+                break
+            if len(header) != 8:
+                raise IOError('truncated binary trace file')
+            count, _ = struct.unpack('=II', header)
+            # the end of each chunk is padded to a multiple of 8 bytes
+            columns_size = count * sum(width for _, _, width in COLUMNS)
+            padding = ((columns_size + 7) & ~7) - columns_size
+            for name, candidates, width in COLUMNS:
+                size = count * width
+                if name == 'event':
+                    size += padding
+                chunk = array.array(columns[name].typecode)
+                data = _read_exactly(f, size)
+                if hasattr(chunk, 'frombytes'):
+                    chunk.frombytes(data[:count * width])
+                else:
+                    chunk.fromstring(data[:count * width])
+                columns[name].extend(chunk)
+    return columns
+
+
+def read_dataframe(filename):
+    """Return the records of the file as a pandas DataFrame, with the
+    event types as a categorical column."""
+    import numpy
+    import pandas
+    columns = read_columns(filename)
+    frame = pandas.DataFrame(dict((name, numpy.frombuffer(values, dtype=values.typecode))
+                                  for name, values in columns.items()),
+                             columns=[name for name, _, _ in COLUMNS])
+    frame['event'] = pandas.Categorical.from_codes(frame['event'], EVENTS)
+    return frame
+
+
+def main(argv):
+    if len(argv) != 2:
+        sys.stderr.write('usage: %s FILE\n' % argv[0])
+        return 1
+    columns = read_columns(argv[1])
+    names = [name for name, _, _ in COLUMNS]
+    sys.stdout.write(','.join(names) + '\n')
+    for i in range(len(columns['time'])):
+        values = [columns[name][i] for name in names]
+        values[-1] = EVENTS[values[-1]] if values[-1] < len(EVENTS) else values[-1]
+        sys.stdout.write(','.join(str(v) for v in values) + '\n')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))